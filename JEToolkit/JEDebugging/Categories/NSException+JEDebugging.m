@@ -101,20 +101,18 @@
     @autoreleasepool {
         
         NSMutableString *callStackString = [[NSMutableString alloc] initWithString:@"["];
-        [[self callStackSymbols] enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+        // Only the raw return addresses are described, since descriptions are built on the logging (possibly crashing) thread. JEDebugging writes the symbols from its file log queue, and JECallStackSymbolsForReturnAddresses() resolves them on demand.
+        [[self callStackReturnAddresses] enumerateObjectsUsingBlock:^(NSNumber *returnAddress, NSUInteger idx, BOOL *stop) {
             
-            @autoreleasepool {
-                
-                [callStackString appendString:@"\n"];
-                [callStackString appendString:[obj description]];
-                
-            }
+            [callStackString appendFormat:@"\n%-4lu0x%016llx",
+             (unsigned long)idx,
+             [returnAddress unsignedLongLongValue]];
             
         }];
         [callStackString indentByLevel:1];
         [callStackString appendString:@"\n]"];
         
-        [description appendString:@",\ncallStackSymbols: "];
+        [description appendString:@",\ncallStackReturnAddresses: "];
         [description appendString:callStackString];
         
     }
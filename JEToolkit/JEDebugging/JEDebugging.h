@@ -48,6 +48,16 @@
 #import "JEConsoleLoggerSettings.h"
 #import "JEHUDLoggerSettings.h"
 #import "JEFileLoggerSettings.h"
+#import "JELogLevelOverride.h"
+
+#import "JELogSubscription.h"
+#import "JEFileLogQuery.h"
+#import "JELogCallsite.h"
+#import "JELogC.h"
+#import "JELogFormat.h"
+#import "JELogThrottle.h"
+#import "JEMetrics.h"
+#import "JEPrometheusMetricExporter.h"
 
 
 
@@ -114,6 +124,8 @@
  The macro argument is variadic to allow expressions that have commas in them. You can use this as a trick to use the comma operator to attach a string before the expression, such as JEDump("This will be 2", 1+1); Be warned though that if you are using the comma operator for arrays you need to pass the address instead: JEDump("This is safe", &arrayVariable);
  Otherwise, only the first item in the array will be printed (or crash if you passed an empty array).
  
+ The expression is always evaluated, even if no logger accepts the level, so expressions with side effects behave the same with logging turned off. Only describing and logging the value are skipped.
+ 
  Note that a bug(?) with NSGetSizeAndAlignment() prevents structs and unions with bitfields to be wrapped in NSValue, in which case JEDump() will just print "(?){ ... }".
  */
 #define JEDump(expression...) \
@@ -137,10 +149,16 @@
         JE_PRAGMA_IGNORE("-Wunused-value") \
         /* We need to assign the expression to a variable in case it is an rvalue. */ \
         /* Since arrays cannot be assigned to another array, we use the comma operator in typeof(0, expression) to demote array types to their pointer counterparts. */ \
+        /* The expression is evaluated even if the callsite is disabled, so that its side effects don't depend on the log settings. */ \
         const typeof(0, expression) _je_value = (expression); \
         JE_PRAGMA_POP \
+        static JELogCallsite _je_callsite = 0; \
+        if (!JELogCallsiteIsEnabled(&_je_callsite, (level), __JE_FILE_NAME__, __PRETTY_FUNCTION__)) { \
+            break; \
+        } \
         [JEDebugging \
          dumpLevel:level \
+         callsite:&_je_callsite \
          location:JELogLocationCurrent() \
          label:(@""#expression) \
          value:[NSValue \
@@ -177,12 +195,89 @@
 
 #define JELogLevel(level, formatString, ...) \
     do { \
+        static JELogCallsite _je_callsite = 0; \
+        /* Holds the parsed format string, so the callsite only parses it the first time it logs. */ \
+        static void *_je_formatCache = NULL; \
+        if (!JELogCallsiteIsEnabled(&_je_callsite, (level), __JE_FILE_NAME__, __PRETTY_FUNCTION__)) { \
+            break; \
+        } \
         JE_PRAGMA_PUSH \
         JE_PRAGMA_IGNORE("-Wformat-extra-args") \
         [JEDebugging \
          logLevel:level \
+         callsite:&_je_callsite \
          location:JELogLocationCurrent() \
-         logMessage:^{ return [[NSString alloc] initWithFormat:(formatString), ##__VA_ARGS__]; }]; \
+         logMessage:^{ return JELogFormatWithCallsiteCache(&_je_formatCache, (formatString), ##__VA_ARGS__); }]; \
+        JE_PRAGMA_POP \
+    } while(NO)
+
+
+/*! Logs only one out of every @p sampleInterval calls from the callsite, such as JELogNoticeSampled(100, ...) for 1 in 100. Skipped calls are decided before the message is formatted, and the number skipped is appended to the next logged message.
+ */
+#define JELogTraceSampled(sampleInterval, formatString, ...) \
+    JELogLevelSampled(JELogLevelTrace, (sampleInterval), (formatString), ##__VA_ARGS__)
+
+#define JELogNoticeSampled(sampleInterval, formatString, ...) \
+    JELogLevelSampled(JELogLevelNotice, (sampleInterval), (formatString), ##__VA_ARGS__)
+
+#define JELogAlertSampled(sampleInterval, formatString, ...) \
+    JELogLevelSampled(JELogLevelAlert, (sampleInterval), (formatString), ##__VA_ARGS__)
+
+#define JELogFatalSampled(sampleInterval, formatString, ...) \
+    JELogLevelSampled(JELogLevelFatal, (sampleInterval), (formatString), ##__VA_ARGS__)
+
+#define JELogLevelSampled(level, sampleInterval, formatString, ...) \
+    do { \
+        static JELogCallsite _je_callsite = 0; \
+        static JELogSampler _je_sampler = { 0 }; \
+        static void *_je_formatCache = NULL; \
+        unsigned long _je_numberOfSuppressedCalls = 0; \
+        if (!JELogCallsiteIsEnabled(&_je_callsite, (level), __JE_FILE_NAME__, __PRETTY_FUNCTION__) \
+            || !JELogSamplerShouldLog(&_je_sampler, (sampleInterval), &_je_numberOfSuppressedCalls)) { \
+            break; \
+        } \
+        JE_PRAGMA_PUSH \
+        JE_PRAGMA_IGNORE("-Wformat-extra-args") \
+        [JEDebugging \
+         logLevel:level \
+         callsite:&_je_callsite \
+         location:JELogLocationCurrent() \
+         logMessage:^{ return JELogMessageWithSuppressedCalls(JELogFormatWithCallsiteCache(&_je_formatCache, (formatString), ##__VA_ARGS__), _je_numberOfSuppressedCalls); }]; \
+        JE_PRAGMA_POP \
+    } while(NO)
+
+
+/*! Logs at most @p callsPerSecond calls per second from the callsite, with bursts of up to one second's worth, such as JELogAlertRateLimited(10, ...). Rejected calls are decided before the message is formatted, and the number rejected is appended to the next logged message.
+ */
+#define JELogTraceRateLimited(callsPerSecond, formatString, ...) \
+    JELogLevelRateLimited(JELogLevelTrace, (callsPerSecond), (formatString), ##__VA_ARGS__)
+
+#define JELogNoticeRateLimited(callsPerSecond, formatString, ...) \
+    JELogLevelRateLimited(JELogLevelNotice, (callsPerSecond), (formatString), ##__VA_ARGS__)
+
+#define JELogAlertRateLimited(callsPerSecond, formatString, ...) \
+    JELogLevelRateLimited(JELogLevelAlert, (callsPerSecond), (formatString), ##__VA_ARGS__)
+
+#define JELogFatalRateLimited(callsPerSecond, formatString, ...) \
+    JELogLevelRateLimited(JELogLevelFatal, (callsPerSecond), (formatString), ##__VA_ARGS__)
+
+#define JELogLevelRateLimited(level, callsPerSecond, formatString, ...) \
+    do { \
+        static JELogCallsite _je_callsite = 0; \
+        static JELogRateLimiter _je_rateLimiter = { 0, 0 }; \
+        static void *_je_formatCache = NULL; \
+        unsigned long _je_numberOfSuppressedCalls = 0; \
+        if (!JELogCallsiteIsEnabled(&_je_callsite, (level), __JE_FILE_NAME__, __PRETTY_FUNCTION__) \
+            || !JELogRateLimiterShouldLog(&_je_rateLimiter, (callsPerSecond), &_je_numberOfSuppressedCalls)) { \
+            break; \
+        } \
+        JE_PRAGMA_PUSH \
+        JE_PRAGMA_IGNORE("-Wformat-extra-args") \
+        [JEDebugging \
+         logLevel:level \
+         callsite:&_je_callsite \
+         location:JELogLocationCurrent() \
+         logMessage:^{ return JELogMessageWithSuppressedCalls(JELogFormatWithCallsiteCache(&_je_formatCache, (formatString), ##__VA_ARGS__), _je_numberOfSuppressedCalls); }]; \
         JE_PRAGMA_POP \
     } while(NO)
 
@@ -279,6 +374,15 @@ typedef struct JELogLocation {
             label:(nonnull NSString *)label
             value:(nullable NSValue *)wrappedValue;
 
+/*!
+ Use the @p JEDump(...) family of utilities instead of this method. The per-logger levels cached in @p callsite are used instead of matching level overrides again.
+ */
++ (void)dumpLevel:(JELogLevelMask)level
+         callsite:(nullable JELogCallsite *)callsite
+         location:(JELogLocation)location
+            label:(nonnull NSString *)label
+            value:(nullable NSValue *)wrappedValue;
+
 /*!
  Use the @p JEDump(...) family of utilities instead of this method.
  */
@@ -301,6 +405,14 @@ typedef struct JELogLocation {
         location:(JELogLocation)location
       logMessage:(nonnull id _Nonnull(^__attribute__((noescape)))(void))logMessage;
 
+/*!
+ Use the @p JELog(...) family of utilities instead of this method. The per-logger levels cached in @p callsite are used instead of matching level overrides again.
+ */
++ (void)logLevel:(JELogLevelMask)level
+        callsite:(nullable JELogCallsite *)callsite
+        location:(JELogLocation)location
+      logMessage:(nonnull id _Nonnull(^__attribute__((noescape)))(void))logMessage;
+
 
 /*!
  Use the @p JEAssert(...) family of utilities instead of this method.
@@ -343,4 +455,82 @@ JE_PRAGMA_POP
  */
 + (void)enumerateFileLogURLsWithBlock:(nonnull void (^)(NSURL *_Nonnull fileURL, BOOL *_Nonnull stop))block;
 
+/*!
+ Enumerates all log records synchronously in chronological order, starting with the oldest record. Records from all log files in the logs directory are merged, including files written by other processes sharing the directory. Files are streamed so that only a small part of each file is in memory at a time.
+ @param block The iteration block. The @p record is the record's UTF8 data without the record separator. Set the @p stop argument to @p YES to terminate the enumeration.
+ */
++ (void)enumerateFileLogRecordsWithBlock:(nonnull void (^)(NSString *_Nonnull fileName, NSDate *_Nonnull date, NSData *_Nonnull record, BOOL *_Nonnull stop))block;
+
+/*!
+ Enumerates the log records passing a query synchronously in chronological order, starting with the oldest record. Records are parsed from both text and JSON Lines files; parsing and filtering run on background queues in parallel across files, and files are streamed so that memory use does not grow with the files' sizes.
+ @param fileURLs The log files to read, such as files copied from a device. Pass nil to read all log files in the logs directory.
+ @param query The query for the records to enumerate. Pass nil to enumerate all records.
+ @param block The iteration block. Records parsed from files do not have callStackReturnAddresses; symbolicated call stacks are returned as the @p dump. Set the @p stop argument to @p YES to terminate the enumeration.
+ */
++ (void)enumerateFileLogRecordsAtURLs:(nullable NSArray *)fileURLs
+                        matchingQuery:(nullable JEFileLogQuery *)query
+                            withBlock:(nonnull void (^)(JELogRecord *_Nonnull record, BOOL *_Nonnull stop))block;
+
+/*!
+ Writes the log records passing a query to a single file in chronological order. Records already in the requested format are copied unchanged; other records are converted. Files are streamed so that memory use does not grow with the files' sizes.
+ @param fileURLs The log files to read, such as files copied from a device. Pass nil to read all log files in the logs directory.
+ @param query The query for the records to export. Pass nil to export all records.
+ @param exportFileURL The file to write to. An existing file is overwritten.
+ @param format The format of the exported records
+ @param error The error that occurred while writing, if any
+ @return YES if all records were written, NO otherwise
+ */
++ (BOOL)exportFileLogRecordsAtURLs:(nullable NSArray *)fileURLs
+                     matchingQuery:(nullable JEFileLogQuery *)query
+                             toURL:(nonnull NSURL *)exportFileURL
+                            format:(JEFileLogFormat)format
+                             error:(NSError *_Nullable *_Nullable)error;
+
+
+#pragma mark - subscribing
+
+/*!
+ Subscribes to messages as they are logged. Subscribers receive messages independently of the console, HUD, and file loggers' settings, and do not slow down logging threads; while a subscriber cannot keep up, only its own new messages are dropped.
+ @param filter The filter for the messages to deliver. Pass nil to deliver all messages.
+ @param queue The queue to call the @p handler on. Batches are delivered one at a time even on concurrent queues.
+ @param handler The block called with the logged JELogRecords, in logging order, and the number of records dropped since the last batch.
+ @return The subscription, which can be passed to unsubscribe: to stop receiving messages.
+ */
++ (nonnull JELogSubscription *)subscribeWithFilter:(nullable JELogFilter *)filter
+                                             queue:(nonnull dispatch_queue_t)queue
+                                           handler:(nonnull void (^)(NSArray *_Nonnull records, NSUInteger numberOfDroppedRecords))handler;
+
+/*!
+ Stops delivering messages to a subscription. Batches already scheduled on the subscription's queue are discarded.
+ @param subscription The subscription returned by subscribeWithFilter:queue:handler:
+ */
++ (void)unsubscribe:(nonnull JELogSubscription *)subscription;
+
+
+#pragma mark - metrics
+
+/*! Sets how often metrics recorded with the JEMetric(...) utilities are collected, logged, and passed to exporters. Metrics are only flushed after start is called.
+ @param flushInterval The interval in seconds between flushes. Pass 0 to disable periodic flushing. Defaults to 60
+ */
++ (void)setMetricsFlushInterval:(NSTimeInterval)flushInterval;
+
+/*! Sets the level of the single log message summarizing the metrics at each flush. The message is omitted when no counter changed and no gauge was set.
+ @param level The log level for the metrics summary. Pass JELogLevelNone to stop logging metrics while still passing them to exporters. Defaults to JELogLevelNotice
+ */
++ (void)setMetricsLogLevel:(JELogLevelMask)level;
+
+/*! Adds an exporter that receives a JEMetricSnapshot at each flush.
+ @param exporter The exporter to add. Exporters are retained until removed.
+ */
++ (void)addMetricExporter:(nonnull id<JEMetricExporter>)exporter;
+
+/*! Removes an exporter added with addMetricExporter:.
+ @param exporter The exporter to remove
+ */
++ (void)removeMetricExporter:(nonnull id<JEMetricExporter>)exporter;
+
+/*! Collects, logs, and exports metrics immediately. Returns after all exporters have been called.
+ */
++ (void)flushMetrics;
+
 @end
@@ -26,6 +26,13 @@
 #import "JEDebugging.h"
 
 #import <objc/runtime.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #ifdef DEBUG
 #include <sys/sysctl.h>
@@ -42,6 +49,13 @@
 #import "UIViewController+JEDebugging.h"
 
 #import "JEHUDLogView.h"
+#import "JEJSONLineEncoder.h"
+#import "JEFileLogManifest.h"
+#import "JEFileLogReader.h"
+#import "JECallStackSymbolicator.h"
+#import "JELogRepeatSuppressor.h"
+#import "JELogStager.h"
+#import "JELogScratchPool.h"
 
 
 #define JEDebuggingReverseDNSPrefix   "com.JEToolkit.JEDebugging."
@@ -55,6 +69,119 @@ static const void *_JEDebuggingFileLogQueueID = &_JEDebuggingFileLogQueueID;
 static NSString *const _JEDebuggingFileLogAttributeKey = @"" JEDebuggingReverseDNSPrefix "logFileAttribute";
 static NSString *const _JEDebuggingFileLogAttributeValue = @"1";
 
+uint32_t _JELogCallsiteGeneration = 1;
+
+// Snapshot of the settings read by JELogCWrite() without going through the settings queue
+static atomic_bool _JEDebuggingCIsStarted;
+static atomic_uint _JEDebuggingCConsoleLevelMask;
+static atomic_uint _JEDebuggingCConsoleHeaderMask;
+static atomic_uint _JEDebuggingCHUDLevelMask;
+static atomic_uint _JEDebuggingCFileLevelMask;
+static atomic_bool _JEDebuggingCNeedsObjectPath;
+
+_Static_assert((JELogCLevelTrace == JELogLevelTrace
+                && JELogCLevelNotice == JELogLevelNotice
+                && JELogCLevelAlert == JELogLevelAlert
+                && JELogCLevelFatal == JELogLevelFatal),
+               "JELogC levels must match JELogLevelMask");
+
+enum {
+    
+    _JEDebuggingCMessageCapacity = 1024,
+    _JEDebuggingCNumberOfSlots = 256
+};
+
+_Static_assert((_JEDebuggingCNumberOfSlots & (_JEDebuggingCNumberOfSlots - 1)) == 0,
+               "The JELogC ring size must be a power of two");
+
+/*! The message header of a record. Formatted once when the record is logged, and copied by value into the blocks and staged records that output it, so building and passing it around does not allocate. Values too long for their field are truncated.
+ */
+typedef struct _JEDebuggingHeader {
+    
+    JELogMessageHeaderMask mask;
+    NSTimeInterval timeIntervalSince1970;
+    unsigned int lineNumber;
+    char date[32];
+    char queueLabel[64];
+    char fileName[128];
+    char functionName[512];
+    
+} _JEDebuggingHeader;
+
+/*! A JELog() record staged for the HUD or file logger. The record is copied into the logger's JELogStager instead of being captured by a block, so staging it does not allocate. The message and the logger settings are retained by the record and released by its handler.
+ */
+typedef struct _JEDebuggingStagedRecord {
+    
+    JELogLevelMask level;
+    NSUInteger repeatKey;
+    CFAbsoluteTime timestamp;
+    CFTypeRef message;
+    CFTypeRef loggerSettings;
+    _JEDebuggingHeader header;
+    
+} _JEDebuggingStagedRecord;
+
+static const NSUInteger _JEDebuggingStagedBlocksPerBatch = 32;
+static const NSTimeInterval _JEDebuggingStagedBlockMaximumLatency = 0.01;
+static const NSTimeInterval _JEDebuggingDefaultMetricsFlushInterval = 60;
+
+/*! A message logged with JELogC(), waiting in the preallocated ring for the drain queue. JELogCWrite() claims and fills a slot without allocating or locking, so it can run in signal handlers. A slot is free for ring position p when its sequence is p, and holds the message for position p once its sequence is p + 1.
+ */
+typedef struct _JEDebuggingCSlot {
+    
+    atomic_size_t sequence;
+    JELogCallsite *callsite;
+    JELogLevelMask level;
+    bool needsObjectPath;
+    bool logsToHUD;
+    bool logsToFile;
+    const char *fileName;
+    const char *functionName;
+    unsigned int lineNumber;
+    CFAbsoluteTime timestamp;
+    char queueLabel[64];
+    size_t messageLength;
+    char message[_JEDebuggingCMessageCapacity];
+    
+} _JEDebuggingCSlot;
+
+static _JEDebuggingCSlot _JEDebuggingCSlots[_JEDebuggingCNumberOfSlots];
+static atomic_size_t _JEDebuggingCEnqueuePosition;
+static atomic_uint _JEDebuggingCNumberOfDroppedMessages;
+static atomic_bool _JEDebuggingCIsDrainPending;
+static int _JEDebuggingCWakeUpFileDescriptor = -1;
+
+// Only accessed from the drain queue
+static size_t _JEDebuggingCDequeuePosition;
+
+JE_STATIC void _JEDebuggingCStartDraining(void);
+JE_STATIC void _JEDebuggingCDrainSynchronously(void);
+JE_STATIC void _JEDebuggingOutputStagedRecordToHUD(void *context);
+JE_STATIC void _JEDebuggingOutputStagedRecordToFile(void *context);
+
+/*! A message logged with JELogC(), copied out of the ring and handed to the HUD and file logger queues. The file and function names are string literals, so they are not copied.
+ */
+typedef struct _JEDebuggingCEntry {
+    
+    atomic_uint retainCount;
+    JELogLevelMask level;
+    const char *fileName;
+    const char *functionName;
+    unsigned int lineNumber;
+    CFAbsoluteTime timestamp;
+    char queueLabel[64];
+    size_t messageLength;
+    char message[];
+    
+} _JEDebuggingCEntry;
+
+typedef NS_ENUM(NSInteger, _JEDebuggingLogger) {
+    
+    _JEDebuggingLoggerConsole,
+    _JEDebuggingLoggerHUD,
+    _JEDebuggingLoggerFile
+};
+
 
 @interface JEHUDLogView (JEDebugging)
 
@@ -67,6 +194,20 @@ withThreadSafeSettings:(JEHUDLoggerSettings *)HUDLogSettings;
 @end
 
 
+@interface JELogSubscription (JEDebugging)
+
+- (instancetype)initWithFilter:(JELogFilter *)filter
+                         queue:(dispatch_queue_t)queue
+                       handler:(void (^)(NSArray *records, NSUInteger numberOfDroppedRecords))handler;
+- (BOOL)matchesLevel:(JELogLevelMask)level
+            fileName:(const char *)fileName
+        functionName:(const char *)functionName;
+- (void)publishRecord:(JELogRecord *)record;
+- (void)cancel;
+
+@end
+
+
 @interface JEDebugging ()
 
 @property (nonatomic, strong, readonly) NSString *deviceDescription;
@@ -75,28 +216,309 @@ withThreadSafeSettings:(JEHUDLoggerSettings *)HUDLogSettings;
 @property (nonatomic, strong) JEConsoleLoggerSettings *consoleLoggerSettings;
 @property (nonatomic, strong) JEHUDLoggerSettings *HUDLoggerSettings;
 @property (nonatomic, strong) JEFileLoggerSettings *fileLoggerSettings;
+@property (nonatomic, copy) NSArray *subscriptions;
 
 // File log attributes
 @property (nonatomic, strong) NSFileHandle *fileLogHandle;
 @property (nonatomic, copy) NSURL *fileLogURL;
 @property (nonatomic, assign) unsigned long long fileLogLastSynchronizedOffset;
 @property (nonatomic, assign) BOOL fileLogIsDisabled;
+@property (nonatomic, assign) JEFileLogFormat fileLogFormat;
+@property (nonatomic, strong) JEFileLogManifest *fileLogManifest;
+@property (nonatomic, strong) JEFileLogSegment *fileLogSegment;
 
 // HUD log attributes
 @property (nonatomic, strong) JEHUDLogView *HUDLogView;
 
+// Repeated message suppression, each only accessed from its logger's queue
+@property (nonatomic, strong) JELogRepeatSuppressor *consoleRepeatSuppressor;
+@property (nonatomic, strong) JELogRepeatSuppressor *HUDRepeatSuppressor;
+@property (nonatomic, strong) JELogRepeatSuppressor *fileLogRepeatSuppressor;
+
+// Metrics attributes, only accessed from the metrics queue
+@property (nonatomic, assign) NSTimeInterval metricsFlushInterval;
+@property (nonatomic, assign) JELogLevelMask metricsLogLevel;
+@property (nonatomic, copy) NSArray *metricExporters;
+@property (nonatomic, strong) dispatch_source_t metricsTimer;
+
 
 + (JEDebugging *)sharedInstance;
 
++ (void)dumpLevel:(JELogLevelMask)level
+         callsite:(JELogCallsite *)callsite
+         location:(JELogLocation)location
+            label:(NSString *)label
+ valueDescription:(id (^__attribute__((noescape)))(void))valueDescription
+callStackReturnAddresses:(NSArray *)callStackReturnAddresses;
+
++ (void)logLevel:(JELogLevelMask)level
+        callsite:(JELogCallsite *)callsite
+        location:(JELogLocation)location
+            date:(NSDate *)loggedDate
+      queueLabel:(const char *)loggedQueueLabel
+      logMessage:(id (^__attribute__((noescape)))(void))logMessage;
+
++ (void)flushStagedFileLogRecords;
+
 @end
 
 
+JE_STATIC
+const char *_JEDebuggingLevelName(JELogLevelMask level) {
+    
+    if (JEEnumBitmasked(level, JELogLevelFatal)) {
+        
+        return "fatal";
+    }
+    if (JEEnumBitmasked(level, JELogLevelAlert)) {
+        
+        return "alert";
+    }
+    if (JEEnumBitmasked(level, JELogLevelNotice)) {
+        
+        return "notice";
+    }
+    return "trace";
+}
+
+JE_STATIC
+JELogCallsite _JEDebuggingCallsiteStateForLocation(uint32_t generation,
+                                                   JELogLocation location,
+                                                   JEBaseLoggerSettings *consoleLoggerSettings,
+                                                   JEBaseLoggerSettings *HUDLoggerSettings,
+                                                   JEBaseLoggerSettings *fileLoggerSettings,
+                                                   NSArray *subscriptions) {
+    
+    JELogLevelMask consoleLevelMask = [consoleLoggerSettings
+                                       logLevelMaskForFileName:location.fileName
+                                       functionName:location.functionName];
+    JELogLevelMask HUDLevelMask = [HUDLoggerSettings
+                                   logLevelMaskForFileName:location.fileName
+                                   functionName:location.functionName];
+    JELogLevelMask fileLevelMask = [fileLoggerSettings
+                                    logLevelMaskForFileName:location.fileName
+                                    functionName:location.functionName];
+    
+    // Subscription filters are matched when the message is logged, so any subscription enables all levels.
+    JELogLevelMask enabledLevels = ([subscriptions count] > 0
+                                    ? JELogLevelAll
+                                    : (consoleLevelMask | HUDLevelMask | fileLevelMask));
+    return (((JELogCallsite)generation << 32)
+            | ((JELogCallsite)(fileLevelMask & JELogCallsiteEnabledLevelsMask) << 24)
+            | ((JELogCallsite)(HUDLevelMask & JELogCallsiteEnabledLevelsMask) << 16)
+            | ((JELogCallsite)(consoleLevelMask & JELogCallsiteEnabledLevelsMask) << 8)
+            | (JELogCallsite)(enabledLevels & JELogCallsiteEnabledLevelsMask));
+}
+
+JE_STATIC
+JELogCallsite _JEDebuggingCallsiteState(JELogCallsite *callsite,
+                                        uint32_t generation,
+                                        JELogLocation location,
+                                        JEBaseLoggerSettings *consoleLoggerSettings,
+                                        JEBaseLoggerSettings *HUDLoggerSettings,
+                                        JEBaseLoggerSettings *fileLoggerSettings,
+                                        NSArray *subscriptions) {
+    
+    if (callsite) {
+        
+        JELogCallsite state = __atomic_load_n(callsite, __ATOMIC_RELAXED);
+        if ((uint32_t)(state >> 32) == generation) {
+            
+            return state;
+        }
+    }
+    
+    // The generation was read before the settings, so if the settings changed since, the stored state is still seen as stale.
+    JELogCallsite state = _JEDebuggingCallsiteStateForLocation(generation,
+                                                               location,
+                                                               consoleLoggerSettings,
+                                                               HUDLoggerSettings,
+                                                               fileLoggerSettings,
+                                                               subscriptions);
+    if (callsite) {
+        
+        __atomic_store_n(callsite, state, __ATOMIC_RELAXED);
+    }
+    return state;
+}
+
+JE_STATIC
+JELogLevelMask _JEDebuggingCallsiteConsoleLevelMask(JELogCallsite state) {
+    
+    return (JELogLevelMask)((state >> 8) & JELogCallsiteEnabledLevelsMask);
+}
+
+JE_STATIC
+JELogLevelMask _JEDebuggingCallsiteHUDLevelMask(JELogCallsite state) {
+    
+    return (JELogLevelMask)((state >> 16) & JELogCallsiteEnabledLevelsMask);
+}
+
+JE_STATIC
+JELogLevelMask _JEDebuggingCallsiteFileLevelMask(JELogCallsite state) {
+    
+    return (JELogLevelMask)((state >> 24) & JELogCallsiteEnabledLevelsMask);
+}
+
+JE_STATIC
+size_t _JEDebuggingFormatTimestamp(char *buffer, size_t bufferSize, NSTimeInterval timeIntervalSince1970) {
+    
+    // Formats "yyyy-MM-dd HH:mm:ss.SSS" in UTC, same as consoleDateFormatter but without allocating. The calendar math is done here because gmtime_r() and strftime() may take locks, which JELogC() must not from signal handlers.
+    int64_t seconds = (int64_t)floor(timeIntervalSince1970);
+    int milliseconds = (int)((timeIntervalSince1970 - (double)seconds) * 1000.0);
+    int64_t days = ((seconds >= 0 ? seconds : (seconds - 86399)) / 86400);
+    int64_t secondOfDay = (seconds - (days * 86400));
+    
+    // Days since 1970-01-01 to a proleptic Gregorian date, counting years from March so that leap days fall at the end.
+    days += 719468;
+    int64_t era = ((days >= 0 ? days : (days - 146096)) / 146097);
+    int64_t dayOfEra = (days - (era * 146097));
+    int64_t yearOfEra = ((dayOfEra - (dayOfEra / 1460) + (dayOfEra / 36524) - (dayOfEra / 146096)) / 365);
+    int64_t dayOfYear = (dayOfEra - ((365 * yearOfEra) + (yearOfEra / 4) - (yearOfEra / 100)));
+    int64_t monthIndex = (((5 * dayOfYear) + 2) / 153);
+    int day = (int)(dayOfYear - (((153 * monthIndex) + 2) / 5) + 1);
+    int month = (int)(monthIndex < 10 ? (monthIndex + 3) : (monthIndex - 9));
+    long long year = (long long)(yearOfEra + (era * 400) + (month <= 2 ? 1 : 0));
+    
+    int length = snprintf(buffer, bufferSize, "%04lld-%02d-%02d %02d:%02d:%02d.%03d",
+                          year, month, day,
+                          (int)(secondOfDay / 3600),
+                          (int)((secondOfDay / 60) % 60),
+                          (int)(secondOfDay % 60),
+                          MIN(milliseconds, 999));
+    return (size_t)MAX(0, MIN(length, (int)(bufferSize - 1)));
+}
+
+JE_STATIC
+void _JEDebuggingWriteFully(int fileDescriptor, const char *bytes, size_t length) {
+    
+    // write(2) is async-signal-safe and, unlike stdio, has no buffer shared with other writers. A record is written with a single call unless interrupted.
+    while (length > 0) {
+        
+        ssize_t writtenLength = write(fileDescriptor, bytes, length);
+        if (writtenLength < 0) {
+            
+            if (errno == EINTR) {
+                
+                continue;
+            }
+            return;
+        }
+        bytes += writtenLength;
+        length -= (size_t)writtenLength;
+    }
+}
+
+JE_STATIC
+void _JEDebuggingCopyHeaderField(char *field, size_t fieldSize, const char *string) {
+    
+    // Truncated on a character boundary so that the field is still valid UTF8.
+    size_t length = strlen(string);
+    if (length >= fieldSize) {
+        
+        length = (fieldSize - 1);
+        while (length > 0 && (((unsigned char)string[length] & 0xC0) == 0x80)) {
+            
+            --length;
+        }
+    }
+    memcpy(field, string, length);
+    field[length] = '\0';
+}
+
+JE_STATIC
+void _JEDebuggingAppendHeader(NSMutableData *buffer,
+                              const _JEDebuggingHeader *header,
+                              JELogMessageHeaderMask logMessageHeaderMask) {
+    
+    JELogMessageHeaderMask mask = (header->mask & logMessageHeaderMask);
+    NSUInteger originalLength = [buffer length];
+    
+    if (JEEnumBitmasked(mask, JELogMessageHeaderDate)) {
+        
+        JELogScratchBufferAppendUTF8String(buffer, header->date);
+        JELogScratchBufferAppendUTF8String(buffer, " ");
+    }
+    if (JEEnumBitmasked(mask, JELogMessageHeaderQueue)) {
+        
+        JELogScratchBufferAppendUTF8String(buffer, "[");
+        JELogScratchBufferAppendUTF8String(buffer, header->queueLabel);
+        JELogScratchBufferAppendUTF8String(buffer, "] ");
+    }
+    if (JEEnumBitmasked(mask, JELogMessageHeaderSourceFile)) {
+        
+        char lineNumber[16];
+        snprintf(lineNumber, sizeof(lineNumber), ":%u ", header->lineNumber);
+        JELogScratchBufferAppendUTF8String(buffer, header->fileName);
+        JELogScratchBufferAppendUTF8String(buffer, lineNumber);
+    }
+    if (JEEnumBitmasked(mask, JELogMessageHeaderFunction)) {
+        
+        JELogScratchBufferAppendUTF8String(buffer, header->functionName);
+        JELogScratchBufferAppendUTF8String(buffer, " ");
+    }
+    
+    if ([buffer length] > originalLength) {
+        
+        JELogScratchBufferAppendUTF8String(buffer, "\n");
+    }
+}
+
+JE_STATIC
+BOOL _JEDebuggingShouldFlushImmediately(JELogLevelMask level) {
+    
+    // Alerts and fatal messages are handed off right away in case the app is about to crash.
+    return ((level & (JELogLevelAlert | JELogLevelFatal)) != 0);
+}
+
+JE_STATIC
+NSUInteger _JEDebuggingRepeatKey(JELogLocation location, NSString *message) {
+    
+    // FNV-1a over the callsite, which is cheap enough to compute before anything is formatted.
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *character = (location.fileName ?: ""); *character != '\0'; ++character) {
+        
+        hash = ((hash ^ (uint8_t)*character) * 1099511628211ULL);
+    }
+    for (const char *character = (location.functionName ?: ""); *character != '\0'; ++character) {
+        
+        hash = ((hash ^ (uint8_t)*character) * 1099511628211ULL);
+    }
+    hash = ((hash ^ location.lineNumber) * 1099511628211ULL);
+    hash = ((hash ^ [message hash]) * 1099511628211ULL);
+    return (NSUInteger)hash;
+}
+
+JE_STATIC
+NSMutableString *_JEDebuggingCallStackDescription(NSArray *callStackReturnAddresses) {
+    
+    NSMutableString *callStackString = [[NSMutableString alloc] initWithString:@"["];
+    for (NSString *symbol in JECallStackSymbolsForReturnAddresses(callStackReturnAddresses)) {
+        
+        [callStackString appendString:@"\n"];
+        [callStackString appendString:symbol];
+    }
+    [callStackString indentByLevel:1];
+    [callStackString appendString:@"\n]"];
+    return callStackString;
+}
+
 JE_STATIC
 void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
     
-    JELogFatal(@"Application (%@) crashed with exception: %@",
-               [JEDebugging sharedInstance].deviceDescription,
-               [exception loggingDescriptionIncludeClass:YES includeAddress:NO]);
+    // The exception's call stack is passed along as raw addresses so that, as with assertion failures, it is symbolicated on the file log queue instead of the crashing thread.
+    [JEDebugging
+     dumpLevel:JELogLevelFatal
+     callsite:NULL
+     location:JELogLocationCurrent()
+     label:[[NSString alloc] initWithFormat:
+            @"Application (%@) crashed with exception",
+            [JEDebugging sharedInstance].deviceDescription]
+     valueDescription:^{
+         
+         return [exception loggingDescriptionIncludeClass:YES includeAddress:NO];
+     }
+     callStackReturnAddresses:[exception callStackReturnAddresses]];
 }
 
 
@@ -125,6 +547,10 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
     _consoleLoggerSettings = [[JEConsoleLoggerSettings alloc] init];
     _HUDLoggerSettings = [[JEHUDLoggerSettings alloc] init];
     _fileLoggerSettings = [[JEFileLoggerSettings alloc] init];
+    [self updateCLoggingState];
+    
+    _metricsFlushInterval = _JEDebuggingDefaultMetricsFlushInterval;
+    _metricsLogLevel = JELogLevelNotice;
     
     NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
     [center
@@ -300,6 +726,54 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
     return fileLogQueue;
 }
 
++ (JELogStager *)HUDLogStager {
+    
+    static JELogStager *HUDLogStager;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        HUDLogStager = [[JELogStager alloc]
+                        initWithQueue:dispatch_get_main_queue()
+                        isBarrier:NO
+                        maximumNumberOfBlocks:_JEDebuggingStagedBlocksPerBatch
+                        maximumLatency:_JEDebuggingStagedBlockMaximumLatency];
+    });
+    return HUDLogStager;
+}
+
++ (JELogStager *)fileLogStager {
+    
+    static JELogStager *fileLogStager;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        fileLogStager = [[JELogStager alloc]
+                         initWithQueue:[self fileLogQueue]
+                         isBarrier:YES
+                         maximumNumberOfBlocks:_JEDebuggingStagedBlocksPerBatch
+                         maximumLatency:_JEDebuggingStagedBlockMaximumLatency];
+    });
+    return fileLogStager;
+}
+
++ (void)flushStagedFileLogRecords {
+    
+    // JELogC() messages still waiting in the ring are handed off along with the staged records.
+    _JEDebuggingCDrainSynchronously();
+    [[self fileLogStager] flushAllThreads];
+}
+
++ (dispatch_queue_t)metricsQueue {
+    
+    static dispatch_queue_t metricsQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        metricsQueue = dispatch_queue_create(JEDebuggingReverseDNSPrefix "metricsQueue", DISPATCH_QUEUE_SERIAL);
+    });
+    return metricsQueue;
+}
+
 #pragma mark default bullets
 
 + (NSString *)defaultTraceBulletString {
@@ -337,6 +811,23 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
     return @"📲";
 }
 
++ (NSString *)defaultBulletStringForLevel:(JELogLevelMask)level {
+    
+    if (JEEnumBitmasked(level, JELogLevelFatal)) {
+        
+        return [self defaultFatalBulletString];
+    }
+    if (JEEnumBitmasked(level, JELogLevelAlert)) {
+        
+        return [self defaultAlertBulletString];
+    }
+    if (JEEnumBitmasked(level, JELogLevelNotice)) {
+        
+        return [self defaultLogBulletString];
+    }
+    return [self defaultTraceBulletString];
+}
+
 #pragma mark utilities
 
 + (void)logFileError:(id)errorOrException
@@ -358,10 +849,17 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
         
     });
     
-    NSDictionary *headerEntries = [self
-                                   headerEntriesForLocation:location
-                                   withMask:(consoleLoggerSettings.logMessageHeaderMask
-                                             | HUDLoggerSettings.logMessageHeaderMask)];
+    JELogLevelMask consoleLevelMask = [consoleLoggerSettings
+                                       logLevelMaskForFileName:location.fileName
+                                       functionName:location.functionName];
+    JELogLevelMask HUDLevelMask = [HUDLoggerSettings
+                                   logLevelMaskForFileName:location.fileName
+                                   functionName:location.functionName];
+    
+    _JEDebuggingHeader header = [self
+                                 headerForLocation:location
+                                 withMask:(consoleLoggerSettings.logMessageHeaderMask
+                                           | HUDLoggerSettings.logMessageHeaderMask)];
     
     NSMutableString *errorDescription = [NSMutableString stringWithString:
                                          [errorOrException
@@ -372,60 +870,33 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
         [errorDescription indentByLevel:1];
     }
     
-    if (JEEnumBitmasked(consoleLoggerSettings.logLevelMask, JELogLevelAlert)) {
+    if (JEEnumBitmasked(consoleLevelMask, JELogLevelAlert)) {
         
         dispatch_barrier_async([JEDebugging consoleLogQueue], ^{
             
             @autoreleasepool {
                 
-                NSMutableString *logString = [self messageHeaderFromEntries:headerEntries
-                                                               withSettings:consoleLoggerSettings];
-                if (errorDescription) {
-                    
-                    [logString appendFormat:
-                     @"%@ %@\n  %@ %@\n",
-                     [JEDebugging defaultAlertBulletString],
-                     message,
-                     [JEDebugging defaultDumpBulletString],
-                     errorDescription];
-                }
-                else {
-                    
-                    [logString appendFormat:
-                     @"%@ %@\n",
-                     [JEDebugging defaultAlertBulletString],
-                     message];
-                }
-                
-                puts([logString UTF8String]);
+                [self
+                 writeTextRecordToConsoleWithHeader:&header
+                 bulletString:[JEDebugging defaultAlertBulletString]
+                 message:message
+                 dump:errorDescription
+                 withSettings:consoleLoggerSettings];
             }
         });
     }
-    if (JEEnumBitmasked(HUDLoggerSettings.logLevelMask, JELogLevelAlert)) {
+    if (JEEnumBitmasked(HUDLevelMask, JELogLevelAlert)) {
         
         dispatch_async(dispatch_get_main_queue(), ^{
             
             @autoreleasepool {
                 
-                NSMutableString *logString = [self
-                                              messageHeaderFromEntries:headerEntries
-                                              withSettings:HUDLoggerSettings];
-                if (errorDescription) {
-                    
-                    [logString appendFormat:
-                     @"%@ %@\n  %@ %@",
-                     [JEDebugging defaultAlertBulletString],
-                     message,
-                     [JEDebugging defaultDumpBulletString],
-                     errorDescription];
-                }
-                else {
-                    
-                    [logString appendFormat:
-                     @"%@ %@",
-                     [JEDebugging defaultAlertBulletString],
-                     message];
-                }
+                NSString *logString = [self
+                                       HUDStringWithHeader:&header
+                                       bulletString:[JEDebugging defaultAlertBulletString]
+                                       message:message
+                                       dump:errorDescription
+                                       withSettings:HUDLoggerSettings];
                 
                 [[self sharedInstance]
                  appendStringToHUD:logString
@@ -435,8 +906,20 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
     }
 }
 
-+ (NSDictionary *)headerEntriesForLocation:(JELogLocation)location
-                                  withMask:(JELogMessageHeaderMask)logMessageHeaderMask {
++ (_JEDebuggingHeader)headerForLocation:(JELogLocation)location
+                               withMask:(JELogMessageHeaderMask)logMessageHeaderMask {
+    
+    return [self
+            headerForLocation:location
+            timestamp:CFAbsoluteTimeGetCurrent()
+            queueLabel:NULL
+            withMask:logMessageHeaderMask];
+}
+
++ (_JEDebuggingHeader)headerForLocation:(JELogLocation)location
+                              timestamp:(CFAbsoluteTime)timestamp
+                             queueLabel:(const char *)loggedQueueLabel
+                               withMask:(JELogMessageHeaderMask)logMessageHeaderMask {
     
     static const char *(^getQueueLabel)(void);
     static dispatch_once_t onceToken;
@@ -469,59 +952,106 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
         }
     });
     
-    NSMutableDictionary * headerEntries = [[NSMutableDictionary alloc] init];
-    
-    headerEntries[@(JELogMessageHeaderDate)]
-    = (JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderDate)
-       ? [NSString stringWithFormat:@"%@ ", [[self consoleDateFormatter] stringFromDate:[[NSDate alloc] init]]]
-       : [NSString string]);
-    headerEntries[@(JELogMessageHeaderQueue)]
-    = (JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderQueue)
-       ? [NSString stringWithFormat:@"[%s] ", getQueueLabel()]
-       : [NSString string]);
-    headerEntries[@(JELogMessageHeaderSourceFile)]
-    = ((JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderSourceFile)
-        && location.fileName != NULL
-        && location.lineNumber > 0)
-       ? [NSString stringWithFormat:@"%s:%lu ", location.fileName, (unsigned long)location.lineNumber]
-       : [NSString string]);
-    headerEntries[@(JELogMessageHeaderFunction)]
-    = ((JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderFunction) && location.functionName != NULL)
-       ? [NSString stringWithFormat:@"%s ", location.functionName]
-       : [NSString string]);
-    
-    return headerEntries;
-}
-
-+ (NSMutableString *)messageHeaderFromEntries:(NSDictionary *)logMessageHeaderEntries
-                                 withSettings:(JEBaseLoggerSettings *)loggerSettings {
-    
-    JELogMessageHeaderMask logMessageHeaderMask = loggerSettings.logMessageHeaderMask;
-    NSMutableString *messageHeader = [[NSMutableString alloc] init];
+    _JEDebuggingHeader header;
+    header.mask = JELogMessageHeaderNone;
+    header.timeIntervalSince1970 = (timestamp + kCFAbsoluteTimeIntervalSince1970);
+    header.lineNumber = location.lineNumber;
+    header.date[0] = '\0';
+    header.queueLabel[0] = '\0';
+    header.fileName[0] = '\0';
+    header.functionName[0] = '\0';
     
     if (JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderDate)) {
         
-        [messageHeader appendString:logMessageHeaderEntries[@(JELogMessageHeaderDate)]];
+        header.mask |= JELogMessageHeaderDate;
+        _JEDebuggingFormatTimestamp(header.date, sizeof(header.date), header.timeIntervalSince1970);
     }
     if (JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderQueue)) {
         
-        [messageHeader appendString:logMessageHeaderEntries[@(JELogMessageHeaderQueue)]];
+        header.mask |= JELogMessageHeaderQueue;
+        _JEDebuggingCopyHeaderField(header.queueLabel, sizeof(header.queueLabel), ((loggedQueueLabel ?: getQueueLabel()) ?: ""));
     }
-    if (JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderSourceFile)) {
+    // The location's C-strings are only guaranteed to be valid during the logging call (Swift passes temporary buffers), so they are copied here.
+    if (JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderSourceFile)
+        && location.fileName != NULL
+        && location.lineNumber > 0) {
         
-        [messageHeader appendString:logMessageHeaderEntries[@(JELogMessageHeaderSourceFile)]];
+        header.mask |= JELogMessageHeaderSourceFile;
+        _JEDebuggingCopyHeaderField(header.fileName, sizeof(header.fileName), location.fileName);
     }
-    if (JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderFunction)) {
+    if (JEEnumBitmasked(logMessageHeaderMask, JELogMessageHeaderFunction) && location.functionName != NULL) {
         
-        [messageHeader appendString:logMessageHeaderEntries[@(JELogMessageHeaderFunction)]];
+        header.mask |= JELogMessageHeaderFunction;
+        _JEDebuggingCopyHeaderField(header.functionName, sizeof(header.functionName), location.functionName);
     }
     
-    if ([messageHeader length] > 0) {
+    return header;
+}
+
++ (void)appendTextRecordWithHeader:(const _JEDebuggingHeader *)header
+                      bulletString:(NSString *)bulletString
+                           message:(NSString *)message
+                              dump:(NSString *)dump
+                          toBuffer:(NSMutableData *)buffer
+                      withSettings:(JEBaseLoggerSettings *)loggerSettings {
+    
+    // Same layout as "header\nbullet message\n  dumpBullet dump", built without formatting.
+    _JEDebuggingAppendHeader(buffer, header, loggerSettings.logMessageHeaderMask);
+    JELogScratchBufferAppendString(buffer, bulletString);
+    JELogScratchBufferAppendUTF8String(buffer, " ");
+    JELogScratchBufferAppendString(buffer, message);
+    if (dump) {
         
-        [messageHeader appendString:@"\n"];
+        JELogScratchBufferAppendUTF8String(buffer, "\n  ");
+        JELogScratchBufferAppendString(buffer, [self defaultDumpBulletString]);
+        JELogScratchBufferAppendUTF8String(buffer, " ");
+        JELogScratchBufferAppendString(buffer, dump);
     }
+}
+
++ (NSString *)HUDStringWithHeader:(const _JEDebuggingHeader *)header
+                     bulletString:(NSString *)bulletString
+                          message:(NSString *)message
+                             dump:(NSString *)dump
+                     withSettings:(JEBaseLoggerSettings *)loggerSettings {
+    
+    // The HUD keeps the string, so only the finished string is allocated.
+    NSMutableData *buffer = JELogScratchBufferAcquire();
+    [self
+     appendTextRecordWithHeader:header
+     bulletString:bulletString
+     message:message
+     dump:dump
+     toBuffer:buffer
+     withSettings:loggerSettings];
+    NSString *HUDString = [[NSString alloc]
+                           initWithBytes:[buffer bytes]
+                           length:[buffer length]
+                           encoding:NSUTF8StringEncoding];
+    JELogScratchBufferRelinquish(buffer);
+    return (HUDString ?: @"");
+}
+
++ (void)writeTextRecordToConsoleWithHeader:(const _JEDebuggingHeader *)header
+                              bulletString:(NSString *)bulletString
+                                   message:(NSString *)message
+                                      dump:(NSString *)dump
+                              withSettings:(JEBaseLoggerSettings *)loggerSettings {
     
-    return messageHeader;
+    NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingConsoleLogQueueID,
+              @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
+    
+    NSMutableData *buffer = JELogScratchBufferAcquire();
+    [self
+     appendTextRecordWithHeader:header
+     bulletString:bulletString
+     message:message
+     dump:dump
+     toBuffer:buffer
+     withSettings:loggerSettings];
+    JELogScratchBufferAppendUTF8String(buffer, "\n\n");
+    _JEDebuggingWriteFully(STDOUT_FILENO, [buffer bytes], [buffer length]);
+    JELogScratchBufferRelinquish(buffer);
 }
 
 - (NSFileHandle *)cachedFileHandleWithThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings {
@@ -530,6 +1060,16 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
               @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
     
     NSFileHandle *fileHandle = self.fileLogHandle;
+    if (fileHandle && self.fileLogFormat != fileLoggerSettings.fileLogFormat) {
+        
+        // Text and JSON Lines records are never mixed in a single file.
+        [self flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
+        [fileHandle closeFile];
+        fileHandle = nil;
+        self.fileLogHandle = nil;
+        self.fileLogURL = nil;
+        self.fileLogSegment = nil;
+    }
     if (fileHandle) {
         
         return fileHandle;
@@ -573,10 +1113,12 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
         
         fileURL = [fileLogsDirectoryURL
                    URLByAppendingPathComponent:
-                   [[NSString alloc] initWithFormat:@"%@(%@) %@.log",
+                   [[NSString alloc] initWithFormat:@"%@(%@) %@ [%d].%@",
                     [NSString applicationName],
                     ([NSString applicationBundleVersion] ?: @"-"),
-                    [[JEDebugging fileNameDateFormatter] stringFromDate:[[NSDate alloc] init]]]
+                    [[JEDebugging fileNameDateFormatter] stringFromDate:[[NSDate alloc] init]],
+                    (int)getpid(),
+                    (fileLoggerSettings.fileLogFormat == JEFileLogFormatJSONLines ? @"jsonl" : @"log")]
                    isDirectory:NO];
         
         NSString *filePath = [fileURL path];
@@ -604,28 +1146,18 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
         }
         
         self.fileLogURL = fileURL;
+        self.fileLogFormat = fileLoggerSettings.fileLogFormat;
     }
     
-    NSString *attributeString;
-    NSError *attributeError;
-    if (![fileURL
-          getExtendedAttribute:&attributeString
-          forKey:_JEDebuggingFileLogAttributeKey
-          error:&attributeError]) {
-        
-        failure(JELogLocationCurrent(),
-                @"Failed to read extended attribute from log file because of error:",
-                attributeError);
-        return nil;
-    }
-    
-    if (![_JEDebuggingFileLogAttributeValue isEqualToString:attributeString]) {
+    // Log files are identified through the manifest instead of reading back their extended attribute.
+    JEFileLogManifest *manifest = [self fileLogManifestWithThreadSafeSettings:fileLoggerSettings];
+    JEFileLogSegment *segment = [manifest addSegmentWithFileName:[fileURL lastPathComponent]];
+    if (segment.firstTimestamp <= 0) {
         
-        failure(JELogLocationCurrent(),
-                @"Extended attribute read from log file is incorrect.",
-                nil);
-        return nil;
+        segment.firstTimestamp = (CFAbsoluteTimeGetCurrent() + kCFAbsoluteTimeIntervalSince1970);
     }
+    segment.processIdentifier = getpid();
+    [manifest segmentDidChange:segment];
     
     NSError *fileHandleError;
     fileHandle = [NSFileHandle fileHandleForWritingToURL:fileURL error:&fileHandleError];
@@ -637,28 +1169,63 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
         return nil;
     }
     
-    [fileHandle seekToEndOfFile];
+    unsigned long long offsetInFile = [fileHandle seekToEndOfFile];
+    segment.fileSize = offsetInFile;
     
     self.fileLogHandle = fileHandle;
-    self.fileLogLastSynchronizedOffset = [fileHandle offsetInFile];
+    self.fileLogSegment = segment;
+    self.fileLogLastSynchronizedOffset = offsetInFile;
     
     [self deleteOldFileLogsWithThreadSafeSettings:fileLoggerSettings];
+    [self synchronizeFileLogManifest];
     
     return fileHandle;
 }
 
-- (void)enumerateFileLogsWithThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings
-                                          block:(void (^)(NSURL *fileURL, BOOL *stop))block {
+- (JEFileLogManifest *)fileLogManifestWithThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings {
+    
+    NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingFileLogQueueID,
+              @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
+    
+    NSURL *fileLogsDirectoryURL = fileLoggerSettings.fileLogsDirectoryURL;
+    JEFileLogManifest *manifest = self.fileLogManifest;
+    if ([manifest.directoryURL isEqual:fileLogsDirectoryURL]) {
+        
+        return manifest;
+    }
+    
+    [self synchronizeFileLogManifest];
+    
+    manifest = [[JEFileLogManifest alloc] initWithDirectoryURL:fileLogsDirectoryURL];
+    if (![manifest loadWithError:NULL]) {
+        
+        // Directories written before the manifest existed (or whose manifest was lost) are scanned once.
+        [self rebuildFileLogManifest:manifest];
+    }
+    self.fileLogManifest = manifest;
+    
+    return manifest;
+}
+
+- (void)rebuildFileLogManifest:(JEFileLogManifest *)manifest {
     
     NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingFileLogQueueID,
               @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
     
     NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSURL *directoryURL = manifest.directoryURL;
+    if (![fileManager fileExistsAtPath:[directoryURL path]]) {
+        
+        return;
+    }
+    
     NSError *fileEnumerationError;
     NSArray *fileURLs = [fileManager
-                         contentsOfDirectoryAtURL:fileLoggerSettings.fileLogsDirectoryURL
+                         contentsOfDirectoryAtURL:directoryURL
                          includingPropertiesForKeys:@[(__bridge NSString *)kCFURLIsRegularFileKey,
-                                                      (__bridge NSString *)kCFURLCreationDateKey]
+                                                      (__bridge NSString *)kCFURLCreationDateKey,
+                                                      (__bridge NSString *)kCFURLContentModificationDateKey,
+                                                      (__bridge NSString *)kCFURLFileSizeKey]
                          options:(NSDirectoryEnumerationSkipsSubdirectoryDescendants
                                   | NSDirectoryEnumerationSkipsPackageDescendants
                                   | NSDirectoryEnumerationSkipsHiddenFiles)
@@ -672,12 +1239,7 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
         return;
     }
     
-    fileURLs = [fileURLs
-                sortedArrayUsingDescriptors:@[[NSSortDescriptor
-                                               sortDescriptorWithKey:JEKeypath(NSURL *, path)
-                                               ascending:NO]]];
-    
-    [fileURLs enumerateObjectsUsingBlock:^(NSURL *fileURL, NSUInteger idx, BOOL *stop) {
+    for (NSURL *fileURL in fileURLs) {
         
         @autoreleasepool {
             
@@ -688,7 +1250,7 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
              error:NULL];
             if (![isRegularFile boolValue]) {
                 
-                return;
+                continue;
             }
             
             NSString *extendedAttribute;
@@ -698,66 +1260,204 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
              error:NULL];
             if (![_JEDebuggingFileLogAttributeValue isEqualToString:extendedAttribute]) {
                 
-                return;
+                continue;
             }
             
-            block(fileURL, stop);
+            NSDate *creationDate;
+            NSDate *modificationDate;
+            NSNumber *fileSize;
+            [fileURL getResourceValue:&creationDate forKey:(__bridge NSString *)kCFURLCreationDateKey error:NULL];
+            [fileURL getResourceValue:&modificationDate forKey:(__bridge NSString *)kCFURLContentModificationDateKey error:NULL];
+            [fileURL getResourceValue:&fileSize forKey:(__bridge NSString *)kCFURLFileSizeKey error:NULL];
+            
+            JEFileLogSegment *segment = [manifest addSegmentWithFileName:[fileURL lastPathComponent]];
+            segment.fileSize = [fileSize unsignedLongLongValue];
+            segment.firstTimestamp = [creationDate timeIntervalSince1970];
+            segment.lastTimestamp = [(modificationDate ?: creationDate) timeIntervalSince1970];
+            [manifest segmentDidChange:segment];
         }
-    }];
+    }
 }
 
-- (void)deleteOldFileLogsWithThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings {
+- (void)synchronizeFileLogManifest {
     
     NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingFileLogQueueID,
               @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
     
-    NSURL *currentFileURL = self.fileLogURL;
-    if (!currentFileURL) {
+    NSError *manifestError;
+    if (self.fileLogManifest && ![self.fileLogManifest synchronizeWithError:&manifestError]) {
         
-        return;
+        [JEDebugging
+         logFileError:manifestError
+         location:JELogLocationCurrent()
+         message:@"Failed saving log files manifest because of error:"];
     }
+}
+
+- (void)enumerateFileLogsWithThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings
+                                          block:(void (^)(NSURL *fileURL, JEFileLogSegment *segment, BOOL *stop))block {
     
-    NSDateComponents *dayAgo = [[NSDateComponents alloc] init];
-    [dayAgo setDay:-fileLoggerSettings.numberOfDaysBeforeDeletingFile];
+    NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingFileLogQueueID,
+              @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
     
-    NSDate *earliestAllowedDate = [[NSCalendar gregorianCalendar]
-                                   dateByAddingComponents:dayAgo
-                                   toDate:[[NSDate alloc] init]
-                                   options:kNilOptions];
+    // Pick up files created by other processes writing to the same directory.
+    JEFileLogManifest *manifest = [self fileLogManifestWithThreadSafeSettings:fileLoggerSettings];
+    [manifest loadIfModifiedWithError:NULL];
     
-    NSFileManager *fileManager = [NSFileManager defaultManager];
-    [self enumerateFileLogsWithThreadSafeSettings:fileLoggerSettings block:^(NSURL *fileURL, BOOL *stop) {
+    NSURL *directoryURL = manifest.directoryURL;
+    [[manifest segments] enumerateObjectsUsingBlock:^(JEFileLogSegment *segment, NSUInteger idx, BOOL *stop) {
         
-        if ([fileURL isEqual:currentFileURL]) {
+        @autoreleasepool {
+            
+            block([directoryURL URLByAppendingPathComponent:segment.fileName isDirectory:NO], segment, stop);
+        }
+    }];
+}
+
+- (void)deleteOldFileLogsWithThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings {
+    
+    NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingFileLogQueueID,
+              @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
+    
+    NSURL *currentFileURL = self.fileLogURL;
+    if (!currentFileURL) {
+        
+        return;
+    }
+    
+    NSDateComponents *dayAgo = [[NSDateComponents alloc] init];
+    [dayAgo setDay:-fileLoggerSettings.numberOfDaysBeforeDeletingFile];
+    
+    NSDate *earliestAllowedDate = [[NSCalendar gregorianCalendar]
+                                   dateByAddingComponents:dayAgo
+                                   toDate:[[NSDate alloc] init]
+                                   options:kNilOptions];
+    NSTimeInterval earliestAllowedTimestamp = [earliestAllowedDate timeIntervalSince1970];
+    
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    JEFileLogManifest *manifest = [self fileLogManifestWithThreadSafeSettings:fileLoggerSettings];
+    pid_t currentProcessIdentifier = getpid();
+    [self enumerateFileLogsWithThreadSafeSettings:fileLoggerSettings block:^(NSURL *fileURL, JEFileLogSegment *segment, BOOL *stop) {
+        
+        if ([fileURL isEqual:currentFileURL]) {
             
             return;
         }
         
-        NSDate *creationDate;
-        [fileURL
-         getResourceValue:&creationDate
-         forKey:(__bridge NSString *)kCFURLCreationDateKey
-         error:NULL];
+        if (segment.firstTimestamp >= earliestAllowedTimestamp) {
+            
+            return;
+        }
         
-        if ([creationDate compare:earliestAllowedDate] != NSOrderedAscending) {
+        // Files still being written by other processes are left for those processes to clean up.
+        pid_t processIdentifier = segment.processIdentifier;
+        if (processIdentifier > 0
+            && processIdentifier != currentProcessIdentifier
+            && (kill(processIdentifier, 0) == 0 || errno == EPERM)) {
             
             return;
         }
         
         [fileManager removeItemAtURL:fileURL error:NULL];
+        [manifest removeSegment:segment];
     }];
 }
 
-- (void)appendStringToFile:(NSString *)string
-    withThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings {
+- (void)appendTextRecordToFileWithHeader:(const _JEDebuggingHeader *)header
+                            bulletString:(NSString *)bulletString
+                                 message:(NSString *)message
+                                    dump:(NSString *)dump
+                  withThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings {
+    
+    NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingFileLogQueueID,
+              @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
+    
+    NSMutableData *buffer = JELogScratchBufferAcquire();
+    [JEDebugging
+     appendTextRecordWithHeader:header
+     bulletString:bulletString
+     message:message
+     dump:dump
+     toBuffer:buffer
+     withSettings:fileLoggerSettings];
+    JELogScratchBufferAppendUTF8String(buffer, "\n\n");
+    [self
+     appendDataToFile:buffer
+     timestamp:header->timeIntervalSince1970
+     withThreadSafeSettings:fileLoggerSettings];
+    JELogScratchBufferRelinquish(buffer);
+}
+
+- (void)appendRecordToFileWithLevel:(JELogLevelMask)level
+                             header:(const _JEDebuggingHeader *)header
+                            message:(NSString *)message
+                               dump:(NSString *)dump
+                          callStack:(NSArray *)callStackReturnAddresses
+             withThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings {
+    
+    NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingFileLogQueueID,
+              @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
+    
+    NSMutableData *buffer = JELogScratchBufferAcquire();
+    JELogMessageHeaderMask mask = (header->mask & fileLoggerSettings.logMessageHeaderMask);
+    
+    JEJSONLineBegin(buffer);
+    if (JEEnumBitmasked(mask, JELogMessageHeaderDate)) {
+        
+        JEJSONLineAppendTimestamp(buffer, "timestamp", header->timeIntervalSince1970);
+    }
+    JEJSONLineAppendUTF8String(buffer, "level", _JEDebuggingLevelName(level));
+    if (JEEnumBitmasked(mask, JELogMessageHeaderQueue)) {
+        
+        JEJSONLineAppendUTF8String(buffer, "queue", header->queueLabel);
+    }
+    if (JEEnumBitmasked(mask, JELogMessageHeaderSourceFile)) {
+        
+        JEJSONLineAppendUTF8String(buffer, "file", header->fileName);
+        JEJSONLineAppendInteger(buffer, "line", header->lineNumber);
+    }
+    if (JEEnumBitmasked(mask, JELogMessageHeaderFunction)) {
+        
+        JEJSONLineAppendUTF8String(buffer, "function", header->functionName);
+    }
+    JEJSONLineAppendString(buffer, "message", message);
+    if (dump) {
+        
+        JEJSONLineAppendString(buffer, "dump", dump);
+    }
+    if (callStackReturnAddresses) {
+        
+        JEJSONLineAppendString(buffer, "callStack", [JECallStackSymbolsForReturnAddresses(callStackReturnAddresses) componentsJoinedByString:@"\n"]);
+    }
+    JEJSONLineEnd(buffer);
+    
+    [self
+     appendDataToFile:buffer
+     timestamp:header->timeIntervalSince1970
+     withThreadSafeSettings:fileLoggerSettings];
+    JELogScratchBufferRelinquish(buffer);
+}
+
+- (void)appendDataToFile:(NSData *)data
+               timestamp:(NSTimeInterval)timestamp
+  withThreadSafeSettings:(JEFileLoggerSettings *)fileLoggerSettings {
     
     NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingFileLogQueueID,
               @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
     
     @try {
         
-        [[self cachedFileHandleWithThreadSafeSettings:fileLoggerSettings]
-         writeData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+        NSFileHandle *fileHandle = [self cachedFileHandleWithThreadSafeSettings:fileLoggerSettings];
+        if (!fileHandle) {
+            
+            return;
+        }
+        
+        [fileHandle writeData:data];
+        [self.fileLogManifest
+         recordAppendedToSegment:self.fileLogSegment
+         length:[data length]
+         timestamp:timestamp];
         [self flushFileHandleIfNeededOrForced:NO withThreadSafeSettings:fileLoggerSettings];
     }
     @catch (NSException *exception) {
@@ -794,6 +1494,8 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
         
         [fileHandle synchronizeFile];
         self.fileLogLastSynchronizedOffset = offsetInFile;
+        
+        [self synchronizeFileLogManifest];
     }
 }
 
@@ -837,789 +1539,2650 @@ void _JEDebuggingUncaughtExceptionHandler(NSException *exception) {
     [self.HUDLogView addLogString:string withThreadSafeSettings:HUDLoggerSettings];
 }
 
-
-#pragma mark @selector
-
-- (void)applicationWillResignActive:(NSNotification *)note {
+- (JELogRepeatSuppressor *)repeatSuppressorForLogger:(_JEDebuggingLogger)logger {
     
-    JEFileLoggerSettings *fileLoggerSettings = [JEDebugging copyFileLoggerSettings];
-    dispatch_barrier_async([JEDebugging fileLogQueue], ^{
-        
-        [self flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
-    });
+    switch (logger) {
+            
+        case _JEDebuggingLoggerConsole:
+            NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingConsoleLogQueueID,
+                      @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
+            if (!self.consoleRepeatSuppressor) {
+                
+                self.consoleRepeatSuppressor = [[JELogRepeatSuppressor alloc] init];
+            }
+            return self.consoleRepeatSuppressor;
+            
+        case _JEDebuggingLoggerHUD:
+            NSCAssert([NSThread isMainThread],
+                      @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
+            if (!self.HUDRepeatSuppressor) {
+                
+                self.HUDRepeatSuppressor = [[JELogRepeatSuppressor alloc] init];
+            }
+            return self.HUDRepeatSuppressor;
+            
+        case _JEDebuggingLoggerFile:
+            NSCAssert(dispatch_get_specific(_JEDebuggingQueueIDKey) == _JEDebuggingFileLogQueueID,
+                      @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
+            if (!self.fileLogRepeatSuppressor) {
+                
+                self.fileLogRepeatSuppressor = [[JELogRepeatSuppressor alloc] init];
+            }
+            return self.fileLogRepeatSuppressor;
+    }
 }
 
-- (void)applicationDidEnterBackground:(NSNotification *)note {
+- (BOOL)suppressRepeatedMessageWithKey:(NSUInteger)key
+                               message:(NSString *)message
+                                 level:(JELogLevelMask)level
+                          bulletString:(NSString *)bulletString
+                             timestamp:(NSTimeInterval)timestamp
+                                logger:(_JEDebuggingLogger)logger
+                withThreadSafeSettings:(JEBaseLoggerSettings *)loggerSettings {
     
-    JEFileLoggerSettings *fileLoggerSettings = [JEDebugging copyFileLoggerSettings];
-    dispatch_barrier_sync([JEDebugging fileLogQueue], ^{
+    JELogRepeatSuppressor *suppressor = [self repeatSuppressorForLogger:logger];
+    NSTimeInterval interval = loggerSettings.repeatedMessageSuppressionInterval;
+    NSString *summary;
+    if ([suppressor
+         shouldSuppressMessageWithKey:key
+         message:message
+         level:level
+         bulletString:bulletString
+         timestamp:timestamp
+         interval:interval
+         summary:&summary]) {
+        
+        if (suppressor.numberOfRepeats == 1) {
+            
+            // Report the repeats even if nothing else gets logged after the storm ends.
+            [self scheduleRepeatSummaryForLogger:logger afterInterval:interval withThreadSafeSettings:loggerSettings];
+        }
+        return YES;
+    }
     
-        [self flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
-    });
+    if (summary) {
+        
+        [self
+         outputRepeatSummary:summary
+         level:suppressor.level
+         bulletString:suppressor.bulletString
+         logger:logger
+         withThreadSafeSettings:loggerSettings];
+    }
+    return NO;
 }
 
-- (void)applicationWillTerminate:(NSNotification *)note {
+- (void)scheduleRepeatSummaryForLogger:(_JEDebuggingLogger)logger
+                         afterInterval:(NSTimeInterval)interval
+                withThreadSafeSettings:(JEBaseLoggerSettings *)loggerSettings {
     
-    JEFileLoggerSettings *fileLoggerSettings = [JEDebugging copyFileLoggerSettings];
-    dispatch_barrier_sync([JEDebugging fileLogQueue], ^{
+    void (^outputExpiredSummary)(void) = ^{
         
-        [self flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
-    });
+        @autoreleasepool {
+            
+            JELogRepeatSuppressor *suppressor = [self repeatSuppressorForLogger:logger];
+            NSString *summary = [suppressor
+                                 summaryIfExpiredAtTimestamp:CFAbsoluteTimeGetCurrent()
+                                 interval:interval];
+            if (summary) {
+                
+                [self
+                 outputRepeatSummary:summary
+                 level:suppressor.level
+                 bulletString:suppressor.bulletString
+                 logger:logger
+                 withThreadSafeSettings:loggerSettings];
+            }
+        }
+    };
+    
+    dispatch_time_t time = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC));
+    switch (logger) {
+            
+        case _JEDebuggingLoggerConsole:
+            dispatch_after(time, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+                
+                dispatch_barrier_async([JEDebugging consoleLogQueue], outputExpiredSummary);
+            });
+            break;
+            
+        case _JEDebuggingLoggerHUD:
+            dispatch_after(time, dispatch_get_main_queue(), outputExpiredSummary);
+            break;
+            
+        case _JEDebuggingLoggerFile:
+            dispatch_after(time, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0), ^{
+                
+                dispatch_barrier_async([JEDebugging fileLogQueue], outputExpiredSummary);
+            });
+            break;
+    }
 }
 
-- (void)windowDidBecomeTopmost:(NSNotification *)note {
+- (void)outputRepeatSummary:(NSString *)summary
+                      level:(JELogLevelMask)level
+               bulletString:(NSString *)bulletString
+                     logger:(_JEDebuggingLogger)logger
+     withThreadSafeSettings:(JEBaseLoggerSettings *)loggerSettings {
     
-    dispatch_async(dispatch_get_main_queue(), ^{
-        
-        JEHUDLogView *view = self.HUDLogView;
-        if (!view) {
+    _JEDebuggingHeader header = [JEDebugging
+                                 headerForLocation:(JELogLocation){ NULL, NULL, 0 }
+                                 withMask:JELogMessageHeaderDate];
+    switch (logger) {
             
-            return;
+        case _JEDebuggingLoggerConsole: {
+            
+            [JEDebugging
+             writeTextRecordToConsoleWithHeader:&header
+             bulletString:bulletString
+             message:summary
+             dump:nil
+             withSettings:loggerSettings];
+            break;
         }
-        
-        if (view.window == [[UIApplication sharedApplication].windows lastObject]) {
+        case _JEDebuggingLoggerHUD: {
             
-            return;
+            NSString *logString = [JEDebugging
+                                   HUDStringWithHeader:&header
+                                   bulletString:bulletString
+                                   message:summary
+                                   dump:nil
+                                   withSettings:loggerSettings];
+            
+            [self
+             appendStringToHUD:logString
+             withThreadSafeSettings:(JEHUDLoggerSettings *)loggerSettings];
+            break;
         }
-        
-        JEHUDLoggerSettings *__block HUDLoggerSettings;
-        dispatch_barrier_sync([JEDebugging settingsQueue], ^{
+        case _JEDebuggingLoggerFile: {
             
-            HUDLoggerSettings = self.HUDLoggerSettings;
-        });
-        
-        [self moveHUDLoggerToTopmostWindowIfNeededWithThreadSafeSettings:HUDLoggerSettings];
-    });
+            JEFileLoggerSettings *fileLoggerSettings = (JEFileLoggerSettings *)loggerSettings;
+            if (fileLoggerSettings.fileLogFormat == JEFileLogFormatJSONLines) {
+                
+                [self
+                 appendRecordToFileWithLevel:level
+                 header:&header
+                 message:summary
+                 dump:nil
+                 callStack:nil
+                 withThreadSafeSettings:fileLoggerSettings];
+            }
+            else {
+                
+                [self
+                 appendTextRecordToFileWithHeader:&header
+                 bulletString:bulletString
+                 message:summary
+                 dump:nil
+                 withThreadSafeSettings:fileLoggerSettings];
+            }
+            break;
+        }
+    }
 }
 
-
-#pragma mark - Public
-
-#pragma mark utilities
-
-+ (BOOL)isDebugBuild {
+- (void)updateCLoggingState {
     
-#ifdef DEBUG
-    return YES;
-#else
-    return NO;
-#endif
-}
-
-+ (BOOL)isDebuggerAttached {
+    JEConsoleLoggerSettings *consoleLoggerSettings = self.consoleLoggerSettings;
+    JEHUDLoggerSettings *HUDLoggerSettings = self.HUDLoggerSettings;
+    JEFileLoggerSettings *fileLoggerSettings = self.fileLoggerSettings;
     
-#ifdef DEBUG
+    atomic_store(&_JEDebuggingCConsoleLevelMask, (unsigned int)consoleLoggerSettings.logLevelMask);
+    atomic_store(&_JEDebuggingCConsoleHeaderMask, (unsigned int)consoleLoggerSettings.logMessageHeaderMask);
+    atomic_store(&_JEDebuggingCHUDLevelMask, (unsigned int)HUDLoggerSettings.logLevelMask);
+    atomic_store(&_JEDebuggingCFileLevelMask, (unsigned int)fileLoggerSettings.logLevelMask);
     
-    // https://developer.apple.com/library/mac/qa/qa1361/_index.html
-    int mib[4] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+    // Subscriptions, level overrides, and repeat suppression need Objective-C objects, so JELogC() defers to the regular path for them.
+    atomic_store(&_JEDebuggingCNeedsObjectPath,
+                 ([self.subscriptions count] > 0
+                  || [consoleLoggerSettings.logLevelOverrides count] > 0
+                  || [HUDLoggerSettings.logLevelOverrides count] > 0
+                  || [fileLoggerSettings.logLevelOverrides count] > 0
+                  || consoleLoggerSettings.repeatedMessageSuppressionInterval > 0
+                  || HUDLoggerSettings.repeatedMessageSuppressionInterval > 0
+                  || fileLoggerSettings.repeatedMessageSuppressionInterval > 0));
     
-    struct kinfo_proc info = { .kp_proc.p_flag = 0 };
-    size_t infoSize = sizeof(info);
-    if (noErr == sysctl(mib, (sizeof(mib) / sizeof(*mib)), &info, &infoSize, NULL, 0)) {
+    [JEDebugging invalidateCallsites];
+}
+
++ (void)invalidateCallsites {
+    
+    // 0 is skipped so callsites that never resolved are never mistaken as current.
+    if (__atomic_add_fetch(&_JELogCallsiteGeneration, 1, __ATOMIC_RELEASE) == 0) {
         
-        return JEEnumBitmasked(info.kp_proc.p_flag, P_TRACED);
+        __atomic_add_fetch(&_JELogCallsiteGeneration, 1, __ATOMIC_RELEASE);
     }
-    
-    return NO;
-    
-#else
-    
-    return NO;
-    
-#endif
 }
 
-#pragma mark configuring
-
-+ (JEConsoleLoggerSettings *)copyConsoleLoggerSettings {
++ (JELogCallsite)callsiteStateForGeneration:(uint32_t)generation
+                                   fileName:(const char *)fileName
+                               functionName:(const char *)functionName {
     
-    JEConsoleLoggerSettings *__block settings;
+    if (![self sharedInstance].isStarted) {
+        
+        return ((JELogCallsite)generation << 32);
+    }
+    
+    JELogCallsite __block state = 0;
     dispatch_barrier_sync([self settingsQueue], ^{
         
-        settings = [[self sharedInstance].consoleLoggerSettings copy];
+        JEDebugging *instance = [self sharedInstance];
+        state = _JEDebuggingCallsiteStateForLocation(generation,
+                                                     (JELogLocation){ fileName, functionName, 0 },
+                                                     instance.consoleLoggerSettings,
+                                                     instance.HUDLoggerSettings,
+                                                     instance.fileLoggerSettings,
+                                                     instance.subscriptions);
     });
-    return settings;
+    return state;
 }
 
-+ (void)setConsoleLoggerSettings:(JEConsoleLoggerSettings *)consoleLoggerSettings {
++ (NSArray *)subscriptions:(NSArray *)subscriptions
+             matchingLevel:(JELogLevelMask)level
+                  location:(JELogLocation)location {
     
-    JEAssertParameter(consoleLoggerSettings != nil);
-    
-    dispatch_barrier_async([self settingsQueue], ^{
+    NSMutableArray *matchingSubscriptions;
+    for (JELogSubscription *subscription in subscriptions) {
         
-        [self sharedInstance].consoleLoggerSettings = [consoleLoggerSettings copy];
-    });
+        if (![subscription
+              matchesLevel:level
+              fileName:location.fileName
+              functionName:location.functionName]) {
+            
+            continue;
+        }
+        
+        if (!matchingSubscriptions) {
+            
+            matchingSubscriptions = [[NSMutableArray alloc] initWithCapacity:[subscriptions count]];
+        }
+        [matchingSubscriptions addObject:subscription];
+    }
+    return matchingSubscriptions;
 }
 
-+ (JEHUDLoggerSettings *)copyHUDLoggerSettings {
++ (void)publishRecordToSubscriptions:(NSArray *)subscriptions
+                               level:(JELogLevelMask)level
+                            location:(JELogLocation)location
+                             message:(NSString *)message
+                                dump:(NSString *)dump
+            callStackReturnAddresses:(NSArray *)callStackReturnAddresses {
     
-    JEHUDLoggerSettings *__block settings;
-    dispatch_barrier_sync([self settingsQueue], ^{
+    // The location's strings may be temporary (as with Swift callers), so they are copied before the record leaves this thread.
+    JELogRecord *record = [[JELogRecord alloc]
+                           initWithLevel:level
+                           date:[[NSDate alloc] init]
+                           fileName:(location.fileName ? [[NSString alloc] initWithUTF8String:location.fileName] : nil)
+                           functionName:(location.functionName ? [[NSString alloc] initWithUTF8String:location.functionName] : nil)
+                           lineNumber:location.lineNumber
+                           message:message
+                           dump:dump
+                           callStackReturnAddresses:callStackReturnAddresses];
+    for (JELogSubscription *subscription in subscriptions) {
         
-        settings = [[self sharedInstance].HUDLoggerSettings copy];
-    });
-    return settings;
+        [subscription publishRecord:record];
+    }
 }
 
-+ (void)setHUDLoggerSettings:(JEHUDLoggerSettings *)HUDLoggerSettings {
+
+#pragma mark metrics
+
+- (void)scheduleMetricsTimer {
     
-    JEAssertParameter(HUDLoggerSettings != nil);
+    if (self.metricsTimer) {
+        
+        dispatch_source_cancel(self.metricsTimer);
+        self.metricsTimer = nil;
+    }
     
-    dispatch_barrier_async([self settingsQueue], ^{
+    NSTimeInterval flushInterval = self.metricsFlushInterval;
+    if (!self.isStarted || flushInterval <= 0) {
         
-        [self sharedInstance].HUDLoggerSettings = [HUDLoggerSettings copy];
-    });
-}
-
-+ (JEFileLoggerSettings *)copyFileLoggerSettings {
+        return;
+    }
     
-    JEFileLoggerSettings *__block settings;
-    dispatch_barrier_sync([self settingsQueue], ^{
+    uint64_t interval = (uint64_t)(flushInterval * NSEC_PER_SEC);
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, [JEDebugging metricsQueue]);
+    dispatch_source_set_timer(timer,
+                              dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval),
+                              interval,
+                              (interval / 10));
+    JEScopeWeak(self);
+    dispatch_source_set_event_handler(timer, ^{
         
-        settings = [[self sharedInstance].fileLoggerSettings copy];
+        JEScopeStrong(self);
+        [self flushMetricsOnMetricsQueue];
     });
-    return settings;
+    dispatch_resume(timer);
+    self.metricsTimer = timer;
 }
 
-+ (void)setFileLoggerSettings:(JEFileLoggerSettings *)fileLoggerSettings {
+- (void)flushMetricsOnMetricsQueue {
     
-    JEAssertParameter(fileLoggerSettings != nil);
+    JEMetricSnapshot *snapshot = [JEMetricSnapshot collectSnapshot];
+    NSDictionary *counterChanges = snapshot.counterChanges;
+    NSDictionary *gauges = snapshot.gauges;
     
-    dispatch_barrier_async([self settingsQueue], ^{
+    JELogLevelMask metricsLogLevel = self.metricsLogLevel;
+    if (metricsLogLevel != JELogLevelNone
+        && ([counterChanges count] > 0 || [gauges count] > 0)) {
         
-        [self sharedInstance].fileLoggerSettings = [fileLoggerSettings copy];
-    });
+        NSDictionary *counters = snapshot.counters;
+        [JEDebugging
+         logLevel:metricsLogLevel
+         location:(JELogLocation){ NULL, NULL, 0 }
+         logMessage:^id{
+             
+             NSMutableString *message = [[NSMutableString alloc] initWithString:@"Metrics:"];
+             __block BOOL isFirstEntry = YES;
+             void (^appendSeparator)(void) = ^{
+                 
+                 [message appendString:(isFirstEntry ? @" " : @", ")];
+                 isFirstEntry = NO;
+             };
+             for (NSString *name in [[counterChanges allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+                 
+                 appendSeparator();
+                 [message appendFormat:@"%@ %+lld (%lld)",
+                  name,
+                  [counterChanges[name] longLongValue],
+                  [counters[name] longLongValue]];
+             }
+             for (NSString *name in [[gauges allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+                 
+                 appendSeparator();
+                 [message appendFormat:@"%@ %g", name, [gauges[name] doubleValue]];
+             }
+             return message;
+         }];
+    }
+    
+    for (id<JEMetricExporter> exporter in self.metricExporters) {
+        
+        [exporter exportMetricSnapshot:snapshot];
+    }
 }
 
-+ (void)setExceptionLoggingEnabled:(BOOL)enabled {
+
+#pragma mark file log records
+
++ (NSArray *)fileLogURLsForReading {
     
-    dispatch_barrier_sync([self settingsQueue], ^{
+    JEFileLoggerSettings *__block fileLoggerSettings;
+    dispatch_barrier_sync([JEDebugging settingsQueue], ^{
         
-        static NSUncaughtExceptionHandler *defaultHandler;
-        if (enabled) {
-            
-            if (defaultHandler != _JEDebuggingUncaughtExceptionHandler) {
-                
-                defaultHandler = NSGetUncaughtExceptionHandler();
-            }
-            
-            NSSetUncaughtExceptionHandler(_JEDebuggingUncaughtExceptionHandler);
-        }
-        else {
+        fileLoggerSettings = [self sharedInstance].fileLoggerSettings;
+    });
+    
+    NSMutableArray *fileURLs = [[NSMutableArray alloc] init];
+    [self flushStagedFileLogRecords];
+    dispatch_barrier_sync([self fileLogQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        [instance flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
+        [instance enumerateFileLogsWithThreadSafeSettings:fileLoggerSettings block:^(NSURL *fileURL, JEFileLogSegment *segment, BOOL *stop) {
             
-            NSSetUncaughtExceptionHandler(defaultHandler);
-        }
+            [fileURLs addObject:fileURL];
+        }];
+    });
+    return fileURLs;
+}
+
++ (JELogLevelMask)levelForTextRecordBulletInString:(NSString *)string {
+    
+    if ([string hasPrefix:[self defaultFatalBulletString]]) {
+        
+        return JELogLevelFatal;
+    }
+    if ([string hasPrefix:[self defaultAlertBulletString]]) {
+        
+        return JELogLevelAlert;
+    }
+    if ([string hasPrefix:[self defaultLogBulletString]]) {
+        
+        return JELogLevelNotice;
+    }
+    if ([string hasPrefix:[self defaultTraceBulletString]]
+        || [string hasPrefix:[self defaultLifeCycleBulletString]]) {
+        
+        return JELogLevelTrace;
+    }
+    return JELogLevelNone;
+}
+
++ (JELogRecord *)logRecordFromTextRecord:(NSData *)data
+                                    date:(NSDate *)date {
+    
+    NSString *string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    if (!string) {
+        
+        return nil;
+    }
+    
+    // Text records are an optional header line ("date [queue] file:line function ") followed by "bullet message", and "\n  dumpBullet dump" for dumps and assertion call stacks.
+    NSString *body = string;
+    NSString *fileName;
+    NSString *functionName;
+    NSUInteger lineNumber = 0;
+    JELogLevelMask level = [self levelForTextRecordBulletInString:string];
+    if (level == JELogLevelNone) {
+        
+        NSRange lineBreakRange = [string rangeOfString:@"\n"];
+        NSString *header = (lineBreakRange.location == NSNotFound
+                            ? string
+                            : [string substringToIndex:lineBreakRange.location]);
+        body = (lineBreakRange.location == NSNotFound
+                ? [NSString string]
+                : [string substringFromIndex:NSMaxRange(lineBreakRange)]);
+        level = [self levelForTextRecordBulletInString:body];
+        
+        NSScanner *scanner = [[NSScanner alloc] initWithString:header];
+        scanner.charactersToBeSkipped = nil;
+        if ([header length] >= 24 && [header characterAtIndex:4] == '-' && [header characterAtIndex:23] == ' ') {
+            
+            scanner.scanLocation = 24;
+        }
+        if ([scanner scanString:@"[" intoString:NULL]) {
+            
+            [scanner scanUpToString:@"] " intoString:NULL];
+            [scanner scanString:@"] " intoString:NULL];
+        }
+        
+        NSString *token;
+        NSUInteger tokenLocation = scanner.scanLocation;
+        if ([scanner scanUpToString:@" " intoString:&token]) {
+            
+            NSRange separatorRange = [token rangeOfString:@":" options:NSBackwardsSearch];
+            NSString *lineNumberString = (separatorRange.location == NSNotFound
+                                          ? nil
+                                          : [token substringFromIndex:NSMaxRange(separatorRange)]);
+            if ([lineNumberString length] > 0
+                && [lineNumberString rangeOfCharacterFromSet:[[NSCharacterSet decimalDigitCharacterSet] invertedSet]].location == NSNotFound) {
+                
+                fileName = [token substringToIndex:separatorRange.location];
+                lineNumber = (NSUInteger)[lineNumberString integerValue];
+                [scanner scanString:@" " intoString:NULL];
+            }
+            else {
+                
+                scanner.scanLocation = tokenLocation;
+            }
+        }
+        
+        NSString *remainder = [[header substringFromIndex:scanner.scanLocation]
+                               stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        if ([remainder length] > 0) {
+            
+            functionName = remainder;
+        }
+    }
+    
+    NSString *message = body;
+    NSRange bulletSeparatorRange = [body rangeOfString:@" "];
+    if (level != JELogLevelNone && bulletSeparatorRange.location != NSNotFound) {
+        
+        message = [body substringFromIndex:NSMaxRange(bulletSeparatorRange)];
+    }
+    
+    NSString *dump;
+    NSRange dumpRange = [message rangeOfString:[NSString stringWithFormat:@"\n  %@ ", [self defaultDumpBulletString]]];
+    if (dumpRange.location != NSNotFound) {
+        
+        dump = [message substringFromIndex:NSMaxRange(dumpRange)];
+        message = [message substringToIndex:dumpRange.location];
+    }
+    
+    return [[JELogRecord alloc]
+            initWithLevel:level
+            date:date
+            fileName:fileName
+            functionName:functionName
+            lineNumber:lineNumber
+            message:message
+            dump:dump
+            callStackReturnAddresses:nil];
+}
+
++ (JELogRecord *)logRecordFromJSONLinesRecord:(NSData *)data
+                                         date:(NSDate *)date {
+    
+    NSDictionary *object = [NSJSONSerialization JSONObjectWithData:data options:kNilOptions error:NULL];
+    if (![object isKindOfClass:[NSDictionary class]]) {
+        
+        return nil;
+    }
+    
+    NSString *(^stringForKey)(NSString *) = ^NSString *(NSString *key) {
+        
+        id value = object[key];
+        return ([value isKindOfClass:[NSString class]] ? value : nil);
+    };
+    
+    JELogLevelMask level = JELogLevelNone;
+    const char *levelName = [stringForKey(@"level") UTF8String];
+    if (levelName) {
+        
+        static const JELogLevelMask levels[] = { JELogLevelTrace, JELogLevelNotice, JELogLevelAlert, JELogLevelFatal };
+        for (size_t index = 0; index < (sizeof(levels) / sizeof(levels[0])); ++index) {
+            
+            if (strcmp(levelName, _JEDebuggingLevelName(levels[index])) == 0) {
+                
+                level = levels[index];
+                break;
+            }
+        }
+    }
+    
+    // Symbolicated call stacks cannot be converted back to return addresses, so they are kept as the dump like in text records.
+    NSString *dump = (stringForKey(@"dump") ?: stringForKey(@"callStack"));
+    id lineNumber = object[@"line"];
+    return [[JELogRecord alloc]
+            initWithLevel:level
+            date:date
+            fileName:stringForKey(@"file")
+            functionName:stringForKey(@"function")
+            lineNumber:([lineNumber isKindOfClass:[NSNumber class]] ? [lineNumber unsignedIntegerValue] : 0)
+            message:(stringForKey(@"message") ?: [NSString string])
+            dump:dump
+            callStackReturnAddresses:nil];
+}
+
++ (NSData *)fileLogRecordFromLogRecord:(JELogRecord *)record
+                                format:(JEFileLogFormat)format {
+    
+    switch (format) {
+            
+        case JEFileLogFormatJSONLines: {
+            
+            NSMutableData *buffer = [[NSMutableData alloc] initWithCapacity:256];
+            JEJSONLineBegin(buffer);
+            JEJSONLineAppendTimestamp(buffer, "timestamp", [record.date timeIntervalSince1970]);
+            JEJSONLineAppendUTF8String(buffer, "level", _JEDebuggingLevelName(record.level));
+            if (record.fileName) {
+                
+                JEJSONLineAppendString(buffer, "file", record.fileName);
+                JEJSONLineAppendInteger(buffer, "line", (long long)record.lineNumber);
+            }
+            if (record.functionName) {
+                
+                JEJSONLineAppendString(buffer, "function", record.functionName);
+            }
+            JEJSONLineAppendString(buffer, "message", record.message);
+            if (record.dump) {
+                
+                JEJSONLineAppendString(buffer, "dump", record.dump);
+            }
+            JEJSONLineEnd(buffer);
+            return buffer;
+        }
+            
+        case JEFileLogFormatText:
+        default: {
+            
+            NSMutableString *string = [[NSMutableString alloc] initWithFormat:
+                                       @"%@ ",
+                                       [[self consoleDateFormatter] stringFromDate:record.date]];
+            if (record.fileName) {
+                
+                [string appendFormat:@"%@:%lu ", record.fileName, (unsigned long)record.lineNumber];
+            }
+            if (record.functionName) {
+                
+                [string appendFormat:@"%@ ", record.functionName];
+            }
+            [string appendFormat:@"\n%@ %@", [self defaultBulletStringForLevel:record.level], record.message];
+            if (record.dump) {
+                
+                [string appendFormat:@"\n  %@ %@", [self defaultDumpBulletString], record.dump];
+            }
+            [string appendString:@"\n\n"];
+            return [string dataUsingEncoding:NSUTF8StringEncoding];
+        }
+    }
+}
+
+
++ (JELogRecord *)logRecordFromFileLogRecord:(NSData *)record
+                                   fileName:(NSString *)fileName
+                                  timestamp:(NSTimeInterval)timestamp
+                              matchingQuery:(JEFileLogQuery *)query {
+    
+    // The date range is checked first so that records outside it are never parsed.
+    if (query && ![query includesTimeIntervalSince1970:timestamp]) {
+        
+        return nil;
+    }
+    
+    NSDate *date = [[NSDate alloc] initWithTimeIntervalSince1970:timestamp];
+    JELogRecord *logRecord = ([[fileName pathExtension] isEqualToString:@"jsonl"]
+                              ? [self logRecordFromJSONLinesRecord:record date:date]
+                              : [self logRecordFromTextRecord:record date:date]);
+    if (!logRecord || (query && ![query matchesRecord:logRecord])) {
+        
+        return nil;
+    }
+    return logRecord;
+}
+
+
+#pragma mark @selector
+
+- (void)applicationWillResignActive:(NSNotification *)note {
+    
+    [JEDebugging flushStagedFileLogRecords];
+    
+    JEFileLoggerSettings *fileLoggerSettings = [JEDebugging copyFileLoggerSettings];
+    dispatch_barrier_async([JEDebugging fileLogQueue], ^{
+        
+        [self flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
+    });
+}
+
+- (void)applicationDidEnterBackground:(NSNotification *)note {
+    
+    if (self.isStarted) {
+        
+        [JEDebugging flushMetrics];
+    }
+    [JEDebugging flushStagedFileLogRecords];
+    
+    JEFileLoggerSettings *fileLoggerSettings = [JEDebugging copyFileLoggerSettings];
+    dispatch_barrier_sync([JEDebugging fileLogQueue], ^{
+    
+        [self flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
+    });
+}
+
+- (void)applicationWillTerminate:(NSNotification *)note {
+    
+    [JEDebugging flushStagedFileLogRecords];
+    
+    JEFileLoggerSettings *fileLoggerSettings = [JEDebugging copyFileLoggerSettings];
+    dispatch_barrier_sync([JEDebugging fileLogQueue], ^{
+        
+        [self flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
+    });
+}
+
+- (void)windowDidBecomeTopmost:(NSNotification *)note {
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        
+        JEHUDLogView *view = self.HUDLogView;
+        if (!view) {
+            
+            return;
+        }
+        
+        if (view.window == [[UIApplication sharedApplication].windows lastObject]) {
+            
+            return;
+        }
+        
+        JEHUDLoggerSettings *__block HUDLoggerSettings;
+        dispatch_barrier_sync([JEDebugging settingsQueue], ^{
+            
+            HUDLoggerSettings = self.HUDLoggerSettings;
+        });
+        
+        [self moveHUDLoggerToTopmostWindowIfNeededWithThreadSafeSettings:HUDLoggerSettings];
+    });
+}
+
+
+#pragma mark - Public
+
+#pragma mark utilities
+
++ (BOOL)isDebugBuild {
+    
+#ifdef DEBUG
+    return YES;
+#else
+    return NO;
+#endif
+}
+
++ (BOOL)isDebuggerAttached {
+    
+#ifdef DEBUG
+    
+    // https://developer.apple.com/library/mac/qa/qa1361/_index.html
+    int mib[4] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+    
+    struct kinfo_proc info = { .kp_proc.p_flag = 0 };
+    size_t infoSize = sizeof(info);
+    if (noErr == sysctl(mib, (sizeof(mib) / sizeof(*mib)), &info, &infoSize, NULL, 0)) {
+        
+        return JEEnumBitmasked(info.kp_proc.p_flag, P_TRACED);
+    }
+    
+    return NO;
+    
+#else
+    
+    return NO;
+    
+#endif
+}
+
+#pragma mark configuring
+
++ (JEConsoleLoggerSettings *)copyConsoleLoggerSettings {
+    
+    JEConsoleLoggerSettings *__block settings;
+    dispatch_barrier_sync([self settingsQueue], ^{
+        
+        settings = [[self sharedInstance].consoleLoggerSettings copy];
+    });
+    return settings;
+}
+
++ (void)setConsoleLoggerSettings:(JEConsoleLoggerSettings *)consoleLoggerSettings {
+    
+    JEAssertParameter(consoleLoggerSettings != nil);
+    
+    dispatch_barrier_async([self settingsQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        instance.consoleLoggerSettings = [consoleLoggerSettings copy];
+        [instance updateCLoggingState];
+    });
+}
+
++ (JEHUDLoggerSettings *)copyHUDLoggerSettings {
+    
+    JEHUDLoggerSettings *__block settings;
+    dispatch_barrier_sync([self settingsQueue], ^{
+        
+        settings = [[self sharedInstance].HUDLoggerSettings copy];
+    });
+    return settings;
+}
+
++ (void)setHUDLoggerSettings:(JEHUDLoggerSettings *)HUDLoggerSettings {
+    
+    JEAssertParameter(HUDLoggerSettings != nil);
+    
+    dispatch_barrier_async([self settingsQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        instance.HUDLoggerSettings = [HUDLoggerSettings copy];
+        [instance updateCLoggingState];
+    });
+}
+
++ (JEFileLoggerSettings *)copyFileLoggerSettings {
+    
+    JEFileLoggerSettings *__block settings;
+    dispatch_barrier_sync([self settingsQueue], ^{
+        
+        settings = [[self sharedInstance].fileLoggerSettings copy];
+    });
+    return settings;
+}
+
++ (void)setFileLoggerSettings:(JEFileLoggerSettings *)fileLoggerSettings {
+    
+    JEAssertParameter(fileLoggerSettings != nil);
+    
+    dispatch_barrier_async([self settingsQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        instance.fileLoggerSettings = [fileLoggerSettings copy];
+        [instance updateCLoggingState];
+    });
+}
+
++ (void)setExceptionLoggingEnabled:(BOOL)enabled {
+    
+    dispatch_barrier_sync([self settingsQueue], ^{
+        
+        static NSUncaughtExceptionHandler *defaultHandler;
+        if (enabled) {
+            
+            if (defaultHandler != _JEDebuggingUncaughtExceptionHandler) {
+                
+                defaultHandler = NSGetUncaughtExceptionHandler();
+            }
+            
+            NSSetUncaughtExceptionHandler(_JEDebuggingUncaughtExceptionHandler);
+        }
+        else {
+            
+            NSSetUncaughtExceptionHandler(defaultHandler);
+        }
     });
 }
 
 + (void)setApplicationLifeCycleLoggingEnabled:(BOOL)enabled {
     
-    JEDebugging *instance = [self sharedInstance];
-    if (enabled) {
+    JEDebugging *instance = [self sharedInstance];
+    if (enabled) {
+        
+        [instance
+         registerForNotificationsWithName:UIApplicationDidEnterBackgroundNotification
+         targetBlock:^(NSNotification *note) {
+             
+             [self logLifeCycleEventWithFormat:@"Application did enter background."];
+         }];
+        [instance
+         registerForNotificationsWithName:UIApplicationWillEnterForegroundNotification
+         targetBlock:^(NSNotification *note) {
+             
+             [self logLifeCycleEventWithFormat:@"Application will enter foreground."];
+         }];
+        [instance
+         registerForNotificationsWithName:UIApplicationDidBecomeActiveNotification
+         targetBlock:^(NSNotification *note) {
+             
+             [self logLifeCycleEventWithFormat:@"Application did become active."];
+         }];
+        [instance
+         registerForNotificationsWithName:UIApplicationWillResignActiveNotification
+         targetBlock:^(NSNotification *note) {
+             
+             [self logLifeCycleEventWithFormat:@"Application will resign active."];
+         }];
+        
+        NSString *(^resourceName)(UIViewController *viewController) = ^NSString *(UIViewController *viewController) {
+            
+#if DEBUG // -[UIStoryboard name] is a private API. Use only when debugging!
+            NSString *storyboardName = ([viewController.storyboard respondsToSelector:@selector(name)]
+                                        ? [viewController.storyboard performSelector:@selector(name)]
+                                        : nil);
+            if (storyboardName) {
+                
+                return [NSString stringWithFormat:@" (%@.storyboard)", storyboardName];
+            }
+#endif
+            
+            NSString *nibName = viewController.nibName;
+            return (nibName
+                    ? [NSString stringWithFormat:@" (%@)", nibName]
+                    : @"");
+        };
+        [instance
+         registerForNotificationsWithName:_JEDebugging_UIViewController_viewDidAppear
+         targetBlock:^(NSNotification *note) {
+             
+             UIViewController *controller = note.object;
+             [self logLifeCycleEventWithFormat:
+              @"%@%@ did appear.",
+              [[controller class] fullyQualifiedClassName], resourceName(controller)];
+         }];
+        [instance
+         registerForNotificationsWithName:_JEDebugging_UIViewController_viewWillDisappear
+         targetBlock:^(NSNotification *note) {
+             
+             UIViewController *controller = note.object;
+             [self logLifeCycleEventWithFormat:
+              @"%@%@ will disappear.",
+              [[controller class] fullyQualifiedClassName], resourceName(controller)];
+         }];
+    }
+    else {
+        
+        [instance unregisterForNotificationsWithName:UIApplicationDidEnterBackgroundNotification];
+        [instance unregisterForNotificationsWithName:UIApplicationWillEnterForegroundNotification];
+        [instance unregisterForNotificationsWithName:UIApplicationDidBecomeActiveNotification];
+        [instance unregisterForNotificationsWithName:UIApplicationWillResignActiveNotification];
+        [instance unregisterForNotificationsWithName:_JEDebugging_UIViewController_viewDidAppear];
+        [instance unregisterForNotificationsWithName:_JEDebugging_UIViewController_viewWillDisappear];
+    }
+}
+
++ (void)start {
+    
+    JEDebugging *instance = [self sharedInstance];
+    if (instance.isStarted) {
+        
+        return;
+    }
+    
+    instance.isStarted = YES;
+    _JEDebuggingCStartDraining();
+    atomic_store(&_JEDebuggingCIsStarted, true);
+    [self invalidateCallsites];
+    
+    [self
+     logLevel:JELogLevelNotice
+     location:(JELogLocation){ NULL, NULL, 0 }
+     format:@"Debugging session started. (%@)", instance.deviceDescription];
+    
+    dispatch_async([self metricsQueue], ^{
+        
+        [instance scheduleMetricsTimer];
+    });
+}
+
+#pragma mark logging
+
++ (void)dumpLevel:(JELogLevelMask)level
+         location:(JELogLocation)location
+            label:(NSString *)label
+            value:(NSValue *)wrappedValue {
+    
+    [self
+     dumpLevel:level
+     callsite:NULL
+     location:location
+     label:label
+     value:wrappedValue];
+}
+
++ (void)dumpLevel:(JELogLevelMask)level
+         callsite:(JELogCallsite *)callsite
+         location:(JELogLocation)location
+            label:(NSString *)label
+            value:(NSValue *)wrappedValue {
+    
+    // Exceptions only describe their call stack as raw addresses. Their symbols are written by the file logger and resolved by subscribers, off the calling thread.
+    NSArray *callStackReturnAddresses = nil;
+    if (wrappedValue && [wrappedValue objCType][0] == _C_ID) {
+        
+        id __unsafe_unretained idValue = nil;
+        [wrappedValue getValue:&idValue];
+        if ([idValue isKindOfClass:[NSException class]]) {
+            
+            callStackReturnAddresses = [(NSException *)idValue callStackReturnAddresses];
+        }
+    }
+    
+    [self
+     dumpLevel:level
+     callsite:callsite
+     location:location
+     label:label
+     valueDescription:^{
+         
+         return (wrappedValue
+                 // Note that because of a bug(?) with NSGetSizeAndAlignment, structs and unions with bitfields cannot be wrapped in NSValue, in which case wrappedValue will be nil.
+                 ? [wrappedValue loggingDescriptionIncludeClass:NO includeAddress:NO]
+                 : @"(?) { ... }");
+     }
+     callStackReturnAddresses:callStackReturnAddresses];
+}
+
++ (void)dumpLevel:(JELogLevelMask)level
+         location:(JELogLocation)location
+            label:(NSString *)label
+ valueDescription:(nonnull id _Nonnull(^__attribute__((noescape)))(void))valueDescription {
+    
+    [self
+     dumpLevel:level
+     callsite:NULL
+     location:location
+     label:label
+     valueDescription:valueDescription
+     callStackReturnAddresses:nil];
+}
+
++ (void)dumpLevel:(JELogLevelMask)level
+         callsite:(JELogCallsite *)callsite
+         location:(JELogLocation)location
+            label:(NSString *)label
+ valueDescription:(id (^__attribute__((noescape)))(void))valueDescription
+callStackReturnAddresses:(NSArray *)callStackReturnAddresses {
+
+    if (![self sharedInstance].isStarted) {
+        
+        return;
+    }
+    
+    @autoreleasepool {
+        
+        uint32_t generation = __atomic_load_n(&_JELogCallsiteGeneration, __ATOMIC_ACQUIRE);
+        JEConsoleLoggerSettings *__block consoleLoggerSettings;
+        JEHUDLoggerSettings *__block HUDLoggerSettings;
+        JEFileLoggerSettings *__block fileLoggerSettings;
+        NSArray *__block subscriptions;
+        dispatch_barrier_sync([self settingsQueue], ^{
+            
+            JEDebugging *instance = [self sharedInstance];
+            consoleLoggerSettings = instance.consoleLoggerSettings;
+            HUDLoggerSettings = instance.HUDLoggerSettings;
+            fileLoggerSettings = instance.fileLoggerSettings;
+            subscriptions = instance.subscriptions;
+        });
+        
+        // Level overrides were matched when the callsite was resolved, so only callsites without a cached state match them here.
+        JELogCallsite callsiteState = _JEDebuggingCallsiteState(callsite,
+                                                                generation,
+                                                                location,
+                                                                consoleLoggerSettings,
+                                                                HUDLoggerSettings,
+                                                                fileLoggerSettings,
+                                                                subscriptions);
+        JELogLevelMask consoleLevelMask = _JEDebuggingCallsiteConsoleLevelMask(callsiteState);
+        JELogLevelMask HUDLevelMask = _JEDebuggingCallsiteHUDLevelMask(callsiteState);
+        JELogLevelMask fileLevelMask = _JEDebuggingCallsiteFileLevelMask(callsiteState);
+        NSArray *matchingSubscriptions = [self
+                                          subscriptions:subscriptions
+                                          matchingLevel:level
+                                          location:location];
+        if (!JEEnumBitmasked(consoleLevelMask, level)
+            && !JEEnumBitmasked(HUDLevelMask, level)
+            && !JEEnumBitmasked(fileLevelMask, level)
+            && !matchingSubscriptions) {
+            
+            return;
+        }
+        
+        NSString *rawDescription = valueDescription();
+        if (matchingSubscriptions) {
+            
+            [self
+             publishRecordToSubscriptions:matchingSubscriptions
+             level:level
+             location:location
+             message:label
+             dump:rawDescription
+             callStackReturnAddresses:callStackReturnAddresses];
+        }
+        
+        NSMutableString *description = [NSMutableString stringWithString:rawDescription];
+        [description indentByLevel:1];
+        
+        _JEDebuggingHeader header = [self
+                                     headerForLocation:location
+                                     withMask:(consoleLoggerSettings.logMessageHeaderMask
+                                               | HUDLoggerSettings.logMessageHeaderMask
+                                               | fileLoggerSettings.logMessageHeaderMask)];
+        NSString *bulletString;
+        if (JEEnumBitmasked(level, JELogLevelFatal)) {
+            
+            bulletString = [self defaultFatalBulletString];
+        }
+        else if (JEEnumBitmasked(level, JELogLevelAlert)) {
+            
+            bulletString = [self defaultAlertBulletString];
+        }
+        else if (JEEnumBitmasked(level, JELogLevelNotice)) {
+            
+            bulletString = [self defaultLogBulletString];
+        }
+        else {
+            
+            bulletString = [self defaultTraceBulletString];
+        }
+        
+        NSUInteger repeatKey = _JEDebuggingRepeatKey(location, rawDescription);
+        NSTimeInterval timestamp = CFAbsoluteTimeGetCurrent();
+        
+        if (JEEnumBitmasked(consoleLevelMask, level)) {
+            
+            dispatch_barrier_sync([self consoleLogQueue], ^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:rawDescription
+                         level:level
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerConsole
+                         withThreadSafeSettings:consoleLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    [self
+                     writeTextRecordToConsoleWithHeader:&header
+                     bulletString:bulletString
+                     message:label
+                     dump:description
+                     withSettings:consoleLoggerSettings];
+                }
+            });
+        }
+        if (JEEnumBitmasked(HUDLevelMask, level)) {
+            
+            [[self HUDLogStager] stageBlock:^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:rawDescription
+                         level:level
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerHUD
+                         withThreadSafeSettings:HUDLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    NSString *logString = [self
+                                           HUDStringWithHeader:&header
+                                           bulletString:bulletString
+                                           message:label
+                                           dump:description
+                                           withSettings:HUDLoggerSettings];
+                    
+                    [[self sharedInstance]
+                     appendStringToHUD:logString
+                     withThreadSafeSettings:HUDLoggerSettings];
+                }
+            } flushImmediately:_JEDebuggingShouldFlushImmediately(level)];
+        }
+        if (JEEnumBitmasked(fileLevelMask, level)) {
+            
+            [[self fileLogStager] stageBlock:^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:rawDescription
+                         level:level
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerFile
+                         withThreadSafeSettings:fileLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    if (fileLoggerSettings.fileLogFormat == JEFileLogFormatJSONLines) {
+                        
+                        [[self sharedInstance]
+                         appendRecordToFileWithLevel:level
+                         header:&header
+                         message:label
+                         dump:rawDescription
+                         callStack:callStackReturnAddresses
+                         withThreadSafeSettings:fileLoggerSettings];
+                    }
+                    else if (callStackReturnAddresses) {
+                        
+                        NSMutableString *callStackString = _JEDebuggingCallStackDescription(callStackReturnAddresses);
+                        [callStackString indentByLevel:1];
+                        
+                        [[self sharedInstance]
+                         appendTextRecordToFileWithHeader:&header
+                         bulletString:bulletString
+                         message:label
+                         dump:[description stringByAppendingFormat:@"\n  callStackSymbols: %@", callStackString]
+                         withThreadSafeSettings:fileLoggerSettings];
+                    }
+                    else {
+                        
+                        [[self sharedInstance]
+                         appendTextRecordToFileWithHeader:&header
+                         bulletString:bulletString
+                         message:label
+                         dump:description
+                         withThreadSafeSettings:fileLoggerSettings];
+                    }
+                }
+            } flushImmediately:_JEDebuggingShouldFlushImmediately(level)];
+        }
+    }
+}
+
++ (void)logLevel:(JELogLevelMask)level
+        location:(JELogLocation)location
+          format:(NSString *)format, ... {
+    
+    va_list arguments;
+    va_start(arguments, format);
+    NSString *logMessage = [[NSString alloc] initWithFormat:format arguments:arguments];
+    va_end(arguments);
+    
+    [self logLevel:level location:location logMessage:^{
+        
+        return logMessage;
+    }];
+}
+
++ (void)logLevel:(JELogLevelMask)level
+        location:(JELogLocation)location
+      logMessage:(nonnull id _Nonnull(^__attribute__((noescape)))(void))logMessage {
+    
+    [self
+     logLevel:level
+     callsite:NULL
+     location:location
+     logMessage:logMessage];
+}
+
++ (void)logLevel:(JELogLevelMask)level
+        callsite:(JELogCallsite *)callsite
+        location:(JELogLocation)location
+      logMessage:(nonnull id _Nonnull(^__attribute__((noescape)))(void))logMessage {
+    
+    [self
+     logLevel:level
+     callsite:callsite
+     location:location
+     date:nil
+     queueLabel:NULL
+     logMessage:logMessage];
+}
+
++ (void)logLevel:(JELogLevelMask)level
+        callsite:(JELogCallsite *)callsite
+        location:(JELogLocation)location
+            date:(NSDate *)loggedDate
+      queueLabel:(const char *)loggedQueueLabel
+      logMessage:(id (^__attribute__((noescape)))(void))logMessage {
+    
+    if (![self sharedInstance].isStarted) {
+        
+        return;
+    }
+    
+    @autoreleasepool {
+        
+        uint32_t generation = __atomic_load_n(&_JELogCallsiteGeneration, __ATOMIC_ACQUIRE);
+        JEConsoleLoggerSettings *__block consoleLoggerSettings;
+        JEHUDLoggerSettings *__block HUDLoggerSettings;
+        JEFileLoggerSettings *__block fileLoggerSettings;
+        NSArray *__block subscriptions;
+        dispatch_barrier_sync([self settingsQueue], ^{
+            
+            JEDebugging *instance = [self sharedInstance];
+            consoleLoggerSettings = instance.consoleLoggerSettings;
+            HUDLoggerSettings = instance.HUDLoggerSettings;
+            fileLoggerSettings = instance.fileLoggerSettings;
+            subscriptions = instance.subscriptions;
+            
+        });
+        
+        // Level overrides were matched when the callsite was resolved, so only callsites without a cached state match them here.
+        JELogCallsite callsiteState = _JEDebuggingCallsiteState(callsite,
+                                                                generation,
+                                                                location,
+                                                                consoleLoggerSettings,
+                                                                HUDLoggerSettings,
+                                                                fileLoggerSettings,
+                                                                subscriptions);
+        JELogLevelMask consoleLevelMask = _JEDebuggingCallsiteConsoleLevelMask(callsiteState);
+        JELogLevelMask HUDLevelMask = _JEDebuggingCallsiteHUDLevelMask(callsiteState);
+        JELogLevelMask fileLevelMask = _JEDebuggingCallsiteFileLevelMask(callsiteState);
+        NSArray *matchingSubscriptions = [self
+                                          subscriptions:subscriptions
+                                          matchingLevel:level
+                                          location:location];
+        if (!JEEnumBitmasked(consoleLevelMask, level)
+            && !JEEnumBitmasked(HUDLevelMask, level)
+            && !JEEnumBitmasked(fileLevelMask, level)
+            && !matchingSubscriptions) {
+            
+            return;
+        }
+        
+        NSString *formattedString = logMessage();
+        if (matchingSubscriptions) {
+            
+            [self
+             publishRecordToSubscriptions:matchingSubscriptions
+             level:level
+             location:location
+             message:formattedString
+             dump:nil
+             callStackReturnAddresses:nil];
+        }
+        
+        NSTimeInterval timestamp = (loggedDate
+                                    ? [loggedDate timeIntervalSinceReferenceDate]
+                                    : CFAbsoluteTimeGetCurrent());
+        _JEDebuggingHeader header = [self
+                                     headerForLocation:location
+                                     timestamp:timestamp
+                                     queueLabel:loggedQueueLabel
+                                     withMask:(consoleLoggerSettings.logMessageHeaderMask
+                                               | HUDLoggerSettings.logMessageHeaderMask
+                                               | fileLoggerSettings.logMessageHeaderMask)];
+        NSString *bulletString = [self defaultBulletStringForLevel:level];
+        NSUInteger repeatKey = _JEDebuggingRepeatKey(location, formattedString);
+        
+        if (JEEnumBitmasked(consoleLevelMask, level)) {
+            
+            dispatch_barrier_sync([self consoleLogQueue], ^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:formattedString
+                         level:level
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerConsole
+                         withThreadSafeSettings:consoleLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    [self
+                     writeTextRecordToConsoleWithHeader:&header
+                     bulletString:bulletString
+                     message:formattedString
+                     dump:nil
+                     withSettings:consoleLoggerSettings];
+                }
+            });
+        }
+        
+        // Staged as records instead of blocks so that messages bound for the HUD and file loggers are handed off without allocating.
+        if (JEEnumBitmasked(HUDLevelMask, level)) {
+            
+            _JEDebuggingStagedRecord record = {
+                
+                .level = level,
+                .repeatKey = repeatKey,
+                .timestamp = timestamp,
+                .message = (__bridge_retained CFTypeRef)formattedString,
+                .loggerSettings = (__bridge_retained CFTypeRef)HUDLoggerSettings,
+                .header = header
+            };
+            [[self HUDLogStager]
+             stageRecord:&record
+             length:sizeof(record)
+             handler:_JEDebuggingOutputStagedRecordToHUD
+             flushImmediately:_JEDebuggingShouldFlushImmediately(level)];
+        }
+        if (JEEnumBitmasked(fileLevelMask, level)) {
+            
+            _JEDebuggingStagedRecord record = {
+                
+                .level = level,
+                .repeatKey = repeatKey,
+                .timestamp = timestamp,
+                .message = (__bridge_retained CFTypeRef)formattedString,
+                .loggerSettings = (__bridge_retained CFTypeRef)fileLoggerSettings,
+                .header = header
+            };
+            [[self fileLogStager]
+             stageRecord:&record
+             length:sizeof(record)
+             handler:_JEDebuggingOutputStagedRecordToFile
+             flushImmediately:_JEDebuggingShouldFlushImmediately(level)];
+        }
+    }
+}
+
++ (void)logFailureInAssertionCondition:(NSString *)conditionString
+                              location:(JELogLocation)location {
+ 
+    [self
+     logFailureInAssertionWithMessage:
+     [[NSString alloc] initWithFormat:@"Assertion failed for condition: (%@)", conditionString]
+     location:location];
+}
+
++ (void)logFailureInAssertionWithMessage:(NSString *)failureMessage
+                                location:(JELogLocation)location {
+    
+    if (![self sharedInstance].isStarted) {
+        
+        return;
+    }
+    
+    @autoreleasepool {
+        
+        JEConsoleLoggerSettings *__block consoleLoggerSettings;
+        JEHUDLoggerSettings *__block HUDLoggerSettings;
+        JEFileLoggerSettings *__block fileLoggerSettings;
+        NSArray *__block subscriptions;
+        dispatch_barrier_sync([self settingsQueue], ^{
+            
+            JEDebugging *instance = [self sharedInstance];
+            consoleLoggerSettings = instance.consoleLoggerSettings;
+            HUDLoggerSettings = instance.HUDLoggerSettings;
+            fileLoggerSettings = instance.fileLoggerSettings;
+            subscriptions = instance.subscriptions;
+            
+        });
+        
+        JELogLevelMask consoleLevelMask = [consoleLoggerSettings
+                                           logLevelMaskForFileName:location.fileName
+                                           functionName:location.functionName];
+        JELogLevelMask HUDLevelMask = [HUDLoggerSettings
+                                       logLevelMaskForFileName:location.fileName
+                                       functionName:location.functionName];
+        JELogLevelMask fileLevelMask = [fileLoggerSettings
+                                        logLevelMaskForFileName:location.fileName
+                                        functionName:location.functionName];
+        NSArray *matchingSubscriptions = [self
+                                          subscriptions:subscriptions
+                                          matchingLevel:JELogLevelAlert
+                                          location:location];
+        if (!JEEnumBitmasked(consoleLevelMask, JELogLevelAlert)
+            && !JEEnumBitmasked(HUDLevelMask, JELogLevelAlert)
+            && !JEEnumBitmasked(fileLevelMask, JELogLevelAlert)
+            && !matchingSubscriptions) {
+            
+            return;
+        }
+        
+        // Only raw return addresses are captured on the failing thread. Symbolication happens on the file log queue or when a subscriber asks the record for its symbols.
+        NSArray *callStackReturnAddresses = JECallStackCaptureReturnAddresses(1);
+        
+        if (matchingSubscriptions) {
+            
+            [self
+             publishRecordToSubscriptions:matchingSubscriptions
+             level:JELogLevelAlert
+             location:location
+             message:failureMessage
+             dump:nil
+             callStackReturnAddresses:callStackReturnAddresses];
+        }
+        
+        _JEDebuggingHeader header = [self
+                                     headerForLocation:location
+                                     withMask:(consoleLoggerSettings.logMessageHeaderMask
+                                               | HUDLoggerSettings.logMessageHeaderMask
+                                               | fileLoggerSettings.logMessageHeaderMask)];
+        NSString *bulletString = [self defaultAssertBulletString];
+        
+        NSUInteger repeatKey = _JEDebuggingRepeatKey(location, failureMessage);
+        NSTimeInterval timestamp = CFAbsoluteTimeGetCurrent();
+        
+        if (JEEnumBitmasked(consoleLevelMask, JELogLevelAlert)) {
+            
+            dispatch_barrier_sync([self consoleLogQueue], ^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:failureMessage
+                         level:JELogLevelAlert
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerConsole
+                         withThreadSafeSettings:consoleLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    [self
+                     writeTextRecordToConsoleWithHeader:&header
+                     bulletString:bulletString
+                     message:failureMessage
+                     dump:nil
+                     withSettings:consoleLoggerSettings];
+                    
+                }
+            });
+        }
+        if (JEEnumBitmasked(HUDLevelMask, JELogLevelAlert)) {
+            
+            [[self HUDLogStager] stageBlock:^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:failureMessage
+                         level:JELogLevelAlert
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerHUD
+                         withThreadSafeSettings:HUDLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    NSString *logString = [self
+                                           HUDStringWithHeader:&header
+                                           bulletString:bulletString
+                                           message:failureMessage
+                                           dump:nil
+                                           withSettings:HUDLoggerSettings];
+                    
+                    [[self sharedInstance]
+                     appendStringToHUD:logString
+                     withThreadSafeSettings:HUDLoggerSettings];
+                }
+            } flushImmediately:YES];
+        }
+        if (JEEnumBitmasked(fileLevelMask, JELogLevelAlert)) {
+            
+            [[self fileLogStager] stageBlock:^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:failureMessage
+                         level:JELogLevelAlert
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerFile
+                         withThreadSafeSettings:fileLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    if (fileLoggerSettings.fileLogFormat == JEFileLogFormatJSONLines) {
+                        
+                        [[self sharedInstance]
+                         appendRecordToFileWithLevel:JELogLevelAlert
+                         header:&header
+                         message:failureMessage
+                         dump:nil
+                         callStack:callStackReturnAddresses
+                         withThreadSafeSettings:fileLoggerSettings];
+                    }
+                    else {
+                        
+                        NSMutableString *callStackString = _JEDebuggingCallStackDescription(callStackReturnAddresses);
+                        [callStackString indentByLevel:1];
+                        
+                        [[self sharedInstance]
+                         appendTextRecordToFileWithHeader:&header
+                         bulletString:bulletString
+                         message:failureMessage
+                         dump:callStackString
+                         withThreadSafeSettings:fileLoggerSettings];
+                    }
+                }
+            } flushImmediately:YES];
+        }
+    }
+}
+
++ (void)logLifeCycleEventWithFormat:(NSString *)format, ... {
+    
+    va_list arguments;
+    va_start(arguments, format);
+    [self logLifeCycleEventWithFormat:format arguments:arguments];
+    va_end(arguments);
+}
+
++ (void)logLifeCycleEventWithFormat:(NSString *)format arguments:(va_list)arguments {
+    
+    if (![self sharedInstance].isStarted) {
+        
+        return;
+    }
+    
+    @autoreleasepool {
+        
+        JEConsoleLoggerSettings *__block consoleLoggerSettings;
+        JEHUDLoggerSettings *__block HUDLoggerSettings;
+        JEFileLoggerSettings *__block fileLoggerSettings;
+        NSArray *__block subscriptions;
+        dispatch_barrier_sync([self settingsQueue], ^{
+            
+            JEDebugging *instance = [self sharedInstance];
+            consoleLoggerSettings = instance.consoleLoggerSettings;
+            HUDLoggerSettings = instance.HUDLoggerSettings;
+            fileLoggerSettings = instance.fileLoggerSettings;
+            subscriptions = instance.subscriptions;
+            
+        });
+        
+        // Lifecycle messages are logged without a location, but level overrides can still match this method.
+        JELogLocation overrideLocation = JELogLocationCurrent();
+        JELogLevelMask consoleLevelMask = [consoleLoggerSettings
+                                           logLevelMaskForFileName:overrideLocation.fileName
+                                           functionName:overrideLocation.functionName];
+        JELogLevelMask HUDLevelMask = [HUDLoggerSettings
+                                       logLevelMaskForFileName:overrideLocation.fileName
+                                       functionName:overrideLocation.functionName];
+        JELogLevelMask fileLevelMask = [fileLoggerSettings
+                                        logLevelMaskForFileName:overrideLocation.fileName
+                                        functionName:overrideLocation.functionName];
+        NSArray *matchingSubscriptions = [self
+                                          subscriptions:subscriptions
+                                          matchingLevel:JELogLevelTrace
+                                          location:(JELogLocation){ NULL, NULL, 0 }];
+        if (!JEEnumBitmasked(consoleLevelMask, JELogLevelTrace)
+            && !JEEnumBitmasked(HUDLevelMask, JELogLevelTrace)
+            && !JEEnumBitmasked(fileLevelMask, JELogLevelTrace)
+            && !matchingSubscriptions) {
+            
+            return;
+        }
+        
+        NSString *formattedString = [[NSString alloc] initWithFormat:format arguments:arguments];
+        if (matchingSubscriptions) {
+            
+            [self
+             publishRecordToSubscriptions:matchingSubscriptions
+             level:JELogLevelTrace
+             location:(JELogLocation){ NULL, NULL, 0 }
+             message:formattedString
+             dump:nil
+             callStackReturnAddresses:nil];
+        }
+        
+        _JEDebuggingHeader header = [self
+                                     headerForLocation:(JELogLocation){ NULL, NULL, 0 }
+                                     withMask:JELogMessageHeaderNone];
+        NSString *bulletString = [self defaultLifeCycleBulletString];
+        
+        NSUInteger repeatKey = _JEDebuggingRepeatKey((JELogLocation){ NULL, NULL, 0 }, formattedString);
+        NSTimeInterval timestamp = CFAbsoluteTimeGetCurrent();
+        
+        if (JEEnumBitmasked(consoleLevelMask, JELogLevelTrace)) {
+            
+            dispatch_barrier_sync([self consoleLogQueue], ^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:formattedString
+                         level:JELogLevelTrace
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerConsole
+                         withThreadSafeSettings:consoleLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    [self
+                     writeTextRecordToConsoleWithHeader:&header
+                     bulletString:bulletString
+                     message:formattedString
+                     dump:nil
+                     withSettings:consoleLoggerSettings];
+                }
+            });
+        }
+        if (JEEnumBitmasked(HUDLevelMask, JELogLevelTrace)) {
+            
+            [[self HUDLogStager] stageBlock:^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:formattedString
+                         level:JELogLevelTrace
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerHUD
+                         withThreadSafeSettings:HUDLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    NSString *logString = [self
+                                           HUDStringWithHeader:&header
+                                           bulletString:bulletString
+                                           message:formattedString
+                                           dump:nil
+                                           withSettings:HUDLoggerSettings];
+                    
+                    [[self sharedInstance]
+                     appendStringToHUD:logString
+                     withThreadSafeSettings:HUDLoggerSettings];
+                }
+            } flushImmediately:NO];
+        }
+        if (JEEnumBitmasked(fileLevelMask, JELogLevelTrace)) {
+            
+            [[self fileLogStager] stageBlock:^{
+                
+                @autoreleasepool {
+                    
+                    if ([[self sharedInstance]
+                         suppressRepeatedMessageWithKey:repeatKey
+                         message:formattedString
+                         level:JELogLevelTrace
+                         bulletString:bulletString
+                         timestamp:timestamp
+                         logger:_JEDebuggingLoggerFile
+                         withThreadSafeSettings:fileLoggerSettings]) {
+                        
+                        return;
+                    }
+                    
+                    if (fileLoggerSettings.fileLogFormat == JEFileLogFormatJSONLines) {
+                        
+                        [[self sharedInstance]
+                         appendRecordToFileWithLevel:JELogLevelTrace
+                         header:&header
+                         message:formattedString
+                         dump:nil
+                         callStack:nil
+                         withThreadSafeSettings:fileLoggerSettings];
+                    }
+                    else {
+                        
+                        [[self sharedInstance]
+                         appendTextRecordToFileWithHeader:&header
+                         bulletString:bulletString
+                         message:formattedString
+                         dump:nil
+                         withThreadSafeSettings:fileLoggerSettings];
+                    }
+                }
+            } flushImmediately:NO];
+        }
+    }
+}
+
+#pragma mark retrieving
+
++ (void)enumerateFileLogDataWithBlock:(void (^)(NSString *fileName, NSData *data, BOOL *stop))block {
+    
+    JEAssert(block != NULL, @"Enumeration block was NULL.");
+    
+    JEFileLoggerSettings *__block fileLoggerSettings;
+    dispatch_barrier_sync([JEDebugging settingsQueue], ^{
+        
+        fileLoggerSettings = [self sharedInstance].fileLoggerSettings;
+    });
+    
+    [self flushStagedFileLogRecords];
+    dispatch_barrier_sync([self fileLogQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        [instance flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
+        [instance enumerateFileLogsWithThreadSafeSettings:fileLoggerSettings block:^(NSURL *fileURL, JEFileLogSegment *segment, BOOL *stop) {
+            
+            NSData *data = [[NSData alloc]
+                            initWithContentsOfURL:fileURL
+                            options:kNilOptions
+                            error:NULL];
+            if (!data) {
+                
+                return;
+            }
+            
+            BOOL shouldStop = NO;
+            block([fileURL lastPathComponent], data, &shouldStop);
+            if (shouldStop) {
+                
+                (*stop) = YES;
+            }
+        }];
+    });
+}
+
++ (void)enumerateFileLogURLsWithBlock:(void (^)(NSURL *fileURL, BOOL *stop))block {
+    
+    JEAssert(block != NULL, @"Enumeration block was NULL.");
+    
+    JEFileLoggerSettings *__block fileLoggerSettings;
+    dispatch_barrier_sync([JEDebugging settingsQueue], ^{
+        
+        fileLoggerSettings = [self sharedInstance].fileLoggerSettings;
+    });
+    
+    [self flushStagedFileLogRecords];
+    dispatch_barrier_sync([self fileLogQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        [instance flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
+        [instance enumerateFileLogsWithThreadSafeSettings:fileLoggerSettings block:^(NSURL *fileURL, JEFileLogSegment *segment, BOOL *stop) {
+            
+            BOOL shouldStop = NO;
+            block(fileURL, &shouldStop);
+            if (shouldStop) {
+                
+                (*stop) = YES;
+            }
+        }];
+    });
+}
+
++ (void)enumerateFileLogRecordsWithBlock:(void (^)(NSString *fileName, NSDate *date, NSData *record, BOOL *stop))block {
+    
+    JEAssert(block != NULL, @"Enumeration block was NULL.");
+    
+    // Reading happens outside the file log queue so logging is not blocked while the files are merged.
+    JEFileLogReader *reader = [[JEFileLogReader alloc] initWithFileURLs:[self fileLogURLsForReading]];
+    [reader enumerateRecordsWithBlock:^(NSString *fileName, NSTimeInterval timestamp, NSData *record, BOOL *stop) {
+        
+        block(fileName, [[NSDate alloc] initWithTimeIntervalSince1970:timestamp], record, stop);
+    }];
+}
+
++ (void)enumerateFileLogRecordsAtURLs:(NSArray *)fileURLs
+                        matchingQuery:(JEFileLogQuery *)query
+                            withBlock:(void (^)(JELogRecord *record, BOOL *stop))block {
+    
+    JEAssert(block != NULL, @"Enumeration block was NULL.");
+    
+    JEFileLogQuery *threadSafeQuery = [query copy];
+    JEFileLogReader *reader = [[JEFileLogReader alloc] initWithFileURLs:(fileURLs ?: [self fileLogURLsForReading])];
+    [reader
+     enumerateRecordsWithTransform:^id(NSString *fileName, NSTimeInterval timestamp, NSData *record) {
+         
+         return [self
+                 logRecordFromFileLogRecord:record
+                 fileName:fileName
+                 timestamp:timestamp
+                 matchingQuery:threadSafeQuery];
+     }
+     usingBlock:^(NSString *fileName, NSTimeInterval timestamp, id object, BOOL *stop) {
+         
+         block(object, stop);
+     }];
+}
+
++ (BOOL)exportFileLogRecordsAtURLs:(NSArray *)fileURLs
+                     matchingQuery:(JEFileLogQuery *)query
+                             toURL:(NSURL *)exportFileURL
+                            format:(JEFileLogFormat)format
+                             error:(NSError **)error {
+    
+    JEAssertParameter(exportFileURL != nil);
+    
+    NSOutputStream *stream = [[NSOutputStream alloc] initWithURL:exportFileURL append:NO];
+    [stream open];
+    if ([stream streamStatus] != NSStreamStatusOpen) {
+        
+        if (error) {
+            
+            (*error) = [stream streamError];
+        }
+        [stream close];
+        return NO;
+    }
+    
+    JEFileLogQuery *threadSafeQuery = [query copy];
+    JEFileLogReader *reader = [[JEFileLogReader alloc] initWithFileURLs:(fileURLs ?: [self fileLogURLsForReading])];
+    BOOL __block succeeded = YES;
+    [reader
+     enumerateRecordsWithTransform:^id(NSString *fileName, NSTimeInterval timestamp, NSData *record) {
+         
+         BOOL isJSONLines = [[fileName pathExtension] isEqualToString:@"jsonl"];
+         BOOL isInExportFormat = (isJSONLines == (format == JEFileLogFormatJSONLines));
+         JELogRecord *logRecord;
+         if (threadSafeQuery || !isInExportFormat) {
+             
+             logRecord = [self
+                          logRecordFromFileLogRecord:record
+                          fileName:fileName
+                          timestamp:timestamp
+                          matchingQuery:threadSafeQuery];
+             if (!logRecord) {
+                 
+                 return nil;
+             }
+         }
+         if (isInExportFormat) {
+             
+             // Records already in the export format are copied as is so that entries without a JELogRecord equivalent, such as queue labels, are kept.
+             NSMutableData *data = [record mutableCopy];
+             [data appendBytes:(isJSONLines ? "\n" : "\n\n") length:(isJSONLines ? 1 : 2)];
+             return data;
+         }
+         return [self fileLogRecordFromLogRecord:logRecord format:format];
+     }
+     usingBlock:^(NSString *fileName, NSTimeInterval timestamp, id object, BOOL *stop) {
+         
+         NSData *data = object;
+         const uint8_t *bytes = (const uint8_t *)[data bytes];
+         NSUInteger remainingLength = [data length];
+         while (remainingLength > 0) {
+             
+             NSInteger writtenLength = [stream write:bytes maxLength:remainingLength];
+             if (writtenLength <= 0) {
+                 
+                 succeeded = NO;
+                 (*stop) = YES;
+                 return;
+             }
+             bytes += writtenLength;
+             remainingLength -= (NSUInteger)writtenLength;
+         }
+     }];
+    
+    if (!succeeded && error) {
+        
+        (*error) = [stream streamError];
+    }
+    [stream close];
+    return succeeded;
+}
+
+
+#pragma mark subscribing
+
++ (JELogSubscription *)subscribeWithFilter:(JELogFilter *)filter
+                                     queue:(dispatch_queue_t)queue
+                                   handler:(void (^)(NSArray *records, NSUInteger numberOfDroppedRecords))handler {
+    
+    JEAssertParameter(queue != NULL);
+    JEAssertParameter(handler != NULL);
+    
+    JELogSubscription *subscription = [[JELogSubscription alloc]
+                                       initWithFilter:(filter ?: [[JELogFilter alloc] init])
+                                       queue:queue
+                                       handler:handler];
+    dispatch_barrier_async([self settingsQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        instance.subscriptions = [(instance.subscriptions ?: @[]) arrayByAddingObject:subscription];
+        [instance updateCLoggingState];
+    });
+    return subscription;
+}
+
++ (void)unsubscribe:(JELogSubscription *)subscription {
+    
+    JEAssertParameter(subscription != nil);
+    
+    [subscription cancel];
+    dispatch_barrier_async([self settingsQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        NSMutableArray *subscriptions = [instance.subscriptions mutableCopy];
+        [subscriptions removeObjectIdenticalTo:subscription];
+        instance.subscriptions = subscriptions;
+        [instance updateCLoggingState];
+    });
+}
+
+
+#pragma mark metrics
+
++ (void)setMetricsFlushInterval:(NSTimeInterval)flushInterval {
+    
+    JEAssertParameter(flushInterval >= 0);
+    
+    dispatch_async([self metricsQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        instance.metricsFlushInterval = flushInterval;
+        [instance scheduleMetricsTimer];
+    });
+}
+
++ (void)setMetricsLogLevel:(JELogLevelMask)level {
+    
+    dispatch_async([self metricsQueue], ^{
+        
+        [self sharedInstance].metricsLogLevel = level;
+    });
+}
+
++ (void)addMetricExporter:(id<JEMetricExporter>)exporter {
+    
+    JEAssertParameter(exporter != nil);
+    
+    dispatch_async([self metricsQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        instance.metricExporters = [(instance.metricExporters ?: @[]) arrayByAddingObject:exporter];
+    });
+}
+
++ (void)removeMetricExporter:(id<JEMetricExporter>)exporter {
+    
+    JEAssertParameter(exporter != nil);
+    
+    dispatch_async([self metricsQueue], ^{
+        
+        JEDebugging *instance = [self sharedInstance];
+        NSMutableArray *metricExporters = [instance.metricExporters mutableCopy];
+        [metricExporters removeObjectIdenticalTo:exporter];
+        instance.metricExporters = metricExporters;
+    });
+}
+
++ (void)flushMetrics {
+    
+    dispatch_sync([self metricsQueue], ^{
+        
+        [[self sharedInstance] flushMetricsOnMetricsQueue];
+    });
+}
+
+
+@end
+
+
+#pragma mark - Staged records
+
+JE_STATIC
+void _JEDebuggingOutputStagedRecordToHUD(void *context) {
+    
+    _JEDebuggingStagedRecord *record = context;
+    @autoreleasepool {
+        
+        NSString *message = (__bridge_transfer NSString *)record->message;
+        JEHUDLoggerSettings *HUDLoggerSettings = (__bridge_transfer JEHUDLoggerSettings *)record->loggerSettings;
+        NSString *bulletString = [JEDebugging defaultBulletStringForLevel:record->level];
+        
+        JEDebugging *instance = [JEDebugging sharedInstance];
+        if ([instance
+             suppressRepeatedMessageWithKey:record->repeatKey
+             message:message
+             level:record->level
+             bulletString:bulletString
+             timestamp:record->timestamp
+             logger:_JEDebuggingLoggerHUD
+             withThreadSafeSettings:HUDLoggerSettings]) {
+            
+            return;
+        }
+        
+        NSString *logString = [JEDebugging
+                               HUDStringWithHeader:&record->header
+                               bulletString:bulletString
+                               message:message
+                               dump:nil
+                               withSettings:HUDLoggerSettings];
         
         [instance
-         registerForNotificationsWithName:UIApplicationDidEnterBackgroundNotification
-         targetBlock:^(NSNotification *note) {
-             
-             [self logLifeCycleEventWithFormat:@"Application did enter background."];
-         }];
-        [instance
-         registerForNotificationsWithName:UIApplicationWillEnterForegroundNotification
-         targetBlock:^(NSNotification *note) {
-             
-             [self logLifeCycleEventWithFormat:@"Application will enter foreground."];
-         }];
-        [instance
-         registerForNotificationsWithName:UIApplicationDidBecomeActiveNotification
-         targetBlock:^(NSNotification *note) {
-             
-             [self logLifeCycleEventWithFormat:@"Application did become active."];
-         }];
-        [instance
-         registerForNotificationsWithName:UIApplicationWillResignActiveNotification
-         targetBlock:^(NSNotification *note) {
-             
-             [self logLifeCycleEventWithFormat:@"Application will resign active."];
-         }];
+         appendStringToHUD:logString
+         withThreadSafeSettings:HUDLoggerSettings];
+    }
+}
+
+JE_STATIC
+void _JEDebuggingOutputStagedRecordToFile(void *context) {
+    
+    _JEDebuggingStagedRecord *record = context;
+    @autoreleasepool {
         
-        NSString *(^resourceName)(UIViewController *viewController) = ^NSString *(UIViewController *viewController) {
+        NSString *message = (__bridge_transfer NSString *)record->message;
+        JEFileLoggerSettings *fileLoggerSettings = (__bridge_transfer JEFileLoggerSettings *)record->loggerSettings;
+        NSString *bulletString = [JEDebugging defaultBulletStringForLevel:record->level];
+        
+        JEDebugging *instance = [JEDebugging sharedInstance];
+        if ([instance
+             suppressRepeatedMessageWithKey:record->repeatKey
+             message:message
+             level:record->level
+             bulletString:bulletString
+             timestamp:record->timestamp
+             logger:_JEDebuggingLoggerFile
+             withThreadSafeSettings:fileLoggerSettings]) {
             
-#if DEBUG // -[UIStoryboard name] is a private API. Use only when debugging!
-            NSString *storyboardName = ([viewController.storyboard respondsToSelector:@selector(name)]
-                                        ? [viewController.storyboard performSelector:@selector(name)]
-                                        : nil);
-            if (storyboardName) {
-                
-                return [NSString stringWithFormat:@" (%@.storyboard)", storyboardName];
-            }
-#endif
+            return;
+        }
+        
+        if (fileLoggerSettings.fileLogFormat == JEFileLogFormatJSONLines) {
             
-            NSString *nibName = viewController.nibName;
-            return (nibName
-                    ? [NSString stringWithFormat:@" (%@)", nibName]
-                    : @"");
-        };
-        [instance
-         registerForNotificationsWithName:_JEDebugging_UIViewController_viewDidAppear
-         targetBlock:^(NSNotification *note) {
-             
-             UIViewController *controller = note.object;
-             [self logLifeCycleEventWithFormat:
-              @"%@%@ did appear.",
-              [[controller class] fullyQualifiedClassName], resourceName(controller)];
-         }];
-        [instance
-         registerForNotificationsWithName:_JEDebugging_UIViewController_viewWillDisappear
-         targetBlock:^(NSNotification *note) {
-             
-             UIViewController *controller = note.object;
-             [self logLifeCycleEventWithFormat:
-              @"%@%@ will disappear.",
-              [[controller class] fullyQualifiedClassName], resourceName(controller)];
-         }];
+            [instance
+             appendRecordToFileWithLevel:record->level
+             header:&record->header
+             message:message
+             dump:nil
+             callStack:nil
+             withThreadSafeSettings:fileLoggerSettings];
+        }
+        else {
+            
+            [instance
+             appendTextRecordToFileWithHeader:&record->header
+             bulletString:bulletString
+             message:message
+             dump:nil
+             withThreadSafeSettings:fileLoggerSettings];
+        }
     }
-    else {
+}
+
+
+#pragma mark - JELogC
+
+JE_STATIC
+const char *_JEDebuggingCBulletString(JELogLevelMask level) {
+    
+    // Same as the default bullet strings, as UTF-8 literals so the console path needs no NSString.
+    if (JEEnumBitmasked(level, JELogLevelFatal)) {
         
-        [instance unregisterForNotificationsWithName:UIApplicationDidEnterBackgroundNotification];
-        [instance unregisterForNotificationsWithName:UIApplicationWillEnterForegroundNotification];
-        [instance unregisterForNotificationsWithName:UIApplicationDidBecomeActiveNotification];
-        [instance unregisterForNotificationsWithName:UIApplicationWillResignActiveNotification];
-        [instance unregisterForNotificationsWithName:_JEDebugging_UIViewController_viewDidAppear];
-        [instance unregisterForNotificationsWithName:_JEDebugging_UIViewController_viewWillDisappear];
+        return "\xE2\x9D\x97";
+    }
+    if (JEEnumBitmasked(level, JELogLevelAlert)) {
+        
+        return "\xE2\x9A\xA0\xEF\xB8\x8F";
+    }
+    if (JEEnumBitmasked(level, JELogLevelNotice)) {
+        
+        return "\xF0\x9F\x94\xB8";
     }
+    return "\xF0\x9F\x94\xB9";
 }
 
-+ (void)start {
+JE_STATIC
+size_t _JEDebuggingCAppend(char *buffer, size_t capacity, size_t length, const char *format, ...) {
     
-    JEDebugging *instance = [self sharedInstance];
-    if (instance.isStarted) {
+    if (length >= capacity) {
         
-        return;
+        return length;
     }
     
-    instance.isStarted = YES;
+    va_list arguments;
+    va_start(arguments, format);
+    int written = vsnprintf(buffer + length, capacity - length, format, arguments);
+    va_end(arguments);
     
-    [self
-     logLevel:JELogLevelNotice
-     location:(JELogLocation){ NULL, NULL, 0 }
-     format:@"Debugging session started. (%@)", instance.deviceDescription];
+    if (written < 0) {
+        
+        return length;
+    }
+    return MIN(length + (size_t)written, capacity - 1);
 }
 
-#pragma mark logging
-
-+ (void)dumpLevel:(JELogLevelMask)level
-         location:(JELogLocation)location
-            label:(NSString *)label
-            value:(NSValue *)wrappedValue {
+JE_STATIC
+void _JEDebuggingCReleaseEntry(_JEDebuggingCEntry *entry) {
     
-    [self
-     dumpLevel:level
-     location:location
-     label:label
-     valueDescription:^{
-         
-         return (wrappedValue
-                 // Note that because of a bug(?) with NSGetSizeAndAlignment, structs and unions with bitfields cannot be wrapped in NSValue, in which case wrappedValue will be nil.
-                 ? [wrappedValue loggingDescriptionIncludeClass:NO includeAddress:NO]
-                 : @"(?) { ... }");
-     }];
+    if (atomic_fetch_sub_explicit(&entry->retainCount, 1, memory_order_acq_rel) == 1) {
+        
+        free(entry);
+    }
 }
 
-+ (void)dumpLevel:(JELogLevelMask)level
-         location:(JELogLocation)location
-            label:(NSString *)label
- valueDescription:(nonnull id _Nonnull(^__attribute__((noescape)))(void))valueDescription {
+JE_STATIC
+_JEDebuggingHeader _JEDebuggingCHeader(_JEDebuggingCEntry *entry, JELogMessageHeaderMask logMessageHeaderMask) {
+    
+    return [JEDebugging
+            headerForLocation:(JELogLocation){ entry->fileName, entry->functionName, entry->lineNumber }
+            timestamp:entry->timestamp
+            queueLabel:entry->queueLabel
+            withMask:logMessageHeaderMask];
+}
 
-    if (![self sharedInstance].isStarted) {
-        
-        return;
-    }
+JE_STATIC
+void _JEDebuggingCOutputToHUD(void *context) {
     
+    _JEDebuggingCEntry *entry = context;
     @autoreleasepool {
         
-        JEConsoleLoggerSettings *__block consoleLoggerSettings;
         JEHUDLoggerSettings *__block HUDLoggerSettings;
-        JEFileLoggerSettings *__block fileLoggerSettings;
-        dispatch_barrier_sync([self settingsQueue], ^{
+        dispatch_barrier_sync([JEDebugging settingsQueue], ^{
             
-            JEDebugging *instance = [self sharedInstance];
-            consoleLoggerSettings = instance.consoleLoggerSettings;
-            HUDLoggerSettings = instance.HUDLoggerSettings;
-            fileLoggerSettings = instance.fileLoggerSettings;
+            HUDLoggerSettings = [JEDebugging sharedInstance].HUDLoggerSettings;
         });
         
-        if (!JEEnumBitmasked(consoleLoggerSettings.logLevelMask, level)
-            && !JEEnumBitmasked(HUDLoggerSettings.logLevelMask, level)
-            && !JEEnumBitmasked(fileLoggerSettings.logLevelMask, level)) {
-            
-            return;
-        }
+        _JEDebuggingHeader header = _JEDebuggingCHeader(entry, HUDLoggerSettings.logMessageHeaderMask);
+        NSMutableData *buffer = JELogScratchBufferAcquire();
+        _JEDebuggingAppendHeader(buffer, &header, HUDLoggerSettings.logMessageHeaderMask);
+        JELogScratchBufferAppendUTF8String(buffer, _JEDebuggingCBulletString(entry->level));
+        JELogScratchBufferAppendUTF8String(buffer, " ");
+        [buffer appendBytes:entry->message length:entry->messageLength];
+        NSString *logString = [[NSString alloc]
+                               initWithBytes:[buffer bytes]
+                               length:[buffer length]
+                               encoding:NSUTF8StringEncoding] ?: @"";
+        JELogScratchBufferRelinquish(buffer);
         
-        NSMutableString *description = [NSMutableString stringWithString:valueDescription()];
-        [description indentByLevel:1];
+        [[JEDebugging sharedInstance]
+         appendStringToHUD:logString
+         withThreadSafeSettings:HUDLoggerSettings];
+    }
+    _JEDebuggingCReleaseEntry(entry);
+}
+
+JE_STATIC
+void _JEDebuggingCOutputToFile(void *context) {
+    
+    _JEDebuggingCEntry *entry = context;
+    @autoreleasepool {
         
-        NSDictionary *headerEntries = [self
-                                       headerEntriesForLocation:location
-                                       withMask:(consoleLoggerSettings.logMessageHeaderMask
-                                                 | HUDLoggerSettings.logMessageHeaderMask
-                                                 | fileLoggerSettings.logMessageHeaderMask)];
-        NSString *bulletString;
-        if (JEEnumBitmasked(level, JELogLevelFatal)) {
-            
-            bulletString = [self defaultFatalBulletString];
-        }
-        else if (JEEnumBitmasked(level, JELogLevelAlert)) {
+        JEFileLoggerSettings *__block fileLoggerSettings;
+        dispatch_barrier_sync([JEDebugging settingsQueue], ^{
             
-            bulletString = [self defaultAlertBulletString];
-        }
-        else if (JEEnumBitmasked(level, JELogLevelNotice)) {
+            fileLoggerSettings = [JEDebugging sharedInstance].fileLoggerSettings;
+        });
+        
+        _JEDebuggingHeader header = _JEDebuggingCHeader(entry, fileLoggerSettings.logMessageHeaderMask);
+        NSString *message = [[NSString alloc]
+                             initWithBytes:entry->message
+                             length:entry->messageLength
+                             encoding:NSUTF8StringEncoding] ?: @"";
+        if (fileLoggerSettings.fileLogFormat == JEFileLogFormatJSONLines) {
             
-            bulletString = [self defaultLogBulletString];
+            [[JEDebugging sharedInstance]
+             appendRecordToFileWithLevel:entry->level
+             header:&header
+             message:message
+             dump:nil
+             callStack:nil
+             withThreadSafeSettings:fileLoggerSettings];
         }
         else {
             
-            bulletString = [self defaultTraceBulletString];
+            NSMutableData *buffer = JELogScratchBufferAcquire();
+            _JEDebuggingAppendHeader(buffer, &header, fileLoggerSettings.logMessageHeaderMask);
+            JELogScratchBufferAppendUTF8String(buffer, _JEDebuggingCBulletString(entry->level));
+            JELogScratchBufferAppendUTF8String(buffer, " ");
+            JELogScratchBufferAppendString(buffer, message);
+            JELogScratchBufferAppendUTF8String(buffer, "\n\n");
+            
+            [[JEDebugging sharedInstance]
+             appendDataToFile:buffer
+             timestamp:header.timeIntervalSince1970
+             withThreadSafeSettings:fileLoggerSettings];
+            JELogScratchBufferRelinquish(buffer);
         }
+    }
+    _JEDebuggingCReleaseEntry(entry);
+}
+
+JE_STATIC
+void _JEDebuggingCOutputSlot(_JEDebuggingCSlot *slot) {
+    
+    // Resolving the callsite needs Objective-C, so JELogCWrite() leaves it to the drain queue.
+    if (slot->callsite != NULL) {
+        
+        JELogCallsiteIsEnabled(slot->callsite, (unsigned int)slot->level, slot->fileName, slot->functionName);
+    }
+    
+    if (slot->needsObjectPath) {
         
-        if (JEEnumBitmasked(consoleLoggerSettings.logLevelMask, level)) {
+        @autoreleasepool {
             
-            dispatch_barrier_sync([self consoleLogQueue], ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:consoleLoggerSettings];
-                    [logString appendFormat:@"%@ %@\n  %@ %@\n",
-                     bulletString, label, [self defaultDumpBulletString], description];
-                    
-                    puts([logString UTF8String]);
-                }
-            });
+            NSString *messageString = [[NSString alloc]
+                                       initWithBytes:slot->message
+                                       length:slot->messageLength
+                                       encoding:NSUTF8StringEncoding] ?: @"";
+            [JEDebugging
+             logLevel:slot->level
+             callsite:slot->callsite
+             location:(JELogLocation){ slot->fileName, slot->functionName, slot->lineNumber }
+             date:[[NSDate alloc] initWithTimeIntervalSinceReferenceDate:slot->timestamp]
+             queueLabel:slot->queueLabel
+             logMessage:^id{
+                 
+                 return messageString;
+             }];
         }
-        if (JEEnumBitmasked(HUDLoggerSettings.logLevelMask, level)) {
+        return;
+    }
+    
+    // A single entry is shared by the HUD and file loggers, and freed by whichever finishes last.
+    _JEDebuggingCEntry *entry = malloc(sizeof(_JEDebuggingCEntry) + slot->messageLength + 1);
+    if (entry == NULL) {
+        
+        return;
+    }
+    atomic_init(&entry->retainCount, (slot->logsToHUD && slot->logsToFile) ? 2 : 1);
+    entry->level = slot->level;
+    entry->fileName = slot->fileName;
+    entry->functionName = slot->functionName;
+    entry->lineNumber = slot->lineNumber;
+    entry->timestamp = slot->timestamp;
+    memcpy(entry->queueLabel, slot->queueLabel, sizeof(entry->queueLabel));
+    entry->messageLength = slot->messageLength;
+    memcpy(entry->message, slot->message, slot->messageLength);
+    entry->message[slot->messageLength] = '\0';
+    
+    if (slot->logsToHUD) {
+        
+        dispatch_async_f(dispatch_get_main_queue(), entry, _JEDebuggingCOutputToHUD);
+    }
+    if (slot->logsToFile) {
+        
+        dispatch_barrier_async_f([JEDebugging fileLogQueue], entry, _JEDebuggingCOutputToFile);
+    }
+}
+
+JE_STATIC
+void _JEDebuggingCDrain(void) {
+    
+    // Cleared before draining, so a message published after its slot was checked schedules another drain.
+    atomic_exchange(&_JEDebuggingCIsDrainPending, false);
+    
+    BOOL hasFlushedStagers = NO;
+    while (YES) {
+        
+        size_t position = _JEDebuggingCDequeuePosition;
+        _JEDebuggingCSlot *slot = &_JEDebuggingCSlots[position & (_JEDebuggingCNumberOfSlots - 1)];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != (position + 1)) {
             
-            dispatch_async(dispatch_get_main_queue(), ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:HUDLoggerSettings];
-                    [logString appendFormat:@"%@ %@\n  %@ %@",
-                     bulletString, label, [self defaultDumpBulletString], description];
-                    
-                    [[self sharedInstance]
-                     appendStringToHUD:logString
-                     withThreadSafeSettings:HUDLoggerSettings];
-                }
-            });
+            break;
         }
-        if (JEEnumBitmasked(fileLoggerSettings.logLevelMask, level)) {
+        
+        if (!hasFlushedStagers) {
             
-            dispatch_barrier_async([self fileLogQueue], ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:fileLoggerSettings];
-                    [logString appendFormat:@"%@ %@\n  %@ %@\n\n",
-                     bulletString, label, [self defaultDumpBulletString], description];
-                    
-                    [[self sharedInstance]
-                     appendStringToFile:logString
-                     withThreadSafeSettings:fileLoggerSettings];
-                }
-            });
+            // Staged JELog() records are handed off first so that the loggers see records from the same thread in the order they were logged.
+            [[JEDebugging HUDLogStager] flushAllThreads];
+            [[JEDebugging fileLogStager] flushAllThreads];
+            hasFlushedStagers = YES;
         }
+        
+        _JEDebuggingCOutputSlot(slot);
+        
+        // Frees the slot for the position one lap ahead.
+        atomic_store_explicit(&slot->sequence, (position + _JEDebuggingCNumberOfSlots), memory_order_release);
+        _JEDebuggingCDequeuePosition = (position + 1);
+    }
+    
+    unsigned int numberOfDroppedMessages = atomic_exchange(&_JEDebuggingCNumberOfDroppedMessages, 0);
+    if (numberOfDroppedMessages > 0) {
+        
+        [JEDebugging
+         logLevel:JELogLevelAlert
+         location:(JELogLocation){ NULL, NULL, 0 }
+         format:@"JELogC() dropped %u messages because its buffer was full.", numberOfDroppedMessages];
     }
 }
 
-+ (void)logLevel:(JELogLevelMask)level
-        location:(JELogLocation)location
-          format:(NSString *)format, ... {
-    
-    va_list arguments;
-    va_start(arguments, format);
-    NSString *logMessage = [[NSString alloc] initWithFormat:format arguments:arguments];
-    va_end(arguments);
+static dispatch_queue_t _JEDebuggingCDrainQueue;
+
+JE_STATIC
+void _JEDebuggingCStartDraining(void) {
     
-    [self logLevel:level location:location logMessage:^{
+    static dispatch_source_t wakeUpSource;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        for (size_t i = 0; i < _JEDebuggingCNumberOfSlots; ++i) {
+            
+            atomic_init(&_JEDebuggingCSlots[i].sequence, i);
+        }
+        _JEDebuggingCDrainQueue = dispatch_queue_create(JEDebuggingReverseDNSPrefix "CLogDrainQueue", DISPATCH_QUEUE_SERIAL);
+        
+        // Signal handlers cannot submit blocks, but can write(2) to a pipe. Without the pipe, messages are drained only when file logs are flushed.
+        int fileDescriptors[2];
+        if (pipe(fileDescriptors) != 0) {
+            
+            return;
+        }
+        for (NSUInteger i = 0; i < 2; ++i) {
+            
+            fcntl(fileDescriptors[i], F_SETFL, (fcntl(fileDescriptors[i], F_GETFL) | O_NONBLOCK));
+            fcntl(fileDescriptors[i], F_SETFD, FD_CLOEXEC);
+        }
         
-        return logMessage;
-    }];
+        int readFileDescriptor = fileDescriptors[0];
+        wakeUpSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ,
+                                              (uintptr_t)readFileDescriptor,
+                                              0,
+                                              _JEDebuggingCDrainQueue);
+        dispatch_source_set_event_handler(wakeUpSource, ^{
+            
+            char bytes[64];
+            while (read(readFileDescriptor, bytes, sizeof(bytes)) > 0) {
+                
+                // Any number of wake-ups is answered with one drain.
+            }
+            _JEDebuggingCDrain();
+        });
+        dispatch_resume(wakeUpSource);
+        _JEDebuggingCWakeUpFileDescriptor = fileDescriptors[1];
+    });
 }
 
-+ (void)logLevel:(JELogLevelMask)level
-        location:(JELogLocation)location
-      logMessage:(nonnull id _Nonnull(^__attribute__((noescape)))(void))logMessage {
+JE_STATIC
+void _JEDebuggingCDrainSynchronously(void) {
     
-    if (![self sharedInstance].isStarted) {
+    dispatch_queue_t drainQueue = _JEDebuggingCDrainQueue;
+    if (drainQueue == NULL) {
         
         return;
     }
+    dispatch_sync(drainQueue, ^{
+        
+        _JEDebuggingCDrain();
+    });
+}
+
+JE_STATIC
+BOOL _JEDebuggingCFormatHasConversion(const char *format, const char *conversions) {
     
-    @autoreleasepool {
+    // Walks each conversion specification, including positional ones such as "%1$@", so that "%%@" and "%-@" are not mistaken for or missed as conversions.
+    for (const char *character = format; *character != '\0'; ++character) {
         
-        JEConsoleLoggerSettings *__block consoleLoggerSettings;
-        JEHUDLoggerSettings *__block HUDLoggerSettings;
-        JEFileLoggerSettings *__block fileLoggerSettings;
-        dispatch_barrier_sync([self settingsQueue], ^{
+        if (*character != '%') {
             
-            JEDebugging *instance = [self sharedInstance];
-            consoleLoggerSettings = instance.consoleLoggerSettings;
-            HUDLoggerSettings = instance.HUDLoggerSettings;
-            fileLoggerSettings = instance.fileLoggerSettings;
+            continue;
+        }
+        ++character;
+        if (*character == '%') {
             
-        });
+            continue;
+        }
         
-        if (!JEEnumBitmasked(consoleLoggerSettings.logLevelMask, level)
-            && !JEEnumBitmasked(HUDLoggerSettings.logLevelMask, level)
-            && !JEEnumBitmasked(fileLoggerSettings.logLevelMask, level)) {
+        const char *digits = character;
+        while (*character >= '0' && *character <= '9') {
             
-            return;
+            ++character;
         }
-        
-        NSString *formattedString = logMessage();
-        NSDictionary *headerEntries = [self
-                                       headerEntriesForLocation:location
-                                       withMask:(consoleLoggerSettings.logMessageHeaderMask
-                                                 | HUDLoggerSettings.logMessageHeaderMask
-                                                 | fileLoggerSettings.logMessageHeaderMask)];
-        NSString *bulletString;
-        if (JEEnumBitmasked(level, JELogLevelFatal)) {
+        if (*character != '$') {
             
-            bulletString = [self defaultFatalBulletString];
+            // Not an argument position, so the digits are flags or width and are parsed again below.
+            character = digits;
         }
-        else if (JEEnumBitmasked(level, JELogLevelAlert)) {
+        else {
             
-            bulletString = [self defaultAlertBulletString];
+            ++character;
         }
-        else if (JEEnumBitmasked(level, JELogLevelNotice)) {
+        while (*character != '\0' && strchr("-+ #0'", *character) != NULL) {
             
-            bulletString = [self defaultLogBulletString];
+            ++character;
         }
-        else {
+        while (*character == '*' || *character == '.' || *character == '$' || (*character >= '0' && *character <= '9')) {
             
-            bulletString = [self defaultTraceBulletString];
+            ++character;
         }
-        
-        if (JEEnumBitmasked(consoleLoggerSettings.logLevelMask, level)) {
+        while (*character != '\0' && strchr("hlqLjzt", *character) != NULL) {
             
-            dispatch_barrier_sync([self consoleLogQueue], ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:consoleLoggerSettings];
-                    [logString appendFormat:@"%@ %@\n",
-                     bulletString, formattedString];
-                    
-                    puts([logString UTF8String]);
-                }
-            });
+            ++character;
         }
-        if (JEEnumBitmasked(HUDLoggerSettings.logLevelMask, level)) {
+        if (*character == '\0') {
             
-            dispatch_async(dispatch_get_main_queue(), ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:HUDLoggerSettings];
-                    [logString appendFormat:@"%@ %@",
-                     bulletString, formattedString];
-                    
-                    [[self sharedInstance]
-                     appendStringToHUD:logString
-                     withThreadSafeSettings:HUDLoggerSettings];
-                }
-            });
+            break;
         }
-        if (JEEnumBitmasked(fileLoggerSettings.logLevelMask, level)) {
+        if (strchr(conversions, *character) != NULL) {
             
-            dispatch_barrier_async([self fileLogQueue], ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:fileLoggerSettings];
-                    [logString appendFormat:@"%@ %@\n\n",
-                     bulletString, formattedString];
-                    
-                    [[self sharedInstance]
-                     appendStringToFile:logString
-                     withThreadSafeSettings:fileLoggerSettings];
-                }
-            });
+            return YES;
         }
     }
+    return NO;
 }
 
-+ (void)logFailureInAssertionCondition:(NSString *)conditionString
-                              location:(JELogLocation)location {
- 
-    [self
-     logFailureInAssertionWithMessage:
-     [[NSString alloc] initWithFormat:@"Assertion failed for condition: (%@)", conditionString]
-     location:location];
-}
-
-+ (void)logFailureInAssertionWithMessage:(NSString *)failureMessage
-                                location:(JELogLocation)location {
+JE_STATIC
+size_t _JEDebuggingCFormatMessage(char *message, size_t capacity, const char *format, va_list arguments, bool isSignalSafe) {
     
-    if (![self sharedInstance].isStarted) {
+    if (isSignalSafe && _JEDebuggingCFormatHasConversion(format, "@aAeEfFgGCS")) {
         
-        return;
+        // Floating-point and wide character conversions may allocate, so the format is logged as is.
+        return MIN(strlcpy(message, format, capacity), (capacity - 1));
     }
-    
-    @autoreleasepool {
+    if (_JEDebuggingCFormatHasConversion(format, "@")) {
         
-        JEConsoleLoggerSettings *__block consoleLoggerSettings;
-        JEHUDLoggerSettings *__block HUDLoggerSettings;
-        JEFileLoggerSettings *__block fileLoggerSettings;
-        dispatch_barrier_sync([self settingsQueue], ^{
-            
-            JEDebugging *instance = [self sharedInstance];
-            consoleLoggerSettings = instance.consoleLoggerSettings;
-            HUDLoggerSettings = instance.HUDLoggerSettings;
-            fileLoggerSettings = instance.fileLoggerSettings;
+        // Objects can only be formatted by CoreFoundation. A format it rejects is logged as is.
+        CFStringRef formatString = CFStringCreateWithCStringNoCopy(NULL, format, kCFStringEncodingUTF8, kCFAllocatorNull);
+        CFStringRef string = (formatString ? CFStringCreateWithFormatAndArguments(NULL, NULL, formatString, arguments) : NULL);
+        if (formatString) {
             
-        });
-        
-        if (!JEEnumBitmasked(consoleLoggerSettings.logLevelMask, JELogLevelAlert)
-            && !JEEnumBitmasked(HUDLoggerSettings.logLevelMask, JELogLevelAlert)
-            && !JEEnumBitmasked(fileLoggerSettings.logLevelMask, JELogLevelAlert)) {
+            CFRelease(formatString);
+        }
+        if (string == NULL) {
             
-            return;
+            return MIN(strlcpy(message, format, capacity), (capacity - 1));
         }
         
-        NSDictionary *headerEntries = [self
-                                       headerEntriesForLocation:location
-                                       withMask:(consoleLoggerSettings.logMessageHeaderMask
-                                                 | HUDLoggerSettings.logMessageHeaderMask
-                                                 | fileLoggerSettings.logMessageHeaderMask)];
-        NSString *bulletString = [self defaultAssertBulletString];
+        CFIndex usedLength = 0;
+        CFStringGetBytes(string,
+                         CFRangeMake(0, CFStringGetLength(string)),
+                         kCFStringEncodingUTF8,
+                         '?',
+                         false,
+                         (UInt8 *)message,
+                         (CFIndex)(capacity - 1),
+                         &usedLength);
+        CFRelease(string);
+        return (size_t)usedLength;
+    }
+    
+    int written = vsnprintf(message, capacity, format, arguments);
+    size_t messageLength = (written < 0 ? 0 : MIN((size_t)written, (capacity - 1)));
+    if (written >= (int)capacity) {
         
-        if (JEEnumBitmasked(consoleLoggerSettings.logLevelMask, JELogLevelAlert)) {
+        // Don't cut a truncated message in the middle of a UTF-8 sequence.
+        size_t leadIndex = messageLength;
+        while (leadIndex > 0 && (message[leadIndex - 1] & 0xC0) == 0x80) {
             
-            dispatch_barrier_sync([self consoleLogQueue], ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:consoleLoggerSettings];
-                    [logString appendFormat:@"%@ %@\n",
-                     bulletString, failureMessage];
-                    
-                    puts([logString UTF8String]);
-                    
-                }
-            });
+            --leadIndex;
         }
-        if (JEEnumBitmasked(HUDLoggerSettings.logLevelMask, JELogLevelAlert)) {
+        if (leadIndex > 0) {
             
-            dispatch_async(dispatch_get_main_queue(), ^{
+            unsigned char lead = (unsigned char)message[leadIndex - 1];
+            size_t sequenceLength = (lead >= 0xF0 ? 4 : (lead >= 0xE0 ? 3 : (lead >= 0xC0 ? 2 : 1)));
+            if (messageLength - (leadIndex - 1) < sequenceLength) {
                 
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:HUDLoggerSettings];
-                    [logString appendFormat:@"%@ %@",
-                     bulletString, failureMessage];
-                    
-                    [[self sharedInstance]
-                     appendStringToHUD:logString
-                     withThreadSafeSettings:HUDLoggerSettings];
-                }
-            });
+                messageLength = (leadIndex - 1);
+            }
         }
-        if (JEEnumBitmasked(fileLoggerSettings.logLevelMask, JELogLevelAlert)) {
+    }
+    return messageLength;
+}
+
+JE_STATIC
+_JEDebuggingCSlot *_JEDebuggingCClaimSlot(size_t *position) {
+    
+    size_t claimedPosition = atomic_load_explicit(&_JEDebuggingCEnqueuePosition, memory_order_relaxed);
+    while (YES) {
+        
+        _JEDebuggingCSlot *slot = &_JEDebuggingCSlots[claimedPosition & (_JEDebuggingCNumberOfSlots - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence == claimedPosition) {
             
-            dispatch_barrier_async([self fileLogQueue], ^{
+            if (atomic_compare_exchange_weak_explicit(&_JEDebuggingCEnqueuePosition,
+                                                      &claimedPosition,
+                                                      (claimedPosition + 1),
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
                 
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:fileLoggerSettings];
-                    [logString appendFormat:@"%@ %@\n\n",
-                     bulletString, failureMessage];
-                    
-                    [[self sharedInstance]
-                     appendStringToFile:logString
-                     withThreadSafeSettings:fileLoggerSettings];
-                }
-            });
+                (*position) = claimedPosition;
+                return slot;
+            }
+        }
+        else if ((intptr_t)(sequence - claimedPosition) < 0) {
+            
+            // The slot still holds the message from the previous lap, so the ring is full.
+            return NULL;
+        }
+        else {
+            
+            claimedPosition = atomic_load_explicit(&_JEDebuggingCEnqueuePosition, memory_order_relaxed);
         }
     }
 }
 
-+ (void)logLifeCycleEventWithFormat:(NSString *)format, ... {
+void JELogCWrite(JELogCallsite *callsite,
+                 unsigned int level,
+                 const char *fileName,
+                 const char *functionName,
+                 unsigned int lineNumber,
+                 const char *format, ...) {
     
-    va_list arguments;
-    va_start(arguments, format);
-    [self logLifeCycleEventWithFormat:format arguments:arguments];
-    va_end(arguments);
-}
-
-+ (void)logLifeCycleEventWithFormat:(NSString *)format arguments:(va_list)arguments {
+    bool isSignalSafe = JEEnumBitmasked(level, JELogCSignalSafe);
+    level &= ~JELogCSignalSafe;
     
-    if (![self sharedInstance].isStarted) {
+    // Acquire pairs with +start, which sets up the ring before setting the flag.
+    if (!atomic_load_explicit(&_JEDebuggingCIsStarted, memory_order_acquire)) {
         
         return;
     }
     
-    @autoreleasepool {
+    unsigned int consoleLevelMask = atomic_load_explicit(&_JEDebuggingCConsoleLevelMask, memory_order_relaxed);
+    unsigned int HUDLevelMask = atomic_load_explicit(&_JEDebuggingCHUDLevelMask, memory_order_relaxed);
+    unsigned int fileLevelMask = atomic_load_explicit(&_JEDebuggingCFileLevelMask, memory_order_relaxed);
+    bool needsObjectPath = atomic_load_explicit(&_JEDebuggingCNeedsObjectPath, memory_order_relaxed);
+    bool logsToConsole = (!needsObjectPath && JEEnumBitmasked(consoleLevelMask, level));
+    bool logsToHUD = (!needsObjectPath && JEEnumBitmasked(HUDLevelMask, level));
+    bool logsToFile = (!needsObjectPath && JEEnumBitmasked(fileLevelMask, level));
+    if (!logsToConsole && !logsToHUD && !logsToFile && !needsObjectPath) {
         
-        JEConsoleLoggerSettings *__block consoleLoggerSettings;
-        JEHUDLoggerSettings *__block HUDLoggerSettings;
-        JEFileLoggerSettings *__block fileLoggerSettings;
-        dispatch_barrier_sync([self settingsQueue], ^{
-            
-            JEDebugging *instance = [self sharedInstance];
-            consoleLoggerSettings = instance.consoleLoggerSettings;
-            HUDLoggerSettings = instance.HUDLoggerSettings;
-            fileLoggerSettings = instance.fileLoggerSettings;
-            
-        });
+        return;
+    }
+    
+    // Signal handlers must leave errno as they found it.
+    int savedErrno = errno;
+    
+    char message[_JEDebuggingCMessageCapacity];
+    va_list arguments;
+    va_start(arguments, format);
+    size_t messageLength = _JEDebuggingCFormatMessage(message, sizeof(message), format, arguments, isSignalSafe);
+    va_end(arguments);
+    message[messageLength] = '\0';
+    
+    CFAbsoluteTime timestamp = CFAbsoluteTimeGetCurrent();
+    // dispatch_queue_get_label() is not async-signal-safe.
+    const char *queueLabel = (isSignalSafe ? "" : (dispatch_queue_get_label(DISPATCH_CURRENT_QUEUE_LABEL) ?: ""));
+    
+    if (logsToConsole) {
         
-        if (!JEEnumBitmasked(consoleLoggerSettings.logLevelMask, JELogLevelTrace)
-            && !JEEnumBitmasked(HUDLoggerSettings.logLevelMask, JELogLevelTrace)
-            && !JEEnumBitmasked(fileLoggerSettings.logLevelMask, JELogLevelTrace)) {
+        JELogMessageHeaderMask headerMask = atomic_load_explicit(&_JEDebuggingCConsoleHeaderMask, memory_order_relaxed);
+        char logString[_JEDebuggingCMessageCapacity + 512];
+        size_t logLength = 0;
+        if (JEEnumBitmasked(headerMask, JELogMessageHeaderDate)) {
             
-            return;
+            logLength = _JEDebuggingFormatTimestamp(logString, sizeof(logString), (timestamp + kCFAbsoluteTimeIntervalSince1970));
+            logLength = _JEDebuggingCAppend(logString, sizeof(logString), logLength, " ");
         }
-        
-        NSString *formattedString = [[NSString alloc] initWithFormat:format arguments:arguments];
-        NSDictionary *headerEntries = [self
-                                       headerEntriesForLocation:(JELogLocation){ NULL, NULL, 0 }
-                                       withMask:JELogMessageHeaderNone];
-        NSString *bulletString = [self defaultLifeCycleBulletString];
-        
-        if (JEEnumBitmasked(consoleLoggerSettings.logLevelMask, JELogLevelTrace)) {
+        if (JEEnumBitmasked(headerMask, JELogMessageHeaderQueue)) {
             
-            dispatch_barrier_sync([self consoleLogQueue], ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:consoleLoggerSettings];
-                    [logString appendFormat:@"%@ %@\n",
-                     bulletString, formattedString];
-                    
-                    puts([logString UTF8String]);
-                }
-            });
+            logLength = _JEDebuggingCAppend(logString, sizeof(logString), logLength, "[%s] ", queueLabel);
         }
-        if (JEEnumBitmasked(HUDLoggerSettings.logLevelMask, JELogLevelTrace)) {
+        if (JEEnumBitmasked(headerMask, JELogMessageHeaderSourceFile) && fileName != NULL && lineNumber > 0) {
             
-            dispatch_async(dispatch_get_main_queue(), ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:HUDLoggerSettings];
-                    [logString appendFormat:@"%@ %@",
-                     bulletString, formattedString];
-                    
-                    [[self sharedInstance]
-                     appendStringToHUD:logString
-                     withThreadSafeSettings:HUDLoggerSettings];
-                }
-            });
+            logLength = _JEDebuggingCAppend(logString, sizeof(logString), logLength, "%s:%u ", fileName, lineNumber);
         }
-        if (JEEnumBitmasked(fileLoggerSettings.logLevelMask, JELogLevelTrace)) {
+        if (JEEnumBitmasked(headerMask, JELogMessageHeaderFunction) && functionName != NULL) {
             
-            dispatch_barrier_async([self fileLogQueue], ^{
-                
-                @autoreleasepool {
-                    
-                    NSMutableString *logString = [self
-                                                  messageHeaderFromEntries:headerEntries
-                                                  withSettings:fileLoggerSettings];
-                    [logString appendFormat:@"%@ %@\n\n",
-                     bulletString, formattedString];
-                    
-                    [[self sharedInstance]
-                     appendStringToFile:logString
-                     withThreadSafeSettings:fileLoggerSettings];
-                }
-            });
+            logLength = _JEDebuggingCAppend(logString, sizeof(logString), logLength, "%s ", functionName);
         }
-    }
-}
-
-#pragma mark retrieving
-
-+ (void)enumerateFileLogDataWithBlock:(void (^)(NSString *fileName, NSData *data, BOOL *stop))block {
-    
-    JEAssert(block != NULL, @"Enumeration block was NULL.");
-    
-    JEFileLoggerSettings *__block fileLoggerSettings;
-    dispatch_barrier_sync([JEDebugging settingsQueue], ^{
+        if (logLength > 0) {
+            
+            logLength = _JEDebuggingCAppend(logString, sizeof(logString), logLength, "\n");
+        }
+        logLength = _JEDebuggingCAppend(logString, sizeof(logString), logLength, "%s %s\n\n",
+                                        _JEDebuggingCBulletString(level), message);
         
-        fileLoggerSettings = [self sharedInstance].fileLoggerSettings;
-    });
+        // The console logger also writes each record with a single write(2), so records are never interleaved.
+        _JEDebuggingWriteFully(STDOUT_FILENO, logString, logLength);
+    }
     
-    dispatch_barrier_sync([self fileLogQueue], ^{
+    if (logsToHUD || logsToFile || needsObjectPath) {
         
-        JEDebugging *instance = [self sharedInstance];
-        [instance flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
-        [instance enumerateFileLogsWithThreadSafeSettings:fileLoggerSettings block:^(NSURL *fileURL, BOOL *stop) {
+        size_t position = 0;
+        _JEDebuggingCSlot *slot = _JEDebuggingCClaimSlot(&position);
+        if (slot == NULL) {
             
-            NSData *data = [[NSData alloc]
-                            initWithContentsOfURL:fileURL
-                            options:kNilOptions
-                            error:NULL];
-            if (!data) {
-                
-                return;
-            }
+            atomic_fetch_add_explicit(&_JEDebuggingCNumberOfDroppedMessages, 1, memory_order_relaxed);
+        }
+        else {
             
-            BOOL shouldStop = NO;
-            block([fileURL lastPathComponent], data, &shouldStop);
-            if (shouldStop) {
+            slot->callsite = callsite;
+            slot->level = level;
+            slot->needsObjectPath = needsObjectPath;
+            slot->logsToHUD = logsToHUD;
+            slot->logsToFile = logsToFile;
+            slot->fileName = fileName;
+            slot->functionName = functionName;
+            slot->lineNumber = lineNumber;
+            slot->timestamp = timestamp;
+            strlcpy(slot->queueLabel, queueLabel, sizeof(slot->queueLabel));
+            slot->messageLength = messageLength;
+            memcpy(slot->message, message, messageLength);
+            atomic_store_explicit(&slot->sequence, (position + 1), memory_order_release);
+            
+            // One byte wakes the drain queue for any number of messages. If the pipe is full, a wake-up is already waiting.
+            if (!atomic_exchange(&_JEDebuggingCIsDrainPending, true)) {
                 
-                (*stop) = YES;
+                char wakeUpByte = 0;
+                (void)write(_JEDebuggingCWakeUpFileDescriptor, &wakeUpByte, 1);
             }
-        }];
-    });
+        }
+    }
+    
+    errno = savedErrno;
 }
 
-+ (void)enumerateFileLogURLsWithBlock:(void (^)(NSURL *fileURL, BOOL *stop))block {
-    
-    JEAssert(block != NULL, @"Enumeration block was NULL.");
-    
-    JEFileLoggerSettings *__block fileLoggerSettings;
-    dispatch_barrier_sync([JEDebugging settingsQueue], ^{
-        
-        fileLoggerSettings = [self sharedInstance].fileLoggerSettings;
-    });
+JELogCallsite JELogCallsiteResolve(JELogCallsite *callsite,
+                                   const char *fileName,
+                                   const char *functionName) {
     
-    dispatch_barrier_sync([self fileLogQueue], ^{
-        
-        JEDebugging *instance = [self sharedInstance];
-        [instance flushFileHandleIfNeededOrForced:YES withThreadSafeSettings:fileLoggerSettings];
-        [instance enumerateFileLogsWithThreadSafeSettings:fileLoggerSettings block:^(NSURL *fileURL, BOOL *stop) {
-            
-            BOOL shouldStop = NO;
-            block(fileURL, &shouldStop);
-            if (shouldStop) {
-                
-                (*stop) = YES;
-            }
-        }];
-    });
+    // The generation is read first, so a settings change while resolving leaves the callsite stale instead of wrong.
+    uint32_t generation = __atomic_load_n(&_JELogCallsiteGeneration, __ATOMIC_ACQUIRE);
+    JELogCallsite state = [JEDebugging
+                           callsiteStateForGeneration:generation
+                           fileName:fileName
+                           functionName:functionName];
+    __atomic_store_n(callsite, state, __ATOMIC_RELAXED);
+    return state;
 }
-
-
-@end
@@ -0,0 +1,110 @@
+//
+//  JELogC.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#ifndef JEToolkit_JELogC_h
+#define JEToolkit_JELogC_h
+
+#include <stdarg.h>
+#include <string.h>
+
+#include "JELogCallsite.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*! Log levels for JELogC(). The values are the same as the corresponding JELogLevelMask flags.
+ */
+enum {
+    
+    JELogCLevelTrace    = (1 << 0),
+    JELogCLevelNotice   = (1 << 1),
+    JELogCLevelAlert    = (1 << 2),
+    JELogCLevelFatal    = (1 << 3)
+};
+
+/*! Combine with a level, as in JELogC(JELogCLevelFatal | JELogCSignalSafe, ...), when logging from a signal handler. The message is logged without the queue label, and a format string with conversions other than integer, character, string, and pointer ones is logged as is instead of being formatted.
+ */
+enum {
+    
+    JELogCSignalSafe    = (1 << 8)
+};
+
+
+/*! Logs a printf-style format string from C, C++, or Objective-C code with the source filename, line number, and function name. The message is formatted with vsnprintf() into a stack buffer and passed to the loggers as raw bytes, so no Objective-C objects are created unless the format string contains %@.
+ 
+ With JELogCSignalSafe, JELogC() neither allocates nor takes locks, so it can be used from signal handlers. Only integer, character, string, and pointer conversions are formatted in that mode, since vsnprintf() may allocate for floating-point conversions and CoreFoundation allocates for %@. Without JELogCSignalSafe, the current queue's label is looked up for the message header, which is not async-signal-safe. Console output is written with write(2) before JELogC() returns. Messages for the HUD and file loggers are copied into a preallocated ring and handed to the loggers from a background queue; if the loggers fall behind and the ring fills up, messages are dropped and the number dropped is logged once there is room. Messages longer than 1023 bytes are truncated.
+ 
+ While there are log subscriptions, level overrides, or loggers that suppress repeated messages, all output goes through the ring to the same path as JELog(), so it is written after JELogC() returns.
+ */
+#define JELogC(level, format, ...) \
+    do { \
+        static JELogCallsite _je_callsite = 0; \
+        const char *const _je_fileName = ((strrchr(__FILE__, '/') ?: (__FILE__ - 1)) + 1); \
+        if (JELogCallsiteMayBeEnabled(&_je_callsite, (level))) { \
+            JELogCWrite(&_je_callsite, (level), _je_fileName, __PRETTY_FUNCTION__, __LINE__, (format), ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define JELogCTrace(format, ...) \
+    JELogC(JELogCLevelTrace, (format), ##__VA_ARGS__)
+
+#define JELogCNotice(format, ...) \
+    JELogC(JELogCLevelNotice, (format), ##__VA_ARGS__)
+
+#define JELogCAlert(format, ...) \
+    JELogC(JELogCLevelAlert, (format), ##__VA_ARGS__)
+
+#define JELogCFatal(format, ...) \
+    JELogC(JELogCLevelFatal, (format), ##__VA_ARGS__)
+
+
+/* Objective-C callers may pass %@, which the printf format type rejects. The os_log format type checks the same C format strings and accepts %@. */
+#if defined(__OBJC__) && defined(__has_builtin)
+#if __has_builtin(__builtin_os_log_format)
+#define JE_LOGC_FORMAT_STRING(F,A)  __attribute__((format(os_log, F, A)))
+#endif
+#endif
+#ifndef JE_LOGC_FORMAT_STRING
+#define JE_LOGC_FORMAT_STRING(F,A)  __attribute__((format(printf, F, A)))
+#endif
+
+/*! The function called by JELogC(). The @p fileName and @p functionName must point to strings that live for the rest of the process, such as string literals.
+ @param callsite the callsite's cached state, resolved later off the calling thread if it is out of date. May be NULL.
+ */
+extern void JELogCWrite(JELogCallsite *callsite,
+                        unsigned int level,
+                        const char *fileName,
+                        const char *functionName,
+                        unsigned int lineNumber,
+                        const char *format, ...) JE_LOGC_FORMAT_STRING(6, 7);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+//
+//  JELogCallsite.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#ifndef JEToolkit_JELogCallsite_h
+#define JEToolkit_JELogCallsite_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*! The log levels enabled for a single callsite. The JELog(...), JEDump(...), and JELogC(...) macros declare one as a static variable initialized to 0, so logger settings and level overrides are only evaluated the first time the callsite fires and again after the settings change.
+ 
+ The upper 32 bits hold the settings generation the state was computed for. The lowest byte holds the JELogLevelMask flags enabled for any logger or log subscription, and the next three bytes hold the levels enabled for the console, HUD, and file loggers respectively, so that messages that pass the check do not evaluate level overrides again.
+ */
+typedef uint64_t JELogCallsite;
+
+#define JELogCallsiteEnabledLevelsMask  0xFFu
+
+/*! Incremented each time logger settings or subscriptions change. Do not modify directly.
+ */
+extern uint32_t _JELogCallsiteGeneration;
+
+/*! Evaluates the logger settings for a callsite and caches the result. Use JELogCallsiteIsEnabled() instead.
+ @param callsite the callsite's cached state
+ @param fileName the callsite's source file name
+ @param functionName the callsite's function name
+ @return the callsite's updated state
+ */
+extern JELogCallsite JELogCallsiteResolve(JELogCallsite *callsite,
+                                          const char *fileName,
+                                          const char *functionName);
+
+/*! Checks if any logger or log subscription accepts messages of the specified level from a callsite. Unless the settings changed since the last call, this is a single load and test.
+ @param callsite the callsite's cached state
+ @param level the JELogLevelMask flag of the message
+ @param fileName the callsite's source file name
+ @param functionName the callsite's function name
+ @return nonzero if the message should be logged, 0 otherwise
+ */
+static inline int JELogCallsiteIsEnabled(JELogCallsite *callsite,
+                                         unsigned int level,
+                                         const char *fileName,
+                                         const char *functionName) {
+    
+    JELogCallsite state = __atomic_load_n(callsite, __ATOMIC_RELAXED);
+    if ((uint32_t)(state >> 32) != __atomic_load_n(&_JELogCallsiteGeneration, __ATOMIC_RELAXED)) {
+        
+        state = JELogCallsiteResolve(callsite, fileName, functionName);
+    }
+    return ((uint32_t)state & JELogCallsiteEnabledLevelsMask & level) != 0;
+}
+
+/*! Like JELogCallsiteIsEnabled(), but never resolves the callsite, so it can be called from signal handlers. A callsite whose cached state is out of date counts as enabled, leaving the level checks to the caller.
+ @param callsite the callsite's cached state
+ @param level the JELogLevelMask flag of the message
+ @return nonzero if the message may need to be logged, 0 otherwise
+ */
+static inline int JELogCallsiteMayBeEnabled(const JELogCallsite *callsite,
+                                            unsigned int level) {
+    
+    JELogCallsite state = __atomic_load_n(callsite, __ATOMIC_RELAXED);
+    return ((uint32_t)(state >> 32) != __atomic_load_n(&_JELogCallsiteGeneration, __ATOMIC_RELAXED)
+            || ((uint32_t)state & JELogCallsiteEnabledLevelsMask & level) != 0);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -61,4 +61,20 @@ typedef NS_OPTIONS(NSUInteger, JELogMessageHeaderMask) {
  */
 @property (nonatomic, assign) JELogMessageHeaderMask logMessageHeaderMask;
 
+/*! The time window in seconds within which consecutive repeats of a message from the same callsite are collapsed into a single "Last message repeated N times" entry. Each logger suppresses repeats independently. Defaults to 0, which outputs all repeats
+ */
+@property (nonatomic, assign) NSTimeInterval repeatedMessageSuppressionInterval;
+
+/*! An array of JELogLevelOverrides that replace the logLevelMask for specific source files or functions. The first matching override is used. Each callsite evaluates the overrides only once after the settings are applied, so the number of overrides does not affect logging calls. Defaults to nil
+ */
+@property (nonatomic, copy) NSArray *logLevelOverrides;
+
+/*! Returns the logLevelMask for messages logged from the specified callsite after applying the logLevelOverrides.
+ @param fileName the callsite's source file name, or NULL
+ @param functionName the callsite's function name, or NULL
+ @return the combination of JELogLevelMask flags that will be output for the callsite
+ */
+- (JELogLevelMask)logLevelMaskForFileName:(const char *)fileName
+                             functionName:(const char *)functionName;
+
 @end
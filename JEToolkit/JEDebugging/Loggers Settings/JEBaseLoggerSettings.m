@@ -25,6 +25,8 @@
 
 #import "JEBaseLoggerSettings.h"
 
+#import "JELogLevelOverride.h"
+
 @implementation JEBaseLoggerSettings
 
 #pragma mark - NSCopying
@@ -34,8 +36,26 @@
     typeof(self) copy = [[[self class] allocWithZone:zone] init];
     copy->_logLevelMask = _logLevelMask;
     copy->_logMessageHeaderMask = _logMessageHeaderMask;
+    copy->_repeatedMessageSuppressionInterval = _repeatedMessageSuppressionInterval;
+    copy->_logLevelOverrides = _logLevelOverrides;
     return copy;
 }
 
 
+#pragma mark - Public
+
+- (JELogLevelMask)logLevelMaskForFileName:(const char *)fileName
+                             functionName:(const char *)functionName {
+    
+    for (JELogLevelOverride *override in _logLevelOverrides) {
+        
+        if ([override matchesFileName:fileName functionName:functionName]) {
+            
+            return override.logLevelMask;
+        }
+    }
+    return _logLevelMask;
+}
+
+
 @end
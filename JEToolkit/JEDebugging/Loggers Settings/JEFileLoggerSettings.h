@@ -25,6 +25,12 @@
 
 #import "JEBaseLoggerSettings.h"
 
+typedef NS_ENUM(NSInteger, JEFileLogFormat) {
+    
+    JEFileLogFormatText         = 0,    // human-readable records, one bulleted block per log
+    JEFileLogFormatJSONLines    = 1,    // one JSON object per line, written to .jsonl files
+};
+
 /*! JEFileLoggerSettings provides configurations to JEDebugging file logging.
  */
 @interface JEFileLoggerSettings : JEBaseLoggerSettings
@@ -49,4 +55,8 @@
  */
 @property (nonatomic, assign) NSUInteger numberOfDaysBeforeDeletingFile;
 
+/*! The format of records written to log files. When set to JEFileLogFormatJSONLines, each record is written as a single-line JSON object with the keys "timestamp", "level", "queue", "file", "line", "function", "message" and "dump". The "message" key is always written; keys for headers excluded by logMessageHeaderMask or unavailable for a record are omitted, and "dump" is only written for JEDump() records. Defaults to JEFileLogFormatText
+ */
+@property (nonatomic, assign) JEFileLogFormat fileLogFormat;
+
 @end
@@ -48,6 +48,7 @@
                                  isDirectory:YES];
     self.numberOfBytesInMemoryBeforeWritingToFile = (1024 * 100); // 100KB
     self.numberOfDaysBeforeDeletingFile = 7;
+    self.fileLogFormat = JEFileLogFormatText;
     
     return self;
 }
@@ -61,6 +62,7 @@
     copy->_fileLogsDirectoryURL = [_fileLogsDirectoryURL copyWithZone:zone];
     copy->_numberOfBytesInMemoryBeforeWritingToFile = _numberOfBytesInMemoryBeforeWritingToFile;
     copy->_numberOfDaysBeforeDeletingFile = _numberOfDaysBeforeDeletingFile;
+    copy->_fileLogFormat = _fileLogFormat;
     return copy;
 }
 
@@ -0,0 +1,68 @@
+//
+//  JELogLevelOverride.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JEBaseLoggerSettings.h"
+
+
+/*! JELogLevelOverride replaces a logger's logLevelMask for messages logged from matching callsites, such as to enable JELogLevelTrace for a single subsystem. Overrides are immutable.
+ */
+@interface JELogLevelOverride : NSObject <NSCopying>
+
+/*! A shell wildcard pattern (see fnmatch(3)) matched against the callsite's source file name, such as @"JEHUD*.m". nil matches all files
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *fileNamePattern;
+
+/*! A prefix matched against the callsite's function name, such as @"-[JEHUDLogView ". nil matches all functions
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *functionNamePrefix;
+
+/*! The combination of JELogLevelMask flags used instead of the logger's logLevelMask for matching callsites.
+ */
+@property (nonatomic, assign, readonly) JELogLevelMask logLevelMask;
+
+/*! Creates an override for callsites that match both the file name pattern and the function name prefix. Messages not logged from source code never match an override.
+ @param fileNamePattern a shell wildcard pattern for the source file name, or nil to match all files
+ @param functionNamePrefix a prefix for the function name, or nil to match all functions
+ @param logLevelMask the combination of JELogLevelMask flags to use for matching callsites
+ */
+- (nonnull instancetype)initWithFileNamePattern:(nullable NSString *)fileNamePattern
+                             functionNamePrefix:(nullable NSString *)functionNamePrefix
+                                   logLevelMask:(JELogLevelMask)logLevelMask NS_DESIGNATED_INITIALIZER;
+
+/*! Use initWithFileNamePattern:functionNamePrefix:logLevelMask: instead.
+ */
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+/*! Checks if the override applies to the specified callsite.
+ @param fileName the callsite's source file name, or NULL
+ @param functionName the callsite's function name, or NULL
+ @return YES if the override applies, NO otherwise
+ */
+- (BOOL)matchesFileName:(nullable const char *)fileName
+           functionName:(nullable const char *)functionName;
+
+@end
@@ -0,0 +1,95 @@
+//
+//  JELogLevelOverride.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogLevelOverride.h"
+
+#include <fnmatch.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+@implementation JELogLevelOverride {
+    
+    // UTF8 copies so matching does not touch NSString on the logging thread.
+    char *_fileNameCPattern;
+    char *_functionNameCPrefix;
+    size_t _functionNameCPrefixLength;
+}
+
+#pragma mark - NSObject
+
+- (instancetype)initWithFileNamePattern:(NSString *)fileNamePattern
+                     functionNamePrefix:(NSString *)functionNamePrefix
+                           logLevelMask:(JELogLevelMask)logLevelMask {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _fileNamePattern = [fileNamePattern copy];
+    _functionNamePrefix = [functionNamePrefix copy];
+    _logLevelMask = logLevelMask;
+    
+    _fileNameCPattern = (fileNamePattern ? strdup([fileNamePattern UTF8String]) : NULL);
+    _functionNameCPrefix = (functionNamePrefix ? strdup([functionNamePrefix UTF8String]) : NULL);
+    _functionNameCPrefixLength = (_functionNameCPrefix ? strlen(_functionNameCPrefix) : 0);
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    free(_fileNameCPattern);
+    free(_functionNameCPrefix);
+}
+
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+    
+    return self;
+}
+
+
+#pragma mark - Public
+
+- (BOOL)matchesFileName:(const char *)fileName
+           functionName:(const char *)functionName {
+    
+    if (_fileNameCPattern && (!fileName || fnmatch(_fileNameCPattern, fileName, 0) != 0)) {
+        
+        return NO;
+    }
+    if (_functionNameCPrefix && (!functionName || strncmp(functionName, _functionNameCPrefix, _functionNameCPrefixLength) != 0)) {
+        
+        return NO;
+    }
+    return YES;
+}
+
+@end
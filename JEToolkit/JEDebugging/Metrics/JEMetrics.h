@@ -0,0 +1,125 @@
+//
+//  JEMetrics.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#ifndef JEToolkit_JEMetrics_h
+#define JEToolkit_JEMetrics_h
+
+#include <stdint.h>
+
+#import "JECompilerDefines.h"
+
+
+#pragma mark - JEMetric() variants
+
+/*! Adds 1 to a counter, such as JEMetricIncrement("cache.miss"). Counters are aggregated per thread without locking and collected periodically by JEDebugging, so this is cheap enough for hot paths. The name should be a string literal.
+ */
+#define JEMetricIncrement(name) \
+    JEMetricIncrementBy((name), 1)
+
+/*! Adds an amount to a counter. The name should be a string literal.
+ */
+#define JEMetricIncrementBy(name, amount) \
+    do { \
+        static JEMetric _je_metric = 0; \
+        JEMetricAdd(&_je_metric, (name), (int64_t)(amount)); \
+    } while (0)
+
+/*! Sets a gauge to its latest value, such as JEMetricGauge("queue.depth", [queue count]). The name should be a string literal.
+ */
+#define JEMetricGauge(name, value) \
+    do { \
+        static JEMetric _je_metric = 0; \
+        JEMetricSetGauge(&_je_metric, (name), (double)(value)); \
+    } while (0)
+
+
+/*! The metric a callsite resolved its name to. The JEMetric(...) macros declare one as a static variable initialized to 0, so the name is only looked up the first time the callsite fires.
+ */
+typedef uint32_t JEMetric;
+
+/*! The maximum number of distinct counter names and of distinct gauge names. Updates to names registered past this limit are ignored.
+ */
+JE_EXTERN const NSUInteger JEMetricMaximumNumberOfNames;
+
+/*! Use the JEMetricIncrement(...) family of utilities instead of this function.
+ */
+JE_EXTERN
+void JEMetricAdd(JEMetric *_Nonnull metric, const char *_Nonnull name, int64_t amount);
+
+/*! Use the JEMetricGauge(...) utility instead of this function.
+ */
+JE_EXTERN
+void JEMetricSetGauge(JEMetric *_Nonnull metric, const char *_Nonnull name, double value);
+
+
+#pragma mark - JEMetricSnapshot
+
+/*! JEMetricSnapshot holds the metric values collected at one point in time.
+ */
+@interface JEMetricSnapshot : NSObject
+
+/*! The time the snapshot was collected.
+ */
+@property (nonatomic, strong, readonly, nonnull) NSDate *date;
+
+/*! The running totals of all counters, keyed by name.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSDictionary *counters;
+
+/*! The change in each counter since the previous snapshot, keyed by name. Counters that did not change are omitted.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSDictionary *counterChanges;
+
+/*! The latest values of all gauges, keyed by name.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSDictionary *gauges;
+
+/*! Collects the current values of all counters and gauges. Thread-safe. Note that each snapshot resets the counterChanges baseline, so JEDebugging's periodic flush should normally be the only caller.
+ @return the collected metric values
+ */
++ (nonnull JEMetricSnapshot *)collectSnapshot;
+
+@end
+
+
+#pragma mark - JEMetricExporter
+
+/*! Receives metric snapshots each time JEDebugging flushes metrics. See JEDebugging's addMetricExporter:.
+ */
+@protocol JEMetricExporter <NSObject>
+
+@required
+
+/*! Called on a background queue each time metrics are flushed. Calls are never concurrent.
+ @param snapshot the collected metric values
+ */
+- (void)exportMetricSnapshot:(nonnull JEMetricSnapshot *)snapshot;
+
+@end
+
+
+#endif
@@ -0,0 +1,284 @@
+//
+//  JEMetrics.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JEMetrics.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+enum {
+    
+    _JEMetricCapacity = 256
+};
+
+// JEMetric values are the name's index + 1, or _JEMetricUnavailable once the capacity is used up.
+static const JEMetric _JEMetricUnavailable = UINT32_MAX;
+
+const NSUInteger JEMetricMaximumNumberOfNames = _JEMetricCapacity;
+
+/*! A thread's counters. Only the owning thread writes to its shard; collection reads it with atomic loads.
+ */
+typedef struct _JEMetricShard {
+    
+    int64_t counters[_JEMetricCapacity];
+    struct _JEMetricShard *next;
+    
+} _JEMetricShard;
+
+// Only accessed from the registry queue.
+static NSMutableDictionary *_JEMetricCounterIndexes;
+static NSMutableArray *_JEMetricCounterNames;
+static NSMutableDictionary *_JEMetricGaugeIndexes;
+static NSMutableArray *_JEMetricGaugeNames;
+static _JEMetricShard *_JEMetricShards;
+static int64_t _JEMetricRetiredCounters[_JEMetricCapacity];
+static int64_t _JEMetricCollectedCounters[_JEMetricCapacity];
+
+// Gauge values as raw double bits, stored atomically from any thread.
+static uint64_t _JEMetricGaugeBits[_JEMetricCapacity];
+
+
+#pragma mark - Private
+
+JE_STATIC
+dispatch_queue_t _JEMetricRegistryQueue(void) {
+    
+    static dispatch_queue_t registryQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        registryQueue = dispatch_queue_create("com.JEToolkit.JEDebugging.metricRegistryQueue", DISPATCH_QUEUE_SERIAL);
+        _JEMetricCounterIndexes = [[NSMutableDictionary alloc] init];
+        _JEMetricCounterNames = [[NSMutableArray alloc] init];
+        _JEMetricGaugeIndexes = [[NSMutableDictionary alloc] init];
+        _JEMetricGaugeNames = [[NSMutableArray alloc] init];
+    });
+    return registryQueue;
+}
+
+JE_STATIC
+void _JEMetricThreadDidExit(void *value) {
+    
+    // The exiting thread's counts are folded into the retired totals so they are not lost.
+    _JEMetricShard *shard = value;
+    dispatch_sync(_JEMetricRegistryQueue(), ^{
+        
+        for (NSUInteger i = 0; i < _JEMetricCapacity; ++i) {
+            
+            _JEMetricRetiredCounters[i] += __atomic_load_n(&shard->counters[i], __ATOMIC_RELAXED);
+        }
+        for (_JEMetricShard **link = &_JEMetricShards; *link != NULL; link = &(*link)->next) {
+            
+            if (*link == shard) {
+                
+                *link = shard->next;
+                break;
+            }
+        }
+    });
+    free(shard);
+}
+
+JE_STATIC
+_JEMetricShard *_JEMetricCurrentShard(void) {
+    
+    static pthread_key_t shardKey;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        pthread_key_create(&shardKey, _JEMetricThreadDidExit);
+    });
+    
+    _JEMetricShard *shard = pthread_getspecific(shardKey);
+    if (shard) {
+        
+        return shard;
+    }
+    
+    shard = calloc(1, sizeof(_JEMetricShard));
+    if (!shard) {
+        
+        return NULL;
+    }
+    dispatch_sync(_JEMetricRegistryQueue(), ^{
+        
+        shard->next = _JEMetricShards;
+        _JEMetricShards = shard;
+    });
+    pthread_setspecific(shardKey, shard);
+    return shard;
+}
+
+JE_STATIC
+JEMetric _JEMetricResolve(JEMetric *metric, const char *name, BOOL isGauge) {
+    
+    JEMetric __block resolvedMetric = _JEMetricUnavailable;
+    dispatch_sync(_JEMetricRegistryQueue(), ^{
+        
+        NSMutableDictionary *indexes = (isGauge ? _JEMetricGaugeIndexes : _JEMetricCounterIndexes);
+        NSMutableArray *names = (isGauge ? _JEMetricGaugeNames : _JEMetricCounterNames);
+        
+        NSString *key = ([[NSString alloc] initWithUTF8String:name] ?: @"");
+        NSNumber *index = indexes[key];
+        if (!index) {
+            
+            if ([names count] >= _JEMetricCapacity) {
+                
+                return;
+            }
+            index = @([names count]);
+            indexes[key] = index;
+            [names addObject:key];
+        }
+        resolvedMetric = (JEMetric)([index unsignedIntegerValue] + 1);
+    });
+    __atomic_store_n(metric, resolvedMetric, __ATOMIC_RELAXED);
+    return resolvedMetric;
+}
+
+
+#pragma mark - Public
+
+void JEMetricAdd(JEMetric *metric, const char *name, int64_t amount) {
+    
+    JEMetric resolvedMetric = __atomic_load_n(metric, __ATOMIC_RELAXED);
+    if (resolvedMetric == 0) {
+        
+        resolvedMetric = _JEMetricResolve(metric, name, NO);
+    }
+    if (resolvedMetric == _JEMetricUnavailable) {
+        
+        return;
+    }
+    
+    _JEMetricShard *shard = _JEMetricCurrentShard();
+    if (!shard) {
+        
+        return;
+    }
+    
+    // Only this thread writes to its shard, so the read doesn't need to be atomic.
+    int64_t *counter = &shard->counters[resolvedMetric - 1];
+    __atomic_store_n(counter, (*counter + amount), __ATOMIC_RELAXED);
+}
+
+void JEMetricSetGauge(JEMetric *metric, const char *name, double value) {
+    
+    JEMetric resolvedMetric = __atomic_load_n(metric, __ATOMIC_RELAXED);
+    if (resolvedMetric == 0) {
+        
+        resolvedMetric = _JEMetricResolve(metric, name, YES);
+    }
+    if (resolvedMetric == _JEMetricUnavailable) {
+        
+        return;
+    }
+    
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    __atomic_store_n(&_JEMetricGaugeBits[resolvedMetric - 1], bits, __ATOMIC_RELAXED);
+}
+
+
+#pragma mark - JEMetricSnapshot
+
+@interface JEMetricSnapshot ()
+
+- (instancetype)initWithDate:(NSDate *)date
+                    counters:(NSDictionary *)counters
+              counterChanges:(NSDictionary *)counterChanges
+                      gauges:(NSDictionary *)gauges;
+
+@end
+
+
+@implementation JEMetricSnapshot
+
+#pragma mark - NSObject
+
+- (instancetype)initWithDate:(NSDate *)date
+                    counters:(NSDictionary *)counters
+              counterChanges:(NSDictionary *)counterChanges
+                      gauges:(NSDictionary *)gauges {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _date = date;
+    _counters = [counters copy];
+    _counterChanges = [counterChanges copy];
+    _gauges = [gauges copy];
+    
+    return self;
+}
+
+
+#pragma mark - Public
+
++ (JEMetricSnapshot *)collectSnapshot {
+    
+    NSMutableDictionary *counters = [[NSMutableDictionary alloc] init];
+    NSMutableDictionary *counterChanges = [[NSMutableDictionary alloc] init];
+    NSMutableDictionary *gauges = [[NSMutableDictionary alloc] init];
+    dispatch_sync(_JEMetricRegistryQueue(), ^{
+        
+        [_JEMetricCounterNames enumerateObjectsUsingBlock:^(NSString *name, NSUInteger idx, BOOL *stop) {
+            
+            int64_t total = _JEMetricRetiredCounters[idx];
+            for (_JEMetricShard *shard = _JEMetricShards; shard != NULL; shard = shard->next) {
+                
+                total += __atomic_load_n(&shard->counters[idx], __ATOMIC_RELAXED);
+            }
+            counters[name] = @(total);
+            
+            int64_t change = (total - _JEMetricCollectedCounters[idx]);
+            if (change != 0) {
+                
+                counterChanges[name] = @(change);
+            }
+            _JEMetricCollectedCounters[idx] = total;
+        }];
+        [_JEMetricGaugeNames enumerateObjectsUsingBlock:^(NSString *name, NSUInteger idx, BOOL *stop) {
+            
+            uint64_t bits = __atomic_load_n(&_JEMetricGaugeBits[idx], __ATOMIC_RELAXED);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            gauges[name] = @(value);
+        }];
+    });
+    
+    return [[self alloc]
+            initWithDate:[[NSDate alloc] init]
+            counters:counters
+            counterChanges:counterChanges
+            gauges:gauges];
+}
+
+@end
@@ -0,0 +1,54 @@
+//
+//  JEPrometheusMetricExporter.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JEMetrics.h"
+
+
+/*! JEPrometheusMetricExporter writes each metric snapshot to a local file in the Prometheus text exposition format, replacing the file's previous contents. Metric names are converted to valid Prometheus names by replacing unsupported characters with underscores, so "cache.miss" is written as "cache_miss".
+ */
+@interface JEPrometheusMetricExporter : NSObject <JEMetricExporter>
+
+/*! The file the snapshots are written to.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSURL *fileURL;
+
+/*! Initializes an exporter that writes to the specified file.
+ @param fileURL the file URL to write to. The file is replaced atomically on each export.
+ */
+- (nonnull instancetype)initWithFileURL:(nonnull NSURL *)fileURL NS_DESIGNATED_INITIALIZER;
+
+/*! Use initWithFileURL: instead.
+ */
+- (nonnull instancetype)init NS_UNAVAILABLE;
+
+/*! Formats a snapshot in the Prometheus text exposition format.
+ @param snapshot the metric values to format
+ @return the formatted metrics
+ */
++ (nonnull NSString *)textForMetricSnapshot:(nonnull JEMetricSnapshot *)snapshot;
+
+@end
@@ -0,0 +1,126 @@
+//
+//  JEPrometheusMetricExporter.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JEPrometheusMetricExporter.h"
+
+#include <math.h>
+
+
+JE_STATIC
+NSString *_JEPrometheusMetricName(NSString *name) {
+    
+    NSMutableString *metricName = [[NSMutableString alloc] initWithCapacity:[name length]];
+    [name enumerateSubstringsInRange:NSMakeRange(0, [name length])
+                             options:NSStringEnumerationByComposedCharacterSequences
+                          usingBlock:^(NSString *substring, NSRange substringRange, NSRange enclosingRange, BOOL *stop) {
+                              
+                              unichar character = [substring characterAtIndex:0];
+                              BOOL isValid = ([substring length] == 1
+                                              && ((character >= 'a' && character <= 'z')
+                                                  || (character >= 'A' && character <= 'Z')
+                                                  || (character >= '0' && character <= '9')
+                                                  || character == '_'
+                                                  || character == ':'));
+                              [metricName appendString:(isValid ? substring : @"_")];
+                          }];
+    if ([metricName length] == 0
+        || ([metricName characterAtIndex:0] >= '0' && [metricName characterAtIndex:0] <= '9')) {
+        
+        [metricName insertString:@"_" atIndex:0];
+    }
+    return metricName;
+}
+
+
+@implementation JEPrometheusMetricExporter
+
+#pragma mark - NSObject
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _fileURL = [fileURL copy];
+    
+    return self;
+}
+
+
+#pragma mark - JEMetricExporter
+
+- (void)exportMetricSnapshot:(JEMetricSnapshot *)snapshot {
+    
+    NSData *data = [[[self class] textForMetricSnapshot:snapshot] dataUsingEncoding:NSUTF8StringEncoding];
+    [data writeToURL:self.fileURL options:NSDataWritingAtomic error:NULL];
+}
+
+
+#pragma mark - Public
+
++ (NSString *)textForMetricSnapshot:(JEMetricSnapshot *)snapshot {
+    
+    NSMutableString *text = [[NSMutableString alloc] init];
+    long long timestamp = (long long)([snapshot.date timeIntervalSince1970] * 1000.0);
+    
+    for (NSString *name in [[snapshot.counters allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+        
+        NSString *metricName = _JEPrometheusMetricName(name);
+        [text appendFormat:@"# TYPE %@ counter\n%@ %lld %lld\n",
+         metricName,
+         metricName,
+         [snapshot.counters[name] longLongValue],
+         timestamp];
+    }
+    for (NSString *name in [[snapshot.gauges allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+        
+        NSString *metricName = _JEPrometheusMetricName(name);
+        double value = [snapshot.gauges[name] doubleValue];
+        NSString *valueString;
+        if (isnan(value)) {
+            
+            valueString = @"NaN";
+        }
+        else if (isinf(value)) {
+            
+            valueString = (value > 0 ? @"+Inf" : @"-Inf");
+        }
+        else {
+            
+            valueString = [[NSString alloc] initWithFormat:@"%.17g", value];
+        }
+        [text appendFormat:@"# TYPE %@ gauge\n%@ %@ %lld\n",
+         metricName,
+         metricName,
+         valueString,
+         timestamp];
+    }
+    return text;
+}
+
+@end
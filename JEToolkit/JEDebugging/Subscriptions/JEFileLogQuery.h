@@ -0,0 +1,64 @@
+//
+//  JEFileLogQuery.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JELogFilter.h"
+#import "JELogRecord.h"
+
+
+/*! JEFileLogQuery selects the records read back from log files by JEDebugging's enumerateFileLogRecordsAtURLs:matchingQuery:withBlock: and exportFileLogRecordsAtURLs:matchingQuery:toURL:format:error:.
+ */
+@interface JEFileLogQuery : NSObject <NSCopying>
+
+/*! The earliest time of the records to include. Defaults to nil, which does not limit the start time
+ */
+@property (nonatomic, copy, nullable) NSDate *startDate;
+
+/*! The time before which records are included. Defaults to nil, which does not limit the end time
+ */
+@property (nonatomic, copy, nullable) NSDate *endDate;
+
+/*! The level, file name, and function name filter for the records to include. Records written without a file or function header never match the filter's patterns. Defaults to nil, which includes all records
+ */
+@property (nonatomic, copy, nullable) JELogFilter *filter;
+
+/*! A regular expression searched in the records' messages and dumps. Defaults to nil, which includes all records
+ */
+@property (nonatomic, strong, nullable) NSRegularExpression *messageRegularExpression;
+
+/*! Checks if a record's timestamp is within the query's date range. This check is cheap and is done before the record is parsed.
+ @param timeIntervalSince1970 the record's timestamp
+ @return YES if the timestamp is within the date range, NO otherwise
+ */
+- (BOOL)includesTimeIntervalSince1970:(NSTimeInterval)timeIntervalSince1970;
+
+/*! Checks if a parsed record passes the query.
+ @param record the record to check
+ @return YES if the record passes the query, NO otherwise
+ */
+- (BOOL)matchesRecord:(nonnull JELogRecord *)record;
+
+@end
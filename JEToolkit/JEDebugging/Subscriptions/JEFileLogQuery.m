@@ -0,0 +1,124 @@
+//
+//  JEFileLogQuery.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JEFileLogQuery.h"
+
+
+@implementation JEFileLogQuery {
+    
+    // Cached so that the date range can be checked without messaging NSDate for every record.
+    NSTimeInterval _startTimeIntervalSince1970;
+    NSTimeInterval _endTimeIntervalSince1970;
+}
+
+#pragma mark - NSObject
+
+- (instancetype)init {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _startTimeIntervalSince1970 = -INFINITY;
+    _endTimeIntervalSince1970 = INFINITY;
+    
+    return self;
+}
+
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+    
+    typeof(self) copy = [[[self class] allocWithZone:zone] init];
+    copy.startDate = self.startDate;
+    copy.endDate = self.endDate;
+    copy.filter = self.filter;
+    copy.messageRegularExpression = self.messageRegularExpression;
+    return copy;
+}
+
+
+#pragma mark - Public
+
+- (void)setStartDate:(NSDate *)startDate {
+    
+    _startDate = [startDate copy];
+    _startTimeIntervalSince1970 = (startDate ? [startDate timeIntervalSince1970] : -INFINITY);
+}
+
+- (void)setEndDate:(NSDate *)endDate {
+    
+    _endDate = [endDate copy];
+    _endTimeIntervalSince1970 = (endDate ? [endDate timeIntervalSince1970] : INFINITY);
+}
+
+- (BOOL)includesTimeIntervalSince1970:(NSTimeInterval)timeIntervalSince1970 {
+    
+    return (timeIntervalSince1970 >= _startTimeIntervalSince1970
+            && timeIntervalSince1970 < _endTimeIntervalSince1970);
+}
+
+- (BOOL)matchesRecord:(JELogRecord *)record {
+    
+    if (![self includesTimeIntervalSince1970:[record.date timeIntervalSince1970]]) {
+        
+        return NO;
+    }
+    
+    JELogFilter *filter = self.filter;
+    if (filter
+        && ![filter
+             matchesLevel:record.level
+             fileName:[record.fileName UTF8String]
+             functionName:[record.functionName UTF8String]]) {
+        
+        return NO;
+    }
+    
+    NSRegularExpression *messageRegularExpression = self.messageRegularExpression;
+    if (messageRegularExpression) {
+        
+        NSString *message = record.message;
+        NSString *dump = record.dump;
+        if ([messageRegularExpression
+             rangeOfFirstMatchInString:message
+             options:kNilOptions
+             range:NSMakeRange(0, [message length])].location == NSNotFound
+            && (!dump
+                || [messageRegularExpression
+                    rangeOfFirstMatchInString:dump
+                    options:kNilOptions
+                    range:NSMakeRange(0, [dump length])].location == NSNotFound)) {
+            
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@end
@@ -0,0 +1,57 @@
+//
+//  JELogFilter.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JEBaseLoggerSettings.h"
+
+
+/*! JELogFilter selects the logged messages delivered to a JELogSubscription.
+ */
+@interface JELogFilter : NSObject <NSCopying>
+
+/*! The combination of JELogLevelMask flags that will be delivered. Defaults to JELogLevelAll
+ */
+@property (nonatomic, assign) JELogLevelMask logLevelMask;
+
+/*! A shell wildcard pattern (see fnmatch(3)) matched against the callsite's source file name, such as @"JEHUD*.m". Messages not logged from source code never match a pattern. Defaults to nil, which matches all files
+ */
+@property (nonatomic, copy, nullable) NSString *fileNamePattern;
+
+/*! A shell wildcard pattern (see fnmatch(3)) matched against the callsite's function name, such as @"-[JEHUDLogView *]". Messages not logged from source code never match a pattern. Defaults to nil, which matches all functions
+ */
+@property (nonatomic, copy, nullable) NSString *functionNamePattern;
+
+/*! Checks if a message logged from the specified callsite passes the filter.
+ @param level the level of the logged message
+ @param fileName the callsite's source file name, or NULL
+ @param functionName the callsite's function name, or NULL
+ @return YES if the message passes the filter, NO otherwise
+ */
+- (BOOL)matchesLevel:(JELogLevelMask)level
+            fileName:(nullable const char *)fileName
+        functionName:(nullable const char *)functionName;
+
+@end
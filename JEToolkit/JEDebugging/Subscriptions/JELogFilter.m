@@ -0,0 +1,113 @@
+//
+//  JELogFilter.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogFilter.h"
+
+#include <fnmatch.h>
+#include <stdlib.h>
+#include <string.h>
+
+#import "JESafetyHelpers.h"
+
+
+@implementation JELogFilter {
+    
+    // UTF8 copies of the patterns so matching does not touch NSString on the logging thread.
+    char *_fileNameCPattern;
+    char *_functionNameCPattern;
+}
+
+#pragma mark - NSObject
+
+- (instancetype)init {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _logLevelMask = JELogLevelAll;
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    free(_fileNameCPattern);
+    free(_functionNameCPattern);
+}
+
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+    
+    typeof(self) copy = [[[self class] allocWithZone:zone] init];
+    copy.logLevelMask = self.logLevelMask;
+    copy.fileNamePattern = self.fileNamePattern;
+    copy.functionNamePattern = self.functionNamePattern;
+    return copy;
+}
+
+
+#pragma mark - Public
+
+- (void)setFileNamePattern:(NSString *)fileNamePattern {
+    
+    _fileNamePattern = [fileNamePattern copy];
+    
+    free(_fileNameCPattern);
+    _fileNameCPattern = (fileNamePattern ? strdup([fileNamePattern UTF8String]) : NULL);
+}
+
+- (void)setFunctionNamePattern:(NSString *)functionNamePattern {
+    
+    _functionNamePattern = [functionNamePattern copy];
+    
+    free(_functionNameCPattern);
+    _functionNameCPattern = (functionNamePattern ? strdup([functionNamePattern UTF8String]) : NULL);
+}
+
+- (BOOL)matchesLevel:(JELogLevelMask)level
+            fileName:(const char *)fileName
+        functionName:(const char *)functionName {
+    
+    if (!JEEnumBitmasked(self.logLevelMask, level)) {
+        
+        return NO;
+    }
+    if (_fileNameCPattern && (!fileName || fnmatch(_fileNameCPattern, fileName, 0) != 0)) {
+        
+        return NO;
+    }
+    if (_functionNameCPattern && (!functionName || fnmatch(_functionNameCPattern, functionName, 0) != 0)) {
+        
+        return NO;
+    }
+    return YES;
+}
+
+@end
@@ -0,0 +1,83 @@
+//
+//  JELogRecord.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JEBaseLoggerSettings.h"
+
+
+/*! JELogRecord is a single logged message delivered to JELogSubscription handlers.
+ */
+@interface JELogRecord : NSObject
+
+/*! The level the message was logged with.
+ */
+@property (nonatomic, assign, readonly) JELogLevelMask level;
+
+/*! The time the message was logged.
+ */
+@property (nonatomic, strong, readonly, nonnull) NSDate *date;
+
+/*! The source file name of the logging callsite, or nil if the message was not logged from source code.
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *fileName;
+
+/*! The function name of the logging callsite, or nil if the message was not logged from source code.
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *functionName;
+
+/*! The line number of the logging callsite, or zero if the message was not logged from source code.
+ */
+@property (nonatomic, assign, readonly) NSUInteger lineNumber;
+
+/*! The logged message. For dumps, this is the dumped expression.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSString *message;
+
+/*! The description of the dumped value, or nil if the message was not a dump.
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *dump;
+
+/*! The raw return addresses of the call stack captured when the message was logged, or nil if no call stack was captured. Call stacks are captured for assertion failures, and taken from the exception for dumped and uncaught exceptions.
+ */
+@property (nonatomic, copy, readonly, nullable) NSArray *callStackReturnAddresses;
+
+/*! Symbolicates the captured call stack, formatted like -[NSException callStackSymbols]. Symbols are cached across records, so repeated call stacks are only symbolicated once.
+ @return the symbolicated call stack, or nil if no call stack was captured
+ */
+- (nullable NSArray *)callStackSymbols;
+
+/*! Initializes a log record.
+ */
+- (nonnull instancetype)initWithLevel:(JELogLevelMask)level
+                                 date:(nonnull NSDate *)date
+                             fileName:(nullable NSString *)fileName
+                         functionName:(nullable NSString *)functionName
+                           lineNumber:(NSUInteger)lineNumber
+                              message:(nonnull NSString *)message
+                                 dump:(nullable NSString *)dump
+             callStackReturnAddresses:(nullable NSArray *)callStackReturnAddresses;
+
+@end
@@ -0,0 +1,82 @@
+//
+//  JELogRecord.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogRecord.h"
+
+#import "JECallStackSymbolicator.h"
+
+
+@implementation JELogRecord
+
+#pragma mark - NSObject
+
+- (instancetype)initWithLevel:(JELogLevelMask)level
+                         date:(NSDate *)date
+                     fileName:(NSString *)fileName
+                 functionName:(NSString *)functionName
+                   lineNumber:(NSUInteger)lineNumber
+                      message:(NSString *)message
+                         dump:(NSString *)dump
+     callStackReturnAddresses:(NSArray *)callStackReturnAddresses {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _level = level;
+    _date = date;
+    _fileName = [fileName copy];
+    _functionName = [functionName copy];
+    _lineNumber = lineNumber;
+    _message = [message copy];
+    _dump = [dump copy];
+    _callStackReturnAddresses = [callStackReturnAddresses copy];
+    
+    return self;
+}
+
+- (NSString *)description {
+    
+    return [[NSString alloc] initWithFormat:@"%@ %@:%lu %@",
+            self.date,
+            (self.fileName ?: @"-"),
+            (unsigned long)self.lineNumber,
+            self.message];
+}
+
+
+#pragma mark - Public
+
+- (NSArray *)callStackSymbols {
+    
+    NSArray *callStackReturnAddresses = self.callStackReturnAddresses;
+    return (callStackReturnAddresses
+            ? JECallStackSymbolsForReturnAddresses(callStackReturnAddresses)
+            : nil);
+}
+
+@end
@@ -0,0 +1,50 @@
+//
+//  JELogSubscription.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JELogFilter.h"
+#import "JELogRecord.h"
+
+
+/*! JELogSubscription is a live feed of logged messages returned by +[JEDebugging subscribeWithFilter:queue:handler:].
+ 
+ Each subscription buffers records in its own fixed-capacity lock-free ring buffer, and delivers them in batches on the subscription's queue. Logging threads never wait for a subscriber; when a subscriber falls behind and its buffer is full, only that subscriber's new records are dropped.
+ */
+@interface JELogSubscription : NSObject
+
+/*! The filter the subscription was created with.
+ */
+@property (nonatomic, copy, readonly, nonnull) JELogFilter *filter;
+
+/*! The total number of records dropped because the subscription's buffer was full.
+ */
+@property (nonatomic, assign, readonly) NSUInteger numberOfDroppedRecords;
+
+/*! Checks if the subscription was removed with +[JEDebugging unsubscribe:].
+ */
+@property (nonatomic, assign, readonly, getter=isCancelled) BOOL cancelled;
+
+@end
@@ -0,0 +1,260 @@
+//
+//  JELogSubscription.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogSubscription.h"
+
+#include <stdatomic.h>
+
+
+static const NSUInteger _JELogSubscriptionCapacity = 1024;
+
+
+/*! A slot of the bounded multi-producer single-consumer queue. The sequence number tells producers and the consumer whose turn it is to use the slot.
+ */
+typedef struct _JELogSubscriptionSlot {
+    
+    atomic_size_t sequence;
+    CFTypeRef record;
+    
+} _JELogSubscriptionSlot;
+
+
+
+
+@implementation JELogSubscription {
+    
+    JELogFilter *_filter;
+    dispatch_queue_t _queue;
+    void (^_handler)(NSArray *records, NSUInteger numberOfDroppedRecords);
+    
+    _JELogSubscriptionSlot *_slots;
+    size_t _slotMask;
+    
+    // Claimed by producers from any thread.
+    atomic_size_t _enqueuePosition;
+    
+    // Only accessed by the drain block, of which at most one is scheduled at a time.
+    size_t _dequeuePosition;
+    
+    atomic_bool _isDrainScheduled;
+    atomic_bool _isCancelled;
+    atomic_size_t _numberOfDroppedRecords;
+    atomic_size_t _numberOfUndeliveredDroppedRecords;
+}
+
+#pragma mark - NSObject
+
+- (instancetype)initWithFilter:(JELogFilter *)filter
+                         queue:(dispatch_queue_t)queue
+                       handler:(void (^)(NSArray *records, NSUInteger numberOfDroppedRecords))handler {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _filter = [filter copy];
+    _queue = queue;
+    _handler = [handler copy];
+    
+    _slots = calloc(_JELogSubscriptionCapacity, sizeof(_JELogSubscriptionSlot));
+    _slotMask = (_JELogSubscriptionCapacity - 1);
+    for (size_t i = 0; i < _JELogSubscriptionCapacity; ++i) {
+        
+        atomic_init(&_slots[i].sequence, i);
+    }
+    atomic_init(&_enqueuePosition, 0);
+    atomic_init(&_isDrainScheduled, false);
+    atomic_init(&_isCancelled, false);
+    atomic_init(&_numberOfDroppedRecords, 0);
+    atomic_init(&_numberOfUndeliveredDroppedRecords, 0);
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    for (size_t i = 0; i < _JELogSubscriptionCapacity; ++i) {
+        
+        if (_slots[i].record) {
+            
+            CFRelease(_slots[i].record);
+        }
+    }
+    free(_slots);
+}
+
+
+#pragma mark - Private
+
+- (BOOL)enqueueRecord:(JELogRecord *)record {
+    
+    size_t position = atomic_load_explicit(&_enqueuePosition, memory_order_relaxed);
+    _JELogSubscriptionSlot *slot;
+    while (YES) {
+        
+        slot = &_slots[position & _slotMask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = ((intptr_t)sequence - (intptr_t)position);
+        if (difference == 0) {
+            
+            if (atomic_compare_exchange_weak_explicit(&_enqueuePosition,
+                                                      &position,
+                                                      (position + 1),
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                
+                break;
+            }
+        }
+        else if (difference < 0) {
+            
+            // Full. Dropping keeps the logging thread from ever waiting on this subscriber.
+            atomic_fetch_add_explicit(&_numberOfDroppedRecords, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&_numberOfUndeliveredDroppedRecords, 1, memory_order_relaxed);
+            return NO;
+        }
+        else {
+            
+            position = atomic_load_explicit(&_enqueuePosition, memory_order_relaxed);
+        }
+    }
+    
+    slot->record = CFBridgingRetain(record);
+    atomic_store_explicit(&slot->sequence, (position + 1), memory_order_release);
+    return YES;
+}
+
+- (JELogRecord *)dequeueRecord {
+    
+    _JELogSubscriptionSlot *slot = &_slots[_dequeuePosition & _slotMask];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (((intptr_t)sequence - (intptr_t)(_dequeuePosition + 1)) < 0) {
+        
+        return nil;
+    }
+    
+    JELogRecord *record = CFBridgingRelease(slot->record);
+    slot->record = NULL;
+    atomic_store_explicit(&slot->sequence, (_dequeuePosition + _slotMask + 1), memory_order_release);
+    ++_dequeuePosition;
+    return record;
+}
+
+- (BOOL)hasPendingRecords {
+    
+    _JELogSubscriptionSlot *slot = &_slots[_dequeuePosition & _slotMask];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    return (((intptr_t)sequence - (intptr_t)(_dequeuePosition + 1)) >= 0
+            || atomic_load_explicit(&_numberOfUndeliveredDroppedRecords, memory_order_relaxed) > 0);
+}
+
+- (void)scheduleDrainIfNeeded {
+    
+    if (atomic_exchange(&_isDrainScheduled, true)) {
+        
+        return;
+    }
+    
+    dispatch_async(_queue, ^{
+        
+        [self drain];
+    });
+}
+
+- (void)drain {
+    
+    while (YES) {
+        
+        @autoreleasepool {
+            
+            NSMutableArray *records = [[NSMutableArray alloc] init];
+            JELogRecord *record;
+            while ([records count] < _JELogSubscriptionCapacity && (record = [self dequeueRecord])) {
+                
+                [records addObject:record];
+            }
+            
+            NSUInteger numberOfDroppedRecords = atomic_exchange(&_numberOfUndeliveredDroppedRecords, 0);
+            if (([records count] > 0 || numberOfDroppedRecords > 0) && !self.isCancelled) {
+                
+                _handler(records, numberOfDroppedRecords);
+            }
+        }
+        
+        atomic_store(&_isDrainScheduled, false);
+        
+        // A producer may have enqueued after the buffer was emptied but before the flag was cleared, in which case it did not schedule a drain.
+        if (![self hasPendingRecords] || atomic_exchange(&_isDrainScheduled, true)) {
+            
+            return;
+        }
+    }
+}
+
+- (BOOL)matchesLevel:(JELogLevelMask)level
+            fileName:(const char *)fileName
+        functionName:(const char *)functionName {
+    
+    return [_filter matchesLevel:level fileName:fileName functionName:functionName];
+}
+
+- (void)publishRecord:(JELogRecord *)record {
+    
+    if (self.isCancelled) {
+        
+        return;
+    }
+    
+    [self enqueueRecord:record];
+    [self scheduleDrainIfNeeded];
+}
+
+- (void)cancel {
+    
+    atomic_store(&_isCancelled, true);
+}
+
+
+#pragma mark - Public
+
+- (JELogFilter *)filter {
+    
+    // The filter is used from logging threads, so only copies are handed out.
+    return [_filter copy];
+}
+
+- (NSUInteger)numberOfDroppedRecords {
+    
+    return atomic_load_explicit(&_numberOfDroppedRecords, memory_order_relaxed);
+}
+
+- (BOOL)isCancelled {
+    
+    return atomic_load(&_isCancelled);
+}
+
+@end
@@ -0,0 +1,52 @@
+//
+//  JECallStackSymbolicator.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#ifndef JEToolkit_JECallStackSymbolicator_h
+#define JEToolkit_JECallStackSymbolicator_h
+
+#import "JECompilerDefines.h"
+
+
+/*! Call stack capture and symbolication used by JEDebugging. Capturing only records raw return addresses so it is cheap enough for failing threads; symbolication is done separately and caches each address's symbol so call stacks from the same site are only symbolicated once. Used internally by JEDebugging.
+ */
+
+/*! Captures the current thread's call stack as raw return addresses.
+ @param numberOfFramesToSkip the number of innermost frames to omit, not counting this function's frame
+ @return an array of NSNumbers in the same form as -[NSException callStackReturnAddresses]
+ */
+JE_EXTERN
+NSArray *_Nonnull JECallStackCaptureReturnAddresses(NSUInteger numberOfFramesToSkip);
+
+/*! Symbolicates raw return addresses into lines formatted like -[NSException callStackSymbols]. Thread-safe.
+ @param returnAddresses an array of NSNumbers from JECallStackCaptureReturnAddresses() or -[NSException callStackReturnAddresses]
+ @return an array of NSStrings, one for each address
+ */
+JE_EXTERN
+NSArray *_Nonnull JECallStackSymbolsForReturnAddresses(NSArray *_Nonnull returnAddresses);
+
+
+#endif
@@ -0,0 +1,109 @@
+//
+//  JECallStackSymbolicator.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JECallStackSymbolicator.h"
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <string.h>
+
+
+static const int _JECallStackMaximumNumberOfFrames = 128;
+
+
+JE_STATIC
+NSCache *_JECallStackSymbolCache(void) {
+    
+    static NSCache *symbolCache;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        symbolCache = [[NSCache alloc] init];
+        symbolCache.name = @"JECallStackSymbolicator";
+        symbolCache.countLimit = 4096;
+    });
+    return symbolCache;
+}
+
+JE_STATIC
+NSString *_JECallStackSymbolForAddress(uintptr_t address) {
+    
+    Dl_info info;
+    if (dladdr((const void *)address, &info) == 0) {
+        
+        return [[NSString alloc] initWithFormat:@"%-35s 0x%016llx", "???", (unsigned long long)address];
+    }
+    
+    const char *imagePath = (info.dli_fname ?: "???");
+    const char *imageName = strrchr(imagePath, '/');
+    imageName = (imageName ? (imageName + 1) : imagePath);
+    
+    if (info.dli_sname) {
+        
+        return [[NSString alloc] initWithFormat:@"%-35s 0x%016llx %s + %llu",
+                imageName,
+                (unsigned long long)address,
+                info.dli_sname,
+                (unsigned long long)(address - (uintptr_t)info.dli_saddr)];
+    }
+    return [[NSString alloc] initWithFormat:@"%-35s 0x%016llx 0x%llx + %llu",
+            imageName,
+            (unsigned long long)address,
+            (unsigned long long)(uintptr_t)info.dli_fbase,
+            (unsigned long long)(address - (uintptr_t)info.dli_fbase)];
+}
+
+
+NSArray *JECallStackCaptureReturnAddresses(NSUInteger numberOfFramesToSkip) {
+    
+    void *frames[_JECallStackMaximumNumberOfFrames];
+    int numberOfFrames = backtrace(frames, _JECallStackMaximumNumberOfFrames);
+    
+    // Skip this function's own frame as well.
+    NSUInteger firstFrame = MIN((NSUInteger)numberOfFrames, (numberOfFramesToSkip + 1));
+    NSMutableArray *returnAddresses = [[NSMutableArray alloc] initWithCapacity:((NSUInteger)numberOfFrames - firstFrame)];
+    for (NSUInteger i = firstFrame; i < (NSUInteger)numberOfFrames; ++i) {
+        
+        [returnAddresses addObject:@((uintptr_t)frames[i])];
+    }
+    return returnAddresses;
+}
+
+NSArray *JECallStackSymbolsForReturnAddresses(NSArray *returnAddresses) {
+    
+    NSCache *symbolCache = _JECallStackSymbolCache();
+    NSMutableArray *symbols = [[NSMutableArray alloc] initWithCapacity:[returnAddresses count]];
+    [returnAddresses enumerateObjectsUsingBlock:^(NSNumber *returnAddress, NSUInteger idx, BOOL *stop) {
+        
+        NSString *symbol = [symbolCache objectForKey:returnAddress];
+        if (!symbol) {
+            
+            symbol = _JECallStackSymbolForAddress((uintptr_t)[returnAddress unsignedLongLongValue]);
+            [symbolCache setObject:symbol forKey:returnAddress];
+        }
+        [symbols addObject:[[NSString alloc] initWithFormat:@"%-4lu%@", (unsigned long)idx, symbol]];
+    }];
+    return symbols;
+}
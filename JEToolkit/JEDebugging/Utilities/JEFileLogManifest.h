@@ -0,0 +1,122 @@
+//
+//  JEFileLogManifest.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JECompilerDefines.h"
+
+
+/*! Metadata for a single log file tracked by JEFileLogManifest. Used internally by JEDebugging.
+ */
+@interface JEFileLogSegment : NSObject
+
+/*! The log file's name, relative to the manifest's directory.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSString *fileName;
+
+/*! The number of bytes written to the log file.
+ */
+@property (nonatomic, assign) unsigned long long fileSize;
+
+/*! The time of the first record written to the log file, in seconds since 1970.
+ */
+@property (nonatomic, assign) NSTimeInterval firstTimestamp;
+
+/*! The time of the last record written to the log file, in seconds since 1970.
+ */
+@property (nonatomic, assign) NSTimeInterval lastTimestamp;
+
+/*! The number of records written to the log file. Zero for files that were tracked by rebuilding the manifest from an existing directory.
+ */
+@property (nonatomic, assign) NSUInteger numberOfRecords;
+
+/*! The process that writes to the log file, or zero if unknown.
+ */
+@property (nonatomic, assign) pid_t processIdentifier;
+
+@end
+
+
+/*! JEFileLogManifest keeps the list of log files in a logs directory so that the file logger does not need to scan the directory and read extended attributes whenever logs are enumerated or cleaned up. The manifest is persisted as a hidden property list inside the logs directory and is updated incrementally as files are created, appended to, and deleted. Multiple processes may share a logs directory; each process only overwrites the segments it changed when saving. Used internally by JEDebugging.
+ 
+ JEFileLogManifest is not thread-safe; JEDebugging only accesses it from its file logging queue.
+ */
+@interface JEFileLogManifest : NSObject
+
+/*! Initializes an empty manifest for the specified directory. Call loadWithError: to read the persisted manifest.
+ @param directoryURL the logs directory
+ */
+- (nonnull instancetype)initWithDirectoryURL:(nonnull NSURL *)directoryURL;
+
+/*! The logs directory tracked by the receiver.
+ */
+@property (nonatomic, copy, readonly, nonnull) NSURL *directoryURL;
+
+/*! Reads the persisted manifest, replacing the receiver's segments except for unsaved changes. Segments whose files no longer exist are removed.
+ @param error the error if the manifest does not exist or could not be read
+ @return YES if the manifest was loaded, NO otherwise
+ */
+- (BOOL)loadWithError:(NSError *_Nullable *_Nullable)error;
+
+/*! Reads the persisted manifest like loadWithError:, but only if the manifest file's modification date, size or file number changed since the receiver last read or wrote it.
+ @param error the error if the manifest does not exist or could not be read
+ @return YES if the receiver is up to date with the persisted manifest, NO otherwise
+ */
+- (BOOL)loadIfModifiedWithError:(NSError *_Nullable *_Nullable)error;
+
+/*! Persists the manifest if it changed since it was last saved, merging segments saved by other processes. The merge and the write hold an exclusive lock on a hidden lock file in the directory, so concurrent saves from other processes never drop this process's segments.
+ @param error the error if the manifest could not be written
+ @return YES if the manifest is up to date on disk, NO otherwise
+ */
+- (BOOL)synchronizeWithError:(NSError *_Nullable *_Nullable)error;
+
+/*! Returns the tracked segments, ordered by the timestamp of their last record from the most recent up to the oldest file.
+ */
+- (nonnull NSArray *)segments;
+
+/*! Returns the segment for the specified file name, or nil if the file is not tracked.
+ */
+- (nullable JEFileLogSegment *)segmentWithFileName:(nonnull NSString *)fileName;
+
+/*! Starts tracking a file. Returns the existing segment if the file is already tracked.
+ */
+- (nonnull JEFileLogSegment *)addSegmentWithFileName:(nonnull NSString *)fileName;
+
+/*! Stops tracking a file.
+ */
+- (void)removeSegment:(nonnull JEFileLogSegment *)segment;
+
+/*! Updates a segment's size, timestamps and record count after a record was appended to its file.
+ @param timestamp the time the record was logged, in seconds since 1970
+ */
+- (void)recordAppendedToSegment:(nonnull JEFileLogSegment *)segment
+                         length:(unsigned long long)length
+                      timestamp:(NSTimeInterval)timestamp;
+
+/*! Marks a segment as changed after its properties were modified directly.
+ */
+- (void)segmentDidChange:(nonnull JEFileLogSegment *)segment;
+
+@end
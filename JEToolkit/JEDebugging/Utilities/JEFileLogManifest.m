@@ -0,0 +1,473 @@
+//
+//  JEFileLogManifest.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JEFileLogManifest.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+
+static NSString *const _JEFileLogManifestFileName = @".JEDebuggingLogManifest.plist";
+static NSString *const _JEFileLogManifestLockFileName = @".JEDebuggingLogManifest.lock";
+static const NSInteger _JEFileLogManifestVersion = 1;
+
+static NSString *const _JEFileLogManifestVersionKey = @"version";
+static NSString *const _JEFileLogManifestSegmentsKey = @"segments";
+static NSString *const _JEFileLogSegmentFileNameKey = @"fileName";
+static NSString *const _JEFileLogSegmentFileSizeKey = @"fileSize";
+static NSString *const _JEFileLogSegmentFirstTimestampKey = @"firstTimestamp";
+static NSString *const _JEFileLogSegmentLastTimestampKey = @"lastTimestamp";
+static NSString *const _JEFileLogSegmentNumberOfRecordsKey = @"numberOfRecords";
+static NSString *const _JEFileLogSegmentProcessIdentifierKey = @"processIdentifier";
+
+
+#pragma mark - JEFileLogSegment
+
+@interface JEFileLogSegment ()
+
+@property (nonatomic, copy) NSString *fileName;
+
+- (instancetype)initWithFileName:(NSString *)fileName;
+- (instancetype)initWithPropertyList:(NSDictionary *)propertyList;
+- (NSDictionary *)propertyList;
+- (void)setPropertiesFromSegment:(JEFileLogSegment *)segment;
+
+@end
+
+
+@implementation JEFileLogSegment
+
+#pragma mark - Private
+
+- (instancetype)initWithFileName:(NSString *)fileName {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _fileName = [fileName copy];
+    
+    return self;
+}
+
+- (instancetype)initWithPropertyList:(NSDictionary *)propertyList {
+    
+    NSString *fileName = propertyList[_JEFileLogSegmentFileNameKey];
+    if (![fileName isKindOfClass:[NSString class]] || [fileName length] <= 0) {
+        
+        return nil;
+    }
+    
+    self = [self initWithFileName:fileName];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _fileSize = [propertyList[_JEFileLogSegmentFileSizeKey] unsignedLongLongValue];
+    _firstTimestamp = [propertyList[_JEFileLogSegmentFirstTimestampKey] doubleValue];
+    _lastTimestamp = [propertyList[_JEFileLogSegmentLastTimestampKey] doubleValue];
+    _numberOfRecords = [propertyList[_JEFileLogSegmentNumberOfRecordsKey] unsignedIntegerValue];
+    _processIdentifier = [propertyList[_JEFileLogSegmentProcessIdentifierKey] intValue];
+    
+    return self;
+}
+
+- (NSDictionary *)propertyList {
+    
+    return @{ _JEFileLogSegmentFileNameKey : self.fileName,
+              _JEFileLogSegmentFileSizeKey : @(self.fileSize),
+              _JEFileLogSegmentFirstTimestampKey : @(self.firstTimestamp),
+              _JEFileLogSegmentLastTimestampKey : @(self.lastTimestamp),
+              _JEFileLogSegmentNumberOfRecordsKey : @(self.numberOfRecords),
+              _JEFileLogSegmentProcessIdentifierKey : @(self.processIdentifier) };
+}
+
+- (void)setPropertiesFromSegment:(JEFileLogSegment *)segment {
+    
+    self.fileSize = segment.fileSize;
+    self.firstTimestamp = segment.firstTimestamp;
+    self.lastTimestamp = segment.lastTimestamp;
+    self.numberOfRecords = segment.numberOfRecords;
+    self.processIdentifier = segment.processIdentifier;
+}
+
+@end
+
+
+#pragma mark - JEFileLogManifest
+
+@interface JEFileLogManifest ()
+
+@property (nonatomic, strong, readonly) NSMutableDictionary *segmentsByFileName;
+@property (nonatomic, strong, readonly) NSMutableDictionary *changedSegmentsByFileName;
+@property (nonatomic, strong, readonly) NSMutableSet *removedFileNames;
+@property (nonatomic, copy) NSDictionary *persistedFileAttributes;
+
+@end
+
+
+@implementation JEFileLogManifest
+
+#pragma mark - NSObject
+
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL {
+    
+    NSParameterAssert(directoryURL != nil);
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _directoryURL = [directoryURL copy];
+    _segmentsByFileName = [[NSMutableDictionary alloc] init];
+    _changedSegmentsByFileName = [[NSMutableDictionary alloc] init];
+    _removedFileNames = [[NSMutableSet alloc] init];
+    
+    return self;
+}
+
+
+#pragma mark - Private
+
+- (NSURL *)manifestURL {
+    
+    return [self.directoryURL URLByAppendingPathComponent:_JEFileLogManifestFileName isDirectory:NO];
+}
+
+
+- (int)lockManifestWithError:(NSError **)error {
+    
+    // The lock is taken on a separate file because saves replace the manifest atomically, which would leave a lock on the manifest itself held on an unlinked file.
+    NSURL *lockURL = [self.directoryURL URLByAppendingPathComponent:_JEFileLogManifestLockFileName isDirectory:NO];
+    int fileDescriptor = open([lockURL fileSystemRepresentation], (O_RDWR | O_CREAT | O_CLOEXEC), 0644);
+    if (fileDescriptor < 0) {
+        
+        if (error) {
+            
+            (*error) = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{ NSURLErrorKey : lockURL }];
+        }
+        return -1;
+    }
+    while (flock(fileDescriptor, LOCK_EX) != 0) {
+        
+        if (errno != EINTR) {
+            
+            if (error) {
+                
+                (*error) = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{ NSURLErrorKey : lockURL }];
+            }
+            close(fileDescriptor);
+            return -1;
+        }
+    }
+    return fileDescriptor;
+}
+
+- (void)unlockManifest:(int)fileDescriptor {
+    
+    flock(fileDescriptor, LOCK_UN);
+    close(fileDescriptor);
+}
+
+- (NSDictionary *)manifestFileAttributes {
+    
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:[[self manifestURL] path] error:NULL];
+    if (!attributes) {
+        
+        return nil;
+    }
+    
+    // Saves are atomic, so a save from any process also replaces the file number even when the date and size happen to match.
+    NSMutableDictionary *fileAttributes = [[NSMutableDictionary alloc] initWithCapacity:3];
+    for (NSString *key in @[NSFileModificationDate, NSFileSize, NSFileSystemFileNumber]) {
+        
+        id value = attributes[key];
+        if (value) {
+            
+            fileAttributes[key] = value;
+        }
+    }
+    return fileAttributes;
+}
+
+- (NSDictionary *)readPersistedSegmentsWithError:(NSError **)error {
+    
+    // The attributes are read first so that a save racing with the read is picked up by the next load.
+    NSDictionary *fileAttributes = [self manifestFileAttributes];
+    NSData *data = [[NSData alloc] initWithContentsOfURL:[self manifestURL] options:kNilOptions error:error];
+    if (!data) {
+        
+        return nil;
+    }
+    
+    NSDictionary *propertyList = [NSPropertyListSerialization
+                                  propertyListWithData:data
+                                  options:NSPropertyListImmutable
+                                  format:NULL
+                                  error:error];
+    if (![propertyList isKindOfClass:[NSDictionary class]]
+        || [propertyList[_JEFileLogManifestVersionKey] integerValue] != _JEFileLogManifestVersion) {
+        
+        if (error && !*error) {
+            
+            (*error) = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:nil];
+        }
+        return nil;
+    }
+    
+    NSMutableDictionary *segmentsByFileName = [[NSMutableDictionary alloc] init];
+    for (NSDictionary *segmentPropertyList in propertyList[_JEFileLogManifestSegmentsKey]) {
+        
+        if (![segmentPropertyList isKindOfClass:[NSDictionary class]]) {
+            
+            continue;
+        }
+        
+        JEFileLogSegment *segment = [[JEFileLogSegment alloc] initWithPropertyList:segmentPropertyList];
+        if (segment) {
+            
+            segmentsByFileName[segment.fileName] = segment;
+        }
+    }
+    self.persistedFileAttributes = fileAttributes;
+    return segmentsByFileName;
+}
+
+- (void)mergePersistedSegments:(NSDictionary *)persistedSegmentsByFileName {
+    
+    // Other processes sharing the directory own their own segments, so only the segments changed by this process take precedence over the persisted ones.
+    NSMutableDictionary *segmentsByFileName = self.segmentsByFileName;
+    NSDictionary *changedSegmentsByFileName = self.changedSegmentsByFileName;
+    for (NSString *fileName in [segmentsByFileName allKeys]) {
+        
+        if (!persistedSegmentsByFileName[fileName] && !changedSegmentsByFileName[fileName]) {
+            
+            [segmentsByFileName removeObjectForKey:fileName];
+        }
+    }
+    
+    NSSet *removedFileNames = self.removedFileNames;
+    [persistedSegmentsByFileName enumerateKeysAndObjectsUsingBlock:^(NSString *fileName, JEFileLogSegment *persistedSegment, BOOL *stop) {
+        
+        if ([removedFileNames containsObject:fileName] || changedSegmentsByFileName[fileName]) {
+            
+            return;
+        }
+        
+        JEFileLogSegment *segment = segmentsByFileName[fileName];
+        if (segment) {
+            
+            [segment setPropertiesFromSegment:persistedSegment];
+        }
+        else {
+            
+            segmentsByFileName[fileName] = persistedSegment;
+        }
+    }];
+}
+
+
+- (void)removeSegmentsWithMissingFiles {
+    
+    // Files deleted outside the logger are dropped here so that they are not listed or read. Segments changed by this process are for files it has just written.
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSURL *directoryURL = self.directoryURL;
+    NSDictionary *changedSegmentsByFileName = self.changedSegmentsByFileName;
+    for (JEFileLogSegment *segment in [self.segmentsByFileName allValues]) {
+        
+        if (changedSegmentsByFileName[segment.fileName]) {
+            
+            continue;
+        }
+        if (![fileManager fileExistsAtPath:[[directoryURL URLByAppendingPathComponent:segment.fileName isDirectory:NO] path]]) {
+            
+            [self removeSegment:segment];
+        }
+    }
+}
+
+
+- (BOOL)synchronizeLockedWithError:(NSError **)error {
+    
+    NSDictionary *persistedSegmentsByFileName = [self readPersistedSegmentsWithError:NULL];
+    if (persistedSegmentsByFileName) {
+        
+        [self mergePersistedSegments:persistedSegmentsByFileName];
+    }
+    
+    NSMutableArray *segmentPropertyLists = [[NSMutableArray alloc] initWithCapacity:[self.segmentsByFileName count]];
+    for (JEFileLogSegment *segment in [self.segmentsByFileName objectEnumerator]) {
+        
+        [segmentPropertyLists addObject:[segment propertyList]];
+    }
+    
+    NSData *data = [NSPropertyListSerialization
+                    dataWithPropertyList:@{ _JEFileLogManifestVersionKey : @(_JEFileLogManifestVersion),
+                                            _JEFileLogManifestSegmentsKey : segmentPropertyLists }
+                    format:NSPropertyListBinaryFormat_v1_0
+                    options:kNilOptions
+                    error:error];
+    if (!data || ![data writeToURL:[self manifestURL] options:NSDataWritingAtomic error:error]) {
+        
+        return NO;
+    }
+    
+    // The merge above read everything saved before this write, so the file as written needs no reload.
+    self.persistedFileAttributes = (persistedSegmentsByFileName ? [self manifestFileAttributes] : nil);
+    [self.changedSegmentsByFileName removeAllObjects];
+    [self.removedFileNames removeAllObjects];
+    return YES;
+}
+
+
+#pragma mark - Public
+
+- (BOOL)loadWithError:(NSError **)error {
+    
+    NSDictionary *persistedSegmentsByFileName = [self readPersistedSegmentsWithError:error];
+    if (!persistedSegmentsByFileName) {
+        
+        return NO;
+    }
+    
+    [self mergePersistedSegments:persistedSegmentsByFileName];
+    [self removeSegmentsWithMissingFiles];
+    return YES;
+}
+
+- (BOOL)loadIfModifiedWithError:(NSError **)error {
+    
+    NSDictionary *persistedFileAttributes = self.persistedFileAttributes;
+    if (persistedFileAttributes && [persistedFileAttributes isEqualToDictionary:[self manifestFileAttributes]]) {
+        
+        return YES;
+    }
+    return [self loadWithError:error];
+}
+
+- (BOOL)synchronizeWithError:(NSError **)error {
+    
+    if ([self.changedSegmentsByFileName count] <= 0 && [self.removedFileNames count] <= 0) {
+        
+        return YES;
+    }
+    
+    // Records are written without any lock, but the read-merge-write of the manifest holds an exclusive lock shared by every process logging to the directory. Otherwise a save racing with another process's could drop that process's segments, which would then never be listed or deleted. The lock is only held for the merge and the write.
+    int lockFileDescriptor = [self lockManifestWithError:error];
+    if (lockFileDescriptor < 0) {
+        
+        return NO;
+    }
+    @try {
+        
+        return [self synchronizeLockedWithError:error];
+    }
+    @finally {
+        
+        [self unlockManifest:lockFileDescriptor];
+    }
+}
+
+- (NSArray *)segments {
+    
+    return [[self.segmentsByFileName allValues]
+            sortedArrayUsingComparator:^NSComparisonResult(JEFileLogSegment *segment1, JEFileLogSegment *segment2) {
+                
+                // File names start with the app name and version, so they only order files written by the same build.
+                if (segment1.lastTimestamp != segment2.lastTimestamp) {
+                    
+                    return (segment1.lastTimestamp < segment2.lastTimestamp ? NSOrderedDescending : NSOrderedAscending);
+                }
+                if (segment1.firstTimestamp != segment2.firstTimestamp) {
+                    
+                    return (segment1.firstTimestamp < segment2.firstTimestamp ? NSOrderedDescending : NSOrderedAscending);
+                }
+                return [segment2.fileName compare:segment1.fileName];
+            }];
+}
+
+- (JEFileLogSegment *)segmentWithFileName:(NSString *)fileName {
+    
+    return self.segmentsByFileName[fileName];
+}
+
+- (JEFileLogSegment *)addSegmentWithFileName:(NSString *)fileName {
+    
+    NSParameterAssert(fileName != nil);
+    
+    JEFileLogSegment *segment = self.segmentsByFileName[fileName];
+    if (segment) {
+        
+        return segment;
+    }
+    
+    segment = [[JEFileLogSegment alloc] initWithFileName:fileName];
+    self.segmentsByFileName[fileName] = segment;
+    [self.removedFileNames removeObject:fileName];
+    self.changedSegmentsByFileName[fileName] = segment;
+    return segment;
+}
+
+- (void)removeSegment:(JEFileLogSegment *)segment {
+    
+    NSParameterAssert(segment != nil);
+    
+    NSString *fileName = segment.fileName;
+    [self.segmentsByFileName removeObjectForKey:fileName];
+    [self.changedSegmentsByFileName removeObjectForKey:fileName];
+    [self.removedFileNames addObject:fileName];
+}
+
+- (void)recordAppendedToSegment:(JEFileLogSegment *)segment
+                         length:(unsigned long long)length
+                      timestamp:(NSTimeInterval)timestamp {
+    
+    NSParameterAssert(segment != nil);
+    
+    // Records can reach the file slightly out of order, since they are timestamped when logged rather than when written.
+    if (segment.firstTimestamp <= 0 || timestamp < segment.firstTimestamp) {
+        
+        segment.firstTimestamp = timestamp;
+    }
+    segment.lastTimestamp = MAX(segment.lastTimestamp, timestamp);
+    segment.fileSize += length;
+    segment.numberOfRecords += 1;
+    [self segmentDidChange:segment];
+}
+
+- (void)segmentDidChange:(JEFileLogSegment *)segment {
+    
+    NSParameterAssert(segment != nil);
+    
+    self.changedSegmentsByFileName[segment.fileName] = segment;
+}
+
+@end
@@ -0,0 +1,54 @@
+//
+//  JEFileLogReader.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JECompilerDefines.h"
+
+
+/*! JEFileLogReader merges the records of multiple log files into a single chronological sequence. Files are memory-mapped and read sequentially in batches, and pages already read are released, so only a small window of each file is kept in memory regardless of the files' sizes. Each file reads its next batch on a background queue while the current one is consumed, so multiple files are read in parallel. Used internally by JEDebugging.
+ 
+ Records are separated by a newline in JSON Lines files (with the "jsonl" extension) and by an empty line in text files. Each record's time is read from its leading timestamp; records without one are ordered with the record before it in the same file.
+ */
+@interface JEFileLogReader : NSObject
+
+/*! Initializes a reader for the specified log files.
+ @param fileURLs the log files to merge
+ */
+- (nonnull instancetype)initWithFileURLs:(nonnull NSArray *)fileURLs;
+
+/*! Enumerates the records of all files, starting with the oldest record.
+ @param block The iteration block. The @p record does not include the record separator. Set the @p stop argument to @p YES to terminate the enumeration.
+ */
+- (void)enumerateRecordsWithBlock:(nonnull void (^)(NSString *_Nonnull fileName, NSTimeInterval timestamp, NSData *_Nonnull record, BOOL *_Nonnull stop))block;
+
+/*! Enumerates the records of all files, starting with the oldest record, after converting each record with a transform block. Use this to parse and filter records in parallel across files.
+ @param transform The block that converts a record to the object passed to @p block, or returns nil to skip the record. Called on background queues, concurrently for different files but in order for the records of a single file, and never after this method returns. Pass nil to pass the records unchanged.
+ @param block The iteration block. Set the @p stop argument to @p YES to terminate the enumeration; records being read ahead are discarded after at most one more call to @p transform per file.
+ */
+- (void)enumerateRecordsWithTransform:(nullable id _Nullable (^)(NSString *_Nonnull fileName, NSTimeInterval timestamp, NSData *_Nonnull record))transform
+                           usingBlock:(nonnull void (^)(NSString *_Nonnull fileName, NSTimeInterval timestamp, id _Nonnull object, BOOL *_Nonnull stop))block;
+
+@end
@@ -0,0 +1,475 @@
+//
+//  JEFileLogReader.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JEFileLogReader.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static const NSUInteger _JEFileLogReaderMaximumNumberOfRecordsPerBatch = 256;
+static const NSUInteger _JEFileLogReaderMaximumBatchLength = (256 * 1024);
+
+
+JE_STATIC
+BOOL _JEFileLogReaderParseTimestamp(const char *bytes, NSUInteger length, NSTimeInterval *timestamp) {
+    
+    // Matches both "yyyy-MM-dd HH:mm:ss.SSS" (text headers) and "yyyy-MM-ddTHH:mm:ss.SSSZ" (JSON Lines), both in UTC.
+    static const NSUInteger timestampLength = 23;
+    if (length < timestampLength) {
+        
+        return NO;
+    }
+    
+    char string[timestampLength + 1];
+    memcpy(string, bytes, timestampLength);
+    string[timestampLength] = '\0';
+    
+    struct tm components = {0};
+    char separator;
+    int milliseconds;
+    if (sscanf(string, "%4d-%2d-%2d%c%2d:%2d:%2d.%3d",
+               &components.tm_year,
+               &components.tm_mon,
+               &components.tm_mday,
+               &separator,
+               &components.tm_hour,
+               &components.tm_min,
+               &components.tm_sec,
+               &milliseconds) != 8
+        || (separator != ' ' && separator != 'T')) {
+        
+        return NO;
+    }
+    
+    components.tm_year -= 1900;
+    components.tm_mon -= 1;
+    (*timestamp) = ((NSTimeInterval)timegm(&components) + ((NSTimeInterval)milliseconds / 1000.0));
+    return YES;
+}
+
+
+#pragma mark - _JEFileLogReaderEntry
+
+@interface _JEFileLogReaderEntry : NSObject
+
+@property (nonatomic, assign) NSTimeInterval timestamp;
+@property (nonatomic, assign) BOOL isContinuation;
+@property (nonatomic, strong) id object;
+
+@end
+
+
+@implementation _JEFileLogReaderEntry
+
+@end
+
+
+#pragma mark - _JEFileLogRecordCursor
+
+@interface _JEFileLogRecordCursor : NSObject
+
+@property (nonatomic, copy, readonly) NSString *fileName;
+@property (nonatomic, strong, readonly) _JEFileLogReaderEntry *entry;
+
+@end
+
+
+@implementation _JEFileLogRecordCursor {
+    
+    // The whole file is mapped read-only; pages behind the read offset are released after each batch so that resident memory stays around the size of a batch regardless of the file's size.
+    const char *_bytes;
+    size_t _length;
+    size_t _offset;
+    size_t _releasedLength;
+    BOOL _isJSONLines;
+    NSTimeInterval _lastTimestamp;
+    id (^_transform)(NSString *fileName, NSTimeInterval timestamp, NSData *record);
+    
+    // Only accessed from the enumerating thread.
+    NSArray *_entries;
+    NSUInteger _entryIndex;
+    
+    // Written by the read-ahead block and read after waiting on the group.
+    dispatch_group_t _readAheadGroup;
+    NSArray *_readAheadEntries;
+    atomic_bool _isStopped;
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+                      transform:(id (^)(NSString *fileName, NSTimeInterval timestamp, NSData *record))transform {
+    
+    int fileDescriptor = open([[fileURL path] fileSystemRepresentation], O_RDONLY);
+    if (fileDescriptor < 0) {
+        
+        return nil;
+    }
+    
+    struct stat fileStatus;
+    void *bytes = MAP_FAILED;
+    if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0) {
+        
+        bytes = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    }
+    // The mapping stays valid after the descriptor is closed, and even after the log file is deleted.
+    close(fileDescriptor);
+    if (bytes == MAP_FAILED) {
+        
+        return nil;
+    }
+    
+    self = [super init];
+    if (!self) {
+        
+        munmap(bytes, (size_t)fileStatus.st_size);
+        return nil;
+    }
+    
+    madvise(bytes, (size_t)fileStatus.st_size, MADV_SEQUENTIAL);
+    _bytes = (const char *)bytes;
+    _length = (size_t)fileStatus.st_size;
+    _fileName = [[fileURL lastPathComponent] copy];
+    _isJSONLines = [[fileURL pathExtension] isEqualToString:@"jsonl"];
+    _transform = [transform copy];
+    _readAheadGroup = dispatch_group_create();
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    munmap((void *)_bytes, _length);
+}
+
+- (BOOL)readRecordWithTimestamp:(NSTimeInterval *)timestamp
+                 isContinuation:(BOOL *)isContinuation
+                         record:(NSData **)record {
+    
+    const char *separator = (_isJSONLines ? "\n" : "\n\n");
+    size_t separatorLength = strlen(separator);
+    
+    // Skip leading newlines left over from separators and blank lines.
+    while (_offset < _length && _bytes[_offset] == '\n') {
+        
+        ++_offset;
+    }
+    if (_offset >= _length) {
+        
+        return NO;
+    }
+    
+    const char *start = (_bytes + _offset);
+    size_t remainingLength = (_length - _offset);
+    const char *end = memmem(start, remainingLength, separator, separatorLength);
+    
+    // The last record of a file that another process is still writing may not be terminated yet.
+    size_t recordLength = (end ? (size_t)(end - start) : remainingLength);
+    
+    const char *timestampBytes = start;
+    NSUInteger timestampLength = recordLength;
+    static const char timestampKeyPrefix[] = "{\"timestamp\":\"";
+    if (_isJSONLines
+        && recordLength > (sizeof(timestampKeyPrefix) - 1)
+        && memcmp(start, timestampKeyPrefix, (sizeof(timestampKeyPrefix) - 1)) == 0) {
+        
+        timestampBytes += (sizeof(timestampKeyPrefix) - 1);
+        timestampLength -= (sizeof(timestampKeyPrefix) - 1);
+    }
+    
+    if (_JEFileLogReaderParseTimestamp(timestampBytes, timestampLength, timestamp)) {
+        
+        _lastTimestamp = (*timestamp);
+        (*isContinuation) = NO;
+    }
+    else {
+        
+        (*timestamp) = _lastTimestamp;
+        (*isContinuation) = YES;
+    }
+    
+    (*record) = [[NSData alloc] initWithBytes:start length:recordLength];
+    _offset += MIN(remainingLength, (recordLength + separatorLength));
+    return YES;
+}
+
+- (NSArray *)readBatch {
+    
+    NSMutableArray *entries = [[NSMutableArray alloc] initWithCapacity:_JEFileLogReaderMaximumNumberOfRecordsPerBatch];
+    size_t batchStartOffset = _offset;
+    while ([entries count] < _JEFileLogReaderMaximumNumberOfRecordsPerBatch
+           && (_offset - batchStartOffset) < _JEFileLogReaderMaximumBatchLength
+           && !atomic_load_explicit(&_isStopped, memory_order_relaxed)) {
+        
+        @autoreleasepool {
+            
+            NSTimeInterval timestamp;
+            BOOL isContinuation;
+            NSData *record;
+            if (![self readRecordWithTimestamp:&timestamp isContinuation:&isContinuation record:&record]) {
+                
+                break;
+            }
+            
+            id object = (_transform ? _transform(self.fileName, timestamp, record) : record);
+            if (!object) {
+                
+                continue;
+            }
+            
+            _JEFileLogReaderEntry *entry = [[_JEFileLogReaderEntry alloc] init];
+            entry.timestamp = timestamp;
+            entry.isContinuation = isContinuation;
+            entry.object = object;
+            [entries addObject:entry];
+        }
+    }
+    
+    size_t pageSize = (size_t)getpagesize();
+    size_t releasableLength = ((_offset / pageSize) * pageSize);
+    if (releasableLength > _releasedLength) {
+        
+        madvise((void *)(_bytes + _releasedLength), (releasableLength - _releasedLength), MADV_DONTNEED);
+        _releasedLength = releasableLength;
+    }
+    return entries;
+}
+
+- (void)readAhead {
+    
+    dispatch_group_async(_readAheadGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        
+        self->_readAheadEntries = [self readBatch];
+    });
+}
+
+- (void)startReading {
+    
+    if (!_entries) {
+        
+        _entries = @[];
+        [self readAhead];
+    }
+}
+
+- (void)stopReading {
+    
+    // The read-ahead block gives up after the record it is transforming, so this waits for at most one transform.
+    atomic_store_explicit(&_isStopped, true, memory_order_relaxed);
+    dispatch_group_wait(_readAheadGroup, DISPATCH_TIME_FOREVER);
+}
+
+- (BOOL)advance {
+    
+    if (_entryIndex + 1 < [_entries count]) {
+        
+        ++_entryIndex;
+        _entry = _entries[_entryIndex];
+        return YES;
+    }
+    [self startReading];
+    
+    while (YES) {
+        
+        dispatch_group_wait(_readAheadGroup, DISPATCH_TIME_FOREVER);
+        NSArray *entries = _readAheadEntries;
+        _readAheadEntries = nil;
+        
+        // Start reading the next batch before the current one is consumed so files are read and transformed in parallel.
+        BOOL reachedEndOfFile = (_offset >= _length);
+        if (!reachedEndOfFile) {
+            
+            [self readAhead];
+        }
+        if ([entries count] > 0) {
+            
+            _entries = entries;
+            _entryIndex = 0;
+            _entry = entries[0];
+            return YES;
+        }
+        if (reachedEndOfFile) {
+            
+            _entries = @[];
+            _entryIndex = 0;
+            _entry = nil;
+            return NO;
+        }
+    }
+}
+
+- (BOOL)isOrderedBeforeCursor:(_JEFileLogRecordCursor *)cursor {
+    
+    _JEFileLogReaderEntry *entry = self.entry;
+    _JEFileLogReaderEntry *otherEntry = cursor.entry;
+    if (entry.timestamp != otherEntry.timestamp) {
+        
+        return (entry.timestamp < otherEntry.timestamp);
+    }
+    return (entry.isContinuation && !otherEntry.isContinuation);
+}
+
+@end
+
+
+#pragma mark - JEFileLogReader
+
+JE_STATIC
+void _JEFileLogReaderSiftDown(NSMutableArray *heap, NSUInteger index) {
+    
+    NSUInteger count = [heap count];
+    while (YES) {
+        
+        NSUInteger smallestIndex = index;
+        NSUInteger leftIndex = ((2 * index) + 1);
+        NSUInteger rightIndex = (leftIndex + 1);
+        if (leftIndex < count && [heap[leftIndex] isOrderedBeforeCursor:heap[smallestIndex]]) {
+            
+            smallestIndex = leftIndex;
+        }
+        if (rightIndex < count && [heap[rightIndex] isOrderedBeforeCursor:heap[smallestIndex]]) {
+            
+            smallestIndex = rightIndex;
+        }
+        if (smallestIndex == index) {
+            
+            return;
+        }
+        
+        [heap exchangeObjectAtIndex:index withObjectAtIndex:smallestIndex];
+        index = smallestIndex;
+    }
+}
+
+
+@interface JEFileLogReader ()
+
+@property (nonatomic, copy, readonly) NSArray *fileURLs;
+
+@end
+
+
+@implementation JEFileLogReader
+
+#pragma mark - NSObject
+
+- (instancetype)initWithFileURLs:(NSArray *)fileURLs {
+    
+    NSParameterAssert(fileURLs != nil);
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _fileURLs = [fileURLs copy];
+    
+    return self;
+}
+
+
+#pragma mark - Public
+
+- (void)enumerateRecordsWithBlock:(void (^)(NSString *fileName, NSTimeInterval timestamp, NSData *record, BOOL *stop))block {
+    
+    NSParameterAssert(block != NULL);
+    
+    [self
+     enumerateRecordsWithTransform:nil
+     usingBlock:^(NSString *fileName, NSTimeInterval timestamp, id object, BOOL *stop) {
+         
+         block(fileName, timestamp, object, stop);
+     }];
+}
+
+- (void)enumerateRecordsWithTransform:(id (^)(NSString *fileName, NSTimeInterval timestamp, NSData *record))transform
+                           usingBlock:(void (^)(NSString *fileName, NSTimeInterval timestamp, id object, BOOL *stop))block {
+    
+    NSParameterAssert(block != NULL);
+    
+    NSMutableArray *heap = [[NSMutableArray alloc] initWithCapacity:[self.fileURLs count]];
+    for (NSURL *fileURL in self.fileURLs) {
+        
+        _JEFileLogRecordCursor *cursor = [[_JEFileLogRecordCursor alloc]
+                                          initWithFileURL:fileURL
+                                          transform:transform];
+        if (cursor) {
+            
+            [cursor startReading];
+            [heap addObject:cursor];
+        }
+    }
+    for (NSUInteger index = [heap count]; index > 0; --index) {
+        
+        if (![heap[(index - 1)] advance]) {
+            
+            [heap removeObjectAtIndex:(index - 1)];
+        }
+    }
+    for (NSUInteger index = ([heap count] / 2); index > 0; --index) {
+        
+        _JEFileLogReaderSiftDown(heap, (index - 1));
+    }
+    
+    BOOL stop = NO;
+    @try {
+        
+        while ([heap count] > 0) {
+            
+            @autoreleasepool {
+                
+                _JEFileLogRecordCursor *cursor = heap[0];
+                _JEFileLogReaderEntry *entry = cursor.entry;
+                block(cursor.fileName, entry.timestamp, entry.object, &stop);
+                if (stop) {
+                    
+                    break;
+                }
+                
+                if (![cursor advance]) {
+                    
+                    [heap exchangeObjectAtIndex:0 withObjectAtIndex:([heap count] - 1)];
+                    [heap removeLastObject];
+                }
+                _JEFileLogReaderSiftDown(heap, 0);
+            }
+        }
+    }
+    @finally {
+        
+        // Cursors still in the heap may be reading ahead, and the transform must not run after this method returns.
+        for (_JEFileLogRecordCursor *cursor in heap) {
+            
+            [cursor stopReading];
+        }
+    }
+}
+
+@end
@@ -0,0 +1,68 @@
+//
+//  JEJSONLineEncoder.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#ifndef JEToolkit_JEJSONLineEncoder_h
+#define JEToolkit_JEJSONLineEncoder_h
+
+#import "JECompilerDefines.h"
+
+
+/*! Streaming JSON object encoder used by the JEDebugging file logger. Members are escaped and written directly into the buffer without creating intermediate Foundation objects. Used internally by JEDebugging.
+ */
+
+/*! Appends the opening brace of a JSON object to the buffer.
+ */
+JE_EXTERN
+void JEJSONLineBegin(NSMutableData *_Nonnull buffer);
+
+/*! Appends the closing brace of a JSON object and a line feed to the buffer.
+ */
+JE_EXTERN
+void JEJSONLineEnd(NSMutableData *_Nonnull buffer);
+
+/*! Appends a string member to the current JSON object. A nil value is written as null.
+ */
+JE_EXTERN
+void JEJSONLineAppendString(NSMutableData *_Nonnull buffer, const char *_Nonnull key, NSString *_Nullable value);
+
+/*! Appends a UTF8 C-string member to the current JSON object. A NULL value is written as null.
+ */
+JE_EXTERN
+void JEJSONLineAppendUTF8String(NSMutableData *_Nonnull buffer, const char *_Nonnull key, const char *_Nullable value);
+
+/*! Appends an integer member to the current JSON object.
+ */
+JE_EXTERN
+void JEJSONLineAppendInteger(NSMutableData *_Nonnull buffer, const char *_Nonnull key, long long value);
+
+/*! Appends a timestamp member to the current JSON object, formatted as an ISO 8601 UTC string with milliseconds.
+ */
+JE_EXTERN
+void JEJSONLineAppendTimestamp(NSMutableData *_Nonnull buffer, const char *_Nonnull key, NSTimeInterval timeIntervalSince1970);
+
+
+#endif
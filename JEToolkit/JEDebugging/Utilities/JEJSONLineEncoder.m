@@ -0,0 +1,185 @@
+//
+//  JEJSONLineEncoder.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JEJSONLineEncoder.h"
+
+#include <time.h>
+
+
+JE_STATIC_INLINE
+void _JEJSONLineAppendLiteral(NSMutableData *buffer, const char *literal) {
+    
+    [buffer appendBytes:literal length:strlen(literal)];
+}
+
+JE_STATIC
+void _JEJSONLineAppendEscapedBytes(NSMutableData *buffer, const uint8_t *bytes, NSUInteger length) {
+    
+    static const char hexDigits[] = "0123456789abcdef";
+    
+    NSUInteger runStart = 0;
+    for (NSUInteger i = 0; i < length; ++i) {
+        
+        uint8_t byte = bytes[i];
+        if (byte >= 0x20 && byte != '"' && byte != '\\') {
+            
+            continue;
+        }
+        
+        if (i > runStart) {
+            
+            [buffer appendBytes:(bytes + runStart) length:(i - runStart)];
+        }
+        runStart = i + 1;
+        
+        switch (byte) {
+                
+            case '"':   _JEJSONLineAppendLiteral(buffer, "\\\""); break;
+            case '\\':  _JEJSONLineAppendLiteral(buffer, "\\\\"); break;
+            case '\b':  _JEJSONLineAppendLiteral(buffer, "\\b"); break;
+            case '\f':  _JEJSONLineAppendLiteral(buffer, "\\f"); break;
+            case '\n':  _JEJSONLineAppendLiteral(buffer, "\\n"); break;
+            case '\r':  _JEJSONLineAppendLiteral(buffer, "\\r"); break;
+            case '\t':  _JEJSONLineAppendLiteral(buffer, "\\t"); break;
+            default: {
+                
+                char escaped[6] = { '\\', 'u', '0', '0', hexDigits[byte >> 4], hexDigits[byte & 0xF] };
+                [buffer appendBytes:escaped length:sizeof(escaped)];
+                break;
+            }
+        }
+    }
+    
+    if (length > runStart) {
+        
+        [buffer appendBytes:(bytes + runStart) length:(length - runStart)];
+    }
+}
+
+JE_STATIC
+void _JEJSONLineAppendKey(NSMutableData *buffer, const char *key) {
+    
+    NSUInteger length = [buffer length];
+    if (length > 0 && ((const char *)[buffer bytes])[length - 1] != '{') {
+        
+        _JEJSONLineAppendLiteral(buffer, ",");
+    }
+    _JEJSONLineAppendLiteral(buffer, "\"");
+    _JEJSONLineAppendEscapedBytes(buffer, (const uint8_t *)key, strlen(key));
+    _JEJSONLineAppendLiteral(buffer, "\":");
+}
+
+
+#pragma mark - Public
+
+void JEJSONLineBegin(NSMutableData *buffer) {
+    
+    _JEJSONLineAppendLiteral(buffer, "{");
+}
+
+void JEJSONLineEnd(NSMutableData *buffer) {
+    
+    _JEJSONLineAppendLiteral(buffer, "}\n");
+}
+
+void JEJSONLineAppendString(NSMutableData *buffer, const char *key, NSString *value) {
+    
+    _JEJSONLineAppendKey(buffer, key);
+    if (!value) {
+        
+        _JEJSONLineAppendLiteral(buffer, "null");
+        return;
+    }
+    
+    _JEJSONLineAppendLiteral(buffer, "\"");
+    
+    // Transcode through a stack buffer so that no intermediate C-string or NSData is created. getBytes:... only converts whole characters, so surrogate pairs are never split between chunks.
+    uint8_t chunk[512];
+    NSRange remainingRange = (NSRange){ .location = 0, .length = [value length] };
+    while (remainingRange.length > 0) {
+        
+        NSUInteger usedLength = 0;
+        if (![value
+              getBytes:chunk
+              maxLength:sizeof(chunk)
+              usedLength:&usedLength
+              encoding:NSUTF8StringEncoding
+              options:NSStringEncodingConversionAllowLossy
+              range:remainingRange
+              remainingRange:&remainingRange]
+            || usedLength == 0) {
+            
+            break;
+        }
+        _JEJSONLineAppendEscapedBytes(buffer, chunk, usedLength);
+    }
+    
+    _JEJSONLineAppendLiteral(buffer, "\"");
+}
+
+void JEJSONLineAppendUTF8String(NSMutableData *buffer, const char *key, const char *value) {
+    
+    _JEJSONLineAppendKey(buffer, key);
+    if (!value) {
+        
+        _JEJSONLineAppendLiteral(buffer, "null");
+        return;
+    }
+    
+    _JEJSONLineAppendLiteral(buffer, "\"");
+    _JEJSONLineAppendEscapedBytes(buffer, (const uint8_t *)value, strlen(value));
+    _JEJSONLineAppendLiteral(buffer, "\"");
+}
+
+void JEJSONLineAppendInteger(NSMutableData *buffer, const char *key, long long value) {
+    
+    _JEJSONLineAppendKey(buffer, key);
+    
+    char digits[24];
+    int length = snprintf(digits, sizeof(digits), "%lld", value);
+    [buffer appendBytes:digits length:(NSUInteger)MAX(0, length)];
+}
+
+void JEJSONLineAppendTimestamp(NSMutableData *buffer, const char *key, NSTimeInterval timeIntervalSince1970) {
+    
+    _JEJSONLineAppendKey(buffer, key);
+    
+    time_t seconds = (time_t)floor(timeIntervalSince1970);
+    int milliseconds = (int)((timeIntervalSince1970 - (NSTimeInterval)seconds) * 1000.0);
+    struct tm components;
+    gmtime_r(&seconds, &components);
+    
+    char timestamp[32];
+    int length = snprintf(timestamp, sizeof(timestamp),
+                          "\"%04d-%02d-%02dT%02d:%02d:%02d.%03dZ\"",
+                          (components.tm_year + 1900),
+                          (components.tm_mon + 1),
+                          components.tm_mday,
+                          components.tm_hour,
+                          components.tm_min,
+                          components.tm_sec,
+                          MIN(999, MAX(0, milliseconds)));
+    [buffer appendBytes:timestamp length:(NSUInteger)MAX(0, length)];
+}
@@ -0,0 +1,53 @@
+//
+//  JELogFormat.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#ifndef JEToolkit_JELogFormat_h
+#define JEToolkit_JELogFormat_h
+
+#import "JECompilerDefines.h"
+
+
+/*! Formats a log message from a format string that is parsed once per callsite. The first call parses @p format into literal runs and conversion specifiers and stores the result in @p callsiteCache; later calls with the same format string render from the stored result instead of parsing the format again. Used by the JELog(...) family of utilities.
+ 
+ Only the format string the callsite was first called with is cached, so a callsite that passes different format strings falls back to -[NSString initWithFormat:arguments:]. So do format strings with positional arguments, %n, or field widths on %@, %C, and %S.
+ @param callsiteCache a pointer to a static variable owned by the callsite, initialized to NULL. Thread-safe.
+ @param format the format string, which should be a string literal
+ @return the formatted message
+ */
+JE_EXTERN
+NSString *_Nonnull JELogFormatWithCallsiteCache(void *_Nullable *_Nonnull callsiteCache,
+                                                NSString *_Nonnull format, ...) JE_FORMAT_STRING(2, 3);
+
+/*! The va_list variant of JELogFormatWithCallsiteCache().
+ */
+JE_EXTERN
+NSString *_Nonnull JELogFormatWithCallsiteCacheArguments(void *_Nullable *_Nonnull callsiteCache,
+                                                         NSString *_Nonnull format,
+                                                         va_list arguments) JE_FORMAT_STRING(2, 0);
+
+
+#endif
@@ -0,0 +1,610 @@
+//
+//  JELogFormat.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogFormat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+typedef NS_ENUM(NSInteger, _JELogFormatLength) {
+    
+    _JELogFormatLengthDefault = 0,
+    _JELogFormatLengthChar,
+    _JELogFormatLengthShort,
+    _JELogFormatLengthLong,
+    _JELogFormatLengthLongLong,
+    _JELogFormatLengthLongDouble,
+    _JELogFormatLengthSize,
+    _JELogFormatLengthPointerDifference,
+    _JELogFormatLengthMaximum
+};
+
+typedef struct _JELogFormatSegment {
+    
+    CFStringRef literal;            // NULL for conversion specifiers
+    char cFormat[32];               // the specifier rewritten for snprintf()
+    unichar conversion;
+    _JELogFormatLength length;
+    BOOL widthFromArgument;
+    BOOL precisionFromArgument;
+    
+} _JELogFormatSegment;
+
+
+#pragma mark - _JELogFormatSpec
+
+/*! The parsed form of a format string. Immutable once created, so it can be shared between threads.
+ */
+@interface _JELogFormatSpec : NSObject {
+    
+@public
+    NSString *_format;
+    BOOL _isSupported;
+    NSUInteger _numberOfSegments;
+    _JELogFormatSegment *_segments;
+}
+
+- (instancetype)initWithFormat:(NSString *)format;
+
+@end
+
+
+@implementation _JELogFormatSpec
+
+#pragma mark - NSObject
+
+- (instancetype)initWithFormat:(NSString *)format {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _format = [format copy];
+    _isSupported = [self parseFormat:format];
+    if (!_isSupported) {
+        
+        [self releaseSegments];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    
+    [self releaseSegments];
+}
+
+#pragma mark - Private
+
+- (void)releaseSegments {
+    
+    for (NSUInteger i = 0; i < _numberOfSegments; ++i) {
+        
+        if (_segments[i].literal) {
+            
+            CFRelease(_segments[i].literal);
+        }
+    }
+    free(_segments);
+    _segments = NULL;
+    _numberOfSegments = 0;
+}
+
+- (_JELogFormatSegment *)addSegment {
+    
+    _segments = reallocf(_segments, (sizeof(_JELogFormatSegment) * (_numberOfSegments + 1)));
+    if (!_segments) {
+        
+        _numberOfSegments = 0;
+        return NULL;
+    }
+    _JELogFormatSegment *segment = &_segments[_numberOfSegments++];
+    memset(segment, 0, sizeof(_JELogFormatSegment));
+    return segment;
+}
+
+- (BOOL)addLiteralFromCharacters:(const unichar *)characters length:(NSUInteger)length {
+    
+    if (length == 0) {
+        
+        return YES;
+    }
+    _JELogFormatSegment *segment = [self addSegment];
+    if (!segment) {
+        
+        return NO;
+    }
+    segment->literal = CFStringCreateWithCharacters(NULL, characters, (CFIndex)length);
+    return YES;
+}
+
+- (BOOL)parseFormat:(NSString *)format {
+    
+    NSUInteger length = [format length];
+    unichar *characters = malloc(sizeof(unichar) * (length + 1));
+    if (!characters) {
+        
+        return NO;
+    }
+    [format getCharacters:characters range:NSMakeRange(0, length)];
+    characters[length] = 0;
+    
+    BOOL isSupported = [self parseCharacters:characters length:length];
+    free(characters);
+    return isSupported;
+}
+
+- (BOOL)parseCharacters:(const unichar *)characters length:(NSUInteger)length {
+    
+    NSUInteger literalStart = 0;
+    NSUInteger index = 0;
+    while (index < length) {
+        
+        if (characters[index] != '%') {
+            
+            ++index;
+            continue;
+        }
+        if ((index + 1) < length && characters[index + 1] == '%') {
+            
+            // Keep one '%' in the literal run.
+            if (![self addLiteralFromCharacters:(characters + literalStart) length:(index + 1 - literalStart)]) {
+                
+                return NO;
+            }
+            index += 2;
+            literalStart = index;
+            continue;
+        }
+        if (![self addLiteralFromCharacters:(characters + literalStart) length:(index - literalStart)]) {
+            
+            return NO;
+        }
+        
+        _JELogFormatSegment *segment = [self addSegment];
+        if (!segment) {
+            
+            return NO;
+        }
+        
+        char *cFormat = segment->cFormat;
+        const char *cFormatEnd = (segment->cFormat + sizeof(segment->cFormat) - 8);
+        BOOL hasWidthOrPrecision = NO;
+        *cFormat++ = '%';
+        ++index;
+        
+        // flags
+        while (index < length
+               && characters[index] != 0
+               && characters[index] < 0x80
+               && strchr("-+ #0'", (int)characters[index]) != NULL) {
+            
+            if (cFormat >= cFormatEnd) {
+                
+                return NO;
+            }
+            *cFormat++ = (char)characters[index++];
+        }
+        
+        // width
+        if (index < length && characters[index] == '*') {
+            
+            segment->widthFromArgument = YES;
+            hasWidthOrPrecision = YES;
+            *cFormat++ = '*';
+            ++index;
+        }
+        else {
+            
+            while (index < length && characters[index] >= '0' && characters[index] <= '9') {
+                
+                if (cFormat >= cFormatEnd) {
+                    
+                    return NO;
+                }
+                hasWidthOrPrecision = YES;
+                *cFormat++ = (char)characters[index++];
+            }
+            if (index < length && characters[index] == '$') {
+                
+                // Positional arguments can't be consumed in order.
+                return NO;
+            }
+        }
+        
+        // precision
+        if (index < length && characters[index] == '.') {
+            
+            hasWidthOrPrecision = YES;
+            *cFormat++ = '.';
+            ++index;
+            if (index < length && characters[index] == '*') {
+                
+                segment->precisionFromArgument = YES;
+                *cFormat++ = '*';
+                ++index;
+            }
+            else {
+                
+                while (index < length && characters[index] >= '0' && characters[index] <= '9') {
+                    
+                    if (cFormat >= cFormatEnd) {
+                        
+                        return NO;
+                    }
+                    *cFormat++ = (char)characters[index++];
+                }
+            }
+        }
+        
+        // length modifier
+        if (index < length) {
+            
+            switch (characters[index]) {
+                    
+                case 'h':
+                    ++index;
+                    if (index < length && characters[index] == 'h') {
+                        
+                        ++index;
+                        segment->length = _JELogFormatLengthChar;
+                        *cFormat++ = 'h';
+                        *cFormat++ = 'h';
+                    }
+                    else {
+                        
+                        segment->length = _JELogFormatLengthShort;
+                        *cFormat++ = 'h';
+                    }
+                    break;
+                    
+                case 'l':
+                    ++index;
+                    if (index < length && characters[index] == 'l') {
+                        
+                        ++index;
+                        segment->length = _JELogFormatLengthLongLong;
+                        *cFormat++ = 'l';
+                        *cFormat++ = 'l';
+                    }
+                    else {
+                        
+                        segment->length = _JELogFormatLengthLong;
+                        *cFormat++ = 'l';
+                    }
+                    break;
+                    
+                case 'q':
+                    ++index;
+                    segment->length = _JELogFormatLengthLongLong;
+                    *cFormat++ = 'l';
+                    *cFormat++ = 'l';
+                    break;
+                    
+                case 'L':
+                    ++index;
+                    segment->length = _JELogFormatLengthLongDouble;
+                    *cFormat++ = 'L';
+                    break;
+                    
+                case 'z':
+                    ++index;
+                    segment->length = _JELogFormatLengthSize;
+                    *cFormat++ = 'z';
+                    break;
+                    
+                case 't':
+                    ++index;
+                    segment->length = _JELogFormatLengthPointerDifference;
+                    *cFormat++ = 't';
+                    break;
+                    
+                case 'j':
+                    ++index;
+                    segment->length = _JELogFormatLengthMaximum;
+                    *cFormat++ = 'j';
+                    break;
+                    
+                default:
+                    break;
+            }
+        }
+        if (index >= length || cFormat >= cFormatEnd) {
+            
+            return NO;
+        }
+        
+        // conversion
+        unichar conversion = characters[index++];
+        switch (conversion) {
+                
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                if (segment->length == _JELogFormatLengthLongDouble) {
+                    
+                    return NO;
+                }
+                break;
+                
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                if (segment->length != _JELogFormatLengthDefault
+                    && segment->length != _JELogFormatLengthLong
+                    && segment->length != _JELogFormatLengthLongDouble) {
+                    
+                    return NO;
+                }
+                break;
+                
+            case 'c': case 's': case 'p':
+                if (segment->length != _JELogFormatLengthDefault) {
+                    
+                    return NO;
+                }
+                break;
+                
+            case '@': case 'C': case 'S':
+                // Padding for these is done by CoreFoundation, not snprintf().
+                if (segment->length != _JELogFormatLengthDefault || hasWidthOrPrecision) {
+                    
+                    return NO;
+                }
+                break;
+                
+            default:
+                // %n, %D, %U, %O, and anything unknown
+                return NO;
+        }
+        segment->conversion = conversion;
+        *cFormat++ = (char)conversion;
+        *cFormat = '\0';
+        
+        literalStart = index;
+    }
+    return [self addLiteralFromCharacters:(characters + literalStart) length:(length - literalStart)];
+}
+
+@end
+
+
+#pragma mark - Rendering
+
+JE_STATIC
+void _JELogFormatAppendCFormat(CFMutableStringRef string, const char *cFormat, ...) {
+    
+    char buffer[256];
+    va_list arguments;
+    va_start(arguments, cFormat);
+    va_list argumentsCopy;
+    va_copy(argumentsCopy, arguments);
+    int length = vsnprintf(buffer, sizeof(buffer), cFormat, arguments);
+    va_end(arguments);
+    
+    if (length >= 0 && (size_t)length < sizeof(buffer)) {
+        
+        CFStringAppendCString(string, buffer, CFStringGetSystemEncoding());
+    }
+    else if (length >= 0) {
+        
+        char *heapBuffer = malloc((size_t)length + 1);
+        if (heapBuffer) {
+            
+            vsnprintf(heapBuffer, (size_t)length + 1, cFormat, argumentsCopy);
+            CFStringAppendCString(string, heapBuffer, CFStringGetSystemEncoding());
+            free(heapBuffer);
+        }
+    }
+    va_end(argumentsCopy);
+}
+
+// Passes the '*' width and precision arguments, which come before the value, only when the specifier has them.
+#define _JELogFormatAppendValue(string, segment, width, precision, value) \
+    do { \
+        if ((segment)->widthFromArgument && (segment)->precisionFromArgument) { \
+            _JELogFormatAppendCFormat((string), (segment)->cFormat, (width), (precision), (value)); \
+        } \
+        else if ((segment)->widthFromArgument) { \
+            _JELogFormatAppendCFormat((string), (segment)->cFormat, (width), (value)); \
+        } \
+        else if ((segment)->precisionFromArgument) { \
+            _JELogFormatAppendCFormat((string), (segment)->cFormat, (precision), (value)); \
+        } \
+        else { \
+            _JELogFormatAppendCFormat((string), (segment)->cFormat, (value)); \
+        } \
+    } while (NO)
+
+JE_STATIC
+void _JELogFormatAppendSegment(CFMutableStringRef string, const _JELogFormatSegment *segment, va_list *arguments) {
+    
+    int width = (segment->widthFromArgument ? va_arg(*arguments, int) : 0);
+    int precision = (segment->precisionFromArgument ? va_arg(*arguments, int) : 0);
+    
+    switch (segment->conversion) {
+            
+        case '@': {
+            
+            id object = va_arg(*arguments, id);
+            CFStringAppend(string, (__bridge CFStringRef)(object ? [object description] : @"(null)") ?: CFSTR(""));
+            break;
+        }
+        case 'C': {
+            
+            unichar character = (unichar)va_arg(*arguments, int);
+            CFStringAppendCharacters(string, &character, 1);
+            break;
+        }
+        case 'S': {
+            
+            const unichar *characters = va_arg(*arguments, const unichar *);
+            if (!characters) {
+                
+                CFStringAppend(string, CFSTR("(null)"));
+                break;
+            }
+            CFIndex length = 0;
+            while (characters[length] != 0) {
+                
+                ++length;
+            }
+            CFStringAppendCharacters(string, characters, length);
+            break;
+        }
+        case 's': {
+            
+            const char *cString = va_arg(*arguments, const char *);
+            if (!segment->widthFromArgument && !segment->precisionFromArgument && segment->cFormat[2] == '\0') {
+                
+                CFStringAppendCString(string, (cString ?: "(null)"), CFStringGetSystemEncoding());
+                break;
+            }
+            _JELogFormatAppendValue(string, segment, width, precision, cString);
+            break;
+        }
+        case 'c':
+            _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, int));
+            break;
+            
+        case 'p':
+            _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, void *));
+            break;
+            
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (segment->length == _JELogFormatLengthLongDouble) {
+                
+                _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, long double));
+            }
+            else {
+                
+                _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, double));
+            }
+            break;
+            
+        case 'd': case 'i':
+            switch (segment->length) {
+                    
+                case _JELogFormatLengthLong:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, long));
+                    break;
+                case _JELogFormatLengthLongLong:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, long long));
+                    break;
+                case _JELogFormatLengthSize:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, ssize_t));
+                    break;
+                case _JELogFormatLengthPointerDifference:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, ptrdiff_t));
+                    break;
+                case _JELogFormatLengthMaximum:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, intmax_t));
+                    break;
+                default:
+                    // char and short are promoted to int
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, int));
+                    break;
+            }
+            break;
+            
+        default:
+            // 'u', 'o', 'x', and 'X'
+            switch (segment->length) {
+                    
+                case _JELogFormatLengthLong:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, unsigned long));
+                    break;
+                case _JELogFormatLengthLongLong:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, unsigned long long));
+                    break;
+                case _JELogFormatLengthSize:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, size_t));
+                    break;
+                case _JELogFormatLengthPointerDifference:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, ptrdiff_t));
+                    break;
+                case _JELogFormatLengthMaximum:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, uintmax_t));
+                    break;
+                default:
+                    _JELogFormatAppendValue(string, segment, width, precision, va_arg(*arguments, unsigned int));
+                    break;
+            }
+            break;
+    }
+}
+
+
+#pragma mark - Public
+
+NSString *JELogFormatWithCallsiteCache(void **callsiteCache, NSString *format, ...) {
+    
+    va_list arguments;
+    va_start(arguments, format);
+    NSString *string = JELogFormatWithCallsiteCacheArguments(callsiteCache, format, arguments);
+    va_end(arguments);
+    return string;
+}
+
+NSString *JELogFormatWithCallsiteCacheArguments(void **callsiteCache, NSString *format, va_list arguments) {
+    
+    void *cachedSpec = __atomic_load_n(callsiteCache, __ATOMIC_ACQUIRE);
+    if (!cachedSpec) {
+        
+        // Specs are retained by the callsite for the lifetime of the process. If another thread won the race, ours is released.
+        void *newSpec = (void *)CFBridgingRetain([[_JELogFormatSpec alloc] initWithFormat:format]);
+        if (__atomic_compare_exchange_n(callsiteCache, &cachedSpec, newSpec, NO, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            
+            cachedSpec = newSpec;
+        }
+        else {
+            
+            CFRelease(newSpec);
+        }
+    }
+    
+    _JELogFormatSpec *spec = (__bridge _JELogFormatSpec *)cachedSpec;
+    if (!spec->_isSupported
+        || (spec->_format != format && ![spec->_format isEqualToString:format])) {
+        
+        return [[NSString alloc] initWithFormat:format arguments:arguments];
+    }
+    
+    CFMutableStringRef string = CFStringCreateMutable(NULL, 0);
+    va_list argumentsCopy;
+    va_copy(argumentsCopy, arguments);
+    for (NSUInteger i = 0; i < spec->_numberOfSegments; ++i) {
+        
+        const _JELogFormatSegment *segment = &spec->_segments[i];
+        if (segment->literal) {
+            
+            CFStringAppend(string, segment->literal);
+        }
+        else {
+            
+            _JELogFormatAppendSegment(string, segment, &argumentsCopy);
+        }
+    }
+    va_end(argumentsCopy);
+    return (__bridge_transfer NSString *)string;
+}
@@ -0,0 +1,75 @@
+//
+//  JELogRepeatSuppressor.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JEBaseLoggerSettings.h"
+
+
+/*! JELogRepeatSuppressor collapses consecutive repeats of the same message from the same callsite into a single summary. Each logger keeps its own suppressor, so a message suppressed by one logger is not affected by the others' settings. Used internally by JEDebugging.
+ 
+ JELogRepeatSuppressor is not thread-safe; each instance is only accessed from its logger's queue.
+ */
+@interface JELogRepeatSuppressor : NSObject
+
+/*! The level of the message being repeated.
+ */
+@property (nonatomic, assign, readonly) JELogLevelMask level;
+
+/*! The bullet string of the message being repeated.
+ */
+@property (nonatomic, copy, readonly, nullable) NSString *bulletString;
+
+/*! The number of repeats suppressed since the message was last output.
+ */
+@property (nonatomic, assign, readonly) NSUInteger numberOfRepeats;
+
+/*! Checks if a message repeats the last output message within the interval. If not, the message becomes the one that subsequent messages are compared against.
+ @param key the hash of the message's callsite and contents
+ @param message the message, compared when keys are equal
+ @param level the message's level
+ @param bulletString the message's bullet string
+ @param timestamp the time the message was logged
+ @param interval the suppression interval. Repeats are never suppressed if zero
+ @param summary if the message is not suppressed, set to the summary of the previous message's suppressed repeats, or nil if there were none
+ @return YES if the message should not be output, NO otherwise
+ */
+- (BOOL)shouldSuppressMessageWithKey:(NSUInteger)key
+                             message:(nonnull NSString *)message
+                               level:(JELogLevelMask)level
+                        bulletString:(nonnull NSString *)bulletString
+                           timestamp:(NSTimeInterval)timestamp
+                            interval:(NSTimeInterval)interval
+                             summary:(NSString *_Nullable *_Nonnull)summary;
+
+/*! Ends the current suppression window if the interval elapsed, so that the next repeat is output again.
+ @param timestamp the current time
+ @param interval the suppression interval
+ @return the summary of the suppressed repeats, or nil if the window did not end or nothing was suppressed
+ */
+- (nullable NSString *)summaryIfExpiredAtTimestamp:(NSTimeInterval)timestamp
+                                          interval:(NSTimeInterval)interval;
+
+@end
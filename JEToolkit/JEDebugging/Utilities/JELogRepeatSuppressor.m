@@ -0,0 +1,109 @@
+//
+//  JELogRepeatSuppressor.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogRepeatSuppressor.h"
+
+
+@interface JELogRepeatSuppressor ()
+
+@property (nonatomic, assign) JELogLevelMask level;
+@property (nonatomic, copy) NSString *bulletString;
+@property (nonatomic, assign) NSUInteger numberOfRepeats;
+
+@property (nonatomic, assign) BOOL hasMessage;
+@property (nonatomic, assign) NSUInteger key;
+@property (nonatomic, copy) NSString *message;
+@property (nonatomic, assign) NSTimeInterval outputTimestamp;
+@property (nonatomic, assign) NSTimeInterval lastRepeatTimestamp;
+
+@end
+
+
+@implementation JELogRepeatSuppressor
+
+#pragma mark - Private
+
+- (NSString *)takeSummary {
+    
+    NSUInteger numberOfRepeats = self.numberOfRepeats;
+    if (numberOfRepeats <= 0) {
+        
+        return nil;
+    }
+    
+    self.numberOfRepeats = 0;
+    return [[NSString alloc] initWithFormat:@"Last message repeated %lu time%@ over %.0f ms",
+            (unsigned long)numberOfRepeats,
+            (numberOfRepeats == 1 ? @"" : @"s"),
+            ((self.lastRepeatTimestamp - self.outputTimestamp) * 1000.0)];
+}
+
+
+#pragma mark - Public
+
+- (BOOL)shouldSuppressMessageWithKey:(NSUInteger)key
+                             message:(NSString *)message
+                               level:(JELogLevelMask)level
+                        bulletString:(NSString *)bulletString
+                           timestamp:(NSTimeInterval)timestamp
+                            interval:(NSTimeInterval)interval
+                             summary:(NSString **)summary {
+    
+    if (interval > 0
+        && self.hasMessage
+        && self.key == key
+        && (timestamp - self.outputTimestamp) < interval
+        && [self.message isEqualToString:message]) {
+        
+        self.numberOfRepeats += 1;
+        self.lastRepeatTimestamp = timestamp;
+        return YES;
+    }
+    
+    (*summary) = [self takeSummary];
+    
+    self.hasMessage = (interval > 0);
+    self.key = key;
+    self.message = (interval > 0 ? message : nil);
+    self.level = level;
+    self.bulletString = bulletString;
+    self.outputTimestamp = timestamp;
+    return NO;
+}
+
+- (NSString *)summaryIfExpiredAtTimestamp:(NSTimeInterval)timestamp
+                                 interval:(NSTimeInterval)interval {
+    
+    if (!self.hasMessage || (timestamp - self.outputTimestamp) < interval) {
+        
+        return nil;
+    }
+    
+    self.hasMessage = NO;
+    self.message = nil;
+    return [self takeSummary];
+}
+
+@end
@@ -0,0 +1,63 @@
+//
+//  JELogRingBuffer.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JECompilerDefines.h"
+
+/*! JELogRingBuffer is a fixed-capacity FIFO of objects. Once full, adding an object evicts the oldest one in O(1) time. Snapshots are immutable NSArray views over the buffer's storage and are created without copying the entries. Used internally by JEDebugging for the HUD log backlog.
+ 
+ JELogRingBuffer is not thread-safe, but the snapshots it returns are immutable and can be freely passed between threads.
+ */
+@interface JELogRingBuffer : NSObject
+
+/*! Initializes a ring buffer that keeps at most capacity objects.
+ @param capacity the maximum number of objects kept by the receiver
+ */
+- (nonnull instancetype)initWithCapacity:(NSUInteger)capacity JE_DESIGNATED_INITIALIZER;
+
+/*! The maximum number of objects kept by the receiver. Lowering the capacity evicts the oldest objects in excess of the new capacity.
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/*! The number of objects currently in the receiver.
+ */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/*! Appends an object, evicting the oldest object if the receiver is full. Runs in amortized O(1) time.
+ @param object the object to append
+ */
+- (void)addObject:(nonnull id)object;
+
+/*! Removes all objects from the receiver. Existing snapshots are not affected.
+ */
+- (void)removeAllObjects;
+
+/*! Returns an immutable view of the current contents, ordered from the oldest to the newest object. The view shares storage with the receiver; the receiver copies its storage only when an addition would overwrite an entry still visible to a live snapshot, which happens at most once per snapshot. The receiver itself never holds more than capacity objects.
+ @return an immutable array of the receiver's objects at the time of the call
+ */
+- (nonnull NSArray *)snapshot;
+
+@end
@@ -0,0 +1,299 @@
+//
+//  JELogRingBuffer.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogRingBuffer.h"
+
+#include <stdatomic.h>
+
+
+#pragma mark - _JELogRingBufferStorage
+
+/*! Fixed array of retained slots, addressed by entry sequence number modulo the number of slots. There is one slot per entry of ring capacity, so the ring never holds more than its capacity.
+ */
+@interface _JELogRingBufferStorage : NSObject {
+    
+@public
+    CFTypeRef *_slots;
+    NSUInteger _numberOfSlots;
+    
+    // Updated by snapshots from any thread.
+    atomic_ulong _numberOfSnapshots;
+    
+    // Only accessed by the owning ring buffer. The lowest sequence number visible to a live snapshot.
+    uint64_t _pinnedSequence;
+}
+
+- (instancetype)initWithNumberOfSlots:(NSUInteger)numberOfSlots;
+
+@end
+
+
+@implementation _JELogRingBufferStorage
+
+- (instancetype)initWithNumberOfSlots:(NSUInteger)numberOfSlots {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _numberOfSlots = MAX((NSUInteger)1, numberOfSlots);
+    _slots = calloc(_numberOfSlots, sizeof(CFTypeRef));
+    atomic_init(&_numberOfSnapshots, 0);
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    for (NSUInteger i = 0; i < _numberOfSlots; ++i) {
+        
+        if (_slots[i]) {
+            
+            CFRelease(_slots[i]);
+        }
+    }
+    free(_slots);
+}
+
+@end
+
+
+#pragma mark - _JELogRingBufferSnapshot
+
+@interface _JELogRingBufferSnapshot : NSArray {
+    
+@public
+    _JELogRingBufferStorage *_storage;
+    uint64_t _startSequence;
+    NSUInteger _count;
+}
+
+@end
+
+
+@implementation _JELogRingBufferSnapshot
+
+- (void)dealloc {
+    
+    if (_storage) {
+        
+        atomic_fetch_sub(&_storage->_numberOfSnapshots, 1);
+    }
+}
+
+
+#pragma mark - NSArray
+
+- (NSUInteger)count {
+    
+    return _count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+    
+    if (index >= _count) {
+        
+        [NSException
+         raise:NSRangeException
+         format:@"*** %@: index %lu beyond bounds [0 .. %lu]",
+         NSStringFromSelector(_cmd), (unsigned long)index, (unsigned long)_count];
+    }
+    return (__bridge id)_storage->_slots[(_startSequence + index) % _storage->_numberOfSlots];
+}
+
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone {
+    
+    return self;
+}
+
+@end
+
+
+#pragma mark - JELogRingBuffer
+
+@interface JELogRingBuffer () {
+    
+    _JELogRingBufferStorage *_storage;
+    uint64_t _startSequence;
+    NSUInteger _count;
+    _JELogRingBufferSnapshot *__weak _lastSnapshot;
+}
+
+@end
+
+
+@implementation JELogRingBuffer
+
+#pragma mark - NSObject
+
+- (instancetype)init {
+    
+    return [self initWithCapacity:0];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _capacity = capacity;
+    _storage = [[_JELogRingBufferStorage alloc] initWithNumberOfSlots:capacity];
+    
+    return self;
+}
+
+
+#pragma mark - Private
+
+- (BOOL)isSequencePinned:(uint64_t)sequence {
+    
+    // Conservative: a snapshot that died while an older one is alive keeps its entries pinned until all snapshots of the storage are gone.
+    return (atomic_load(&_storage->_numberOfSnapshots) > 0
+            && sequence >= _storage->_pinnedSequence);
+}
+
+- (void)detachStorageWithNumberOfSlots:(NSUInteger)numberOfSlots {
+    
+    // Copies the newest entries that fit into fresh storage, leaving the old storage to the snapshots that still reference it.
+    _JELogRingBufferStorage *oldStorage = _storage;
+    _JELogRingBufferStorage *newStorage = [[_JELogRingBufferStorage alloc] initWithNumberOfSlots:numberOfSlots];
+    
+    NSUInteger count = MIN(_count, _capacity);
+    uint64_t startSequence = (_startSequence + (_count - count));
+    for (uint64_t sequence = startSequence; sequence < (startSequence + count); ++sequence) {
+        
+        CFTypeRef object = oldStorage->_slots[sequence % oldStorage->_numberOfSlots];
+        newStorage->_slots[sequence % newStorage->_numberOfSlots] = CFRetain(object);
+    }
+    
+    _storage = newStorage;
+    _startSequence = startSequence;
+    _count = count;
+}
+
+- (void)removeFirstObject {
+    
+    if (![self isSequencePinned:_startSequence]) {
+        
+        NSUInteger slot = (_startSequence % _storage->_numberOfSlots);
+        CFTypeRef object = _storage->_slots[slot];
+        _storage->_slots[slot] = NULL;
+        if (object) {
+            
+            CFRelease(object);
+        }
+    }
+    ++_startSequence;
+    --_count;
+}
+
+
+#pragma mark - Public
+
+- (void)setCapacity:(NSUInteger)capacity {
+    
+    if (capacity == _capacity) {
+        
+        return;
+    }
+    
+    _capacity = capacity;
+    [self detachStorageWithNumberOfSlots:capacity];
+}
+
+- (void)addObject:(id)object {
+    
+    NSCParameterAssert(object != nil);
+    
+    if (_capacity == 0) {
+        
+        return;
+    }
+    
+    if (_count >= _capacity) {
+        
+        [self removeFirstObject];
+    }
+    
+    uint64_t sequence = (_startSequence + _count);
+    NSUInteger numberOfSlots = _storage->_numberOfSlots;
+    if (sequence >= numberOfSlots && [self isSequencePinned:(sequence - numberOfSlots)]) {
+        
+        // The slot still holds an entry visible to a live snapshot. The snapshot keeps the old storage, so this happens at most once per snapshot.
+        [self detachStorageWithNumberOfSlots:numberOfSlots];
+    }
+    
+    NSUInteger slot = (sequence % numberOfSlots);
+    CFTypeRef previousObject = _storage->_slots[slot];
+    _storage->_slots[slot] = CFBridgingRetain(object);
+    if (previousObject) {
+        
+        // Evicted entries that were pinned by a snapshot are released when their slot is reused.
+        CFRelease(previousObject);
+    }
+    ++_count;
+}
+
+- (void)removeAllObjects {
+    
+    _storage = [[_JELogRingBufferStorage alloc] initWithNumberOfSlots:_storage->_numberOfSlots];
+    _startSequence += _count;
+    _count = 0;
+}
+
+- (NSArray *)snapshot {
+    
+    _JELogRingBufferSnapshot *snapshot = _lastSnapshot;
+    if (snapshot
+        && snapshot->_storage == _storage
+        && snapshot->_startSequence == _startSequence
+        && snapshot->_count == _count) {
+        
+        return snapshot;
+    }
+    
+    _JELogRingBufferStorage *storage = _storage;
+    if (atomic_fetch_add(&storage->_numberOfSnapshots, 1) == 0) {
+        
+        storage->_pinnedSequence = _startSequence;
+    }
+    
+    snapshot = [[_JELogRingBufferSnapshot alloc] init];
+    snapshot->_storage = storage;
+    snapshot->_startSequence = _startSequence;
+    snapshot->_count = _count;
+    _lastSnapshot = snapshot;
+    return snapshot;
+}
+
+@end
@@ -0,0 +1,66 @@
+//
+//  JELogScratchPool.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#ifndef JEToolkit_JELogScratchPool_h
+#define JEToolkit_JELogScratchPool_h
+
+#import "JECompilerDefines.h"
+
+
+/*! Per-thread pools of reusable buffers for formatting log records. Text is built directly as UTF8 bytes because an emptied NSMutableString gives up its capacity, while an NSMutableData keeps it. Once the buffers of a thread have grown to fit typical records, formatting and encoding a record no longer allocates. Used internally by JEDebugging.
+ */
+
+/*! The number of buffers each thread keeps for reuse.
+ */
+JE_EXTERN const NSUInteger JELogScratchPoolCapacity;
+
+/*! Buffers that grew past this length are freed instead of kept, so one huge record does not pin its memory for the thread's lifetime.
+ */
+JE_EXTERN const NSUInteger JELogScratchBufferMaximumRetainedLength;
+
+/*! Takes an empty buffer from the current thread's pool, or creates one if the pool is empty. Pass the buffer to JELogScratchBufferRelinquish() when done; it must not be kept or passed to other threads.
+ */
+JE_EXTERN
+NSMutableData *_Nonnull JELogScratchBufferAcquire(void);
+
+/*! Empties a buffer taken with JELogScratchBufferAcquire() and returns it to the current thread's pool.
+ */
+JE_EXTERN
+void JELogScratchBufferRelinquish(NSMutableData *_Nonnull buffer);
+
+/*! Appends the UTF8 representation of a string to a buffer without creating intermediate objects. A nil string appends nothing.
+ */
+JE_EXTERN
+void JELogScratchBufferAppendString(NSMutableData *_Nonnull buffer, NSString *_Nullable string);
+
+/*! Appends a UTF8 C-string to a buffer. A NULL string appends nothing.
+ */
+JE_EXTERN
+void JELogScratchBufferAppendUTF8String(NSMutableData *_Nonnull buffer, const char *_Nullable string);
+
+
+#endif
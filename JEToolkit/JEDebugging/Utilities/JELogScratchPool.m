@@ -0,0 +1,151 @@
+//
+//  JELogScratchPool.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogScratchPool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+const NSUInteger JELogScratchPoolCapacity = 4;
+const NSUInteger JELogScratchBufferMaximumRetainedLength = (64 * 1024);
+
+static const NSUInteger _JELogScratchBufferInitialCapacity = 512;
+
+
+typedef struct _JELogScratchPool {
+    
+    NSUInteger numberOfBuffers;
+    CFMutableDataRef buffers[];
+    
+} _JELogScratchPool;
+
+
+static pthread_key_t _JELogScratchPoolKey;
+
+
+JE_STATIC
+void _JELogScratchPoolThreadDidExit(void *context) {
+    
+    _JELogScratchPool *pool = (_JELogScratchPool *)context;
+    for (NSUInteger index = 0; index < pool->numberOfBuffers; ++index) {
+        
+        CFRelease(pool->buffers[index]);
+    }
+    free(pool);
+}
+
+JE_STATIC
+_JELogScratchPool *_JELogScratchPoolForCurrentThread(void) {
+    
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        pthread_key_create(&_JELogScratchPoolKey, _JELogScratchPoolThreadDidExit);
+    });
+    
+    _JELogScratchPool *pool = (_JELogScratchPool *)pthread_getspecific(_JELogScratchPoolKey);
+    if (!pool) {
+        
+        pool = (_JELogScratchPool *)calloc(1, (sizeof(_JELogScratchPool) + (JELogScratchPoolCapacity * sizeof(CFMutableDataRef))));
+        pthread_setspecific(_JELogScratchPoolKey, pool);
+    }
+    return pool;
+}
+
+
+NSMutableData *JELogScratchBufferAcquire(void) {
+    
+    _JELogScratchPool *pool = _JELogScratchPoolForCurrentThread();
+    if (pool && pool->numberOfBuffers > 0) {
+        
+        --pool->numberOfBuffers;
+        return (__bridge_transfer NSMutableData *)pool->buffers[pool->numberOfBuffers];
+    }
+    return [[NSMutableData alloc] initWithCapacity:_JELogScratchBufferInitialCapacity];
+}
+
+void JELogScratchBufferRelinquish(NSMutableData *buffer) {
+    
+    NSCParameterAssert(buffer != nil);
+    
+    _JELogScratchPool *pool = _JELogScratchPoolForCurrentThread();
+    if (!pool
+        || pool->numberOfBuffers >= JELogScratchPoolCapacity
+        || [buffer length] > JELogScratchBufferMaximumRetainedLength) {
+        
+        return;
+    }
+    
+    // Shrinking an NSMutableData keeps its allocated capacity.
+    [buffer setLength:0];
+    pool->buffers[pool->numberOfBuffers] = (__bridge_retained CFMutableDataRef)buffer;
+    ++pool->numberOfBuffers;
+}
+
+void JELogScratchBufferAppendString(NSMutableData *buffer, NSString *string) {
+    
+    NSCParameterAssert(buffer != nil);
+    
+    if (!string) {
+        
+        return;
+    }
+    
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    const char *fastBytes = CFStringGetCStringPtr(cfString, kCFStringEncodingUTF8);
+    if (fastBytes) {
+        
+        [buffer appendBytes:fastBytes length:strlen(fastBytes)];
+        return;
+    }
+    
+    CFIndex length = CFStringGetLength(cfString);
+    CFIndex maximumByteLength = CFStringGetMaximumSizeForEncoding(length, kCFStringEncodingUTF8);
+    NSUInteger originalLength = [buffer length];
+    [buffer setLength:(originalLength + (NSUInteger)maximumByteLength)];
+    
+    CFIndex usedByteLength = 0;
+    CFStringGetBytes(cfString,
+                     CFRangeMake(0, length),
+                     kCFStringEncodingUTF8,
+                     '?',
+                     false,
+                     ((UInt8 *)[buffer mutableBytes] + originalLength),
+                     maximumByteLength,
+                     &usedByteLength);
+    [buffer setLength:(originalLength + (NSUInteger)usedByteLength)];
+}
+
+void JELogScratchBufferAppendUTF8String(NSMutableData *buffer, const char *string) {
+    
+    NSCParameterAssert(buffer != nil);
+    
+    if (string) {
+        
+        [buffer appendBytes:string length:strlen(string)];
+    }
+}
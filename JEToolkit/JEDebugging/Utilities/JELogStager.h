@@ -0,0 +1,77 @@
+//
+//  JELogStager.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "JECompilerDefines.h"
+
+/*! Called on the stager's queue with a record staged with -stageRecord:length:handler:flushImmediately:. The record is only valid during the call.
+ */
+typedef void (*JELogStagerRecordHandler)(void *_Nonnull record);
+
+/*! JELogStager batches blocks bound for a single logger queue. Each producer thread appends to its own staging buffer, and a buffer is handed to the queue as one block once it holds enough blocks, once its oldest block has waited long enough, or when flushed explicitly. Buffers are also flushed when their thread exits. Used internally by JEDebugging to amortize queue overhead across many log records.
+ 
+ Blocks and records staged from the same thread run in the order they were staged. JELogStager is thread-safe.
+ */
+@interface JELogStager : NSObject
+
+/*! Initializes a stager for the specified queue.
+ @param queue the queue that runs the staged blocks
+ @param isBarrier YES to submit batches to @p queue as barrier blocks
+ @param maximumNumberOfBlocks the number of blocks and records a thread can stage before they are handed off
+ @param maximumLatency the longest time in seconds a block or record can stay staged
+ */
+- (nonnull instancetype)initWithQueue:(nonnull dispatch_queue_t)queue
+                            isBarrier:(BOOL)isBarrier
+                maximumNumberOfBlocks:(NSUInteger)maximumNumberOfBlocks
+                       maximumLatency:(NSTimeInterval)maximumLatency JE_DESIGNATED_INITIALIZER;
+
+/*! Stages a block in the current thread's buffer.
+ @param block the block to run on the receiver's queue
+ @param flushImmediately YES to hand off the current thread's buffer right away, such as for high-priority records
+ */
+- (void)stageBlock:(nonnull dispatch_block_t)block
+  flushImmediately:(BOOL)flushImmediately;
+
+/*! Stages a copy of a record in the current thread's buffer. The record's bytes are copied into staging storage that is reused across batches, so unlike -stageBlock:flushImmediately:, this does not allocate once the storage has grown to fit a batch. Objects referenced by the record must be retained by the caller and released by @p handler.
+ @param record the bytes of the record
+ @param length the number of bytes in @p record
+ @param handler the function called with the staged copy of the record on the receiver's queue
+ @param flushImmediately YES to hand off the current thread's buffer right away, such as for high-priority records
+ */
+- (void)stageRecord:(nonnull const void *)record
+             length:(NSUInteger)length
+            handler:(nonnull JELogStagerRecordHandler)handler
+   flushImmediately:(BOOL)flushImmediately;
+
+/*! Hands off the current thread's staged blocks and records, such as before submitting work to the receiver's queue directly that must run after them.
+ */
+- (void)flushCurrentThread;
+
+/*! Hands off the staged blocks and records of all threads. Blocks and records staged before this call are submitted to the receiver's queue before it returns.
+ */
+- (void)flushAllThreads;
+
+@end
@@ -0,0 +1,387 @@
+//
+//  JELogStager.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogStager.h"
+
+#include <pthread.h>
+#include <string.h>
+
+
+/*! The header of each staged entry. A block entry holds the retained block, and a record entry is followed by the record's bytes. Entries are padded so that the next one stays aligned.
+ */
+typedef struct _JELogStagedEntry {
+    
+    JELogStagerRecordHandler handler;
+    void *block;
+    NSUInteger length;
+    
+} __attribute__((aligned(16))) _JELogStagedEntry;
+
+// Storage for staged entries is recycled between batches, except when it grew past this length.
+static const NSUInteger _JELogStagerMaximumRetainedEntriesLength = (256 * 1024);
+static const NSUInteger _JELogStagerMaximumNumberOfSpareEntries = 8;
+
+
+JE_STATIC
+NSUInteger _JELogStagedEntryLength(NSUInteger recordLength) {
+    
+    return ((sizeof(_JELogStagedEntry) + recordLength + (_Alignof(_JELogStagedEntry) - 1))
+            & ~(NSUInteger)(_Alignof(_JELogStagedEntry) - 1));
+}
+
+JE_STATIC
+void _JELogStagerRunEntries(NSMutableData *entries) {
+    
+    uint8_t *bytes = (uint8_t *)[entries mutableBytes];
+    NSUInteger length = [entries length];
+    NSUInteger offset = 0;
+    while (offset < length) {
+        
+        _JELogStagedEntry *entry = (_JELogStagedEntry *)(bytes + offset);
+        if (entry->handler) {
+            
+            entry->handler(bytes + offset + sizeof(_JELogStagedEntry));
+        }
+        else {
+            
+            dispatch_block_t block = (__bridge_transfer dispatch_block_t)entry->block;
+            block();
+        }
+        offset += _JELogStagedEntryLength(entry->length);
+    }
+}
+
+
+#pragma mark - _JELogStagingBuffer
+
+/*! A single thread's staged blocks and records. Appended to by the owning thread, but also flushed from the latency timer and from flushAllThreads, so all access goes through the mutex.
+ */
+@interface _JELogStagingBuffer : NSObject {
+    
+@public
+    pthread_mutex_t _mutex;
+    NSMutableData *_entries;
+    NSUInteger _numberOfEntries;
+    BOOL _isFlushScheduled;
+    __weak JELogStager *_stager;
+}
+
+@end
+
+
+@implementation _JELogStagingBuffer
+
+- (instancetype)init {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    pthread_mutex_init(&_mutex, NULL);
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    pthread_mutex_destroy(&_mutex);
+}
+
+@end
+
+
+#pragma mark - JELogStager
+
+@interface JELogStager ()
+
+@property (nonatomic, strong, readonly) dispatch_queue_t queue;
+@property (nonatomic, assign, readonly) BOOL isBarrier;
+@property (nonatomic, assign, readonly) NSUInteger maximumNumberOfBlocks;
+@property (nonatomic, assign, readonly) NSTimeInterval maximumLatency;
+
+// Buffers of live threads, only accessed from the registryQueue.
+@property (nonatomic, strong, readonly) NSMutableSet *buffers;
+@property (nonatomic, strong, readonly) dispatch_queue_t registryQueue;
+
+// Emptied entry storage returned by the queue after a batch ran, guarded by the spareEntriesMutex.
+@property (nonatomic, strong, readonly) NSMutableArray *spareEntries;
+
+- (void)flushBuffer:(_JELogStagingBuffer *)buffer;
+- (void)unregisterBuffer:(_JELogStagingBuffer *)buffer;
+
+@end
+
+
+JE_STATIC
+void _JELogStagerThreadDidExit(void *value) {
+    
+    @autoreleasepool {
+        
+        _JELogStagingBuffer *buffer = (__bridge_transfer _JELogStagingBuffer *)value;
+        JELogStager *stager = buffer->_stager;
+        [stager flushBuffer:buffer];
+        [stager unregisterBuffer:buffer];
+    }
+}
+
+
+@implementation JELogStager {
+    
+    pthread_key_t _bufferKey;
+    pthread_mutex_t _spareEntriesMutex;
+}
+
+#pragma mark - NSObject
+
+- (instancetype)initWithQueue:(dispatch_queue_t)queue
+                    isBarrier:(BOOL)isBarrier
+        maximumNumberOfBlocks:(NSUInteger)maximumNumberOfBlocks
+               maximumLatency:(NSTimeInterval)maximumLatency {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _queue = queue;
+    _isBarrier = isBarrier;
+    _maximumNumberOfBlocks = MAX((NSUInteger)1, maximumNumberOfBlocks);
+    _maximumLatency = MAX(0, maximumLatency);
+    _buffers = [[NSMutableSet alloc] init];
+    _registryQueue = dispatch_queue_create("com.JEToolkit.JEDebugging.logStagerRegistryQueue", DISPATCH_QUEUE_SERIAL);
+    _spareEntries = [[NSMutableArray alloc] initWithCapacity:_JELogStagerMaximumNumberOfSpareEntries];
+    pthread_key_create(&_bufferKey, _JELogStagerThreadDidExit);
+    pthread_mutex_init(&_spareEntriesMutex, NULL);
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    pthread_key_delete(_bufferKey);
+    pthread_mutex_destroy(&_spareEntriesMutex);
+}
+
+
+#pragma mark - Private
+
+- (_JELogStagingBuffer *)currentThreadBuffer {
+    
+    _JELogStagingBuffer *buffer = (__bridge _JELogStagingBuffer *)pthread_getspecific(_bufferKey);
+    if (buffer) {
+        
+        return buffer;
+    }
+    
+    buffer = [[_JELogStagingBuffer alloc] init];
+    buffer->_stager = self;
+    buffer->_entries = [self dequeueSpareEntries];
+    pthread_setspecific(_bufferKey, (__bridge_retained void *)buffer);
+    dispatch_sync(self.registryQueue, ^{
+        
+        [self.buffers addObject:buffer];
+    });
+    return buffer;
+}
+
+- (NSMutableData *)dequeueSpareEntries {
+    
+    pthread_mutex_lock(&_spareEntriesMutex);
+    
+    NSMutableData *entries = [self.spareEntries lastObject];
+    if (entries) {
+        
+        [self.spareEntries removeLastObject];
+    }
+    
+    pthread_mutex_unlock(&_spareEntriesMutex);
+    
+    return (entries ?: [[NSMutableData alloc] initWithCapacity:(self.maximumNumberOfBlocks * 256)]);
+}
+
+- (void)recycleEntries:(NSMutableData *)entries {
+    
+    if ([entries length] > _JELogStagerMaximumRetainedEntriesLength) {
+        
+        return;
+    }
+    
+    // Shrinking an NSMutableData keeps its allocated capacity.
+    [entries setLength:0];
+    
+    pthread_mutex_lock(&_spareEntriesMutex);
+    
+    if ([self.spareEntries count] < _JELogStagerMaximumNumberOfSpareEntries) {
+        
+        [self.spareEntries addObject:entries];
+    }
+    
+    pthread_mutex_unlock(&_spareEntriesMutex);
+}
+
+- (void)flushBuffer:(_JELogStagingBuffer *)buffer {
+    
+    pthread_mutex_lock(&buffer->_mutex);
+    
+    NSMutableData *entries = buffer->_entries;
+    buffer->_isFlushScheduled = NO;
+    if (buffer->_numberOfEntries > 0) {
+        
+        buffer->_entries = [self dequeueSpareEntries];
+        buffer->_numberOfEntries = 0;
+        
+        // Submitted while locked, so batches from the same thread can't overtake each other.
+        dispatch_block_t batch = ^{
+            
+            _JELogStagerRunEntries(entries);
+            [self recycleEntries:entries];
+        };
+        if (self.isBarrier) {
+            
+            dispatch_barrier_async(self.queue, batch);
+        }
+        else {
+            
+            dispatch_async(self.queue, batch);
+        }
+    }
+    
+    pthread_mutex_unlock(&buffer->_mutex);
+}
+
+- (void)unregisterBuffer:(_JELogStagingBuffer *)buffer {
+    
+    dispatch_sync(self.registryQueue, ^{
+        
+        [self.buffers removeObject:buffer];
+    });
+}
+
+- (void)stageEntryWithHandler:(JELogStagerRecordHandler)handler
+                        block:(void *)block
+                       record:(const void *)record
+                       length:(NSUInteger)length
+             flushImmediately:(BOOL)flushImmediately {
+    
+    _JELogStagingBuffer *buffer = [self currentThreadBuffer];
+    
+    pthread_mutex_lock(&buffer->_mutex);
+    
+    // Growing the storage zero-fills it, but once it has grown to fit a batch, appending only copies.
+    NSMutableData *entries = buffer->_entries;
+    NSUInteger offset = [entries length];
+    [entries setLength:(offset + _JELogStagedEntryLength(length))];
+    
+    uint8_t *bytes = ((uint8_t *)[entries mutableBytes] + offset);
+    _JELogStagedEntry *entry = (_JELogStagedEntry *)bytes;
+    entry->handler = handler;
+    entry->block = block;
+    entry->length = length;
+    if (length > 0) {
+        
+        memcpy((bytes + sizeof(_JELogStagedEntry)), record, length);
+    }
+    ++buffer->_numberOfEntries;
+    
+    BOOL isFull = (buffer->_numberOfEntries >= self.maximumNumberOfBlocks);
+    BOOL needsTimer = (!flushImmediately && !isFull && !buffer->_isFlushScheduled);
+    if (needsTimer) {
+        
+        buffer->_isFlushScheduled = YES;
+    }
+    
+    pthread_mutex_unlock(&buffer->_mutex);
+    
+    if (flushImmediately || isFull) {
+        
+        [self flushBuffer:buffer];
+    }
+    else if (needsTimer) {
+        
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.maximumLatency * NSEC_PER_SEC)),
+                       dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                       ^{
+                           
+                           [self flushBuffer:buffer];
+                       });
+    }
+}
+
+
+#pragma mark - Public
+
+- (void)stageBlock:(dispatch_block_t)block
+  flushImmediately:(BOOL)flushImmediately {
+    
+    [self
+     stageEntryWithHandler:NULL
+     block:(__bridge_retained void *)[block copy]
+     record:NULL
+     length:0
+     flushImmediately:flushImmediately];
+}
+
+- (void)stageRecord:(const void *)record
+             length:(NSUInteger)length
+            handler:(JELogStagerRecordHandler)handler
+   flushImmediately:(BOOL)flushImmediately {
+    
+    NSCParameterAssert(record != NULL);
+    NSCParameterAssert(handler != NULL);
+    
+    [self
+     stageEntryWithHandler:handler
+     block:NULL
+     record:record
+     length:length
+     flushImmediately:flushImmediately];
+}
+
+- (void)flushCurrentThread {
+    
+    _JELogStagingBuffer *buffer = (__bridge _JELogStagingBuffer *)pthread_getspecific(_bufferKey);
+    if (buffer) {
+        
+        [self flushBuffer:buffer];
+    }
+}
+
+- (void)flushAllThreads {
+    
+    NSArray *__block buffers;
+    dispatch_sync(self.registryQueue, ^{
+        
+        buffers = [self.buffers allObjects];
+    });
+    for (_JELogStagingBuffer *buffer in buffers) {
+        
+        [self flushBuffer:buffer];
+    }
+}
+
+@end
@@ -0,0 +1,99 @@
+//
+//  JELogThrottle.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#ifndef JEToolkit_JELogThrottle_h
+#define JEToolkit_JELogThrottle_h
+
+#include <stdint.h>
+
+#import "JECompilerDefines.h"
+
+
+/*! Per-callsite state for the JELog...Sampled(...) macros. Declare as a static variable initialized to { 0 }.
+ */
+typedef struct JELogSampler {
+    
+    uint64_t numberOfCalls;
+    
+} JELogSampler;
+
+/*! Per-callsite state for the JELog...RateLimited(...) macros. Declare as a static variable initialized to { 0 }.
+ */
+typedef struct JELogRateLimiter {
+    
+    uint64_t theoreticalArrivalTime;
+    uint64_t numberOfSuppressedCalls;
+    
+} JELogRateLimiter;
+
+
+/*! Lets through one out of every @p sampleInterval calls. Thread-safe and lock-free.
+ @param sampler the callsite's sampler
+ @param sampleInterval the number of calls per logged message. 0 and 1 log every call
+ @param numberOfSuppressedCalls set to the number of calls skipped since the last logged message, if the call should be logged
+ @return nonzero if the call should be logged, 0 otherwise
+ */
+static inline int JELogSamplerShouldLog(JELogSampler *_Nonnull sampler,
+                                        unsigned long sampleInterval,
+                                        unsigned long *_Nonnull numberOfSuppressedCalls) {
+    
+    if (sampleInterval <= 1) {
+        
+        (*numberOfSuppressedCalls) = 0;
+        return 1;
+    }
+    uint64_t callIndex = __atomic_fetch_add(&sampler->numberOfCalls, 1, __ATOMIC_RELAXED);
+    if ((callIndex % sampleInterval) != 0) {
+        
+        return 0;
+    }
+    (*numberOfSuppressedCalls) = (callIndex == 0 ? 0 : (sampleInterval - 1));
+    return 1;
+}
+
+/*! Lets through up to @p callsPerSecond calls per second, allowing a burst of up to one second's worth of calls. Thread-safe and lock-free.
+ @param rateLimiter the callsite's rate limiter
+ @param callsPerSecond the sustained number of calls to let through per second
+ @param numberOfSuppressedCalls set to the number of calls rejected since the last logged message, if the call should be logged
+ @return nonzero if the call should be logged, 0 otherwise
+ */
+JE_EXTERN
+int JELogRateLimiterShouldLog(JELogRateLimiter *_Nonnull rateLimiter,
+                              double callsPerSecond,
+                              unsigned long *_Nonnull numberOfSuppressedCalls);
+
+/*! Appends the number of suppressed calls to a sampled or rate-limited message.
+ @param message the formatted message
+ @param numberOfSuppressedCalls the number of calls suppressed before this message
+ @return @p message if no calls were suppressed, otherwise @p message with the count appended
+ */
+JE_EXTERN
+NSString *_Nonnull JELogMessageWithSuppressedCalls(NSString *_Nonnull message,
+                                                   unsigned long numberOfSuppressedCalls);
+
+
+#endif
@@ -0,0 +1,96 @@
+//
+//  JELogThrottle.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JELogThrottle.h"
+
+#include <mach/mach_time.h>
+
+
+JE_STATIC
+double _JELogThrottleAbsoluteTimePerSecond(void) {
+    
+    static double absoluteTimePerSecond;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        absoluteTimePerSecond = ((double)NSEC_PER_SEC * (double)timebase.denom / (double)timebase.numer);
+    });
+    return absoluteTimePerSecond;
+}
+
+
+int JELogRateLimiterShouldLog(JELogRateLimiter *rateLimiter,
+                              double callsPerSecond,
+                              unsigned long *numberOfSuppressedCalls) {
+    
+    if (callsPerSecond <= 0) {
+        
+        __atomic_fetch_add(&rateLimiter->numberOfSuppressedCalls, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    
+    // A token bucket in its GCRA form: a single timestamp tracks when the bucket would be full again, so it can be updated with one compare-and-swap.
+    double absoluteTimePerSecond = _JELogThrottleAbsoluteTimePerSecond();
+    uint64_t emissionInterval = (uint64_t)MAX(1.0, (absoluteTimePerSecond / callsPerSecond));
+    uint64_t burstTolerance = (uint64_t)MAX(0.0, (absoluteTimePerSecond - (double)emissionInterval));
+    uint64_t now = mach_absolute_time();
+    
+    uint64_t theoreticalArrivalTime = __atomic_load_n(&rateLimiter->theoreticalArrivalTime, __ATOMIC_RELAXED);
+    while (YES) {
+        
+        uint64_t arrivalTime = MAX(theoreticalArrivalTime, now);
+        if ((arrivalTime - now) > burstTolerance) {
+            
+            __atomic_fetch_add(&rateLimiter->numberOfSuppressedCalls, 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+        if (__atomic_compare_exchange_n(&rateLimiter->theoreticalArrivalTime,
+                                        &theoreticalArrivalTime,
+                                        (arrivalTime + emissionInterval),
+                                        YES,
+                                        __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+            
+            break;
+        }
+    }
+    
+    (*numberOfSuppressedCalls) = (unsigned long)__atomic_exchange_n(&rateLimiter->numberOfSuppressedCalls, 0, __ATOMIC_RELAXED);
+    return 1;
+}
+
+NSString *JELogMessageWithSuppressedCalls(NSString *message, unsigned long numberOfSuppressedCalls) {
+    
+    if (numberOfSuppressedCalls == 0) {
+        
+        return message;
+    }
+    return [[NSString alloc] initWithFormat:@"%@ (%lu similar call%@ suppressed)",
+            message,
+            numberOfSuppressedCalls,
+            (numberOfSuppressedCalls == 1 ? @"" : @"s")];
+}
@@ -32,6 +32,7 @@
 #import "JESafetyHelpers.h"
 
 #import "JEDebugging.h"
+#import "JELogRingBuffer.h"
 
 #import "NSObject+JEToolkit.h"
 #import "NSString+JEToolkit.h"
@@ -51,7 +52,7 @@ static const NSTimeInterval JEHUDLogFrameCoalescingInterval = 0.5;
 
 @interface JEHUDLogView () <UITableViewDataSource, UITableViewDelegate>
 
-@property (nonatomic, strong, readonly) NSMutableArray *pendingLogEntries;
+@property (nonatomic, strong, readonly) JELogRingBuffer *pendingLogEntries;
 @property (nonatomic, strong, readonly) CADisplayLink *displayLink;
 
 @property (nonatomic, weak) UIView *menuView;
@@ -88,7 +89,7 @@ static const NSTimeInterval JEHUDLogFrameCoalescingInterval = 0.5;
         return nil;
     }
     
-    _pendingLogEntries = [[NSMutableArray alloc] initWithCapacity:HUDLogSettings.numberOfLogEntriesInMemory];
+    _pendingLogEntries = [[JELogRingBuffer alloc] initWithCapacity:HUDLogSettings.numberOfLogEntriesInMemory];
     _buttonOffsetOnStart = @(HUDLogSettings.buttonOffsetOnStart);
     
     CADisplayLink *displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidFire:)];
@@ -737,7 +738,7 @@ static const NSTimeInterval JEHUDLogFrameCoalescingInterval = 0.5;
     NSCAssert([NSThread isMainThread],
               @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
     
-    self.displayedLogEntries = self.pendingLogEntries;
+    self.displayedLogEntries = [self.pendingLogEntries snapshot];
     self.hasPendingLogUpdates = NO;
     
     UITableView *tableView = self.tableView;
@@ -785,19 +786,8 @@ withThreadSafeSettings:(JEHUDLoggerSettings *)HUDLogSettings {
     NSCAssert([NSThread isMainThread],
               @"%@ called on the wrong queue.", NSStringFromSelector(_cmd));
     
-    NSMutableArray *pendingLogEntries = self.pendingLogEntries;
-    NSUInteger numberOfPendingLogEntries = [pendingLogEntries count];
-    NSUInteger maxNumberOfLogEntriesInMemory = HUDLogSettings.numberOfLogEntriesInMemory;
-    
-    if (numberOfPendingLogEntries >= maxNumberOfLogEntriesInMemory) {
-        
-        NSIndexSet *indexSet = [NSIndexSet indexSetWithIndexesInRange:(NSRange){
-            .location = 0,
-            .length = (numberOfPendingLogEntries - maxNumberOfLogEntriesInMemory)
-        }];
-        [pendingLogEntries removeObjectsAtIndexes:indexSet];
-    }
-    
+    JELogRingBuffer *pendingLogEntries = self.pendingLogEntries;
+    pendingLogEntries.capacity = HUDLogSettings.numberOfLogEntriesInMemory;
     [pendingLogEntries addObject:logString];
     self.hasPendingLogUpdates = YES;
     
@@ -0,0 +1,86 @@
+//
+//  JEConcurrentOrderedDictionary.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class JEOrderedDictionary;
+
+/*! The JEConcurrentOrderedDictionary class is an ordered dictionary that can be read from many threads while being written from others. Readers never take a lock: each read goes through an immutable snapshot of the dictionary, so enumerations always see a consistent state. Writers are serialized by a mutex and publish a new snapshot after each update, and a replaced snapshot is only released once no reader can still be using it.
+ The published snapshot shares its storage with the dictionary writers update, so the next write has to copy every entry first. Every write is therefore O(n). Use performUpdates: to pay that cost once for a batch of updates, and prefer this class for data that is read far more often than it is written.
+ */
+@interface JEConcurrentOrderedDictionary : NSObject
+
+/*! Returns the current snapshot of the dictionary. The snapshot never changes after it is published, and it can be kept and read from any thread for as long as needed.
+ @return The current snapshot. The snapshot must not be mutated.
+ */
+- (nonnull JEOrderedDictionary *)snapshot;
+
+/*! Returns the number of entries in the current snapshot
+ */
+- (NSUInteger)count;
+
+/*! Returns the object for the specified key in the current snapshot
+ @param aKey The key
+ @return The object for aKey, or nil if no object is associated with aKey
+ */
+- (nullable id)objectForKey:(nonnull id)aKey;
+
+/*! Same as objectForKey:
+ */
+- (nullable id)objectForKeyedSubscript:(nonnull id)key;
+
+/*! Sets the object for the specified key and publishes a new snapshot
+ @param anObject The object for aKey
+ @param aKey The key for anObject. The key is copied.
+ */
+- (void)setObject:(nonnull id)anObject forKey:(nonnull id<NSCopying>)aKey;
+
+/*! Same as setObject:forKey:
+ */
+- (void)setObject:(nonnull id)obj forKeyedSubscript:(nonnull id<NSCopying>)key;
+
+/*! Removes the specified key and publishes a new snapshot
+ @param aKey The key to remove
+ */
+- (void)removeObjectForKey:(nonnull id)aKey;
+
+/*! Removes all entries and publishes a new snapshot
+ */
+- (void)removeAllObjects;
+
+/*! Applies several updates under a single writer lock and publishes one snapshot for all of them. Readers see either none or all of the updates.
+ maximumCount, totalCostLimit, and evictionHandler set on the passed dictionary apply to later updates. Published snapshots never order by access, count lookups, or evict, so reads can't change them.
+ @param updates A block that mutates the passed dictionary. The dictionary must not be kept after the block returns.
+ */
+- (void)performUpdates:(nonnull void (^)(JEOrderedDictionary *_Nonnull dictionary))updates;
+
+/*! Applies a given block object to the entries of the current snapshot. Writes made during the enumeration are not seen by it.
+ @param opts Enumeration options.
+ @param block A block object to operate on entries in the dictionary.
+ */
+- (void)enumerateIndexesAndKeysAndObjectsWithOptions:(NSEnumerationOptions)opts
+                                          usingBlock:(nonnull void (^)(NSUInteger idx, id _Nonnull key, id _Nonnull obj, BOOL *_Nonnull stop))block;
+
+@end
@@ -0,0 +1,223 @@
+//
+//  JEConcurrentOrderedDictionary.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JEConcurrentOrderedDictionary.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#import "JEOrderedDictionary.h"
+
+
+/*! Readers announce themselves on one of several counters picked by thread, so concurrent readers rarely write to the same cache line. Each shard has one counter per phase.
+ */
+typedef struct _JEConcurrentOrderedDictionaryReaderShard {
+    
+    uint64_t readerCounts[2];
+    uint8_t padding[64 - (2 * sizeof(uint64_t))];
+    
+} _JEConcurrentOrderedDictionaryReaderShard;
+
+enum {
+    
+    _JEConcurrentOrderedDictionaryReaderShardCount = 16
+};
+
+
+static inline _JEConcurrentOrderedDictionaryReaderShard *_JEConcurrentOrderedDictionaryReaderShardForCurrentThread(_JEConcurrentOrderedDictionaryReaderShard *readerShards) {
+    
+    return &readerShards[pthread_mach_thread_np(pthread_self()) % _JEConcurrentOrderedDictionaryReaderShardCount];
+}
+
+static inline uint32_t _JEConcurrentOrderedDictionaryBeginRead(_JEConcurrentOrderedDictionaryReaderShard *shard, uint32_t *phase) {
+    
+    while (YES) {
+        
+        // A reader is only counted in a phase that was still current after it announced itself. The writer that ends that phase waits for it, so a snapshot loaded before _JEConcurrentOrderedDictionaryEndRead can't be released under it.
+        uint32_t currentPhase = __atomic_load_n(phase, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&shard->readerCounts[currentPhase], 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(phase, __ATOMIC_SEQ_CST) == currentPhase) {
+            
+            return currentPhase;
+        }
+        __atomic_fetch_sub(&shard->readerCounts[currentPhase], 1, __ATOMIC_RELEASE);
+    }
+}
+
+static inline void _JEConcurrentOrderedDictionaryEndRead(_JEConcurrentOrderedDictionaryReaderShard *shard, uint32_t phase) {
+    
+    __atomic_fetch_sub(&shard->readerCounts[phase], 1, __ATOMIC_RELEASE);
+}
+
+
+@implementation JEConcurrentOrderedDictionary {
+    
+    _JEConcurrentOrderedDictionaryReaderShard _readerShards[_JEConcurrentOrderedDictionaryReaderShardCount];
+    uint32_t _phase;
+    CFTypeRef _snapshot;
+    
+    pthread_mutex_t _writerMutex;
+    JEOrderedDictionary *_dictionary;
+}
+
+#pragma mark - NSObject
+
+- (instancetype)init {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    pthread_mutex_init(&_writerMutex, NULL);
+    _dictionary = [[JEOrderedDictionary alloc] init];
+    _snapshot = CFBridgingRetain([_dictionary copy]);
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    CFRelease(_snapshot);
+    pthread_mutex_destroy(&_writerMutex);
+}
+
+
+#pragma mark - Public
+
+- (JEOrderedDictionary *)snapshot {
+    
+    _JEConcurrentOrderedDictionaryReaderShard *shard = _JEConcurrentOrderedDictionaryReaderShardForCurrentThread(_readerShards);
+    uint32_t phase = _JEConcurrentOrderedDictionaryBeginRead(shard, &_phase);
+    CFTypeRef snapshot = CFRetain(__atomic_load_n(&_snapshot, __ATOMIC_SEQ_CST));
+    _JEConcurrentOrderedDictionaryEndRead(shard, phase);
+    return CFBridgingRelease(snapshot);
+}
+
+- (NSUInteger)count {
+    
+    _JEConcurrentOrderedDictionaryReaderShard *shard = _JEConcurrentOrderedDictionaryReaderShardForCurrentThread(_readerShards);
+    uint32_t phase = _JEConcurrentOrderedDictionaryBeginRead(shard, &_phase);
+    NSUInteger count = [(__bridge JEOrderedDictionary *)__atomic_load_n(&_snapshot, __ATOMIC_SEQ_CST) count];
+    _JEConcurrentOrderedDictionaryEndRead(shard, phase);
+    return count;
+}
+
+- (id)objectForKey:(id)aKey {
+    
+    // Single lookups borrow the snapshot inside the read instead of retaining it. Only the object is retained, before the read ends, since releasing the snapshot would release the object too.
+    _JEConcurrentOrderedDictionaryReaderShard *shard = _JEConcurrentOrderedDictionaryReaderShardForCurrentThread(_readerShards);
+    uint32_t phase = _JEConcurrentOrderedDictionaryBeginRead(shard, &_phase);
+    id object = [(__bridge JEOrderedDictionary *)__atomic_load_n(&_snapshot, __ATOMIC_SEQ_CST) objectForKey:aKey];
+    _JEConcurrentOrderedDictionaryEndRead(shard, phase);
+    return object;
+}
+
+- (id)objectForKeyedSubscript:(id)key {
+    
+    return [self objectForKey:key];
+}
+
+- (void)setObject:(id)anObject forKey:(id<NSCopying>)aKey {
+    
+    [self performUpdates:^(JEOrderedDictionary *dictionary) {
+        
+        [dictionary setObject:anObject forKey:aKey];
+    }];
+}
+
+- (void)setObject:(id)obj forKeyedSubscript:(id<NSCopying>)key {
+    
+    [self setObject:obj forKey:key];
+}
+
+- (void)removeObjectForKey:(id)aKey {
+    
+    [self performUpdates:^(JEOrderedDictionary *dictionary) {
+        
+        [dictionary removeObjectForKey:aKey];
+    }];
+}
+
+- (void)removeAllObjects {
+    
+    [self performUpdates:^(JEOrderedDictionary *dictionary) {
+        
+        [dictionary removeAllObjects];
+    }];
+}
+
+- (void)performUpdates:(void (^)(JEOrderedDictionary *dictionary))updates {
+    
+    pthread_mutex_lock(&_writerMutex);
+    @try {
+        
+        updates(_dictionary);
+        
+        // Snapshots are read without locks, so they must not reorder keys, count lookups, or evict. Limits set by the updates still apply to the writer's dictionary.
+        JEOrderedDictionary *snapshot = [_dictionary copy];
+        snapshot.ordersByAccess = NO;
+        snapshot.maximumCount = 0;
+        snapshot.totalCostLimit = 0;
+        snapshot.evictionHandler = nil;
+        [self publishSnapshot:snapshot];
+    }
+    @finally {
+        
+        pthread_mutex_unlock(&_writerMutex);
+    }
+}
+
+- (void)enumerateIndexesAndKeysAndObjectsWithOptions:(NSEnumerationOptions)opts
+                                          usingBlock:(void (^)(NSUInteger idx, id key, id obj, BOOL *stop))block {
+    
+    [[self snapshot]
+     enumerateIndexesAndKeysAndObjectsWithOptions:opts
+     usingBlock:block];
+}
+
+
+#pragma mark - Private
+
+- (void)publishSnapshot:(JEOrderedDictionary *)snapshot {
+    
+    // Only writers change the phase, and writers hold _writerMutex.
+    CFTypeRef previousSnapshot = __atomic_exchange_n(&_snapshot, CFBridgingRetain(snapshot), __ATOMIC_SEQ_CST);
+    uint32_t previousPhase = _phase;
+    __atomic_store_n(&_phase, (previousPhase ^ 1), __ATOMIC_SEQ_CST);
+    
+    // Readers in the previous phase may still be using the previous snapshot. Their window is a retain or a single lookup, so spinning is short.
+    for (NSUInteger i = 0; i < _JEConcurrentOrderedDictionaryReaderShardCount; ++i) {
+        
+        while (__atomic_load_n(&_readerShards[i].readerCounts[previousPhase], __ATOMIC_ACQUIRE) > 0) {
+            
+            sched_yield();
+        }
+    }
+    CFRelease(previousSnapshot);
+}
+
+@end
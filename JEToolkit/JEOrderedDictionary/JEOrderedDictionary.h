@@ -26,9 +26,67 @@
 #import <Foundation/Foundation.h>
 
 /*! The JEOrderedDictionary class is an NSMutableDictionary subclass that remembers the order of inserted keys. This is typically useful in cases where the chronological information or a constant ordering of keys is important.
+ Removing keys is amortized O(1) regardless of position. Index-based methods are O(1) after removals from either end, and O(log n) after removals from the middle until a later mutation compacts the entries.
+ copy and mutableCopy are O(1): copies share their storage until one of them is mutated, at which point that dictionary takes its own copy of the entries. Reads never write to the dictionary unless ordersByAccess is YES or a limit is set, since objectForKey: then reorders keys and counts lookups. Otherwise a dictionary that is not being mutated, and any copies sharing its storage, can be read from different threads at once. Different copies can also be mutated concurrently.
+ Dictionaries with room for up to 8 entries find keys by scanning them instead of keeping a hash index, so small dictionaries need only one allocation for their storage.
  */
 @interface JEOrderedDictionary : NSMutableDictionary
 
+#pragma mark - Access ordering and limits
+
+/*! When YES, objectForKey: (including subscripting) and setObject:forKey: on an existing key move that key to the end of the ordering, so the first key is always the least recently used. Moving a key counts as a mutation, so keys should not be looked up this way while the dictionary is being fast enumerated. Defaults to NO
+ */
+@property (nonatomic, assign) BOOL ordersByAccess;
+
+/*! The maximum number of entries the dictionary holds. When exceeded, entries are evicted from the front. Set to 0 for no limit. Defaults to 0
+ */
+@property (nonatomic, assign) NSUInteger maximumCount;
+
+/*! The maximum total cost of all entries in the dictionary. When exceeded, entries are evicted from the front. Set to 0 for no limit. Defaults to 0
+ */
+@property (nonatomic, assign) NSUInteger totalCostLimit;
+
+/*! The sum of the costs of all entries in the dictionary
+ */
+@property (nonatomic, assign, readonly) NSUInteger totalCost;
+
+/*! Called with the key and object of each entry evicted because of maximumCount or totalCostLimit. Not called for entries removed explicitly. Defaults to nil
+ */
+@property (nonatomic, copy, nullable) void (^evictionHandler)(id _Nonnull key, id _Nonnull obj);
+
+/*! The number of objectForKey: lookups that found an object. Lookups are only counted while ordersByAccess is YES or a limit is set.
+ */
+@property (nonatomic, assign, readonly) NSUInteger hitCount;
+
+/*! The number of objectForKey: lookups that didn't find an object. Lookups are only counted while ordersByAccess is YES or a limit is set.
+ */
+@property (nonatomic, assign, readonly) NSUInteger missCount;
+
+/*! The number of entries evicted because of maximumCount or totalCostLimit
+ */
+@property (nonatomic, assign, readonly) NSUInteger evictionCount;
+
+/*! Sets the object for the specified key with a cost that counts against totalCostLimit
+ @param anObject The object for key
+ @param aKey The key for anObject. The key is copied.
+ @param cost The cost of the entry
+ */
+- (void)setObject:(nonnull id)anObject forKey:(nonnull id<NSCopying>)aKey cost:(NSUInteger)cost;
+
+/*! Moves the specified key to the end of the ordering in amortized O(1) time, regardless of ordersByAccess
+ @param key The key to move
+ @return YES if the key was found, NO otherwise
+ */
+- (BOOL)touchKey:(nonnull id)key;
+
+/*! Resets hitCount, missCount, and evictionCount to 0
+ */
+- (void)resetStatistics;
+
+
+#pragma mark - Ordered access
+
+
 /*! Returns the object for the first key added to the dictionary
  @return The object for the first key added to the receiver or nil if the dictionary is empty
  */
@@ -81,7 +139,8 @@
 - (void)enumerateIndexesAndKeysAndObjectsUsingBlock:(nonnull void (^)(NSUInteger idx, id _Nonnull key, id _Nonnull obj, BOOL *_Nonnull stop))block;
 
 /*! Applies a given block object to the entries of the dictionary.
- If the block sets *stop to YES, the enumeration stops.
+ If the block sets *stop to YES, the enumeration stops. With NSEnumerationConcurrent, the entries are split into contiguous ranges that are enumerated in parallel, and entries already being visited on other threads may still be passed to the block after *stop is set.
+ Mutating the dictionary from the block, including looking up keys while ordersByAccess is YES, raises an NSGenericException. With NSEnumerationConcurrent, the exception is raised once every range has stopped.
  @param opts Enumeration options.
  @param block A block object to operate on entries in the dictionary.
  */
@@ -98,4 +157,52 @@
                                            options:(NSEnumerationOptions)opts
                                         usingBlock:(nonnull void (^)(NSUInteger idx, id _Nonnull key, id _Nonnull obj, BOOL *_Nonnull stop))block;
 
+
+#pragma mark - Bulk operations
+
+/*! Adds entries from a C array of alternating keys and objects, reserving capacity for all of them once instead of growing as entries are added. Existing keys keep their position and take the new object.
+ @param pairs A C array of 2 * count elements in the order key0, object0, key1, object1, ... Keys are copied.
+ @param count The number of key-object pairs in pairs
+ */
+- (void)addEntriesFromOrderedPairs:(const __unsafe_unretained id _Nonnull [_Nonnull])pairs count:(NSUInteger)count;
+
+/*! Removes the entries in the specified range of indexes in a single pass
+ @param range The range of indexes to remove. If the range extends beyond the end of the dictionary, an NSRangeException is raised.
+ */
+- (void)removeKeysInRange:(NSRange)range;
+
+/*! Sorts the keys in place, with the objects following their keys. Dictionaries with many entries are sorted on multiple cores. The sort is stable.
+ @param cmptr A comparator block that compares two keys. The block may be called concurrently from multiple threads.
+ */
+- (void)sortKeysUsingComparator:(nonnull NSComparator)cmptr;
+
+
+#pragma mark - Binary archives
+
+/*! Loads a dictionary from a file written with writeArchiveToURL:error:. The file is memory-mapped when possible, and only the keys are decoded up front. Each object is decoded the first time it is accessed. The file stays mapped while any entry loaded from it remains in the dictionary or its copies.
+ @param url The file URL of the archive
+ @param error The error if the file could not be read or is not a valid archive
+ @return The dictionary, or nil if loading failed
+ */
++ (nullable instancetype)orderedDictionaryWithContentsOfArchiveURL:(nonnull NSURL *)url error:(NSError *_Nullable *_Nullable)error;
+
+/*! Initializes a dictionary from data returned by archiveData. Only the keys are decoded up front. Each object is decoded the first time it is accessed. Every entry keeps a placeholder that holds data and caches the decoded object, so data stays alive until every entry loaded from it has been removed from the receiver and its copies, even after each object is decoded. Objects that fail to decode are logged and read as NSNull.
+ @param data The archive data
+ @param error The error if data is not a valid archive
+ @return The dictionary, or nil if data is not a valid archive
+ */
+- (nullable instancetype)initWithArchiveData:(nonnull NSData *)data error:(NSError *_Nullable *_Nullable)error;
+
+/*! Returns a binary archive of the receiver that stores each key once, in order, followed by a table of offsets to the individually archived objects. Keys and objects must conform to NSCoding. Objects that were loaded from an archive and never accessed are copied without decoding. The access ordering, limits, and eviction handler are not archived.
+ @return The archive data
+ */
+- (nonnull NSData *)archiveData;
+
+/*! Writes archiveData atomically to the specified file
+ @param url The file URL to write to
+ @param error The error if writing failed
+ @return YES if the archive was written, NO otherwise
+ */
+- (BOOL)writeArchiveToURL:(nonnull NSURL *)url error:(NSError *_Nullable *_Nullable)error;
+
 @end
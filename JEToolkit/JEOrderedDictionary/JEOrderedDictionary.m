@@ -25,119 +25,534 @@
 
 #import "JEOrderedDictionary.h"
 
+#import <objc/runtime.h>
 
-@interface JEOrderedDictionary ()
+#if __has_include("JEDebugging.h")
+#import "JEDebugging.h"
+#else
+#define JELogAlert          NSLog
+#endif
 
-@property (nonatomic, strong, readonly) NSMutableDictionary *dictionary;
-@property (nonatomic, strong, readonly) NSMutableOrderedSet *orderedKeys;
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-@end
 
+/*! Entries are stored once, in insertion order, in a dense array. A separate open-addressing table of int32_t positions indexes the array by key hash (the same layout as CPython's compact dict), so lookups are a single probe sequence, index-based access reads the array directly, and enumeration is a linear scan.
+ Removed entries are left in place as tombstones (a NULL key) and their index slots are marked deleted, so removal never shifts the array. Tombstones are only ever squeezed out by mutations, when they outnumber the live entries or when the array runs out of room, so reads never write. Until then a Fenwick tree of tombstone counts by position turns indexes into positions and back in O(log n).
+ Small dictionaries have no index at all: while the array has room for at most _JEOrderedDictionarySmallEntryCapacity entries, lookups scan it and compare cached hashes before calling isEqual:, and slots are simply entry positions.
+ */
+typedef struct _JEOrderedDictionaryEntry {
+    
+    NSUInteger hash;
+    CFTypeRef key;
+    CFTypeRef object;
+    NSUInteger cost;
+    
+} _JEOrderedDictionaryEntry;
 
-@implementation JEOrderedDictionary
+/*! The entry array and the index are reference counted and shared between copies. Shared storage is never written to: a dictionary duplicates it before its first mutation, and the last dictionary to let go of it releases the entries.
+ Entries are allocated inline with the storage so that a small dictionary needs a single allocation besides the object itself.
+ */
+typedef struct _JEOrderedDictionaryStorage {
+    
+    uintptr_t retainCount;
+    int32_t *index;
+    uint32_t *tombstoneCounts;
+    _JEOrderedDictionaryEntry entries[];
+    
+} _JEOrderedDictionaryStorage;
 
-#pragma mark - NSObject
+static const int32_t _JEOrderedDictionaryEmptySlot = -1;
+static const int32_t _JEOrderedDictionaryDeletedSlot = -2;
+static const NSUInteger _JEOrderedDictionaryMinimumEntryCapacity = 4;
+static const NSUInteger _JEOrderedDictionarySmallEntryCapacity = 8;
+static const NSUInteger _JEOrderedDictionaryPerturbShift = 5;
+static const NSUInteger _JEOrderedDictionaryConcurrentSortThreshold = 16384;
+static const NSUInteger _JEOrderedDictionaryInsertionSortThreshold = 16;
 
-- (instancetype)init {
+/*! Binary archives are laid out as a header, the keys archived once as an ordered array, a table of count + 1 value offsets padded to 8 bytes, then each value archived on its own. All integers are little-endian. Values are left archived until first accessed.
+ */
+typedef struct _JEOrderedDictionaryArchiveHeader {
     
-    self = [super init];
-    if (!self) {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    uint64_t keysLength;
+    
+} _JEOrderedDictionaryArchiveHeader;
+
+static const uint32_t _JEOrderedDictionaryArchiveMagic = 0x444F454A; // "JEOD" when written little-endian
+static const uint32_t _JEOrderedDictionaryArchiveVersion = 1;
+
+static Class _JEOrderedDictionaryArchivedObjectClass;
+
+
+static inline NSUInteger _JEOrderedDictionaryArchiveAlignedLength(NSUInteger length) {
+    
+    return ((length + 7) & ~(NSUInteger)7);
+}
+
+static void _JEOrderedDictionarySetCorruptArchiveError(NSError **error) {
+    
+    if (error) {
         
-        return nil;
+        (*error) = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:nil];
     }
+}
+
+
+static inline BOOL _JEOrderedDictionaryStorageIsShared(_JEOrderedDictionaryStorage *storage) {
+    
+    return (__atomic_load_n(&storage->retainCount, __ATOMIC_ACQUIRE) > 1);
+}
+
+static void _JEOrderedDictionaryStorageRelease(_JEOrderedDictionaryStorage *storage,
+                                               NSUInteger firstEntryIndex,
+                                               NSUInteger usedCount) {
     
-    _dictionary = [[NSMutableDictionary alloc] init];
-    _orderedKeys = [[NSMutableOrderedSet alloc] init];
+    if (__atomic_sub_fetch(&storage->retainCount, 1, __ATOMIC_ACQ_REL) > 0) {
+        
+        return;
+    }
     
-    return self;
+    // Every dictionary sharing storage has the same entry range, so the last one's range covers the storage.
+    _JEOrderedDictionaryEntry *entries = storage->entries;
+    for (NSUInteger i = firstEntryIndex; i < usedCount; ++i) {
+        
+        if (entries[i].key) {
+            
+            CFRelease(entries[i].key);
+            CFRelease(entries[i].object);
+        }
+    }
+    free(storage->index);
+    free(storage->tombstoneCounts);
+    free(storage);
 }
 
-- (instancetype)initWithObjects:(const __unsafe_unretained id [])objects
-                        forKeys:(const __unsafe_unretained id<NSCopying> [])keys
-                          count:(NSUInteger)cnt {
+static inline NSUInteger _JEOrderedDictionaryIndexCapacityForEntryCapacity(NSUInteger entryCapacity) {
     
-    self = [super init];
-    if (!self) {
+    // The index is kept at most 2/3 full so probe sequences stay short.
+    NSUInteger minimumCapacity = (((entryCapacity * 3) + 1) / 2);
+    NSUInteger capacity = 8;
+    while (capacity < minimumCapacity) {
         
-        return nil;
+        capacity <<= 1;
     }
+    return capacity;
+}
+
+static inline int32_t _JEOrderedDictionaryEntryIndexAtSlot(const int32_t *index, NSUInteger slot) {
     
-    _dictionary = [[NSMutableDictionary alloc] initWithObjects:objects forKeys:keys count:cnt];
-    _orderedKeys = [[NSMutableOrderedSet alloc] initWithObjects:keys count:cnt];
+    // Without an index, slots are entry positions and NSNotFound stands for a missing key.
+    if (!index) {
+        
+        return (slot == NSNotFound ? _JEOrderedDictionaryEmptySlot : (int32_t)slot);
+    }
+    return index[slot];
+}
+
+static inline void _JEOrderedDictionarySetEntryIndexAtSlot(int32_t *index, NSUInteger slot, int32_t entryIndex) {
     
-    return self;
+    if (index) {
+        
+        index[slot] = entryIndex;
+    }
 }
 
-- (instancetype)initWithCapacity:(NSUInteger)numItems {
+static inline void _JEOrderedDictionaryAddTombstoneCount(uint32_t *tombstoneCounts,
+                                                        NSUInteger entryCapacity,
+                                                        NSUInteger entryIndex,
+                                                        int32_t delta) {
     
-    self = [super init];
-    if (!self) {
+    // Without a tree, positions are found by scanning the few entries there are.
+    if (!tombstoneCounts) {
         
-        return nil;
+        return;
+    }
+    for (NSUInteger i = (entryIndex + 1); i <= entryCapacity; i += (i & -i)) {
+        
+        tombstoneCounts[i] += (uint32_t)delta;
     }
+}
+
+static inline NSUInteger _JEOrderedDictionaryTombstoneCountBeforeEntryIndex(const uint32_t *tombstoneCounts, NSUInteger entryIndex) {
     
-    _dictionary = [[NSMutableDictionary alloc] initWithCapacity:numItems];
-    _orderedKeys = [[NSMutableOrderedSet alloc] initWithCapacity:numItems];
+    NSUInteger count = 0;
+    for (NSUInteger i = entryIndex; i > 0; i -= (i & -i)) {
+        
+        count += tombstoneCounts[i];
+    }
+    return count;
+}
+
+static inline NSUInteger _JEOrderedDictionaryEntryIndexForLiveIndex(const uint32_t *tombstoneCounts,
+                                                                    NSUInteger entryCapacity,
+                                                                    NSUInteger idx) {
     
-    return self;
+    // Descends the tree, skipping every node whose live entries all come before the one at idx.
+    NSUInteger step = 1;
+    while ((step << 1) <= entryCapacity) {
+        
+        step <<= 1;
+    }
+    NSUInteger entryIndex = 0;
+    NSUInteger remainingCount = (idx + 1);
+    for (; step > 0; step >>= 1) {
+        
+        NSUInteger node = (entryIndex + step);
+        if (node <= entryCapacity && (step - tombstoneCounts[node]) < remainingCount) {
+            
+            entryIndex = node;
+            remainingCount -= (step - tombstoneCounts[node]);
+        }
+    }
+    return entryIndex;
 }
 
+static inline BOOL _JEOrderedDictionaryKeysAreEqual(CFTypeRef storedKey, NSUInteger storedHash, id key, NSUInteger hash) {
+    
+    return (storedHash == hash
+            && (storedKey == (__bridge CFTypeRef)key || [(__bridge id)storedKey isEqual:key]));
+}
 
-#pragma mark - NSDictionary
 
-- (NSUInteger)count {
+static void _JEOrderedDictionaryMergeEntries(const _JEOrderedDictionaryEntry *left,
+                                            NSUInteger leftCount,
+                                            const _JEOrderedDictionaryEntry *right,
+                                            NSUInteger rightCount,
+                                            _JEOrderedDictionaryEntry *destination,
+                                            NSComparator comparator) {
     
-    return [self.dictionary count];
+    // Ties take the left entry so the merge stays stable.
+    while (leftCount > 0 && rightCount > 0) {
+        
+        if (comparator((__bridge id)right->key, (__bridge id)left->key) == NSOrderedAscending) {
+            
+            *(destination++) = *(right++);
+            --rightCount;
+        }
+        else {
+            
+            *(destination++) = *(left++);
+            --leftCount;
+        }
+    }
+    memcpy(destination, left, (leftCount * sizeof(_JEOrderedDictionaryEntry)));
+    memcpy((destination + leftCount), right, (rightCount * sizeof(_JEOrderedDictionaryEntry)));
 }
 
-- (id)objectForKey:(id)aKey {
+static void _JEOrderedDictionaryReverseEntries(_JEOrderedDictionaryEntry *entries, NSUInteger count) {
     
-    return [self.dictionary objectForKey:aKey];
+    for (NSUInteger i = 0; i < (count / 2); ++i) {
+        
+        _JEOrderedDictionaryEntry entry = entries[i];
+        entries[i] = entries[count - 1 - i];
+        entries[count - 1 - i] = entry;
+    }
 }
 
-- (NSEnumerator *)keyEnumerator {
+static void _JEOrderedDictionaryMergeEntriesInPlace(_JEOrderedDictionaryEntry *entries,
+                                                   NSUInteger leftCount,
+                                                   NSUInteger count,
+                                                   NSComparator comparator) {
+    
+    NSUInteger rightCount = (count - leftCount);
+    if (leftCount == 0 || rightCount == 0) {
+        
+        return;
+    }
+    if (count == 2) {
+        
+        if (comparator((__bridge id)entries[1].key, (__bridge id)entries[0].key) == NSOrderedAscending) {
+            
+            _JEOrderedDictionaryReverseEntries(entries, 2);
+        }
+        return;
+    }
+    
+    // The longer run is split in half and the other run is cut where that middle entry would go: right entries only move ahead of strictly greater left entries, so equal keys keep their order.
+    NSUInteger leftCut;
+    NSUInteger rightCut;
+    if (leftCount >= rightCount) {
+        
+        leftCut = (leftCount / 2);
+        NSUInteger low = 0;
+        NSUInteger high = rightCount;
+        while (low < high) {
+            
+            NSUInteger middle = ((low + high) / 2);
+            if (comparator((__bridge id)entries[leftCount + middle].key, (__bridge id)entries[leftCut].key) == NSOrderedAscending) {
+                
+                low = (middle + 1);
+            }
+            else {
+                
+                high = middle;
+            }
+        }
+        rightCut = low;
+    }
+    else {
+        
+        rightCut = (rightCount / 2);
+        NSUInteger low = 0;
+        NSUInteger high = leftCount;
+        while (low < high) {
+            
+            NSUInteger middle = ((low + high) / 2);
+            if (comparator((__bridge id)entries[leftCount + rightCut].key, (__bridge id)entries[middle].key) == NSOrderedAscending) {
+                
+                high = middle;
+            }
+            else {
+                
+                low = (middle + 1);
+            }
+        }
+        leftCut = low;
+    }
     
-    return [self.orderedKeys objectEnumerator];
+    // Rotating the two inner pieces by three reversals leaves two smaller merges on either side of the cut.
+    _JEOrderedDictionaryEntry *rotated = (entries + leftCut);
+    NSUInteger rotatedLeftCount = (leftCount - leftCut);
+    _JEOrderedDictionaryReverseEntries(rotated, rotatedLeftCount);
+    _JEOrderedDictionaryReverseEntries((rotated + rotatedLeftCount), rightCut);
+    _JEOrderedDictionaryReverseEntries(rotated, (rotatedLeftCount + rightCut));
+    
+    NSUInteger middle = (leftCut + rightCut);
+    _JEOrderedDictionaryMergeEntriesInPlace(entries, leftCut, middle, comparator);
+    _JEOrderedDictionaryMergeEntriesInPlace((entries + middle), rotatedLeftCount, (count - middle), comparator);
 }
 
+static void _JEOrderedDictionarySortEntriesInPlace(_JEOrderedDictionaryEntry *entries,
+                                                  NSUInteger count,
+                                                  NSComparator comparator) {
+    
+    // Entries only ever move by swaps, so they stay a permutation even if the comparator throws midway.
+    if (count <= _JEOrderedDictionaryInsertionSortThreshold) {
+        
+        for (NSUInteger i = 1; i < count; ++i) {
+            
+            for (NSUInteger j = i; j > 0 && comparator((__bridge id)entries[j].key, (__bridge id)entries[j - 1].key) == NSOrderedAscending; --j) {
+                
+                _JEOrderedDictionaryReverseEntries((entries + j - 1), 2);
+            }
+        }
+        return;
+    }
+    
+    NSUInteger leftCount = (count / 2);
+    _JEOrderedDictionarySortEntriesInPlace(entries, leftCount, comparator);
+    _JEOrderedDictionarySortEntriesInPlace((entries + leftCount), (count - leftCount), comparator);
+    _JEOrderedDictionaryMergeEntriesInPlace(entries, leftCount, count, comparator);
+}
 
-#pragma mark - NSMutableDictionary
+static void _JEOrderedDictionarySortEntries(_JEOrderedDictionaryEntry *entries,
+                                           NSUInteger count,
+                                           NSComparator comparator) {
+    
+    int (^compareEntries)(const void *, const void *) = ^int(const void *left, const void *right) {
+        
+        return (int)comparator((__bridge id)((const _JEOrderedDictionaryEntry *)left)->key,
+                               (__bridge id)((const _JEOrderedDictionaryEntry *)right)->key);
+    };
+    
+    // mergesort_b only fails when it can't allocate its buffer. The fallback merges without one, in O(n log^2 n), so the sort stays stable either way.
+    if (mergesort_b(entries, count, sizeof(_JEOrderedDictionaryEntry), compareEntries) != 0) {
+        
+        _JEOrderedDictionarySortEntriesInPlace(entries, count, comparator);
+    }
+}
 
-- (void)setObject:(id)anObject forKey:(id<NSCopying>)aKey {
+static void _JEOrderedDictionaryRecordException(CFTypeRef *firstException, NSException *exception) {
     
-    [self.dictionary setObject:anObject forKey:aKey];
-    [self.orderedKeys addObject:aKey];
+    CFTypeRef retainedException = CFBridgingRetain(exception);
+    CFTypeRef expectedException = NULL;
+    if (!__atomic_compare_exchange_n(firstException, &expectedException, retainedException, NO, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        
+        CFRelease(retainedException);
+    }
 }
 
-- (void)removeObjectForKey:(id)aKey {
+static _JEOrderedDictionaryEntry *_JEOrderedDictionarySortEntriesConcurrently(_JEOrderedDictionaryEntry *scratch,
+                                                                             NSUInteger count,
+                                                                             NSUInteger processorCount,
+                                                                             NSComparator comparator) {
+    
+    // scratch holds the entries followed by room for as many again. Each core sorts a contiguous run, then runs are merged pairwise between the two halves, each level's merges also running in parallel. Exceptions can't cross dispatch_apply, so the first one from the comparator is kept and raised once the level is done.
+    __block CFTypeRef firstException = NULL;
+    NSUInteger runCount = MIN(processorCount, (count / (_JEOrderedDictionaryConcurrentSortThreshold / 4)));
+    NSUInteger runLength = (((count - 1) / runCount) + 1);
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_apply(runCount, queue, ^(size_t run) {
+        
+        NSUInteger start = MIN((run * runLength), count);
+        @try {
+            
+            _JEOrderedDictionarySortEntries((scratch + start), (MIN((start + runLength), count) - start), comparator);
+        }
+        @catch (NSException *exception) {
+            
+            _JEOrderedDictionaryRecordException(&firstException, exception);
+        }
+        
+    });
+    
+    _JEOrderedDictionaryEntry *source = scratch;
+    _JEOrderedDictionaryEntry *destination = (scratch + count);
+    for (NSUInteger width = runLength; width < count && !firstException; width *= 2) {
+        
+        const _JEOrderedDictionaryEntry *levelSource = source;
+        _JEOrderedDictionaryEntry *levelDestination = destination;
+        dispatch_apply((((count - 1) / (width * 2)) + 1), queue, ^(size_t pair) {
+            
+            NSUInteger start = (pair * width * 2);
+            NSUInteger middle = MIN((start + width), count);
+            NSUInteger end = MIN((middle + width), count);
+            @try {
+                
+                _JEOrderedDictionaryMergeEntries((levelSource + start),
+                                                 (middle - start),
+                                                 (levelSource + middle),
+                                                 (end - middle),
+                                                 (levelDestination + start),
+                                                 comparator);
+            }
+            @catch (NSException *exception) {
+                
+                _JEOrderedDictionaryRecordException(&firstException, exception);
+            }
+            
+        });
+        source = levelDestination;
+        destination = (_JEOrderedDictionaryEntry *)levelSource;
+    }
     
-    [self.dictionary removeObjectForKey:aKey];
-    [self.orderedKeys removeObject:aKey];
+    if (firstException) {
+        
+        @throw (NSException *)CFBridgingRelease(firstException);
+    }
+    return source;
 }
 
 
-#pragma mark - NSCopying
+#pragma mark - _JEOrderedDictionaryArchivedObject
 
-- (instancetype)copyWithZone:(NSZone *)zone {
+/*! Stands in for a value in a binary archive until the value is first accessed.
+ */
+@interface _JEOrderedDictionaryArchivedObject : NSObject
+
+@property (nonatomic, strong, readonly) NSData *archiveData;
+@property (nonatomic, assign, readonly) NSRange range;
+
+- (instancetype)initWithArchiveData:(NSData *)archiveData range:(NSRange)range;
+- (id)decodedObject;
+
+@end
+
+
+@implementation _JEOrderedDictionaryArchivedObject {
     
-    return [self mutableCopyWithZone:zone];
+    CFTypeRef _decodedObject;
 }
 
+- (instancetype)initWithArchiveData:(NSData *)archiveData range:(NSRange)range {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _archiveData = archiveData;
+    _range = range;
+    
+    return self;
+}
 
-#pragma mark - NSMutableCopying
+- (void)dealloc {
+    
+    if (_decodedObject) {
+        
+        CFRelease(_decodedObject);
+    }
+}
 
-- (instancetype)mutableCopyWithZone:(NSZone *)zone {
+- (id)decodedObject {
     
-    typeof(self) instance = [[[self class] allocWithZone:zone] init];
-    instance->_orderedKeys = [_orderedKeys mutableCopyWithZone:zone];
-    instance->_dictionary = [_dictionary mutableCopyWithZone:zone];
-    return instance;
+    // The first decode is kept for every later read, including reads racing on other threads.
+    CFTypeRef decodedObject = __atomic_load_n(&_decodedObject, __ATOMIC_ACQUIRE);
+    if (decodedObject) {
+        
+        return (__bridge id)decodedObject;
+    }
+    
+    id object;
+    NSException *decodingException = nil;
+    @try {
+        
+        object = [NSKeyedUnarchiver unarchiveObjectWithData:[self.archiveData subdataWithRange:self.range]];
+    }
+    @catch (NSException *exception) {
+        
+        object = nil;
+        decodingException = exception;
+    }
+    
+    // Entries can't hold nil, so an object that fails to decode reads as NSNull from then on.
+    decodedObject = CFBridgingRetain(object ?: [NSNull null]);
+    CFTypeRef expectedObject = NULL;
+    if (!__atomic_compare_exchange_n(&_decodedObject, &expectedObject, decodedObject, NO, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        
+        CFRelease(decodedObject);
+        return (__bridge id)expectedObject;
+    }
+    if (!object) {
+        
+        JELogAlert(@"Failed to decode archived object at range %@, replaced with NSNull. Exception: \n%@",
+                   NSStringFromRange(self.range),
+                   (decodingException ?: @"(none)"));
+    }
+    return (__bridge id)decodedObject;
 }
 
+@end
 
-#pragma mark - NSCoding
 
-- (instancetype)initWithCoder:(NSCoder *)aDecoder {
+static inline id _JEOrderedDictionaryEntryObject(_JEOrderedDictionaryEntry *entry) {
+    
+    CFTypeRef object = entry->object;
+    if (object_getClass((__bridge id)object) != _JEOrderedDictionaryArchivedObjectClass) {
+        
+        return (__bridge id)object;
+    }
+    
+    // Values from a binary archive are decoded on first access. The placeholder is kept in the entry so that reads never write to storage that copies or other threads may be sharing.
+    return [(__bridge _JEOrderedDictionaryArchivedObject *)object decodedObject];
+}
+
+
+#pragma mark - _JEOrderedDictionaryEnumerator
+
+@interface _JEOrderedDictionaryEnumerator : NSEnumerator
+
+- (instancetype)initWithOrderedDictionary:(JEOrderedDictionary *)orderedDictionary
+                        enumeratesObjects:(BOOL)enumeratesObjects;
+
+@end
+
+
+@implementation _JEOrderedDictionaryEnumerator {
+    
+    JEOrderedDictionary *_orderedDictionary;
+    BOOL _enumeratesObjects;
+    NSUInteger _nextIndex;
+}
+
+- (instancetype)initWithOrderedDictionary:(JEOrderedDictionary *)orderedDictionary
+                        enumeratesObjects:(BOOL)enumeratesObjects {
     
     self = [super init];
     if (!self) {
@@ -145,94 +560,1385 @@
         return nil;
     }
     
-    _dictionary = [[NSMutableDictionary alloc] initWithDictionary:
-                   [aDecoder decodeObjectForKey:@"dictionary"]];
-    _orderedKeys = [[NSMutableOrderedSet alloc] initWithOrderedSet:
-                    [aDecoder decodeObjectForKey:@"orderedKeys"]];
+    _orderedDictionary = orderedDictionary;
+    _enumeratesObjects = enumeratesObjects;
     
     return self;
 }
 
-- (void)encodeWithCoder:(NSCoder *)aCoder {
+- (id)nextObject {
     
-    [aCoder encodeObject:self.dictionary forKey:@"dictionary"];
-    [aCoder encodeObject:self.orderedKeys forKey:@"orderedKeys"];
+    JEOrderedDictionary *orderedDictionary = _orderedDictionary;
+    if (_nextIndex >= [orderedDictionary count]) {
+        
+        _orderedDictionary = nil;
+        return nil;
+    }
+    return (_enumeratesObjects
+            ? [orderedDictionary objectAtIndex:_nextIndex++]
+            : [orderedDictionary keyAtIndex:_nextIndex++]);
 }
 
+@end
 
-#pragma mark - Public
 
-- (id)firstObject {
+#pragma mark - JEOrderedDictionary
+
+@implementation JEOrderedDictionary {
     
-    return [self.dictionary objectForKey:[self.orderedKeys firstObject]];
+    _JEOrderedDictionaryStorage *_storage;
+    _JEOrderedDictionaryEntry *_entries;
+    NSUInteger _count;
+    NSUInteger _usedCount;
+    NSUInteger _leadingTombstoneCount;
+    NSUInteger _entryCapacity;
+    
+    int32_t *_index;
+    NSUInteger _indexMask;
+    NSUInteger _indexFill;
+    uint32_t *_tombstoneCounts;
+    
+    unsigned long _mutations;
+    BOOL _countsLookups;
 }
 
-- (id)lastObject {
+#pragma mark - NSObject
+
++ (void)initialize {
     
-    return [self.dictionary objectForKey:[self.orderedKeys lastObject]];
+    if (self == [JEOrderedDictionary class]) {
+        
+        _JEOrderedDictionaryArchivedObjectClass = [_JEOrderedDictionaryArchivedObject class];
+    }
 }
 
-- (id)objectAtIndexedSubscript:(NSUInteger)idx {
+- (instancetype)init {
     
-    return [self objectAtIndex:idx];
+    return [self initWithCapacity:0];
 }
 
-- (id)objectAtIndex:(NSUInteger)idx {
+- (instancetype)initWithObjects:(const __unsafe_unretained id [])objects
+                        forKeys:(const __unsafe_unretained id<NSCopying> [])keys
+                          count:(NSUInteger)cnt {
+    
+    self = [self initWithCapacity:cnt];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    for (NSUInteger i = 0; i < cnt; ++i) {
+        
+        [self setObject:objects[i] forKey:keys[i]];
+    }
     
-    return [self.dictionary objectForKey:[self.orderedKeys objectAtIndex:idx]];
+    return self;
 }
 
-- (id)firstKey {
+- (instancetype)initWithCapacity:(NSUInteger)numItems {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    [self resizeToEntryCapacity:MAX(numItems, _JEOrderedDictionaryMinimumEntryCapacity)];
     
-    return [self.orderedKeys firstObject];
+    return self;
 }
 
-- (id)lastKey {
+- (void)dealloc {
     
-    return [self.orderedKeys lastObject];
+    if (_storage) {
+        
+        _JEOrderedDictionaryStorageRelease(_storage, _leadingTombstoneCount, _usedCount);
+    }
 }
 
-- (id)keyAtIndex:(NSUInteger)idx {
+
+#pragma mark - NSDictionary
+
+- (NSUInteger)count {
     
-    return [self.orderedKeys objectAtIndex:idx];
+    return _count;
 }
 
-- (NSUInteger)indexOfKey:(id)key {
+- (id)objectForKey:(id)aKey {
+    
+    if (!aKey) {
+        
+        return nil;
+    }
+    
+    NSUInteger slot = [self slotForKey:aKey hash:[aKey hash]];
+    int32_t entryIndex = _JEOrderedDictionaryEntryIndexAtSlot(_index, slot);
+    if (entryIndex == _JEOrderedDictionaryEmptySlot) {
+        
+        if (_countsLookups) {
+            
+            ++_missCount;
+        }
+        return nil;
+    }
+    
+    // Plain dictionaries don't count lookups, so concurrent readers of a dictionary that is not being mutated never write to it.
+    if (_countsLookups) {
+        
+        ++_hitCount;
+    }
+    id object = _JEOrderedDictionaryEntryObject(&_entries[entryIndex]);
+    if (_ordersByAccess) {
+        
+        [self moveEntryToBackAtSlot:[self prepareStorageForMutationAtSlot:slot]];
+    }
+    return object;
+}
+
+- (NSArray *)allKeys {
     
-    return [self.orderedKeys indexOfObject:key];
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:_count];
+    for (NSUInteger i = _leadingTombstoneCount; i < _usedCount; ++i) {
+        
+        if (_entries[i].key) {
+            
+            [keys addObject:(__bridge id)_entries[i].key];
+        }
+    }
+    return keys;
 }
 
-- (void)enumerateIndexesAndKeysAndObjectsUsingBlock:(void (^)(NSUInteger idx, id key, id obj, BOOL *stop))block {
+- (NSArray *)allValues {
     
-    [self
-     enumerateIndexesAndKeysAndObjectsWithOptions:kNilOptions
-     usingBlock:block];
+    NSMutableArray *objects = [[NSMutableArray alloc] initWithCapacity:_count];
+    for (NSUInteger i = _leadingTombstoneCount; i < _usedCount; ++i) {
+        
+        if (_entries[i].key) {
+            
+            [objects addObject:_JEOrderedDictionaryEntryObject(&_entries[i])];
+        }
+    }
+    return objects;
 }
 
-- (void)enumerateIndexesAndKeysAndObjectsWithOptions:(NSEnumerationOptions)opts
-                                          usingBlock:(void (^)(NSUInteger idx, id key, id obj, BOOL *stop))block {
+- (NSEnumerator *)keyEnumerator {
+    
+    return [[_JEOrderedDictionaryEnumerator alloc]
+            initWithOrderedDictionary:self
+            enumeratesObjects:NO];
+}
+
+- (NSEnumerator *)objectEnumerator {
+    
+    return [[_JEOrderedDictionaryEnumerator alloc]
+            initWithOrderedDictionary:self
+            enumeratesObjects:YES];
+}
+
+- (void)enumerateKeysAndObjectsUsingBlock:(void (^)(id key, id obj, BOOL *stop))block {
     
     [self
-     enumerateIndexesAndKeysAndObjectsAtIndexes:[[NSIndexSet alloc] initWithIndexesInRange:
-                                                 (NSRange){ .location = 0, .length = [self count]}]
-     options:opts
+     enumerateKeysAndObjectsWithOptions:kNilOptions
      usingBlock:block];
 }
 
-- (void)enumerateIndexesAndKeysAndObjectsAtIndexes:(NSIndexSet *)indexes
-                                           options:(NSEnumerationOptions)opts
-                                        usingBlock:(void (^)(NSUInteger idx, id key, id obj, BOOL *stop))block {
+- (void)enumerateKeysAndObjectsWithOptions:(NSEnumerationOptions)opts
+                                usingBlock:(void (^)(id key, id obj, BOOL *stop))block {
     
-    NSDictionary *dictionary = self.dictionary;
-    [self.orderedKeys
-     enumerateObjectsAtIndexes:indexes
-     options:opts
-     usingBlock:^(id key, NSUInteger idx, BOOL *stop) {
+    [self
+     enumerateIndexesAndKeysAndObjectsWithOptions:opts
+     usingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
          
-         block(idx, key, [dictionary objectForKey:key], stop);
+         block(key, obj, stop);
          
      }];
 }
 
 
+#pragma mark - NSFastEnumeration
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(id __unsafe_unretained [])buffer
+                                    count:(NSUInteger)len {
+    
+    // state->state holds the next entry position plus one, so that zero still means the enumeration hasn't started.
+    if (state->state == 0) {
+        
+        state->mutationsPtr = &_mutations;
+        state->state = (_leadingTombstoneCount + 1);
+    }
+    
+    _JEOrderedDictionaryEntry *entries = _entries;
+    NSUInteger usedCount = _usedCount;
+    NSUInteger entryIndex = (state->state - 1);
+    NSUInteger count = 0;
+    while (count < len && entryIndex < usedCount) {
+        
+        CFTypeRef key = entries[entryIndex++].key;
+        if (key) {
+            
+            buffer[count++] = (__bridge id)key;
+        }
+    }
+    state->state = (entryIndex + 1);
+    state->itemsPtr = buffer;
+    return count;
+}
+
+
+#pragma mark - NSMutableDictionary
+
+- (void)setObject:(id)anObject forKey:(id<NSCopying>)aKey {
+    
+    [self setObject:anObject forKey:aKey cost:0];
+}
+
+- (void)addEntriesFromDictionary:(NSDictionary *)otherDictionary {
+    
+    [self reserveCapacityForAppendingCount:[otherDictionary count]];
+    [super addEntriesFromDictionary:otherDictionary];
+}
+
+- (void)removeObjectsForKeys:(NSArray *)keyArray {
+    
+    if ([keyArray count] == 0) {
+        
+        return;
+    }
+    [self prepareStorageForMutation];
+    
+    // Matching entries become tombstones and are squeezed out together in one pass.
+    NSUInteger removedCount = 0;
+    for (id key in keyArray) {
+        
+        NSUInteger slot = [self slotForKey:key hash:[key hash]];
+        int32_t entryIndex = _JEOrderedDictionaryEntryIndexAtSlot(_index, slot);
+        if (entryIndex == _JEOrderedDictionaryEmptySlot) {
+            
+            continue;
+        }
+        
+        _JEOrderedDictionaryEntry entry = _entries[entryIndex];
+        _entries[entryIndex].key = NULL;
+        _entries[entryIndex].object = NULL;
+        _JEOrderedDictionarySetEntryIndexAtSlot(_index, slot, _JEOrderedDictionaryDeletedSlot);
+        _totalCost -= entry.cost;
+        --_count;
+        ++removedCount;
+        
+        CFRelease(entry.key);
+        CFRelease(entry.object);
+    }
+    if (removedCount > 0) {
+        
+        ++_mutations;
+        [self compactEntries];
+    }
+}
+
+- (void)removeObjectForKey:(id)aKey {
+    
+    if (!aKey) {
+        
+        [NSException
+         raise:NSInvalidArgumentException
+         format:@"*** %@: key cannot be nil", NSStringFromSelector(_cmd)];
+    }
+    
+    NSUInteger slot = [self slotForKey:aKey hash:[aKey hash]];
+    if (_JEOrderedDictionaryEntryIndexAtSlot(_index, slot) != _JEOrderedDictionaryEmptySlot) {
+        
+        [self removeEntryAtSlot:[self prepareStorageForMutationAtSlot:slot]];
+    }
+}
+
+- (void)removeAllObjects {
+    
+    _JEOrderedDictionaryStorage *storage = _storage;
+    NSUInteger firstEntryIndex = _leadingTombstoneCount;
+    NSUInteger usedCount = _usedCount;
+    ++_mutations;
+    _count = 0;
+    _usedCount = 0;
+    _leadingTombstoneCount = 0;
+    _totalCost = 0;
+    [self detachStorageWithEntryCapacity:_JEOrderedDictionaryMinimumEntryCapacity];
+    
+    _JEOrderedDictionaryStorageRelease(storage, firstEntryIndex, usedCount);
+}
+
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(NSZone *)zone {
+    
+    return [self mutableCopyWithZone:zone];
+}
+
+
+#pragma mark - NSMutableCopying
+
+- (instancetype)mutableCopyWithZone:(NSZone *)zone {
+    
+    // Tombstones are shared along with the entries. Whichever dictionary mutates first drops them while duplicating the storage.
+    typeof(self) instance = [[[self class] allocWithZone:zone] initSharingStorageOfOrderedDictionary:self];
+    instance->_ordersByAccess = _ordersByAccess;
+    instance->_maximumCount = _maximumCount;
+    instance->_totalCostLimit = _totalCostLimit;
+    instance->_totalCost = _totalCost;
+    instance->_evictionHandler = _evictionHandler;
+    instance->_countsLookups = _countsLookups;
+    return instance;
+}
+
+
+#pragma mark - NSCoding
+
+- (instancetype)initWithCoder:(NSCoder *)aDecoder {
+    
+    NSDictionary *dictionary = [aDecoder decodeObjectForKey:@"dictionary"];
+    NSOrderedSet *orderedKeys = [aDecoder decodeObjectForKey:@"orderedKeys"];
+    
+    self = [self initWithCapacity:[orderedKeys count]];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    for (id key in orderedKeys) {
+        
+        id object = [dictionary objectForKey:key];
+        if (object) {
+            
+            [self setObject:object forKey:key];
+        }
+    }
+    
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+    
+    // Archived in the same layout as before entries were stored in a single array, so existing archives stay readable.
+    NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] initWithCapacity:_count];
+    NSMutableOrderedSet *orderedKeys = [[NSMutableOrderedSet alloc] initWithCapacity:_count];
+    for (NSUInteger i = _leadingTombstoneCount; i < _usedCount; ++i) {
+        
+        id key = (__bridge id)_entries[i].key;
+        if (key) {
+            
+            [dictionary setObject:_JEOrderedDictionaryEntryObject(&_entries[i]) forKey:key];
+            [orderedKeys addObject:key];
+        }
+    }
+    [aCoder encodeObject:dictionary forKey:@"dictionary"];
+    [aCoder encodeObject:orderedKeys forKey:@"orderedKeys"];
+}
+
+
+#pragma mark - Public
+
+- (id)firstObject {
+    
+    return (_count > 0 ? _JEOrderedDictionaryEntryObject(&_entries[_leadingTombstoneCount]) : nil);
+}
+
+- (id)lastObject {
+    
+    return (_count > 0 ? _JEOrderedDictionaryEntryObject(&_entries[_usedCount - 1]) : nil);
+}
+
+- (id)objectAtIndexedSubscript:(NSUInteger)idx {
+    
+    return [self objectAtIndex:idx];
+}
+
+- (id)objectAtIndex:(NSUInteger)idx {
+    
+    return _JEOrderedDictionaryEntryObject(&_entries[[self entryIndexForIndex:idx selector:_cmd]]);
+}
+
+- (id)firstKey {
+    
+    return (_count > 0 ? (__bridge id)_entries[_leadingTombstoneCount].key : nil);
+}
+
+- (id)lastKey {
+    
+    return (_count > 0 ? (__bridge id)_entries[_usedCount - 1].key : nil);
+}
+
+- (id)keyAtIndex:(NSUInteger)idx {
+    
+    return (__bridge id)_entries[[self entryIndexForIndex:idx selector:_cmd]].key;
+}
+
+- (NSUInteger)indexOfKey:(id)key {
+    
+    if (!key) {
+        
+        return NSNotFound;
+    }
+    
+    int32_t entryIndex = _JEOrderedDictionaryEntryIndexAtSlot(_index, [self slotForKey:key hash:[key hash]]);
+    if (entryIndex == _JEOrderedDictionaryEmptySlot) {
+        
+        return NSNotFound;
+    }
+    return [self indexForEntryIndex:(NSUInteger)entryIndex];
+}
+
+- (void)setObject:(id)anObject forKey:(id<NSCopying>)aKey cost:(NSUInteger)cost {
+    
+    if (!anObject) {
+        
+        [NSException
+         raise:NSInvalidArgumentException
+         format:@"*** %@: object cannot be nil (key: %@)", NSStringFromSelector(_cmd), aKey];
+    }
+    if (!aKey) {
+        
+        [NSException
+         raise:NSInvalidArgumentException
+         format:@"*** %@: key cannot be nil", NSStringFromSelector(_cmd)];
+    }
+    
+    [self prepareStorageForMutation];
+    NSUInteger hash = [(id)aKey hash];
+    NSUInteger slot = [self slotForKey:aKey hash:hash];
+    int32_t entryIndex = _JEOrderedDictionaryEntryIndexAtSlot(_index, slot);
+    if (entryIndex != _JEOrderedDictionaryEmptySlot) {
+        
+        // Replacing an object keeps the key's original position unless the dictionary orders by access.
+        CFTypeRef previousObject = _entries[entryIndex].object;
+        _entries[entryIndex].object = CFBridgingRetain(anObject);
+        _totalCost = ((_totalCost - _entries[entryIndex].cost) + cost);
+        _entries[entryIndex].cost = cost;
+        ++_mutations;
+        CFRelease(previousObject);
+        
+        if (_ordersByAccess) {
+            
+            [self moveEntryToBackAtSlot:slot];
+        }
+        [self evictEntriesIfNeeded];
+        return;
+    }
+    
+    if ([self reserveEntryForAppending]) {
+        
+        slot = [self emptySlotForHash:hash];
+    }
+    
+    // Keys are copied, same as NSMutableDictionary.
+    _entries[_usedCount] = (_JEOrderedDictionaryEntry){
+        .hash = hash,
+        .key = CFBridgingRetain([(id<NSCopying>)aKey copyWithZone:NULL]),
+        .object = CFBridgingRetain(anObject),
+        .cost = cost
+    };
+    _JEOrderedDictionarySetEntryIndexAtSlot(_index, slot, (int32_t)_usedCount);
+    ++_mutations;
+    ++_usedCount;
+    ++_indexFill;
+    ++_count;
+    _totalCost += cost;
+    
+    [self evictEntriesIfNeeded];
+}
+
+- (BOOL)touchKey:(id)key {
+    
+    if (!key) {
+        
+        return NO;
+    }
+    
+    NSUInteger slot = [self slotForKey:key hash:[key hash]];
+    if (_JEOrderedDictionaryEntryIndexAtSlot(_index, slot) == _JEOrderedDictionaryEmptySlot) {
+        
+        return NO;
+    }
+    [self moveEntryToBackAtSlot:[self prepareStorageForMutationAtSlot:slot]];
+    return YES;
+}
+
+- (void)setOrdersByAccess:(BOOL)ordersByAccess {
+    
+    _ordersByAccess = ordersByAccess;
+    [self updateCountsLookups];
+}
+
+- (void)setMaximumCount:(NSUInteger)maximumCount {
+    
+    _maximumCount = maximumCount;
+    [self updateCountsLookups];
+    [self evictEntriesIfNeeded];
+}
+
+- (void)setTotalCostLimit:(NSUInteger)totalCostLimit {
+    
+    _totalCostLimit = totalCostLimit;
+    [self updateCountsLookups];
+    [self evictEntriesIfNeeded];
+}
+
+- (void)resetStatistics {
+    
+    _hitCount = 0;
+    _missCount = 0;
+    _evictionCount = 0;
+}
+
+- (void)enumerateIndexesAndKeysAndObjectsUsingBlock:(void (^)(NSUInteger idx, id key, id obj, BOOL *stop))block {
+    
+    [self
+     enumerateIndexesAndKeysAndObjectsWithOptions:kNilOptions
+     usingBlock:block];
+}
+
+- (void)enumerateIndexesAndKeysAndObjectsWithOptions:(NSEnumerationOptions)opts
+                                          usingBlock:(void (^)(NSUInteger idx, id key, id obj, BOOL *stop))block {
+    
+    [self
+     enumerateEntriesInRange:(NSRange){ .location = 0, .length = _count }
+     options:opts
+     stop:NULL
+     usingBlock:block];
+}
+
+- (void)enumerateIndexesAndKeysAndObjectsAtIndexes:(NSIndexSet *)indexes
+                                           options:(NSEnumerationOptions)opts
+                                        usingBlock:(void (^)(NSUInteger idx, id key, id obj, BOOL *stop))block {
+    
+    if ([indexes count] == 0) {
+        
+        return;
+    }
+    [self entryIndexForIndex:[indexes lastIndex] selector:_cmd];
+    
+    // Ranges are visited one after the other and NSEnumerationConcurrent is applied within each range.
+    __block BOOL isStopped = NO;
+    [indexes
+     enumerateRangesWithOptions:(opts & NSEnumerationReverse)
+     usingBlock:^(NSRange range, BOOL *stop) {
+         
+         [self
+          enumerateEntriesInRange:range
+          options:opts
+          stop:&isStopped
+          usingBlock:block];
+         *stop = isStopped;
+         
+     }];
+}
+
+- (void)addEntriesFromOrderedPairs:(const __unsafe_unretained id [])pairs count:(NSUInteger)count {
+    
+    [self reserveCapacityForAppendingCount:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        
+        [self setObject:pairs[(i * 2) + 1] forKey:pairs[i * 2] cost:0];
+    }
+}
+
+- (void)removeKeysInRange:(NSRange)range {
+    
+    if (range.length == 0) {
+        
+        return;
+    }
+    [self entryIndexForIndex:(NSMaxRange(range) - 1) selector:_cmd];
+    [self prepareStorageForMutation];
+    if ([self hasInteriorTombstones]) {
+        
+        [self compactEntries];
+    }
+    NSUInteger firstEntryIndex = (_leadingTombstoneCount + range.location);
+    
+    // Positions are exact once the tombstones in the middle are gone, so the range is released, the tail shifted down once, and the index rebuilt once.
+    _JEOrderedDictionaryEntry *entries = _entries;
+    for (NSUInteger i = firstEntryIndex; i < (firstEntryIndex + range.length); ++i) {
+        
+        _totalCost -= entries[i].cost;
+        CFRelease(entries[i].key);
+        CFRelease(entries[i].object);
+    }
+    memmove((entries + firstEntryIndex),
+            (entries + firstEntryIndex + range.length),
+            ((_usedCount - firstEntryIndex - range.length) * sizeof(_JEOrderedDictionaryEntry)));
+    _usedCount -= range.length;
+    _count -= range.length;
+    if (_count == 0) {
+        
+        _usedCount = 0;
+        _leadingTombstoneCount = 0;
+    }
+    ++_mutations;
+    [self rebuildIndex];
+}
+
+- (void)sortKeysUsingComparator:(NSComparator)cmptr {
+    
+    [self prepareStorageForMutation];
+    if (_usedCount > _count) {
+        
+        [self compactEntries];
+    }
+    
+    // Entries are sorted in a scratch copy and only copied back once sorted, so a comparator that throws leaves the dictionary as it was. The index is rebuilt on every way out.
+    NSUInteger count = _count;
+    _JEOrderedDictionaryEntry *entries = _entries;
+    @try {
+        
+        NSUInteger processorCount = [[NSProcessInfo processInfo] activeProcessorCount];
+        BOOL isConcurrent = (count >= _JEOrderedDictionaryConcurrentSortThreshold && processorCount >= 2);
+        _JEOrderedDictionaryEntry *scratch = (_JEOrderedDictionaryEntry *)malloc((isConcurrent ? 2 : 1) * count * sizeof(_JEOrderedDictionaryEntry));
+        if (!scratch) {
+            
+            // Without room for a copy, the entries are sorted in place by swaps, which needs no memory at all.
+            _JEOrderedDictionarySortEntriesInPlace(entries, count, cmptr);
+            return;
+        }
+        
+        @try {
+            
+            memcpy(scratch, entries, (count * sizeof(_JEOrderedDictionaryEntry)));
+            _JEOrderedDictionaryEntry *sortedEntries = scratch;
+            if (isConcurrent) {
+                
+                sortedEntries = _JEOrderedDictionarySortEntriesConcurrently(scratch, count, processorCount, cmptr);
+            }
+            else {
+                
+                _JEOrderedDictionarySortEntries(scratch, count, cmptr);
+            }
+            memcpy(entries, sortedEntries, (count * sizeof(_JEOrderedDictionaryEntry)));
+        }
+        @finally {
+            
+            free(scratch);
+        }
+    }
+    @finally {
+        
+        ++_mutations;
+        [self rebuildIndex];
+    }
+}
+
+
++ (instancetype)orderedDictionaryWithContentsOfArchiveURL:(NSURL *)url error:(NSError **)error {
+    
+    NSData *data = [[NSData alloc] initWithContentsOfURL:url options:NSDataReadingMappedIfSafe error:error];
+    if (!data) {
+        
+        return nil;
+    }
+    return [[self alloc] initWithArchiveData:data error:error];
+}
+
+- (instancetype)initWithArchiveData:(NSData *)data error:(NSError **)error {
+    
+    const uint8_t *bytes = (const uint8_t *)[data bytes];
+    NSUInteger length = [data length];
+    
+    _JEOrderedDictionaryArchiveHeader header;
+    if (length < sizeof(header)) {
+        
+        _JEOrderedDictionarySetCorruptArchiveError(error);
+        return nil;
+    }
+    memcpy(&header, bytes, sizeof(header));
+    uint64_t count = CFSwapInt64LittleToHost(header.count);
+    uint64_t keysLength = CFSwapInt64LittleToHost(header.keysLength);
+    if (CFSwapInt32LittleToHost(header.magic) != _JEOrderedDictionaryArchiveMagic
+        || CFSwapInt32LittleToHost(header.version) != _JEOrderedDictionaryArchiveVersion
+        || count >= (uint64_t)INT32_MAX
+        || keysLength > (length - sizeof(header))) {
+        
+        _JEOrderedDictionarySetCorruptArchiveError(error);
+        return nil;
+    }
+    
+    NSUInteger offsetsStart = _JEOrderedDictionaryArchiveAlignedLength(sizeof(header) + (NSUInteger)keysLength);
+    if (offsetsStart > length || (count + 1) > ((length - offsetsStart) / sizeof(uint64_t))) {
+        
+        _JEOrderedDictionarySetCorruptArchiveError(error);
+        return nil;
+    }
+    NSUInteger valuesStart = (offsetsStart + (((NSUInteger)count + 1) * sizeof(uint64_t)));
+    
+    // Only the keys are decoded up front since they are needed to build the index.
+    NSArray *keys;
+    @try {
+        
+        keys = [NSKeyedUnarchiver unarchiveObjectWithData:
+                [data subdataWithRange:(NSRange){ .location = sizeof(header), .length = (NSUInteger)keysLength }]];
+    }
+    @catch (NSException *exception) {
+        
+        keys = nil;
+    }
+    if (![keys isKindOfClass:[NSArray class]] || [keys count] != count) {
+        
+        _JEOrderedDictionarySetCorruptArchiveError(error);
+        return nil;
+    }
+    
+    self = [self initWithCapacity:(NSUInteger)count];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    uint64_t offset;
+    memcpy(&offset, (bytes + offsetsStart), sizeof(offset));
+    offset = CFSwapInt64LittleToHost(offset);
+    for (NSUInteger i = 0; i < count; ++i) {
+        
+        uint64_t nextOffset;
+        memcpy(&nextOffset, (bytes + offsetsStart + ((i + 1) * sizeof(uint64_t))), sizeof(nextOffset));
+        nextOffset = CFSwapInt64LittleToHost(nextOffset);
+        if (nextOffset < offset || nextOffset > (length - valuesStart)) {
+            
+            _JEOrderedDictionarySetCorruptArchiveError(error);
+            return nil;
+        }
+        
+        _JEOrderedDictionaryArchivedObject *archivedObject = [[_JEOrderedDictionaryArchivedObject alloc]
+                                                              initWithArchiveData:data
+                                                              range:(NSRange){ .location = (valuesStart + (NSUInteger)offset), .length = (NSUInteger)(nextOffset - offset) }];
+        [self setObject:archivedObject forKey:keys[i] cost:0];
+        offset = nextOffset;
+    }
+    
+    return self;
+}
+
+- (NSData *)archiveData {
+    
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:_count];
+    NSMutableData *valuesData = [[NSMutableData alloc] init];
+    uint64_t *offsets = (uint64_t *)malloc((_count + 1) * sizeof(uint64_t));
+    if (!offsets) {
+        
+        [NSException
+         raise:NSMallocException
+         format:@"*** %@: failed to allocate %lu offsets", NSStringFromSelector(_cmd), (unsigned long)(_count + 1)];
+    }
+    
+    NSUInteger offsetCount = 0;
+    for (NSUInteger i = _leadingTombstoneCount; i < _usedCount; ++i) {
+        
+        _JEOrderedDictionaryEntry entry = _entries[i];
+        if (!entry.key) {
+            
+            continue;
+        }
+        
+        [keys addObject:(__bridge id)entry.key];
+        offsets[offsetCount++] = CFSwapInt64HostToLittle([valuesData length]);
+        
+        // Values that were never accessed since loading are copied over as they are.
+        id object = (__bridge id)entry.object;
+        if (object_getClass(object) == _JEOrderedDictionaryArchivedObjectClass) {
+            
+            _JEOrderedDictionaryArchivedObject *archivedObject = object;
+            NSRange range = archivedObject.range;
+            [valuesData appendBytes:((const uint8_t *)[archivedObject.archiveData bytes] + range.location)
+                             length:range.length];
+        }
+        else {
+            
+            [valuesData appendData:[NSKeyedArchiver archivedDataWithRootObject:object]];
+        }
+    }
+    offsets[offsetCount++] = CFSwapInt64HostToLittle([valuesData length]);
+    
+    NSData *keysData = [NSKeyedArchiver archivedDataWithRootObject:keys];
+    _JEOrderedDictionaryArchiveHeader header = {
+        .magic = CFSwapInt32HostToLittle(_JEOrderedDictionaryArchiveMagic),
+        .version = CFSwapInt32HostToLittle(_JEOrderedDictionaryArchiveVersion),
+        .count = CFSwapInt64HostToLittle([keys count]),
+        .keysLength = CFSwapInt64HostToLittle([keysData length])
+    };
+    
+    NSUInteger offsetsStart = _JEOrderedDictionaryArchiveAlignedLength(sizeof(header) + [keysData length]);
+    NSMutableData *data = [[NSMutableData alloc] initWithCapacity:
+                           (offsetsStart + (offsetCount * sizeof(uint64_t)) + [valuesData length])];
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:keysData];
+    [data setLength:offsetsStart];
+    [data appendBytes:offsets length:(offsetCount * sizeof(uint64_t))];
+    [data appendData:valuesData];
+    free(offsets);
+    return data;
+}
+
+- (BOOL)writeArchiveToURL:(NSURL *)url error:(NSError **)error {
+    
+    return [[self archiveData] writeToURL:url options:NSDataWritingAtomic error:error];
+}
+
+
+#pragma mark - Private
+
+- (instancetype)initSharingStorageOfOrderedDictionary:(JEOrderedDictionary *)orderedDictionary {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _JEOrderedDictionaryStorage *storage = orderedDictionary->_storage;
+    __atomic_add_fetch(&storage->retainCount, 1, __ATOMIC_RELAXED);
+    _storage = storage;
+    _entries = orderedDictionary->_entries;
+    _count = orderedDictionary->_count;
+    _usedCount = orderedDictionary->_usedCount;
+    _leadingTombstoneCount = orderedDictionary->_leadingTombstoneCount;
+    _entryCapacity = orderedDictionary->_entryCapacity;
+    _index = orderedDictionary->_index;
+    _indexMask = orderedDictionary->_indexMask;
+    _indexFill = orderedDictionary->_indexFill;
+    _tombstoneCounts = orderedDictionary->_tombstoneCounts;
+    
+    return self;
+}
+
+- (void)detachStorageWithEntryCapacity:(NSUInteger)entryCapacity {
+    
+    // The caller keeps the previous storage alive until it has copied what it needs.
+    _storage = NULL;
+    _entries = NULL;
+    _index = NULL;
+    _indexMask = 0;
+    _tombstoneCounts = NULL;
+    _entryCapacity = 0;
+    [self resizeToEntryCapacity:entryCapacity];
+}
+
+- (void)prepareStorageForMutation {
+    
+    if (!_JEOrderedDictionaryStorageIsShared(_storage)) {
+        
+        return;
+    }
+    
+    _JEOrderedDictionaryStorage *sharedStorage = _storage;
+    _JEOrderedDictionaryEntry *sharedEntries = _entries;
+    NSUInteger firstEntryIndex = _leadingTombstoneCount;
+    NSUInteger usedCount = _usedCount;
+    
+    _usedCount = 0;
+    _leadingTombstoneCount = 0;
+    [self detachStorageWithEntryCapacity:MAX(_entryCapacity, _JEOrderedDictionaryMinimumEntryCapacity)];
+    
+    _JEOrderedDictionaryEntry *entries = _entries;
+    NSUInteger copiedCount = 0;
+    for (NSUInteger i = firstEntryIndex; i < usedCount; ++i) {
+        
+        _JEOrderedDictionaryEntry entry = sharedEntries[i];
+        if (entry.key) {
+            
+            CFRetain(entry.key);
+            CFRetain(entry.object);
+            entries[copiedCount++] = entry;
+        }
+    }
+    _usedCount = copiedCount;
+    [self rebuildIndex];
+    
+    _JEOrderedDictionaryStorageRelease(sharedStorage, firstEntryIndex, usedCount);
+}
+
+- (NSUInteger)prepareStorageForMutationAtSlot:(NSUInteger)slot {
+    
+    if (!_JEOrderedDictionaryStorageIsShared(_storage)) {
+        
+        return slot;
+    }
+    
+    // Duplicating storage rebuilds the index, so the slot is looked up again with the key that owned it.
+    _JEOrderedDictionaryEntry entry = _entries[_JEOrderedDictionaryEntryIndexAtSlot(_index, slot)];
+    id key = (__bridge id)entry.key;
+    [self prepareStorageForMutation];
+    return [self slotForKey:key hash:entry.hash];
+}
+
+- (NSUInteger)slotForKey:(id)key hash:(NSUInteger)hash {
+    
+    int32_t *index = _index;
+    _JEOrderedDictionaryEntry *entries = _entries;
+    if (!index) {
+        
+        for (NSUInteger i = _leadingTombstoneCount; i < _usedCount; ++i) {
+            
+            if (entries[i].key && _JEOrderedDictionaryKeysAreEqual(entries[i].key, entries[i].hash, key, hash)) {
+                
+                return i;
+            }
+        }
+        return NSNotFound;
+    }
+    
+    NSUInteger mask = _indexMask;
+    NSUInteger perturb = hash;
+    NSUInteger slot = (hash & mask);
+    while (YES) {
+        
+        int32_t entryIndex = index[slot];
+        if (entryIndex == _JEOrderedDictionaryEmptySlot
+            || (entryIndex != _JEOrderedDictionaryDeletedSlot
+                && _JEOrderedDictionaryKeysAreEqual(entries[entryIndex].key, entries[entryIndex].hash, key, hash))) {
+            
+            return slot;
+        }
+        perturb >>= _JEOrderedDictionaryPerturbShift;
+        slot = (((slot * 5) + perturb + 1) & mask);
+    }
+}
+
+- (NSUInteger)emptySlotForHash:(NSUInteger)hash {
+    
+    int32_t *index = _index;
+    if (!index) {
+        
+        return NSNotFound;
+    }
+    
+    NSUInteger mask = _indexMask;
+    NSUInteger perturb = hash;
+    NSUInteger slot = (hash & mask);
+    while (index[slot] != _JEOrderedDictionaryEmptySlot) {
+        
+        perturb >>= _JEOrderedDictionaryPerturbShift;
+        slot = (((slot * 5) + perturb + 1) & mask);
+    }
+    return slot;
+}
+
+- (void)resizeToEntryCapacity:(NSUInteger)entryCapacity {
+    
+    // Callers compact first, so live entries always fit in the new capacity. Storage is never shared here, so it is free to move.
+    _JEOrderedDictionaryStorage *storage = (_JEOrderedDictionaryStorage *)reallocf(_storage, (sizeof(_JEOrderedDictionaryStorage) + (entryCapacity * sizeof(_JEOrderedDictionaryEntry))));
+    if (!storage) {
+        
+        [NSException
+         raise:NSMallocException
+         format:@"*** %@: failed to allocate %lu entries", NSStringFromSelector(_cmd), (unsigned long)entryCapacity];
+    }
+    if (!_storage) {
+        
+        storage->retainCount = 1;
+        storage->index = NULL;
+        storage->tombstoneCounts = NULL;
+    }
+    _storage = storage;
+    _entries = storage->entries;
+    _entryCapacity = entryCapacity;
+    
+    // Entries may have moved, including when copy-on-write detaches shared storage, so enumerations in progress must stop.
+    ++_mutations;
+    
+    // Scanning a few entries is cheaper than probing, and leaves nothing else to allocate.
+    if (entryCapacity <= _JEOrderedDictionarySmallEntryCapacity) {
+        
+        free(_index);
+        _index = NULL;
+        _indexMask = 0;
+        free(_tombstoneCounts);
+        _tombstoneCounts = NULL;
+    }
+    else {
+        
+        NSUInteger indexCapacity = _JEOrderedDictionaryIndexCapacityForEntryCapacity(entryCapacity);
+        if (indexCapacity != (_indexMask + 1) || !_index) {
+            
+            free(_index);
+            _index = (int32_t *)malloc(indexCapacity * sizeof(int32_t));
+            if (!_index) {
+                
+                [NSException
+                 raise:NSMallocException
+                 format:@"*** %@: failed to allocate an index of %lu slots", NSStringFromSelector(_cmd), (unsigned long)indexCapacity];
+            }
+            _indexMask = (indexCapacity - 1);
+        }
+        
+        // The tree is indexed from 1, with a node for every entry position.
+        _tombstoneCounts = (uint32_t *)reallocf(_tombstoneCounts, ((entryCapacity + 1) * sizeof(uint32_t)));
+        if (!_tombstoneCounts) {
+            
+            [NSException
+             raise:NSMallocException
+             format:@"*** %@: failed to allocate tombstone counts for %lu entries", NSStringFromSelector(_cmd), (unsigned long)entryCapacity];
+        }
+    }
+    storage->index = _index;
+    storage->tombstoneCounts = _tombstoneCounts;
+    [self rebuildIndex];
+}
+
+- (void)rebuildIndex {
+    
+    _indexFill = _count;
+    if (!_index) {
+        
+        return;
+    }
+    
+    // All bytes 0xFF is _JEOrderedDictionaryEmptySlot.
+    memset(_index, 0xFF, ((_indexMask + 1) * sizeof(int32_t)));
+    for (NSUInteger i = _leadingTombstoneCount; i < _usedCount; ++i) {
+        
+        if (_entries[i].key) {
+            
+            _index[[self emptySlotForHash:_entries[i].hash]] = (int32_t)i;
+        }
+    }
+    
+    // The tree counts every tombstone before _usedCount, leading ones included. Each node is then added into its parent, which builds it in linear time.
+    uint32_t *tombstoneCounts = _tombstoneCounts;
+    NSUInteger entryCapacity = _entryCapacity;
+    memset(tombstoneCounts, 0, ((entryCapacity + 1) * sizeof(uint32_t)));
+    for (NSUInteger i = 0; i < _usedCount; ++i) {
+        
+        tombstoneCounts[i + 1] = ((i < _leadingTombstoneCount || !_entries[i].key) ? 1 : 0);
+    }
+    for (NSUInteger i = 1; i <= entryCapacity; ++i) {
+        
+        NSUInteger parent = (i + (i & -i));
+        if (parent <= entryCapacity) {
+            
+            tombstoneCounts[parent] += tombstoneCounts[i];
+        }
+    }
+}
+
+- (void)enumerateEntriesInRange:(NSRange)range
+                        options:(NSEnumerationOptions)opts
+                           stop:(BOOL *)stop
+                     usingBlock:(void (^)(NSUInteger idx, id key, id obj, BOOL *stop))block {
+    
+    // Each run of entries starts from a single index lookup, then steps over tombstones, so the array is only ever read. A block that mutates the receiver may free or move the array, so _mutations is checked after every call.
+    _JEOrderedDictionaryEntry *entries = _entries;
+    unsigned long mutations = _mutations;
+    BOOL isReversed = ((opts & NSEnumerationReverse) != 0);
+    __block BOOL isStopped = NO;
+    
+    NSUInteger chunkCount = MIN(range.length, ([[NSProcessInfo processInfo] activeProcessorCount] * 4));
+    if ((opts & NSEnumerationConcurrent) == 0 || chunkCount < 2) {
+        
+        NSUInteger entryIndex = [self entryIndexForLiveIndex:(isReversed ? (NSMaxRange(range) - 1) : range.location)];
+        for (NSUInteger i = 0; i < range.length && !isStopped; ++i) {
+            
+            while (!entries[entryIndex].key) {
+                
+                entryIndex = (isReversed ? (entryIndex - 1) : (entryIndex + 1));
+            }
+            NSUInteger idx = (isReversed
+                              ? (NSMaxRange(range) - 1 - i)
+                              : (range.location + i));
+            block(idx, (__bridge id)entries[entryIndex].key, _JEOrderedDictionaryEntryObject(&entries[entryIndex]), &isStopped);
+            [self checkMutations:mutations];
+            entryIndex = (isReversed ? (entryIndex - 1) : (entryIndex + 1));
+        }
+    }
+    else {
+        
+        // Each chunk gets a contiguous slice of the array. A stop from any chunk is published to the others, which check it before every entry. Exceptions can't be raised across dispatch_apply, so a mutation stops every chunk and is raised once they have all returned.
+        __block BOOL isMutated = NO;
+        NSUInteger chunkLength = (((range.length - 1) / chunkCount) + 1);
+        dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+            
+            NSUInteger start = (range.location + (chunk * chunkLength));
+            NSUInteger end = MIN((start + chunkLength), NSMaxRange(range));
+            if (start >= end) {
+                
+                return;
+            }
+            NSUInteger entryIndex = [self entryIndexForLiveIndex:start];
+            for (NSUInteger idx = start; idx < end && !__atomic_load_n(&isStopped, __ATOMIC_RELAXED); ++idx, ++entryIndex) {
+                
+                while (!entries[entryIndex].key) {
+                    
+                    ++entryIndex;
+                }
+                BOOL shouldStop = NO;
+                block(idx, (__bridge id)entries[entryIndex].key, _JEOrderedDictionaryEntryObject(&entries[entryIndex]), &shouldStop);
+                if (__atomic_load_n(&_mutations, __ATOMIC_RELAXED) != mutations) {
+                    
+                    __atomic_store_n(&isMutated, YES, __ATOMIC_RELAXED);
+                    shouldStop = YES;
+                }
+                if (shouldStop) {
+                    
+                    __atomic_store_n(&isStopped, YES, __ATOMIC_RELAXED);
+                }
+            }
+            
+        });
+        if (isMutated) {
+            
+            [self checkMutations:mutations];
+        }
+    }
+    
+    if (stop) {
+        
+        *stop = isStopped;
+    }
+}
+
+- (void)updateCountsLookups {
+    
+    _countsLookups = (_ordersByAccess || _maximumCount > 0 || _totalCostLimit > 0);
+}
+
+- (void)reserveCapacityForAppendingCount:(NSUInteger)count {
+    
+    if ((_usedCount + count) <= _entryCapacity && (_indexFill + count) <= _entryCapacity) {
+        
+        return;
+    }
+    [self prepareStorageForMutation];
+    if (_usedCount > _count || _indexFill > _count) {
+        
+        [self compactEntries];
+    }
+    if ((_count + count) > _entryCapacity) {
+        
+        [self resizeToEntryCapacity:(_count + count)];
+    }
+}
+
+- (BOOL)reserveEntryForAppending {
+    
+    if (_usedCount < _entryCapacity && _indexFill < _entryCapacity) {
+        
+        return NO;
+    }
+    if (_count >= (NSUInteger)INT32_MAX) {
+        
+        [NSException
+         raise:NSRangeException
+         format:@"*** %@ cannot hold more than %d entries", [self class], INT32_MAX];
+    }
+    if (_usedCount > _count || _indexFill > _count) {
+        
+        [self compactEntries];
+    }
+    if ((_count * 3) >= (_entryCapacity * 2)) {
+        
+        [self resizeToEntryCapacity:(_entryCapacity * 2)];
+    }
+    return YES;
+}
+
+- (void)moveEntryToBackAtSlot:(NSUInteger)slot {
+    
+    NSUInteger entryIndex = (NSUInteger)_JEOrderedDictionaryEntryIndexAtSlot(_index, slot);
+    if (entryIndex == (_usedCount - 1)) {
+        
+        return;
+    }
+    CFTypeRef key = _entries[entryIndex].key;
+    NSUInteger hash = _entries[entryIndex].hash;
+    if ([self reserveEntryForAppending]) {
+        
+        // Positions and slots may have moved while making room.
+        slot = [self slotForKey:(__bridge id)key hash:hash];
+        entryIndex = (NSUInteger)_JEOrderedDictionaryEntryIndexAtSlot(_index, slot);
+    }
+    
+    // The entry is appended and its slot repointed, so the key's probe sequence is unchanged and the old position becomes a tombstone.
+    _entries[_usedCount] = _entries[entryIndex];
+    _JEOrderedDictionarySetEntryIndexAtSlot(_index, slot, (int32_t)_usedCount);
+    ++_usedCount;
+    ++_mutations;
+    [self tombstoneEntryAtIndex:entryIndex];
+}
+
+- (void)removeEntryAtSlot:(NSUInteger)slot {
+    
+    NSUInteger entryIndex = (NSUInteger)_JEOrderedDictionaryEntryIndexAtSlot(_index, slot);
+    _JEOrderedDictionaryEntry entry = _entries[entryIndex];
+    
+    // The slot stays occupied so probe sequences that pass through it still reach later keys.
+    _JEOrderedDictionarySetEntryIndexAtSlot(_index, slot, _JEOrderedDictionaryDeletedSlot);
+    ++_mutations;
+    --_count;
+    _totalCost -= entry.cost;
+    [self tombstoneEntryAtIndex:entryIndex];
+    
+    CFRelease(entry.key);
+    CFRelease(entry.object);
+}
+
+- (void)tombstoneEntryAtIndex:(NSUInteger)entryIndex {
+    
+    _entries[entryIndex].key = NULL;
+    _entries[entryIndex].object = NULL;
+    _JEOrderedDictionaryAddTombstoneCount(_tombstoneCounts, _entryCapacity, entryIndex, 1);
+    
+    // Positions past _usedCount are reused by later appends, so tombstones trimmed off the end are taken back out of the tree.
+    if (_count == 0) {
+        
+        for (NSUInteger i = 0; i < _usedCount; ++i) {
+            
+            _JEOrderedDictionaryAddTombstoneCount(_tombstoneCounts, _entryCapacity, i, -1);
+        }
+        _usedCount = 0;
+        _leadingTombstoneCount = 0;
+    }
+    else if (entryIndex == _leadingTombstoneCount) {
+        
+        do {
+            
+            ++_leadingTombstoneCount;
+            
+        } while (!_entries[_leadingTombstoneCount].key);
+    }
+    else if (entryIndex == (_usedCount - 1)) {
+        
+        do {
+            
+            --_usedCount;
+            _JEOrderedDictionaryAddTombstoneCount(_tombstoneCounts, _entryCapacity, _usedCount, -1);
+            
+        } while (!_entries[_usedCount - 1].key);
+    }
+    else if ((_usedCount - _count) > MAX(_count, _JEOrderedDictionaryMinimumEntryCapacity)) {
+        
+        [self compactEntries];
+    }
+}
+
+- (void)evictEntriesIfNeeded {
+    
+    while (_count > 0
+           && ((_maximumCount > 0 && _count > _maximumCount)
+               || (_totalCostLimit > 0 && _totalCost > _totalCostLimit))) {
+        
+        void (^evictionHandler)(id key, id obj) = self.evictionHandler;
+        [self prepareStorageForMutation];
+        NSUInteger slot = [self slotForKey:(__bridge id)_entries[_leadingTombstoneCount].key
+                                      hash:_entries[_leadingTombstoneCount].hash];
+        id key = (__bridge id)_entries[_leadingTombstoneCount].key;
+        id object = (evictionHandler
+                     ? _JEOrderedDictionaryEntryObject(&_entries[_leadingTombstoneCount])
+                     : nil);
+        [self removeEntryAtSlot:slot];
+        ++_evictionCount;
+        
+        if (evictionHandler) {
+            
+            evictionHandler(key, object);
+        }
+    }
+}
+
+- (void)compactEntries {
+    
+    // Duplicating shared storage already drops every tombstone.
+    if (_JEOrderedDictionaryStorageIsShared(_storage)) {
+        
+        [self prepareStorageForMutation];
+        return;
+    }
+    
+    _JEOrderedDictionaryEntry *entries = _entries;
+    NSUInteger liveCount = 0;
+    for (NSUInteger i = _leadingTombstoneCount; i < _usedCount; ++i) {
+        
+        if (entries[i].key) {
+            
+            entries[liveCount++] = entries[i];
+        }
+    }
+    _usedCount = liveCount;
+    _leadingTombstoneCount = 0;
+    ++_mutations;
+    [self rebuildIndex];
+}
+
+- (void)checkMutations:(unsigned long)mutations {
+    
+    if (mutations != _mutations) {
+        
+        [NSException
+         raise:NSGenericException
+         format:@"*** Collection <%@: %p> was mutated while being enumerated.", NSStringFromClass([self class]), self];
+    }
+}
+
+- (BOOL)hasInteriorTombstones {
+    
+    return ((_usedCount - _count) > _leadingTombstoneCount);
+}
+
+- (NSUInteger)entryIndexForIndex:(NSUInteger)idx selector:(SEL)selector {
+    
+    if (idx >= _count) {
+        
+        [NSException
+         raise:NSRangeException
+         format:@"*** %@: index %lu beyond bounds [0 .. %ld]", NSStringFromSelector(selector), (unsigned long)idx, ((long)_count - 1)];
+    }
+    
+    return [self entryIndexForLiveIndex:idx];
+}
+
+- (NSUInteger)entryIndexForLiveIndex:(NSUInteger)idx {
+    
+    // Tombstones at the front only offset positions. Tombstones in the middle are skipped in place, since squeezing them out here would make reads write.
+    if (![self hasInteriorTombstones]) {
+        
+        return (_leadingTombstoneCount + idx);
+    }
+    if (_tombstoneCounts) {
+        
+        return _JEOrderedDictionaryEntryIndexForLiveIndex(_tombstoneCounts, _entryCapacity, idx);
+    }
+    
+    NSUInteger entryIndex = _leadingTombstoneCount;
+    while (YES) {
+        
+        if (_entries[entryIndex].key) {
+            
+            if (idx == 0) {
+                
+                return entryIndex;
+            }
+            --idx;
+        }
+        ++entryIndex;
+    }
+}
+
+- (NSUInteger)indexForEntryIndex:(NSUInteger)entryIndex {
+    
+    if (![self hasInteriorTombstones]) {
+        
+        return (entryIndex - _leadingTombstoneCount);
+    }
+    if (_tombstoneCounts) {
+        
+        return (entryIndex - _JEOrderedDictionaryTombstoneCountBeforeEntryIndex(_tombstoneCounts, entryIndex));
+    }
+    
+    NSUInteger idx = 0;
+    for (NSUInteger i = _leadingTombstoneCount; i < entryIndex; ++i) {
+        
+        if (_entries[i].key) {
+            
+            ++idx;
+        }
+    }
+    return idx;
+}
+
 @end
@@ -0,0 +1,101 @@
+//
+//  JESortedDictionary.h
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/*! The JESortedDictionary class is an NSMutableDictionary subclass that keeps its keys sorted. This is typically useful for data keyed by timestamps or IDs that is queried by range.
+ Entries are stored in a B-tree with wide nodes, so lookups, insertions, and removals are O(log n), and neighbouring keys share cache lines. Keys are compared with the dictionary's comparator only: two keys are the same key if the comparator returns NSOrderedSame for them.
+ */
+@interface JESortedDictionary : NSMutableDictionary
+
+/*! Initializes an empty dictionary that sorts its keys with the specified comparator
+ @param cmptr The comparator used to sort keys. If nil, keys are sorted with compare:
+ */
+- (nonnull instancetype)initWithComparator:(nullable NSComparator)cmptr;
+
+/*! The comparator used to sort keys. Archived dictionaries don't keep their comparator and are decoded sorted with compare:
+ */
+@property (nonatomic, copy, readonly, nonnull) NSComparator comparator;
+
+
+#pragma mark - Sorted access
+
+/*! Returns the smallest key in the dictionary
+ @return The smallest key in the receiver or nil if the dictionary is empty
+ */
+- (nullable id)firstKey;
+
+/*! Returns the largest key in the dictionary
+ @return The largest key in the receiver or nil if the dictionary is empty
+ */
+- (nullable id)lastKey;
+
+/*! Returns the object for the smallest key in the dictionary
+ @return The object for the smallest key in the receiver or nil if the dictionary is empty
+ */
+- (nullable id)firstObject;
+
+/*! Returns the object for the largest key in the dictionary
+ @return The object for the largest key in the receiver or nil if the dictionary is empty
+ */
+- (nullable id)lastObject;
+
+/*! Returns the largest key that is less than or equal to the specified key
+ @param key The key to search from
+ @return The largest key less than or equal to key, or nil if every key in the dictionary is greater than key
+ */
+- (nullable id)floorKeyForKey:(nonnull id)key;
+
+/*! Returns the smallest key that is greater than or equal to the specified key
+ @param key The key to search from
+ @return The smallest key greater than or equal to key, or nil if every key in the dictionary is less than key
+ */
+- (nullable id)ceilingKeyForKey:(nonnull id)key;
+
+/*! Returns the keys within the specified bounds, in sorted order
+ @param fromKey The inclusive lower bound, or nil for no lower bound
+ @param toKey The inclusive upper bound, or nil for no upper bound
+ @return The keys between fromKey and toKey
+ */
+- (nonnull NSArray *)keysInKeyRangeFromKey:(nullable id)fromKey toKey:(nullable id)toKey;
+
+/*! Returns the objects for the keys within the specified bounds, in sorted order of their keys
+ @param fromKey The inclusive lower bound, or nil for no lower bound
+ @param toKey The inclusive upper bound, or nil for no upper bound
+ @return The objects for the keys between fromKey and toKey
+ */
+- (nonnull NSArray *)objectsInKeyRangeFromKey:(nullable id)fromKey toKey:(nullable id)toKey;
+
+/*! Applies a given block object to the entries of the dictionary in sorted order, starting from the specified key.
+ If the block sets *stop to YES, the enumeration stops. The dictionary must not be mutated during the enumeration.
+ @param key The key to start from. Enumeration starts at ceilingKeyForKey: going forward, or at floorKeyForKey: with NSEnumerationReverse. If nil, enumeration starts from the first or the last key.
+ @param opts Only NSEnumerationReverse is supported
+ @param block A block object to operate on entries in the dictionary.
+ */
+- (void)enumerateKeysAndObjectsFromKey:(nullable id)key
+                               options:(NSEnumerationOptions)opts
+                            usingBlock:(nonnull void (^)(id _Nonnull key, id _Nonnull obj, BOOL *_Nonnull stop))block;
+
+@end
@@ -0,0 +1,900 @@
+//
+//  JESortedDictionary.m
+//  JEToolkit
+//
+//  Copyright (c) 2013 John Rommel Estropia
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to deal
+//  in the Software without restriction, including without limitation the rights
+//  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//  copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in all
+//  copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//  SOFTWARE.
+//
+
+#import "JESortedDictionary.h"
+
+
+enum {
+    
+    // Wide enough that a lookup among 10M keys visits 5 or 6 nodes, while the keys of a node still span only a few cache lines.
+    _JESortedDictionaryNodeCapacity = 32,
+    
+    // Nodes other than the root never have fewer keys than this.
+    _JESortedDictionaryNodeMinimumCount = ((_JESortedDictionaryNodeCapacity / 2) - 1)
+};
+
+/*! Keys come first so that leaves can hand their keys directly to fast enumeration.
+ */
+typedef struct _JESortedDictionaryNode {
+    
+    CFTypeRef keys[_JESortedDictionaryNodeCapacity];
+    NSUInteger count;
+    BOOL isLeaf;
+    
+} _JESortedDictionaryNode;
+
+/*! Leaves hold the entries and are linked in key order, so ordered iteration never walks back up the tree.
+ */
+typedef struct _JESortedDictionaryLeaf {
+    
+    _JESortedDictionaryNode node;
+    CFTypeRef objects[_JESortedDictionaryNodeCapacity];
+    struct _JESortedDictionaryLeaf *previous;
+    struct _JESortedDictionaryLeaf *next;
+    
+} _JESortedDictionaryLeaf;
+
+/*! Branches hold count separator keys and (count + 1) children. Every key under children[i] is less than keys[i], and every key under children[i + 1] is greater than or equal to it.
+ */
+typedef struct _JESortedDictionaryBranch {
+    
+    _JESortedDictionaryNode node;
+    _JESortedDictionaryNode *children[_JESortedDictionaryNodeCapacity + 1];
+    
+} _JESortedDictionaryBranch;
+
+
+static void *_JESortedDictionaryNodeCreate(size_t size, BOOL isLeaf) {
+    
+    _JESortedDictionaryNode *node = (_JESortedDictionaryNode *)calloc(1, size);
+    if (!node) {
+        
+        [NSException
+         raise:NSMallocException
+         format:@"*** failed to allocate %@ node", NSStringFromClass([JESortedDictionary class])];
+    }
+    node->isLeaf = isLeaf;
+    return node;
+}
+
+static inline _JESortedDictionaryLeaf *_JESortedDictionaryLeafCreate(void) {
+    
+    return (_JESortedDictionaryLeaf *)_JESortedDictionaryNodeCreate(sizeof(_JESortedDictionaryLeaf), YES);
+}
+
+static inline _JESortedDictionaryBranch *_JESortedDictionaryBranchCreate(void) {
+    
+    return (_JESortedDictionaryBranch *)_JESortedDictionaryNodeCreate(sizeof(_JESortedDictionaryBranch), NO);
+}
+
+static void _JESortedDictionaryNodeRelease(_JESortedDictionaryNode *node) {
+    
+    NSUInteger count = node->count;
+    for (NSUInteger i = 0; i < count; ++i) {
+        
+        CFRelease(node->keys[i]);
+    }
+    if (node->isLeaf) {
+        
+        _JESortedDictionaryLeaf *leaf = (_JESortedDictionaryLeaf *)node;
+        for (NSUInteger i = 0; i < count; ++i) {
+            
+            CFRelease(leaf->objects[i]);
+        }
+    }
+    else {
+        
+        _JESortedDictionaryBranch *branch = (_JESortedDictionaryBranch *)node;
+        for (NSUInteger i = 0; i <= count; ++i) {
+            
+            _JESortedDictionaryNodeRelease(branch->children[i]);
+        }
+    }
+    free(node);
+}
+
+static inline NSUInteger _JESortedDictionaryLowerBound(_JESortedDictionaryNode *node, id key, NSComparator cmptr) {
+    
+    // The first position whose key is not less than key.
+    NSUInteger low = 0;
+    NSUInteger high = node->count;
+    while (low < high) {
+        
+        NSUInteger middle = ((low + high) / 2);
+        if (cmptr((__bridge id)node->keys[middle], key) == NSOrderedAscending) {
+            
+            low = (middle + 1);
+        }
+        else {
+            
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static inline NSUInteger _JESortedDictionaryUpperBound(_JESortedDictionaryNode *node, id key, NSComparator cmptr) {
+    
+    // The first position whose key is greater than key.
+    NSUInteger low = 0;
+    NSUInteger high = node->count;
+    while (low < high) {
+        
+        NSUInteger middle = ((low + high) / 2);
+        if (cmptr(key, (__bridge id)node->keys[middle]) == NSOrderedAscending) {
+            
+            high = middle;
+        }
+        else {
+            
+            low = (middle + 1);
+        }
+    }
+    return low;
+}
+
+static inline _JESortedDictionaryLeaf *_JESortedDictionaryLeafForKey(_JESortedDictionaryNode *root, id key, NSComparator cmptr) {
+    
+    _JESortedDictionaryNode *node = root;
+    while (!node->isLeaf) {
+        
+        node = ((_JESortedDictionaryBranch *)node)->children[_JESortedDictionaryUpperBound(node, key, cmptr)];
+    }
+    return (_JESortedDictionaryLeaf *)node;
+}
+
+static inline _JESortedDictionaryLeaf *_JESortedDictionaryFirstLeaf(_JESortedDictionaryNode *root) {
+    
+    _JESortedDictionaryNode *node = root;
+    while (!node->isLeaf) {
+        
+        node = ((_JESortedDictionaryBranch *)node)->children[0];
+    }
+    return (_JESortedDictionaryLeaf *)node;
+}
+
+static inline _JESortedDictionaryLeaf *_JESortedDictionaryLastLeaf(_JESortedDictionaryNode *root) {
+    
+    _JESortedDictionaryNode *node = root;
+    while (!node->isLeaf) {
+        
+        node = ((_JESortedDictionaryBranch *)node)->children[node->count];
+    }
+    return (_JESortedDictionaryLeaf *)node;
+}
+
+static void _JESortedDictionarySplitChild(_JESortedDictionaryBranch *branch, NSUInteger childIndex) {
+    
+    // The branch is never full here because insertion splits full nodes on the way down.
+    _JESortedDictionaryNode *child = branch->children[childIndex];
+    _JESortedDictionaryNode *sibling;
+    CFTypeRef separator;
+    if (child->isLeaf) {
+        
+        _JESortedDictionaryLeaf *leaf = (_JESortedDictionaryLeaf *)child;
+        _JESortedDictionaryLeaf *siblingLeaf = _JESortedDictionaryLeafCreate();
+        NSUInteger keptCount = (_JESortedDictionaryNodeCapacity / 2);
+        NSUInteger movedCount = (child->count - keptCount);
+        memcpy(siblingLeaf->node.keys, &child->keys[keptCount], (movedCount * sizeof(CFTypeRef)));
+        memcpy(siblingLeaf->objects, &leaf->objects[keptCount], (movedCount * sizeof(CFTypeRef)));
+        siblingLeaf->node.count = movedCount;
+        child->count = keptCount;
+        
+        siblingLeaf->previous = leaf;
+        siblingLeaf->next = leaf->next;
+        if (leaf->next) {
+            
+            leaf->next->previous = siblingLeaf;
+        }
+        leaf->next = siblingLeaf;
+        
+        sibling = &siblingLeaf->node;
+        separator = CFRetain(siblingLeaf->node.keys[0]);
+    }
+    else {
+        
+        // The middle key moves up to the parent instead of being copied.
+        _JESortedDictionaryBranch *childBranch = (_JESortedDictionaryBranch *)child;
+        _JESortedDictionaryBranch *siblingBranch = _JESortedDictionaryBranchCreate();
+        NSUInteger middle = (_JESortedDictionaryNodeCapacity / 2);
+        NSUInteger movedCount = (child->count - middle - 1);
+        memcpy(siblingBranch->node.keys, &child->keys[middle + 1], (movedCount * sizeof(CFTypeRef)));
+        memcpy(siblingBranch->children, &childBranch->children[middle + 1], ((movedCount + 1) * sizeof(_JESortedDictionaryNode *)));
+        siblingBranch->node.count = movedCount;
+        separator = child->keys[middle];
+        child->count = middle;
+        
+        sibling = &siblingBranch->node;
+    }
+    
+    NSUInteger count = branch->node.count;
+    memmove(&branch->node.keys[childIndex + 1], &branch->node.keys[childIndex], ((count - childIndex) * sizeof(CFTypeRef)));
+    memmove(&branch->children[childIndex + 2], &branch->children[childIndex + 1], ((count - childIndex) * sizeof(_JESortedDictionaryNode *)));
+    branch->node.keys[childIndex] = separator;
+    branch->children[childIndex + 1] = sibling;
+    branch->node.count = (count + 1);
+}
+
+static void _JESortedDictionaryMergeChildren(_JESortedDictionaryBranch *branch, NSUInteger childIndex) {
+    
+    // Merges children[childIndex + 1] into children[childIndex]. Both are at the minimum count, so the result always fits.
+    _JESortedDictionaryNode *child = branch->children[childIndex];
+    _JESortedDictionaryNode *sibling = branch->children[childIndex + 1];
+    CFTypeRef separator = branch->node.keys[childIndex];
+    if (child->isLeaf) {
+        
+        _JESortedDictionaryLeaf *leaf = (_JESortedDictionaryLeaf *)child;
+        _JESortedDictionaryLeaf *siblingLeaf = (_JESortedDictionaryLeaf *)sibling;
+        memcpy(&child->keys[child->count], sibling->keys, (sibling->count * sizeof(CFTypeRef)));
+        memcpy(&leaf->objects[child->count], siblingLeaf->objects, (sibling->count * sizeof(CFTypeRef)));
+        child->count += sibling->count;
+        
+        leaf->next = siblingLeaf->next;
+        if (siblingLeaf->next) {
+            
+            siblingLeaf->next->previous = leaf;
+        }
+        CFRelease(separator);
+    }
+    else {
+        
+        _JESortedDictionaryBranch *childBranch = (_JESortedDictionaryBranch *)child;
+        _JESortedDictionaryBranch *siblingBranch = (_JESortedDictionaryBranch *)sibling;
+        child->keys[child->count] = separator;
+        memcpy(&child->keys[child->count + 1], sibling->keys, (sibling->count * sizeof(CFTypeRef)));
+        memcpy(&childBranch->children[child->count + 1], siblingBranch->children, ((sibling->count + 1) * sizeof(_JESortedDictionaryNode *)));
+        child->count += (sibling->count + 1);
+    }
+    free(sibling);
+    
+    NSUInteger count = branch->node.count;
+    memmove(&branch->node.keys[childIndex], &branch->node.keys[childIndex + 1], ((count - childIndex - 1) * sizeof(CFTypeRef)));
+    memmove(&branch->children[childIndex + 1], &branch->children[childIndex + 2], ((count - childIndex - 1) * sizeof(_JESortedDictionaryNode *)));
+    branch->node.count = (count - 1);
+}
+
+static void _JESortedDictionaryMoveFromLeftSibling(_JESortedDictionaryBranch *branch, NSUInteger childIndex) {
+    
+    _JESortedDictionaryNode *child = branch->children[childIndex];
+    _JESortedDictionaryNode *sibling = branch->children[childIndex - 1];
+    NSUInteger lastIndex = (sibling->count - 1);
+    memmove(&child->keys[1], child->keys, (child->count * sizeof(CFTypeRef)));
+    if (child->isLeaf) {
+        
+        _JESortedDictionaryLeaf *leaf = (_JESortedDictionaryLeaf *)child;
+        _JESortedDictionaryLeaf *siblingLeaf = (_JESortedDictionaryLeaf *)sibling;
+        memmove(&leaf->objects[1], leaf->objects, (child->count * sizeof(CFTypeRef)));
+        child->keys[0] = sibling->keys[lastIndex];
+        leaf->objects[0] = siblingLeaf->objects[lastIndex];
+        
+        CFRelease(branch->node.keys[childIndex - 1]);
+        branch->node.keys[childIndex - 1] = CFRetain(child->keys[0]);
+    }
+    else {
+        
+        // The separator rotates down into the child and the sibling's last key rotates up to replace it.
+        _JESortedDictionaryBranch *childBranch = (_JESortedDictionaryBranch *)child;
+        _JESortedDictionaryBranch *siblingBranch = (_JESortedDictionaryBranch *)sibling;
+        memmove(&childBranch->children[1], childBranch->children, ((child->count + 1) * sizeof(_JESortedDictionaryNode *)));
+        child->keys[0] = branch->node.keys[childIndex - 1];
+        childBranch->children[0] = siblingBranch->children[sibling->count];
+        branch->node.keys[childIndex - 1] = sibling->keys[lastIndex];
+    }
+    ++child->count;
+    --sibling->count;
+}
+
+static void _JESortedDictionaryMoveFromRightSibling(_JESortedDictionaryBranch *branch, NSUInteger childIndex) {
+    
+    _JESortedDictionaryNode *child = branch->children[childIndex];
+    _JESortedDictionaryNode *sibling = branch->children[childIndex + 1];
+    NSUInteger remainingCount = (sibling->count - 1);
+    if (child->isLeaf) {
+        
+        _JESortedDictionaryLeaf *leaf = (_JESortedDictionaryLeaf *)child;
+        _JESortedDictionaryLeaf *siblingLeaf = (_JESortedDictionaryLeaf *)sibling;
+        child->keys[child->count] = sibling->keys[0];
+        leaf->objects[child->count] = siblingLeaf->objects[0];
+        memmove(sibling->keys, &sibling->keys[1], (remainingCount * sizeof(CFTypeRef)));
+        memmove(siblingLeaf->objects, &siblingLeaf->objects[1], (remainingCount * sizeof(CFTypeRef)));
+        
+        CFRelease(branch->node.keys[childIndex]);
+        branch->node.keys[childIndex] = CFRetain(sibling->keys[0]);
+    }
+    else {
+        
+        _JESortedDictionaryBranch *childBranch = (_JESortedDictionaryBranch *)child;
+        _JESortedDictionaryBranch *siblingBranch = (_JESortedDictionaryBranch *)sibling;
+        child->keys[child->count] = branch->node.keys[childIndex];
+        childBranch->children[child->count + 1] = siblingBranch->children[0];
+        branch->node.keys[childIndex] = sibling->keys[0];
+        memmove(sibling->keys, &sibling->keys[1], (remainingCount * sizeof(CFTypeRef)));
+        memmove(siblingBranch->children, &siblingBranch->children[1], (sibling->count * sizeof(_JESortedDictionaryNode *)));
+    }
+    ++child->count;
+    sibling->count = remainingCount;
+}
+
+static NSUInteger _JESortedDictionaryFillChild(_JESortedDictionaryBranch *branch, NSUInteger childIndex) {
+    
+    // Gives a child at the minimum count one more key, either from a sibling that can spare one or by merging with a sibling. Returns the new index of the child.
+    if (childIndex > 0 && branch->children[childIndex - 1]->count > _JESortedDictionaryNodeMinimumCount) {
+        
+        _JESortedDictionaryMoveFromLeftSibling(branch, childIndex);
+        return childIndex;
+    }
+    if (childIndex < branch->node.count) {
+        
+        if (branch->children[childIndex + 1]->count > _JESortedDictionaryNodeMinimumCount) {
+            
+            _JESortedDictionaryMoveFromRightSibling(branch, childIndex);
+        }
+        else {
+            
+            _JESortedDictionaryMergeChildren(branch, childIndex);
+        }
+        return childIndex;
+    }
+    _JESortedDictionaryMergeChildren(branch, (childIndex - 1));
+    return (childIndex - 1);
+}
+
+
+#pragma mark - JESortedDictionary
+
+@implementation JESortedDictionary {
+    
+    _JESortedDictionaryNode *_root;
+    NSUInteger _count;
+    unsigned long _mutations;
+}
+
+#pragma mark - NSObject
+
+- (instancetype)init {
+    
+    return [self initWithComparator:nil];
+}
+
+- (instancetype)initWithObjects:(const __unsafe_unretained id [])objects
+                        forKeys:(const __unsafe_unretained id<NSCopying> [])keys
+                          count:(NSUInteger)cnt {
+    
+    self = [self initWithComparator:nil];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    for (NSUInteger i = 0; i < cnt; ++i) {
+        
+        [self setObject:objects[i] forKey:keys[i]];
+    }
+    
+    return self;
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)numItems {
+    
+    return [self initWithComparator:nil];
+}
+
+- (void)dealloc {
+    
+    if (_root) {
+        
+        _JESortedDictionaryNodeRelease(_root);
+    }
+}
+
+
+#pragma mark - NSDictionary
+
+- (NSUInteger)count {
+    
+    return _count;
+}
+
+- (id)objectForKey:(id)aKey {
+    
+    if (!aKey) {
+        
+        return nil;
+    }
+    
+    NSComparator comparator = _comparator;
+    _JESortedDictionaryLeaf *leaf = _JESortedDictionaryLeafForKey(_root, aKey, comparator);
+    NSUInteger position = _JESortedDictionaryLowerBound(&leaf->node, aKey, comparator);
+    if (position < leaf->node.count
+        && comparator((__bridge id)leaf->node.keys[position], aKey) == NSOrderedSame) {
+        
+        return (__bridge id)leaf->objects[position];
+    }
+    return nil;
+}
+
+- (NSArray *)allKeys {
+    
+    return [self keysInKeyRangeFromKey:nil toKey:nil];
+}
+
+- (NSArray *)allValues {
+    
+    return [self objectsInKeyRangeFromKey:nil toKey:nil];
+}
+
+- (NSEnumerator *)keyEnumerator {
+    
+    // Enumerators outlive the call, so they walk a copy of the keys instead of leaves that later mutations could free.
+    return [[self allKeys] objectEnumerator];
+}
+
+- (NSEnumerator *)objectEnumerator {
+    
+    return [[self allValues] objectEnumerator];
+}
+
+- (void)enumerateKeysAndObjectsUsingBlock:(void (^)(id key, id obj, BOOL *stop))block {
+    
+    [self
+     enumerateKeysAndObjectsFromKey:nil
+     options:kNilOptions
+     usingBlock:block];
+}
+
+- (void)enumerateKeysAndObjectsWithOptions:(NSEnumerationOptions)opts
+                                usingBlock:(void (^)(id key, id obj, BOOL *stop))block {
+    
+    [self
+     enumerateKeysAndObjectsFromKey:nil
+     options:opts
+     usingBlock:block];
+}
+
+
+#pragma mark - NSFastEnumeration
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(id __unsafe_unretained [])buffer
+                                    count:(NSUInteger)len {
+    
+    // Each call hands out one leaf's keys in place. state->extra[0] holds the next leaf.
+    _JESortedDictionaryLeaf *leaf;
+    if (state->state == 0) {
+        
+        state->mutationsPtr = &_mutations;
+        state->state = 1;
+        leaf = _JESortedDictionaryFirstLeaf(_root);
+    }
+    else {
+        
+        leaf = (_JESortedDictionaryLeaf *)state->extra[0];
+    }
+    
+    if (!leaf) {
+        
+        return 0;
+    }
+    state->extra[0] = (unsigned long)leaf->next;
+    state->itemsPtr = (__unsafe_unretained id *)(void *)leaf->node.keys;
+    return leaf->node.count;
+}
+
+
+#pragma mark - NSMutableDictionary
+
+- (void)setObject:(id)anObject forKey:(id<NSCopying>)aKey {
+    
+    if (!anObject) {
+        
+        [NSException
+         raise:NSInvalidArgumentException
+         format:@"*** %@: object cannot be nil (key: %@)", NSStringFromSelector(_cmd), aKey];
+    }
+    if (!aKey) {
+        
+        [NSException
+         raise:NSInvalidArgumentException
+         format:@"*** %@: key cannot be nil", NSStringFromSelector(_cmd)];
+    }
+    
+    // Full nodes are split on the way down, so a split never has to travel back up the tree.
+    id key = (id)aKey;
+    NSComparator comparator = _comparator;
+    if (_root->count == _JESortedDictionaryNodeCapacity) {
+        
+        _JESortedDictionaryBranch *root = _JESortedDictionaryBranchCreate();
+        root->children[0] = _root;
+        _JESortedDictionarySplitChild(root, 0);
+        _root = &root->node;
+    }
+    
+    _JESortedDictionaryNode *node = _root;
+    while (!node->isLeaf) {
+        
+        _JESortedDictionaryBranch *branch = (_JESortedDictionaryBranch *)node;
+        NSUInteger childIndex = _JESortedDictionaryUpperBound(node, key, comparator);
+        if (branch->children[childIndex]->count == _JESortedDictionaryNodeCapacity) {
+            
+            _JESortedDictionarySplitChild(branch, childIndex);
+            if (comparator(key, (__bridge id)node->keys[childIndex]) != NSOrderedAscending) {
+                
+                ++childIndex;
+            }
+        }
+        node = branch->children[childIndex];
+    }
+    
+    _JESortedDictionaryLeaf *leaf = (_JESortedDictionaryLeaf *)node;
+    NSUInteger position = _JESortedDictionaryLowerBound(node, key, comparator);
+    if (position < node->count
+        && comparator((__bridge id)node->keys[position], key) == NSOrderedSame) {
+        
+        CFTypeRef previousObject = leaf->objects[position];
+        leaf->objects[position] = CFBridgingRetain(anObject);
+        CFRelease(previousObject);
+        return;
+    }
+    
+    NSUInteger movedCount = (node->count - position);
+    memmove(&node->keys[position + 1], &node->keys[position], (movedCount * sizeof(CFTypeRef)));
+    memmove(&leaf->objects[position + 1], &leaf->objects[position], (movedCount * sizeof(CFTypeRef)));
+    
+    // Keys are copied, same as NSMutableDictionary.
+    node->keys[position] = CFBridgingRetain([(id<NSCopying>)aKey copyWithZone:NULL]);
+    leaf->objects[position] = CFBridgingRetain(anObject);
+    ++node->count;
+    ++_count;
+    ++_mutations;
+}
+
+- (void)removeObjectForKey:(id)aKey {
+    
+    if (!aKey) {
+        
+        return;
+    }
+    
+    // Nodes at the minimum count are refilled on the way down, so a merge never has to travel back up the tree.
+    NSComparator comparator = _comparator;
+    _JESortedDictionaryNode *node = _root;
+    while (!node->isLeaf) {
+        
+        _JESortedDictionaryBranch *branch = (_JESortedDictionaryBranch *)node;
+        NSUInteger childIndex = _JESortedDictionaryUpperBound(node, aKey, comparator);
+        if (branch->children[childIndex]->count <= _JESortedDictionaryNodeMinimumCount) {
+            
+            childIndex = _JESortedDictionaryFillChild(branch, childIndex);
+        }
+        node = branch->children[childIndex];
+    }
+    
+    _JESortedDictionaryLeaf *leaf = (_JESortedDictionaryLeaf *)node;
+    NSUInteger position = _JESortedDictionaryLowerBound(node, aKey, comparator);
+    if (position < node->count
+        && comparator((__bridge id)node->keys[position], aKey) == NSOrderedSame) {
+        
+        CFTypeRef key = node->keys[position];
+        CFTypeRef object = leaf->objects[position];
+        NSUInteger movedCount = (node->count - position - 1);
+        memmove(&node->keys[position], &node->keys[position + 1], (movedCount * sizeof(CFTypeRef)));
+        memmove(&leaf->objects[position], &leaf->objects[position + 1], (movedCount * sizeof(CFTypeRef)));
+        --node->count;
+        --_count;
+        ++_mutations;
+        CFRelease(key);
+        CFRelease(object);
+    }
+    
+    // A root branch left with a single child after a merge is replaced by that child.
+    while (!_root->isLeaf && _root->count == 0) {
+        
+        _JESortedDictionaryNode *root = _root;
+        _root = ((_JESortedDictionaryBranch *)root)->children[0];
+        free(root);
+    }
+}
+
+- (void)removeAllObjects {
+    
+    _JESortedDictionaryNode *root = _root;
+    _root = &_JESortedDictionaryLeafCreate()->node;
+    _count = 0;
+    ++_mutations;
+    _JESortedDictionaryNodeRelease(root);
+}
+
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(NSZone *)zone {
+    
+    return [self mutableCopyWithZone:zone];
+}
+
+
+#pragma mark - NSMutableCopying
+
+- (instancetype)mutableCopyWithZone:(NSZone *)zone {
+    
+    typeof(self) instance = [[[self class] allocWithZone:zone] initWithComparator:_comparator];
+    [self enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+        
+        [instance setObject:obj forKey:key];
+        
+    }];
+    return instance;
+}
+
+
+#pragma mark - NSCoding
+
+- (Class)classForCoder {
+    
+    // NSMutableDictionary would otherwise archive as itself and lose the ordering of keys.
+    return [self class];
+}
+
+- (instancetype)initWithCoder:(NSCoder *)aDecoder {
+    
+    NSArray *keys = [aDecoder decodeObjectForKey:@"keys"];
+    NSArray *objects = [aDecoder decodeObjectForKey:@"objects"];
+    
+    self = [self initWithComparator:nil];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    NSUInteger count = MIN([keys count], [objects count]);
+    for (NSUInteger i = 0; i < count; ++i) {
+        
+        [self setObject:objects[i] forKey:keys[i]];
+    }
+    
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+    
+    [aCoder encodeObject:[self allKeys] forKey:@"keys"];
+    [aCoder encodeObject:[self allValues] forKey:@"objects"];
+}
+
+
+#pragma mark - Public
+
+- (instancetype)initWithComparator:(NSComparator)cmptr {
+    
+    self = [super init];
+    if (!self) {
+        
+        return nil;
+    }
+    
+    _comparator = ([cmptr copy] ?: ^NSComparisonResult(id obj1, id obj2) {
+        
+        return [obj1 compare:obj2];
+        
+    });
+    _root = &_JESortedDictionaryLeafCreate()->node;
+    
+    return self;
+}
+
+- (id)firstKey {
+    
+    _JESortedDictionaryLeaf *leaf = _JESortedDictionaryFirstLeaf(_root);
+    return (leaf->node.count > 0 ? (__bridge id)leaf->node.keys[0] : nil);
+}
+
+- (id)lastKey {
+    
+    _JESortedDictionaryLeaf *leaf = _JESortedDictionaryLastLeaf(_root);
+    return (leaf->node.count > 0 ? (__bridge id)leaf->node.keys[leaf->node.count - 1] : nil);
+}
+
+- (id)firstObject {
+    
+    _JESortedDictionaryLeaf *leaf = _JESortedDictionaryFirstLeaf(_root);
+    return (leaf->node.count > 0 ? (__bridge id)leaf->objects[0] : nil);
+}
+
+- (id)lastObject {
+    
+    _JESortedDictionaryLeaf *leaf = _JESortedDictionaryLastLeaf(_root);
+    return (leaf->node.count > 0 ? (__bridge id)leaf->objects[leaf->node.count - 1] : nil);
+}
+
+- (id)floorKeyForKey:(id)key {
+    
+    // Separators can outlive their keys, so the answer may be the last key of the previous leaf.
+    _JESortedDictionaryLeaf *leaf = _JESortedDictionaryLeafForKey(_root, key, _comparator);
+    NSUInteger position = _JESortedDictionaryUpperBound(&leaf->node, key, _comparator);
+    if (position > 0) {
+        
+        return (__bridge id)leaf->node.keys[position - 1];
+    }
+    _JESortedDictionaryLeaf *previousLeaf = leaf->previous;
+    return (previousLeaf ? (__bridge id)previousLeaf->node.keys[previousLeaf->node.count - 1] : nil);
+}
+
+- (id)ceilingKeyForKey:(id)key {
+    
+    _JESortedDictionaryLeaf *leaf = _JESortedDictionaryLeafForKey(_root, key, _comparator);
+    NSUInteger position = _JESortedDictionaryLowerBound(&leaf->node, key, _comparator);
+    if (position < leaf->node.count) {
+        
+        return (__bridge id)leaf->node.keys[position];
+    }
+    _JESortedDictionaryLeaf *nextLeaf = leaf->next;
+    return (nextLeaf ? (__bridge id)nextLeaf->node.keys[0] : nil);
+}
+
+- (NSArray *)keysInKeyRangeFromKey:(id)fromKey toKey:(id)toKey {
+    
+    NSMutableArray *keys = [[NSMutableArray alloc] init];
+    [self
+     enumerateEntriesFromKey:fromKey
+     toKey:toKey
+     usingBlock:^(CFTypeRef key, CFTypeRef object) {
+         
+         [keys addObject:(__bridge id)key];
+         
+     }];
+    return keys;
+}
+
+- (NSArray *)objectsInKeyRangeFromKey:(id)fromKey toKey:(id)toKey {
+    
+    NSMutableArray *objects = [[NSMutableArray alloc] init];
+    [self
+     enumerateEntriesFromKey:fromKey
+     toKey:toKey
+     usingBlock:^(CFTypeRef key, CFTypeRef object) {
+         
+         [objects addObject:(__bridge id)object];
+         
+     }];
+    return objects;
+}
+
+- (void)enumerateKeysAndObjectsFromKey:(id)key
+                               options:(NSEnumerationOptions)opts
+                            usingBlock:(void (^)(id key, id obj, BOOL *stop))block {
+    
+    NSComparator comparator = _comparator;
+    BOOL isReversed = ((opts & NSEnumerationReverse) != 0);
+    _JESortedDictionaryLeaf *leaf;
+    NSUInteger position;
+    if (!key) {
+        
+        leaf = (isReversed ? _JESortedDictionaryLastLeaf(_root) : _JESortedDictionaryFirstLeaf(_root));
+        position = (isReversed ? leaf->node.count : 0);
+    }
+    else {
+        
+        leaf = _JESortedDictionaryLeafForKey(_root, key, comparator);
+        position = (isReversed
+                    ? _JESortedDictionaryUpperBound(&leaf->node, key, comparator)
+                    : _JESortedDictionaryLowerBound(&leaf->node, key, comparator));
+    }
+    
+    // Going forward, position is the next entry to visit. Going backward, it is one past the next entry to visit.
+    unsigned long mutations = _mutations;
+    BOOL stop = NO;
+    while (leaf) {
+        
+        if (isReversed) {
+            
+            while (position > 0) {
+                
+                --position;
+                block((__bridge id)leaf->node.keys[position], (__bridge id)leaf->objects[position], &stop);
+                [self checkMutations:mutations];
+                if (stop) {
+                    
+                    return;
+                }
+            }
+            leaf = leaf->previous;
+            position = (leaf ? leaf->node.count : 0);
+        }
+        else {
+            
+            while (position < leaf->node.count) {
+                
+                block((__bridge id)leaf->node.keys[position], (__bridge id)leaf->objects[position], &stop);
+                [self checkMutations:mutations];
+                if (stop) {
+                    
+                    return;
+                }
+                ++position;
+            }
+            leaf = leaf->next;
+            position = 0;
+        }
+    }
+}
+
+
+#pragma mark - Private
+
+- (void)checkMutations:(unsigned long)mutations {
+    
+    // Leaves may have been freed by a mutation, so walking on would read released memory.
+    if (mutations != _mutations) {
+        
+        [NSException
+         raise:NSGenericException
+         format:@"*** Collection <%@: %p> was mutated while being enumerated.", NSStringFromClass([self class]), self];
+    }
+}
+
+- (void)enumerateEntriesFromKey:(id)fromKey
+                          toKey:(id)toKey
+                     usingBlock:(void (^)(CFTypeRef key, CFTypeRef object))block {
+    
+    NSComparator comparator = _comparator;
+    _JESortedDictionaryLeaf *leaf;
+    NSUInteger position;
+    if (fromKey) {
+        
+        leaf = _JESortedDictionaryLeafForKey(_root, fromKey, comparator);
+        position = _JESortedDictionaryLowerBound(&leaf->node, fromKey, comparator);
+    }
+    else {
+        
+        leaf = _JESortedDictionaryFirstLeaf(_root);
+        position = 0;
+    }
+    
+    while (leaf) {
+        
+        NSUInteger count = leaf->node.count;
+        
+        // Only the last leaf of the range needs its keys compared against toKey.
+        if (toKey
+            && count > 0
+            && comparator((__bridge id)leaf->node.keys[count - 1], toKey) == NSOrderedDescending) {
+            
+            count = _JESortedDictionaryUpperBound(&leaf->node, toKey, comparator);
+            for (; position < count; ++position) {
+                
+                block(leaf->node.keys[position], leaf->objects[position]);
+            }
+            return;
+        }
+        for (; position < count; ++position) {
+            
+            block(leaf->node.keys[position], leaf->objects[position]);
+        }
+        leaf = leaf->next;
+        position = 0;
+    }
+}
+
+@end
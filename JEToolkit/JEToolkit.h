@@ -71,5 +71,7 @@
 #import "JEKeychain.h"
 
 #import "JEOrderedDictionary.h"
+#import "JEConcurrentOrderedDictionary.h"
+#import "JESortedDictionary.h"
 
 #import "JEWeakCache.h"
@@ -30,8 +30,55 @@
 #import <Foundation/Foundation.h>
 #import <CoreLocation/CoreLocation.h>
 #import <MapKit/MapKit.h>
+#include <pthread.h>
 
 #import "JEToolkit.h"
+#import "JELogRingBuffer.h"
+#import "JEFileLogManifest.h"
+#import "JEFileLogReader.h"
+#import "JECallStackSymbolicator.h"
+#import "JELogRepeatSuppressor.h"
+#import "JELogStager.h"
+#import "JELogScratchPool.h"
+
+
+// libmalloc calls malloc_logger, if set, for every allocation in every zone. The allocation type bits match MALLOC_LOG_TYPE_ALLOCATE in its stack_logging.h.
+typedef void (_JEMallocLogger)(uint32_t type, uintptr_t argument1, uintptr_t argument2, uintptr_t argument3, uintptr_t result, uint32_t numberOfHotFramesToSkip);
+extern _JEMallocLogger *malloc_logger;
+static const uint32_t _JEMallocLogTypeAllocate = 2;
+
+static pthread_t _JEAllocationCountingThread;
+static volatile NSUInteger _JEAllocationCount;
+
+static void _JECountingMallocLogger(uint32_t type, uintptr_t argument1, uintptr_t argument2, uintptr_t argument3, uintptr_t result, uint32_t numberOfHotFramesToSkip) {
+    
+    if ((type & _JEMallocLogTypeAllocate) != 0 && pthread_equal(pthread_self(), _JEAllocationCountingThread)) {
+        
+        ++_JEAllocationCount;
+    }
+}
+
+static NSMutableArray *_JETestStagedValues;
+
+static void _JETestStageRecordHandler(void *record) {
+    
+    [_JETestStagedValues addObject:@(*(NSInteger *)record)];
+}
+
+/*! Counts the heap allocations made by the current thread while the block runs. Callers should also count a block known to allocate, so that a count of 0 is not mistaken for a pass if the allocator stops reporting to malloc_logger.
+ */
+static NSUInteger _JECountAllocations(void (^block)(void)) {
+    
+    _JEMallocLogger *originalLogger = malloc_logger;
+    _JEAllocationCountingThread = pthread_self();
+    _JEAllocationCount = 0;
+    malloc_logger = _JECountingMallocLogger;
+    
+    block();
+    
+    malloc_logger = originalLogger;
+    return _JEAllocationCount;
+}
 
 
 @interface JETestUserDefaults : JEUserDefaults
@@ -194,6 +241,13 @@
             error:&error]);
     JEDumpAlert(error);
     
+    // Dumped expressions run whether or not any logger accepts the level.
+    XCTAssert(error != nil);
+    NSUInteger numberOfEvaluations = 0;
+    JEDumpTrace(++numberOfEvaluations);
+    JEDumpFatal(++numberOfEvaluations);
+    XCTAssert(numberOfEvaluations == 2);
+    
     NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] init];
     dictionary[@12] = @"cccc";
     dictionary[@34] = @"gggg";
@@ -419,6 +473,1798 @@
     JEDump(weakObject);
 }
 
+- (void)testFileLogJSONLines {
+    
+    JEFileLoggerSettings *fileLoggerSettings = [JEDebugging copyFileLoggerSettings];
+    fileLoggerSettings.fileLogFormat = JEFileLogFormatJSONLines;
+    [JEDebugging setFileLoggerSettings:fileLoggerSettings];
+    
+    JELogNotice(@"JSON record with \"quotes\", \\backslashes\\,\ttabs and\nnewlines 日本語😈");
+    JEDumpAlert(@{ @"key" : @"value" });
+    
+    NSUInteger __block numberOfRecords = 0;
+    [JEDebugging enumerateFileLogDataWithBlock:^(NSString *fileName, NSData *data, BOOL *stop) {
+        
+        if (![[fileName pathExtension] isEqualToString:@"jsonl"]) {
+            
+            return;
+        }
+        
+        NSString *string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        XCTAssert(string != nil);
+        [string enumerateLinesUsingBlock:^(NSString *line, BOOL *stopLines) {
+            
+            NSDictionary *record = [NSJSONSerialization
+                                    JSONObjectWithData:[line dataUsingEncoding:NSUTF8StringEncoding]
+                                    options:kNilOptions
+                                    error:NULL];
+            XCTAssert([record isKindOfClass:[NSDictionary class]]);
+            XCTAssert([record[@"level"] isKindOfClass:[NSString class]]);
+            XCTAssert([record[@"message"] isKindOfClass:[NSString class]]);
+            XCTAssert([record[@"timestamp"] isKindOfClass:[NSString class]]);
+            ++numberOfRecords;
+        }];
+    }];
+    XCTAssert(numberOfRecords >= 2);
+    
+    fileLoggerSettings.fileLogFormat = JEFileLogFormatText;
+    [JEDebugging setFileLoggerSettings:fileLoggerSettings];
+}
+
+- (void)testLogSubscription {
+    
+    JELogFilter *filter = [[JELogFilter alloc] init];
+    filter.logLevelMask = (JELogLevelNotice | JELogLevelAlert);
+    filter.fileNamePattern = @"JEToolkitTests.m";
+    XCTAssert([filter matchesLevel:JELogLevelNotice fileName:"JEToolkitTests.m" functionName:NULL]);
+    XCTAssert(![filter matchesLevel:JELogLevelTrace fileName:"JEToolkitTests.m" functionName:NULL]);
+    XCTAssert(![filter matchesLevel:JELogLevelNotice fileName:"JEDebugging.m" functionName:NULL]);
+    XCTAssert(![filter matchesLevel:JELogLevelNotice fileName:NULL functionName:NULL]);
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"records delivered"];
+    NSMutableArray *messages = [[NSMutableArray alloc] init];
+    dispatch_queue_t queue = dispatch_queue_create("JEToolkitTests.subscription", DISPATCH_QUEUE_SERIAL);
+    JELogSubscription *subscription = [JEDebugging
+                                       subscribeWithFilter:filter
+                                       queue:queue
+                                       handler:^(NSArray *records, NSUInteger numberOfDroppedRecords) {
+                                           
+                                           for (JELogRecord *record in records) {
+                                               
+                                               XCTAssert([record.fileName isEqualToString:@"JEToolkitTests.m"]);
+                                               [messages addObject:record.message];
+                                           }
+                                           if ([messages count] == 2) {
+                                               
+                                               [expectation fulfill];
+                                           }
+                                       }];
+    
+    JELogTrace(@"filtered out");
+    JELogNotice(@"first");
+    JEDumpAlert(@"second");
+    
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    [JEDebugging unsubscribe:subscription];
+    XCTAssert(subscription.isCancelled);
+    
+    dispatch_sync(queue, ^{
+        
+        XCTAssert([messages count] == 2);
+        XCTAssert([messages[0] isEqualToString:@"first"]);
+        XCTAssert(subscription.numberOfDroppedRecords == 0);
+    });
+}
+
+- (void)testCallStackSymbolicator {
+    
+    NSArray *returnAddresses = JECallStackCaptureReturnAddresses(0);
+    XCTAssert([returnAddresses count] > 0);
+    
+    // Symbol names depend on whether the binary is stripped, but the image and address are always resolved.
+    NSArray *symbols = JECallStackSymbolsForReturnAddresses(returnAddresses);
+    NSString *imageName = [[[NSBundle bundleForClass:[self class]] executablePath] lastPathComponent];
+    NSString *address = [[NSString alloc] initWithFormat:@"0x%016llx", [returnAddresses[0] unsignedLongLongValue]];
+    XCTAssert([symbols count] == [returnAddresses count]);
+    XCTAssert([symbols[0] hasPrefix:[@"0   " stringByAppendingString:imageName]]);
+    XCTAssert([symbols[0] rangeOfString:address].location != NSNotFound);
+    
+    // Cached symbols are shared by every position the address appears at, and only the frame number changes.
+    NSArray *repeatedSymbols = JECallStackSymbolsForReturnAddresses(@[returnAddresses[1], returnAddresses[0], returnAddresses[0]]);
+    XCTAssert([[repeatedSymbols[1] substringFromIndex:4] isEqualToString:[symbols[0] substringFromIndex:4]]);
+    XCTAssert([[repeatedSymbols[2] substringFromIndex:4] isEqualToString:[symbols[0] substringFromIndex:4]]);
+    XCTAssert([repeatedSymbols[2] hasPrefix:@"2   "]);
+    XCTAssert([JECallStackSymbolsForReturnAddresses(returnAddresses) isEqualToArray:symbols]);
+    
+    NSArray *unresolvedSymbols = JECallStackSymbolsForReturnAddresses(@[@((uintptr_t)1)]);
+    XCTAssert([unresolvedSymbols[0] hasPrefix:@"0   ???"]);
+    
+    JELogRecord *record = [[JELogRecord alloc]
+                           initWithLevel:JELogLevelAlert
+                           date:[NSDate date]
+                           fileName:nil
+                           functionName:nil
+                           lineNumber:0
+                           message:@"message"
+                           dump:nil
+                           callStackReturnAddresses:returnAddresses];
+    XCTAssert([[record callStackSymbols] isEqualToArray:symbols]);
+}
+
+- (void)testLogRepeatSuppressor {
+    
+    JELogRepeatSuppressor *suppressor = [[JELogRepeatSuppressor alloc] init];
+    NSString *summary;
+    XCTAssert(![suppressor shouldSuppressMessageWithKey:1 message:@"a" level:JELogLevelAlert bulletString:@"!" timestamp:10 interval:1 summary:&summary]);
+    XCTAssert(summary == nil);
+    
+    for (NSInteger i = 0; i < 5; ++i) {
+        
+        XCTAssert([suppressor shouldSuppressMessageWithKey:1 message:@"a" level:JELogLevelAlert bulletString:@"!" timestamp:(10.0 + (i * 0.1)) interval:1 summary:&summary]);
+    }
+    XCTAssert(suppressor.numberOfRepeats == 5);
+    
+    XCTAssert(![suppressor shouldSuppressMessageWithKey:1 message:@"b" level:JELogLevelNotice bulletString:@"-" timestamp:10.5 interval:1 summary:&summary]);
+    XCTAssert([summary isEqualToString:@"Last message repeated 5 times over 400 ms"]);
+    XCTAssert(suppressor.numberOfRepeats == 0);
+    
+    XCTAssert([suppressor shouldSuppressMessageWithKey:1 message:@"b" level:JELogLevelNotice bulletString:@"-" timestamp:10.6 interval:1 summary:&summary]);
+    XCTAssert([suppressor summaryIfExpiredAtTimestamp:11.0 interval:1] == nil);
+    XCTAssert([[suppressor summaryIfExpiredAtTimestamp:11.5 interval:1] isEqualToString:@"Last message repeated 1 time over 100 ms"]);
+    XCTAssert(![suppressor shouldSuppressMessageWithKey:1 message:@"b" level:JELogLevelNotice bulletString:@"-" timestamp:11.6 interval:1 summary:&summary]);
+    XCTAssert(summary == nil);
+    
+    XCTAssert(![suppressor shouldSuppressMessageWithKey:1 message:@"b" level:JELogLevelNotice bulletString:@"-" timestamp:11.7 interval:0 summary:&summary]);
+}
+
+- (void)testLogC {
+    
+    unsigned int token = arc4random();
+    JELogCNotice("C message %u %s", token, "日本語😈");
+    JELogCAlert("C object message %u %@", token, @"object");
+    JELogCAlert("C positional message %2$@ %1$u", token, @"object");
+    JELogCTrace("C trace message %u", token);
+    JELogC(JELogCLevelNotice | JELogCSignalSafe, "C signal-safe message %u %s", token, "signal");
+    JELogC(JELogCLevelNotice | JELogCSignalSafe, "C signal-safe float message %u %.1f", token, 1.5);
+    
+    NSUInteger __block numberOfRecords = 0;
+    NSString *prefix = [NSString stringWithFormat:@"C message %u 日本語😈", token];
+    NSString *objectPrefix = [NSString stringWithFormat:@"C object message %u object", token];
+    NSString *positionalPrefix = [NSString stringWithFormat:@"C positional message object %u", token];
+    NSString *tracePrefix = [NSString stringWithFormat:@"C trace message %u", token];
+    NSString *signalSafePrefix = [NSString stringWithFormat:@"C signal-safe message %u signal", token];
+    NSUInteger __block numberOfUnformattedRecords = 0;
+    [JEDebugging enumerateFileLogRecordsWithBlock:^(NSString *fileName, NSDate *date, NSData *record, BOOL *stop) {
+        
+        NSString *string = [[NSString alloc] initWithData:record encoding:NSUTF8StringEncoding];
+        XCTAssert([string rangeOfString:tracePrefix].location == NSNotFound);
+        if ([string rangeOfString:prefix].location != NSNotFound
+            || [string rangeOfString:objectPrefix].location != NSNotFound
+            || [string rangeOfString:positionalPrefix].location != NSNotFound) {
+            
+            XCTAssert([string rangeOfString:@"JEToolkitTests.m"].location != NSNotFound);
+            ++numberOfRecords;
+        }
+        if ([string rangeOfString:signalSafePrefix].location != NSNotFound) {
+            
+            ++numberOfRecords;
+        }
+        if ([string rangeOfString:@"C signal-safe float message %u %.1f"].location != NSNotFound) {
+            
+            ++numberOfUnformattedRecords;
+        }
+    }];
+    XCTAssert(numberOfRecords == 4);
+    XCTAssert(numberOfUnformattedRecords > 0);
+}
+
+- (void)testLogCPerformance {
+    
+    // Batches stay under the size of the JELogC() ring, so no message is dropped while the loggers catch up.
+    static const NSUInteger numberOfMessages = 100;
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < numberOfMessages; ++i) {
+        
+        JELogNotice(@"Loaded %s in %.2f ms (%lu items)", "view", 1.5, (unsigned long)i);
+    }
+    CFAbsoluteTime objectDuration = (CFAbsoluteTimeGetCurrent() - startTime);
+    [JEDebugging enumerateFileLogURLsWithBlock:^(NSURL *fileURL, BOOL *stop) {
+        
+        (*stop) = YES;
+    }];
+    
+    startTime = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < numberOfMessages; ++i) {
+        
+        JELogCNotice("Loaded %s in %.2f ms (%lu items)", "view", 1.5, (unsigned long)i);
+    }
+    CFAbsoluteTime CDuration = (CFAbsoluteTimeGetCurrent() - startTime);
+    XCTAssert(CDuration < objectDuration, @"JELogC: %.3f ms, JELog: %.3f ms", (CDuration * 1000), (objectDuration * 1000));
+    
+    [self measureBlock:^{
+        
+        for (NSUInteger i = 0; i < numberOfMessages; ++i) {
+            
+            JELogCNotice("Loaded %s in %.2f ms (%lu items)", "view", 1.5, (unsigned long)i);
+        }
+        [JEDebugging enumerateFileLogURLsWithBlock:^(NSURL *fileURL, BOOL *stop) {
+            
+            (*stop) = YES;
+        }];
+    }];
+}
+
+- (void)testLogLevelOverride {
+    
+    JEFileLoggerSettings *fileLoggerSettings = [JEDebugging copyFileLoggerSettings];
+    JEFileLoggerSettings *originalSettings = [fileLoggerSettings copy];
+    fileLoggerSettings.logLevelMask = (JELogLevelNotice | JELogLevelAlert | JELogLevelFatal);
+    fileLoggerSettings.logLevelOverrides = @[ [[JELogLevelOverride alloc]
+                                               initWithFileNamePattern:@"JEToolkit*.m"
+                                               functionNamePrefix:@"-[JEToolkitTests testLogLevelOverride"
+                                               logLevelMask:JELogLevelAll] ];
+    XCTAssert([fileLoggerSettings logLevelMaskForFileName:"JEToolkitTests.m" functionName:__PRETTY_FUNCTION__] == JELogLevelAll);
+    XCTAssert([fileLoggerSettings logLevelMaskForFileName:"JEToolkitTests.m" functionName:"-[JEToolkitTests testDumps]"] == fileLoggerSettings.logLevelMask);
+    XCTAssert([fileLoggerSettings logLevelMaskForFileName:NULL functionName:NULL] == fileLoggerSettings.logLevelMask);
+    XCTAssert([[fileLoggerSettings copy] logLevelOverrides] == fileLoggerSettings.logLevelOverrides);
+    
+    unsigned int token = arc4random();
+    NSString *beforeOverride = [NSString stringWithFormat:@"Trace before override %u", token];
+    NSString *withOverride = [NSString stringWithFormat:@"Trace with override %u", token];
+    for (NSUInteger i = 0; i < 2; ++i) {
+        
+        // The same callsite is re-evaluated after the settings change.
+        JELogTrace(@"%@", (i == 0 ? beforeOverride : withOverride));
+        if (i == 0) {
+            
+            [JEDebugging setFileLoggerSettings:fileLoggerSettings];
+        }
+    }
+    
+    NSUInteger __block numberOfBeforeRecords = 0;
+    NSUInteger __block numberOfWithRecords = 0;
+    [JEDebugging enumerateFileLogRecordsWithBlock:^(NSString *fileName, NSDate *date, NSData *record, BOOL *stop) {
+        
+        NSString *string = [[NSString alloc] initWithData:record encoding:NSUTF8StringEncoding];
+        if ([string rangeOfString:beforeOverride].location != NSNotFound) {
+            
+            ++numberOfBeforeRecords;
+        }
+        if ([string rangeOfString:withOverride].location != NSNotFound) {
+            
+            ++numberOfWithRecords;
+        }
+    }];
+    XCTAssert(numberOfBeforeRecords == (JEEnumBitmasked(originalSettings.logLevelMask, JELogLevelTrace) ? 1 : 0));
+    XCTAssert(numberOfWithRecords == 1);
+    
+    static JELogCallsite callsite = 0;
+    XCTAssert(JELogCallsiteIsEnabled(&callsite, JELogLevelTrace, "JEToolkitTests.m", __PRETTY_FUNCTION__));
+    JELogCallsite state = callsite;
+    XCTAssert(JELogCallsiteIsEnabled(&callsite, JELogLevelTrace, "JEToolkitTests.m", __PRETTY_FUNCTION__));
+    XCTAssert(callsite == state);
+    XCTAssert(JEEnumBitmasked((JELogLevelMask)((state >> 24) & JELogCallsiteEnabledLevelsMask), JELogLevelTrace));
+    
+    // Assertion failures match level overrides the same way as regular messages.
+    fileLoggerSettings.logLevelMask = JELogLevelFatal;
+    [JEDebugging setFileLoggerSettings:fileLoggerSettings];
+    NSString *assertionWithOverride = [NSString stringWithFormat:@"Assertion with override %u", token];
+    NSString *assertionWithoutOverride = [NSString stringWithFormat:@"Assertion without override %u", token];
+    [JEDebugging
+     logFailureInAssertionWithMessage:assertionWithOverride
+     location:JELogLocationCurrent()];
+    [JEDebugging
+     logFailureInAssertionWithMessage:assertionWithoutOverride
+     location:(JELogLocation){ "JEToolkitTests.m", "-[JEToolkitTests testDumps]", __LINE__ }];
+    
+    NSUInteger __block numberOfAssertionWithRecords = 0;
+    NSUInteger __block numberOfAssertionWithoutRecords = 0;
+    [JEDebugging enumerateFileLogRecordsWithBlock:^(NSString *fileName, NSDate *date, NSData *record, BOOL *stop) {
+        
+        NSString *string = [[NSString alloc] initWithData:record encoding:NSUTF8StringEncoding];
+        if ([string rangeOfString:assertionWithOverride].location != NSNotFound) {
+            
+            ++numberOfAssertionWithRecords;
+        }
+        if ([string rangeOfString:assertionWithoutOverride].location != NSNotFound) {
+            
+            ++numberOfAssertionWithoutRecords;
+        }
+    }];
+    XCTAssert(numberOfAssertionWithRecords == 1);
+    XCTAssert(numberOfAssertionWithoutRecords == 0);
+    
+    [JEDebugging setFileLoggerSettings:originalSettings];
+}
+
+- (void)testLogThrottle {
+    
+    JELogSampler sampler = { 0 };
+    unsigned long numberOfSuppressedCalls = 0;
+    NSUInteger numberOfLoggedCalls = 0;
+    for (NSUInteger i = 0; i < 250; ++i) {
+        
+        if (JELogSamplerShouldLog(&sampler, 100, &numberOfSuppressedCalls)) {
+            
+            ++numberOfLoggedCalls;
+            XCTAssert(numberOfSuppressedCalls == (numberOfLoggedCalls == 1 ? 0 : 99));
+        }
+    }
+    XCTAssert(numberOfLoggedCalls == 3);
+    
+    JELogRateLimiter rateLimiter = { 0, 0 };
+    numberOfLoggedCalls = 0;
+    for (NSUInteger i = 0; i < 1000; ++i) {
+        
+        if (JELogRateLimiterShouldLog(&rateLimiter, 10, &numberOfSuppressedCalls)) {
+            
+            ++numberOfLoggedCalls;
+        }
+    }
+    XCTAssert(numberOfLoggedCalls >= 10 && numberOfLoggedCalls <= 11);
+    
+    [NSThread sleepForTimeInterval:0.2];
+    XCTAssert(JELogRateLimiterShouldLog(&rateLimiter, 10, &numberOfSuppressedCalls));
+    XCTAssert(numberOfSuppressedCalls == (1000 - numberOfLoggedCalls));
+    
+    XCTAssertEqualObjects(JELogMessageWithSuppressedCalls(@"message", 0), @"message");
+    XCTAssertEqualObjects(JELogMessageWithSuppressedCalls(@"message", 1), @"message (1 similar call suppressed)");
+    XCTAssertEqualObjects(JELogMessageWithSuppressedCalls(@"message", 2), @"message (2 similar calls suppressed)");
+    
+    for (NSUInteger i = 0; i < 5; ++i) {
+        
+        JELogNoticeSampled(2, @"Sampled call %lu", (unsigned long)i);
+        JELogAlertRateLimited(1, @"Rate limited call %lu", (unsigned long)i);
+    }
+}
+
+- (void)testLogFormat {
+    
+    static void *callsiteCache = NULL;
+    NSString *(^format)(NSInteger) = ^NSString *(NSInteger value) {
+        
+        return JELogFormatWithCallsiteCache(&callsiteCache,
+                                            @"%@ %d%% %-5ld|%05.2f %*s %.*s %c %C %llu %zu %p %x %S",
+                                            @"object", (int)value, (long)value, (double)value / 3.0,
+                                            6, "abc", 2, "abc", 'z', (unichar)0x65E5,
+                                            (unsigned long long)value, (size_t)value, (void *)0x10, (unsigned int)value,
+                                            (const unichar *)u"日本");
+    };
+    for (NSInteger value = 0; value < 3; ++value) {
+        
+        NSString *expected = [[NSString alloc]
+                              initWithFormat:@"%@ %d%% %-5ld|%05.2f %*s %.*s %c %C %llu %zu %p %x %S",
+                              @"object", (int)value, (long)value, (double)value / 3.0,
+                              6, "abc", 2, "abc", 'z', (unichar)0x65E5,
+                              (unsigned long long)value, (size_t)value, (void *)0x10, (unsigned int)value,
+                              (const unichar *)u"日本"];
+        XCTAssertEqualObjects(format(value), expected);
+    }
+    XCTAssert(callsiteCache != NULL);
+    
+    // A different format string at the same callsite is still formatted correctly.
+    XCTAssertEqualObjects(JELogFormatWithCallsiteCache(&callsiteCache, @"%d-%@", 1, nil), @"1-(null)");
+    
+    // Positional arguments are left to Foundation.
+    static void *positionalCache = NULL;
+    XCTAssertEqualObjects(JELogFormatWithCallsiteCache(&positionalCache, @"%2$@ %1$@", @"a", @"b"), @"b a");
+}
+
+- (void)testLogFormatPerformance {
+    
+    [self measureBlock:^{
+        
+        for (NSUInteger i = 0; i < 100000; ++i) {
+            
+            static void *callsiteCache = NULL;
+            NSString *message = JELogFormatWithCallsiteCache(&callsiteCache, @"Loaded %@ in %.2f ms (%lu items)", @"view", 1.5, (unsigned long)i);
+            XCTAssert(message != nil);
+        }
+    }];
+}
+
+- (void)testLogStager {
+    
+    dispatch_queue_t queue = dispatch_queue_create("JEToolkitTests.stager", DISPATCH_QUEUE_SERIAL);
+    JELogStager *stager = [[JELogStager alloc]
+                           initWithQueue:queue
+                           isBarrier:NO
+                           maximumNumberOfBlocks:4
+                           maximumLatency:60];
+    NSMutableArray *values = [[NSMutableArray alloc] init];
+    void (^stageValue)(NSInteger, BOOL) = ^(NSInteger value, BOOL flushImmediately) {
+        
+        [stager stageBlock:^{
+            
+            [values addObject:@(value)];
+        } flushImmediately:flushImmediately];
+    };
+    
+    for (NSInteger i = 0; i < 3; ++i) {
+        
+        stageValue(i, NO);
+    }
+    dispatch_sync(queue, ^{
+        
+        XCTAssert([values count] == 0);
+    });
+    
+    stageValue(3, NO);
+    dispatch_sync(queue, ^{
+        
+        XCTAssert([values isEqualToArray:(@[ @0, @1, @2, @3 ])]);
+    });
+    
+    stageValue(4, NO);
+    [stager flushAllThreads];
+    dispatch_sync(queue, ^{
+        
+        XCTAssert([values count] == 5);
+    });
+    
+    stageValue(5, NO);
+    stageValue(6, YES);
+    dispatch_sync(queue, ^{
+        
+        XCTAssert([values isEqualToArray:(@[ @0, @1, @2, @3, @4, @5, @6 ])]);
+    });
+    
+    // Records run in staging order with blocks, and the handler gets its own copy.
+    _JETestStagedValues = values;
+    for (NSInteger i = 7; i < 10; ++i) {
+        
+        NSInteger value = i;
+        [stager
+         stageRecord:&value
+         length:sizeof(value)
+         handler:_JETestStageRecordHandler
+         flushImmediately:NO];
+        value = -1;
+        if (i == 8) {
+            
+            stageValue(100, NO);
+        }
+    }
+    [stager flushAllThreads];
+    dispatch_sync(queue, ^{
+        
+        XCTAssert([values isEqualToArray:(@[ @0, @1, @2, @3, @4, @5, @6, @7, @8, @100, @9 ])]);
+    });
+    _JETestStagedValues = nil;
+}
+
+- (void)testMetrics {
+    
+    [JEMetricSnapshot collectSnapshot];
+    
+    for (NSInteger i = 0; i < 10; ++i) {
+        
+        JEMetricIncrement("test.counter");
+    }
+    dispatch_queue_t queue = dispatch_queue_create("JEToolkitTests.metrics", DISPATCH_QUEUE_SERIAL);
+    dispatch_sync(queue, ^{
+        
+        JEMetricIncrementBy("test.counter", 5);
+    });
+    JEMetricGauge("test.gauge", 2.5);
+    
+    JEMetricSnapshot *snapshot = [JEMetricSnapshot collectSnapshot];
+    XCTAssert([snapshot.counterChanges[@"test.counter"] longLongValue] == 15);
+    XCTAssert([snapshot.counters[@"test.counter"] longLongValue] >= 15);
+    XCTAssert([snapshot.gauges[@"test.gauge"] doubleValue] == 2.5);
+    
+    JEMetricSnapshot *nextSnapshot = [JEMetricSnapshot collectSnapshot];
+    XCTAssert(nextSnapshot.counterChanges[@"test.counter"] == nil);
+    XCTAssert([nextSnapshot.counters[@"test.counter"] isEqual:snapshot.counters[@"test.counter"]]);
+    
+    NSURL *fileURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:@"JEToolkitTests.prom"];
+    JEPrometheusMetricExporter *exporter = [[JEPrometheusMetricExporter alloc] initWithFileURL:fileURL];
+    [exporter exportMetricSnapshot:snapshot];
+    NSString *text = [[NSString alloc] initWithContentsOfURL:fileURL encoding:NSUTF8StringEncoding error:NULL];
+    XCTAssert([text rangeOfString:@"# TYPE test_counter counter\n"].location != NSNotFound);
+    XCTAssert([text rangeOfString:@"# TYPE test_gauge gauge\n"].location != NSNotFound);
+    [[NSFileManager defaultManager] removeItemAtURL:fileURL error:NULL];
+}
+
+- (void)testLogScratchPool {
+    
+    NSMutableData *buffer = JELogScratchBufferAcquire();
+    JELogScratchBufferAppendString(buffer, @"2014-01-01 00:00:00.000 ");
+    JELogScratchBufferAppendString(buffer, @"héllo wörld");
+    JELogScratchBufferAppendUTF8String(buffer, "\n\n");
+    XCTAssert([[[NSString alloc] initWithData:buffer encoding:NSUTF8StringEncoding]
+               isEqualToString:@"2014-01-01 00:00:00.000 héllo wörld\n\n"]);
+    JELogScratchBufferRelinquish(buffer);
+    
+    NSMutableData *reusedBuffer = JELogScratchBufferAcquire();
+    XCTAssert(reusedBuffer == buffer);
+    XCTAssert([reusedBuffer length] == 0);
+    JELogScratchBufferRelinquish(reusedBuffer);
+    
+    NSString *header = @"2014-01-01 00:00:00.000 [main] JEToolkitTests.m:100 -[JEToolkitTests testLogScratchPool] \n";
+    NSString *message = [[NSString alloc] initWithFormat:@"héllo wörld %d", 42];
+    static const NSUInteger numberOfRecords = 1000;
+    NSMutableArray *controlObjects = [[NSMutableArray alloc] initWithCapacity:numberOfRecords];
+    NSUInteger numberOfControlAllocations = _JECountAllocations(^{
+        
+        for (NSUInteger i = 0; i < numberOfRecords; ++i) {
+            
+            [controlObjects addObject:[[NSObject alloc] init]];
+        }
+    });
+    XCTAssert(numberOfControlAllocations >= numberOfRecords, @"%lu allocations counted for %lu objects", (unsigned long)numberOfControlAllocations, (unsigned long)numberOfRecords);
+    
+    NSUInteger numberOfAllocations = _JECountAllocations(^{
+        
+        for (NSUInteger i = 0; i < numberOfRecords; ++i) {
+            
+            NSMutableData *recordBuffer = JELogScratchBufferAcquire();
+            JELogScratchBufferAppendString(recordBuffer, header);
+            JELogScratchBufferAppendUTF8String(recordBuffer, "🔸 ");
+            JELogScratchBufferAppendString(recordBuffer, message);
+            JELogScratchBufferAppendUTF8String(recordBuffer, "\n\n");
+            JELogScratchBufferRelinquish(recordBuffer);
+        }
+    });
+    XCTAssert(numberOfAllocations < (numberOfRecords / 100), @"%lu allocations for %lu records", (unsigned long)numberOfAllocations, (unsigned long)numberOfRecords);
+    
+    JEFileLoggerSettings *fileLoggerSettings = [JEDebugging copyFileLoggerSettings];
+    JEFileLoggerSettings *originalSettings = [fileLoggerSettings copy];
+    fileLoggerSettings.logLevelMask = JELogLevelAll;
+    fileLoggerSettings.fileLogFormat = JEFileLogFormatText;
+    fileLoggerSettings.repeatedMessageSuppressionInterval = 0;
+    [JEDebugging setFileLoggerSettings:fileLoggerSettings];
+    
+    // Formatting the message is the caller's cost, so only what JELogNotice() allocates on top of it counts against the logger.
+    void (^logRecords)(NSUInteger) = ^(NSUInteger count) {
+        
+        for (NSUInteger i = 0; i < count; ++i) {
+            
+            JELogNotice(@"Scratch pool record %lu", (unsigned long)i);
+        }
+    };
+    void (^formatRecords)(NSUInteger) = ^(NSUInteger count) {
+        
+        static void *formatCache = NULL;
+        for (NSUInteger i = 0; i < count; ++i) {
+            
+            @autoreleasepool {
+                
+                (void)JELogFormatWithCallsiteCache(&formatCache, @"Scratch pool record %lu", (unsigned long)i);
+            }
+        }
+    };
+    logRecords(100);
+    formatRecords(100);
+    [JEDebugging flushStagedFileLogRecords];
+    
+    NSUInteger numberOfFormatAllocations = _JECountAllocations(^{
+        
+        formatRecords(numberOfRecords);
+    });
+    NSUInteger numberOfLogAllocations = _JECountAllocations(^{
+        
+        logRecords(numberOfRecords);
+    });
+    [JEDebugging flushStagedFileLogRecords];
+    [JEDebugging setFileLoggerSettings:originalSettings];
+    
+    // Batches are still handed off as blocks, which is amortized over many records.
+    XCTAssert(numberOfLogAllocations < (numberOfFormatAllocations + (numberOfRecords / 4)),
+              @"%lu allocations for %lu logged records, %lu for formatting alone",
+              (unsigned long)numberOfLogAllocations,
+              (unsigned long)numberOfRecords,
+              (unsigned long)numberOfFormatAllocations);
+}
+
+- (void)testLogRingBuffer {
+    
+    JELogRingBuffer *ringBuffer = [[JELogRingBuffer alloc] initWithCapacity:3];
+    XCTAssert([[ringBuffer snapshot] count] == 0);
+    
+    [ringBuffer addObject:@1];
+    [ringBuffer addObject:@2];
+    NSArray *snapshot = [ringBuffer snapshot];
+    XCTAssert([snapshot isEqualToArray:(@[ @1, @2 ])]);
+    XCTAssert([ringBuffer snapshot] == snapshot);
+    
+    for (NSInteger i = 3; i <= 10; ++i) {
+        
+        [ringBuffer addObject:@(i)];
+    }
+    XCTAssert(ringBuffer.count == 3);
+    XCTAssert([[ringBuffer snapshot] isEqualToArray:(@[ @8, @9, @10 ])]);
+    XCTAssert([snapshot isEqualToArray:(@[ @1, @2 ])]);
+    
+    ringBuffer.capacity = 2;
+    XCTAssert([[ringBuffer snapshot] isEqualToArray:(@[ @9, @10 ])]);
+    
+    [ringBuffer removeAllObjects];
+    XCTAssert(ringBuffer.count == 0);
+    XCTAssert([snapshot isEqualToArray:(@[ @1, @2 ])]);
+}
+
+- (void)testLogRingBufferPerformance {
+    
+    NSString *logString = @"Log entry";
+    [self measureBlock:^{
+        
+        JELogRingBuffer *ringBuffer = [[JELogRingBuffer alloc] initWithCapacity:200];
+        NSArray *displayedSnapshot;
+        for (NSUInteger i = 0; i < 100000; ++i) {
+            
+            [ringBuffer addObject:logString];
+            if ((i % 100) == 0) {
+                
+                displayedSnapshot = [ringBuffer snapshot];
+            }
+        }
+        XCTAssert([displayedSnapshot count] == 200);
+    }];
+}
+
+- (void)testFileLogManifest {
+    
+    NSURL *directoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES]
+                           URLByAppendingPathComponent:[[NSUUID UUID] UUIDString]
+                           isDirectory:YES];
+    XCTAssert([[NSFileManager defaultManager] createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:NULL]);
+    
+    JEFileLogManifest *manifest = [[JEFileLogManifest alloc] initWithDirectoryURL:directoryURL];
+    XCTAssert(![manifest loadWithError:NULL]);
+    
+    for (NSString *fileName in @[@"log 2014-01-01.log", @"log 2014-01-02.log", @"log 2014-01-03.log"]) {
+        
+        XCTAssert([[NSData data] writeToURL:[directoryURL URLByAppendingPathComponent:fileName] atomically:YES]);
+    }
+    
+    JEFileLogSegment *olderSegment = [manifest addSegmentWithFileName:@"log 2014-01-01.log"];
+    JEFileLogSegment *newerSegment = [manifest addSegmentWithFileName:@"log 2014-01-02.log"];
+    JEFileLogSegment *missingSegment = [manifest addSegmentWithFileName:@"log 2014-01-03.log"];
+    XCTAssert([manifest addSegmentWithFileName:@"log 2014-01-01.log"] == olderSegment);
+    
+    [manifest recordAppendedToSegment:newerSegment length:10 timestamp:200];
+    [manifest recordAppendedToSegment:newerSegment length:5 timestamp:100];
+    XCTAssert(newerSegment.fileSize == 15);
+    XCTAssert(newerSegment.numberOfRecords == 2);
+    XCTAssert(newerSegment.firstTimestamp == 100);
+    XCTAssert(newerSegment.lastTimestamp == 200);
+    
+    // File names sort the other way around; the manifest must order by record time.
+    [manifest recordAppendedToSegment:olderSegment length:1 timestamp:300];
+    [manifest recordAppendedToSegment:missingSegment length:1 timestamp:400];
+    XCTAssert([manifest synchronizeWithError:NULL]);
+    XCTAssert([[NSFileManager defaultManager] removeItemAtURL:[directoryURL URLByAppendingPathComponent:@"log 2014-01-03.log"] error:NULL]);
+    
+    JEFileLogManifest *loadedManifest = [[JEFileLogManifest alloc] initWithDirectoryURL:directoryURL];
+    XCTAssert([loadedManifest loadWithError:NULL]);
+    XCTAssert([loadedManifest segmentWithFileName:@"log 2014-01-03.log"] == nil);
+    NSArray *segments = [loadedManifest segments];
+    XCTAssert([segments count] == 2);
+    XCTAssert([[segments[0] fileName] isEqualToString:@"log 2014-01-01.log"]);
+    XCTAssert([[segments[1] fileName] isEqualToString:@"log 2014-01-02.log"]);
+    XCTAssert([segments[1] fileSize] == 15);
+    XCTAssert([segments[1] numberOfRecords] == 2);
+    XCTAssert([segments[1] lastTimestamp] == 200);
+    
+    [loadedManifest removeSegment:[loadedManifest segmentWithFileName:@"log 2014-01-01.log"]];
+    XCTAssert([loadedManifest synchronizeWithError:NULL]);
+    XCTAssert([manifest loadWithError:NULL]);
+    XCTAssert([[manifest segments] count] == 1);
+    XCTAssert([manifest segmentWithFileName:@"log 2014-01-01.log"] == nil);
+    
+    // Saves from other instances are picked up, while an unchanged manifest is not read again (which would drop the segment of the deleted file).
+    [loadedManifest recordAppendedToSegment:[loadedManifest segmentWithFileName:@"log 2014-01-02.log"] length:1 timestamp:500];
+    XCTAssert([loadedManifest synchronizeWithError:NULL]);
+    XCTAssert([manifest loadIfModifiedWithError:NULL]);
+    XCTAssert([manifest segmentWithFileName:@"log 2014-01-02.log"].numberOfRecords == 3);
+    XCTAssert([[NSFileManager defaultManager] removeItemAtURL:[directoryURL URLByAppendingPathComponent:@"log 2014-01-02.log"] error:NULL]);
+    XCTAssert([manifest loadIfModifiedWithError:NULL]);
+    XCTAssert([manifest segmentWithFileName:@"log 2014-01-02.log"] != nil);
+    XCTAssert([manifest loadWithError:NULL]);
+    XCTAssert([manifest segmentWithFileName:@"log 2014-01-02.log"] == nil);
+    
+    // Instances saving at the same time, as separate processes would, must not drop each other's segments.
+    __block BOOL isSynchronized = YES;
+    dispatch_apply(4, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t writer) {
+        
+        JEFileLogManifest *writerManifest = [[JEFileLogManifest alloc] initWithDirectoryURL:directoryURL];
+        for (NSUInteger i = 0; i < 25; ++i) {
+            
+            NSString *fileName = [NSString stringWithFormat:@"log writer%lu-%lu.log", (unsigned long)writer, (unsigned long)i];
+            BOOL isSaved = [[NSData data] writeToURL:[directoryURL URLByAppendingPathComponent:fileName] atomically:YES];
+            [writerManifest recordAppendedToSegment:[writerManifest addSegmentWithFileName:fileName] length:1 timestamp:(1000 + i)];
+            isSaved = (isSaved && [writerManifest synchronizeWithError:NULL]);
+            if (!isSaved) {
+                
+                __atomic_store_n(&isSynchronized, NO, __ATOMIC_RELAXED);
+            }
+        }
+    });
+    XCTAssert(isSynchronized);
+    JEFileLogManifest *mergedManifest = [[JEFileLogManifest alloc] initWithDirectoryURL:directoryURL];
+    XCTAssert([mergedManifest loadWithError:NULL]);
+    XCTAssert([[mergedManifest segments] count] == 100);
+    
+    [[NSFileManager defaultManager] removeItemAtURL:directoryURL error:NULL];
+}
+
+- (void)testFileLogReader {
+    
+    NSURL *directoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES]
+                           URLByAppendingPathComponent:[[NSUUID UUID] UUIDString]
+                           isDirectory:YES];
+    XCTAssert([[NSFileManager defaultManager] createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:NULL]);
+    
+    NSURL *textFileURL = [directoryURL URLByAppendingPathComponent:@"app 2014-01-01 [1].log"];
+    NSURL *JSONFileURL = [directoryURL URLByAppendingPathComponent:@"app 2014-01-01 [2].jsonl"];
+    XCTAssert([[@"2014-01-01 00:00:00.000 \nfirst\n\ncontinued\n\n2014-01-01 00:00:02.000 \nthird\n\n"
+                dataUsingEncoding:NSUTF8StringEncoding] writeToURL:textFileURL atomically:YES]);
+    XCTAssert([[@"{\"timestamp\":\"2014-01-01T00:00:01.000Z\",\"message\":\"second\"}\n{\"timestamp\":\"2014-01-01T00:00:03.500Z\",\"message\":\"fourth\"}\n"
+                dataUsingEncoding:NSUTF8StringEncoding] writeToURL:JSONFileURL atomically:YES]);
+    
+    NSMutableArray *records = [[NSMutableArray alloc] init];
+    NSMutableArray *timestamps = [[NSMutableArray alloc] init];
+    JEFileLogReader *reader = [[JEFileLogReader alloc] initWithFileURLs:@[ JSONFileURL, textFileURL ]];
+    [reader enumerateRecordsWithBlock:^(NSString *fileName, NSTimeInterval timestamp, NSData *record, BOOL *stop) {
+        
+        [records addObject:[[NSString alloc] initWithData:record encoding:NSUTF8StringEncoding]];
+        [timestamps addObject:@(timestamp)];
+    }];
+    
+    XCTAssert([records count] == 5);
+    XCTAssert([records[0] hasSuffix:@"first"]);
+    XCTAssert([records[1] isEqualToString:@"continued"]);
+    XCTAssert([records[2] hasSuffix:@"\"second\"}"]);
+    XCTAssert([records[3] hasSuffix:@"third"]);
+    XCTAssert([records[4] hasSuffix:@"\"fourth\"}"]);
+    XCTAssert([timestamps[0] doubleValue] == 1388534400.0);
+    XCTAssert([timestamps[4] doubleValue] == 1388534403.5);
+    
+    // Stopping early waits for read-ahead, so the transform never runs after the enumeration returns.
+    NSURL *longFileURL = [directoryURL URLByAppendingPathComponent:@"app 2014-01-02 [1].log"];
+    NSMutableString *longFile = [[NSMutableString alloc] init];
+    for (NSUInteger i = 0; i < 10000; ++i) {
+        
+        [longFile appendFormat:@"2014-01-02 00:00:00.000 \nrecord %lu\n\n", (unsigned long)i];
+    }
+    XCTAssert([[longFile dataUsingEncoding:NSUTF8StringEncoding] writeToURL:longFileURL atomically:YES]);
+    NSUInteger __block numberOfTransforms = 0;
+    [[[JEFileLogReader alloc] initWithFileURLs:@[ longFileURL, textFileURL ]]
+     enumerateRecordsWithTransform:^id(NSString *fileName, NSTimeInterval timestamp, NSData *record) {
+         
+         __atomic_fetch_add(&numberOfTransforms, 1, __ATOMIC_RELAXED);
+         usleep(100);
+         return record;
+     }
+     usingBlock:^(NSString *fileName, NSTimeInterval timestamp, id object, BOOL *stop) {
+         
+         (*stop) = YES;
+     }];
+    NSUInteger numberOfTransformsOnReturn = __atomic_load_n(&numberOfTransforms, __ATOMIC_RELAXED);
+    [NSThread sleepForTimeInterval:0.1];
+    XCTAssert(__atomic_load_n(&numberOfTransforms, __ATOMIC_RELAXED) == numberOfTransformsOnReturn);
+    XCTAssert(numberOfTransformsOnReturn < 10000);
+    
+    [[NSFileManager defaultManager] removeItemAtURL:directoryURL error:NULL];
+}
+
+- (void)testFileLogQuery {
+    
+    NSURL *directoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES]
+                           URLByAppendingPathComponent:[[NSUUID UUID] UUIDString]
+                           isDirectory:YES];
+    XCTAssert([[NSFileManager defaultManager] createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:NULL]);
+    
+    NSURL *textFileURL = [directoryURL URLByAppendingPathComponent:@"app 2014-01-01 [1].log"];
+    NSURL *JSONFileURL = [directoryURL URLByAppendingPathComponent:@"app 2014-01-01 [2].jsonl"];
+    XCTAssert([[@"2014-01-01 00:00:00.000 [main] A.m:10 -[A a] \n🔸 first\n\n2014-01-01 00:00:02.000 B.m:5 \n⚠️ third\n  ↪︎ dumped value\n\n"
+                dataUsingEncoding:NSUTF8StringEncoding] writeToURL:textFileURL atomically:YES]);
+    XCTAssert([[@"{\"timestamp\":\"2014-01-01T00:00:01.000Z\",\"level\":\"trace\",\"file\":\"A.m\",\"line\":12,\"message\":\"second\"}\n{\"timestamp\":\"2014-01-01T00:00:03.000Z\",\"level\":\"alert\",\"message\":\"fourth\"}\n"
+                dataUsingEncoding:NSUTF8StringEncoding] writeToURL:JSONFileURL atomically:YES]);
+    NSArray *fileURLs = @[ textFileURL, JSONFileURL ];
+    
+    NSMutableArray *records = [[NSMutableArray alloc] init];
+    [JEDebugging
+     enumerateFileLogRecordsAtURLs:fileURLs
+     matchingQuery:nil
+     withBlock:^(JELogRecord *record, BOOL *stop) {
+         
+         [records addObject:record];
+     }];
+    XCTAssert([records count] == 4);
+    JELogRecord *firstRecord = records[0];
+    XCTAssert(firstRecord.level == JELogLevelNotice);
+    XCTAssert([firstRecord.fileName isEqualToString:@"A.m"]);
+    XCTAssert(firstRecord.lineNumber == 10);
+    XCTAssert([firstRecord.functionName isEqualToString:@"-[A a]"]);
+    XCTAssert([firstRecord.message isEqualToString:@"first"]);
+    JELogRecord *thirdRecord = records[2];
+    XCTAssert(thirdRecord.level == JELogLevelAlert);
+    XCTAssert([thirdRecord.message isEqualToString:@"third"]);
+    XCTAssert([thirdRecord.dump isEqualToString:@"dumped value"]);
+    
+    JEFileLogQuery *query = [[JEFileLogQuery alloc] init];
+    query.filter = [[JELogFilter alloc] init];
+    query.filter.fileNamePattern = @"A.m";
+    query.startDate = [[NSDate alloc] initWithTimeIntervalSince1970:1388534400.5];
+    [records removeAllObjects];
+    [JEDebugging
+     enumerateFileLogRecordsAtURLs:fileURLs
+     matchingQuery:query
+     withBlock:^(JELogRecord *record, BOOL *stop) {
+         
+         [records addObject:record];
+     }];
+    XCTAssert([records count] == 1);
+    XCTAssert([[records.firstObject message] isEqualToString:@"second"]);
+    
+    query = [[JEFileLogQuery alloc] init];
+    query.messageRegularExpression = [[NSRegularExpression alloc] initWithPattern:@"^(third|fourth)$" options:kNilOptions error:NULL];
+    NSURL *exportFileURL = [directoryURL URLByAppendingPathComponent:@"export.jsonl"];
+    XCTAssert([JEDebugging
+               exportFileLogRecordsAtURLs:fileURLs
+               matchingQuery:query
+               toURL:exportFileURL
+               format:JEFileLogFormatJSONLines
+               error:NULL]);
+    NSString *exportedString = [[NSString alloc] initWithContentsOfURL:exportFileURL encoding:NSUTF8StringEncoding error:NULL];
+    NSArray *lines = [exportedString componentsSeparatedByString:@"\n"];
+    XCTAssert([lines count] == 3);
+    XCTAssert([lines[0] rangeOfString:@"\"message\":\"third\""].location != NSNotFound);
+    XCTAssert([lines[0] rangeOfString:@"\"dump\":\"dumped value\""].location != NSNotFound);
+    XCTAssert([lines[1] hasSuffix:@"\"message\":\"fourth\"}"]);
+    
+    [[NSFileManager defaultManager] removeItemAtURL:directoryURL error:NULL];
+}
+
+- (void)testOrderedDictionary {
+    
+    JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+    for (NSUInteger i = 0; i < 1000; ++i) {
+        
+        orderedDictionary[[NSString stringWithFormat:@"%lu", (unsigned long)(999 - i)]] = @(i);
+    }
+    XCTAssert([orderedDictionary count] == 1000);
+    XCTAssert([[orderedDictionary firstKey] isEqualToString:@"999"]);
+    XCTAssert([[orderedDictionary lastKey] isEqualToString:@"0"]);
+    XCTAssert([orderedDictionary[@"500"] isEqual:@499]);
+    XCTAssert([[orderedDictionary objectAtIndex:499] isEqual:@499]);
+    XCTAssert([orderedDictionary indexOfKey:@"500"] == 499);
+    XCTAssert([orderedDictionary indexOfKey:@"missing"] == NSNotFound);
+    XCTAssertThrowsSpecificNamed([orderedDictionary keyAtIndex:1000], NSException, NSRangeException);
+    
+    orderedDictionary[@"999"] = @"replaced";
+    XCTAssert([orderedDictionary count] == 1000);
+    XCTAssert([[orderedDictionary firstObject] isEqual:@"replaced"]);
+    
+    [orderedDictionary removeObjectForKey:@"999"];
+    [orderedDictionary removeObjectForKey:@"500"];
+    XCTAssert([orderedDictionary count] == 998);
+    XCTAssert([[orderedDictionary firstKey] isEqualToString:@"998"]);
+    XCTAssert(orderedDictionary[@"500"] == nil);
+    XCTAssert([orderedDictionary indexOfKey:@"499"] == 498);
+    
+    NSMutableString *mutableKey = [NSMutableString stringWithString:@"mutable"];
+    orderedDictionary[mutableKey] = @YES;
+    [mutableKey appendString:@" changed"];
+    XCTAssert([[orderedDictionary lastKey] isEqualToString:@"mutable"]);
+    
+    __block NSUInteger expectedIndex = 0;
+    __block BOOL isOrdered = YES;
+    [orderedDictionary enumerateIndexesAndKeysAndObjectsUsingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
+        
+        isOrdered = (isOrdered
+                     && idx == expectedIndex
+                     && [[orderedDictionary keyAtIndex:idx] isEqual:key]
+                     && [orderedDictionary[key] isEqual:obj]);
+        ++expectedIndex;
+        
+    }];
+    XCTAssert(isOrdered);
+    XCTAssert(expectedIndex == [orderedDictionary count]);
+    XCTAssert([[[orderedDictionary keyEnumerator] allObjects] count] == [orderedDictionary count]);
+    
+    JEOrderedDictionary *copy = [orderedDictionary copy];
+    XCTAssert([copy isEqualToDictionary:orderedDictionary]);
+    XCTAssert([[copy keyAtIndex:100] isEqual:[orderedDictionary keyAtIndex:100]]);
+    
+    JEOrderedDictionary *unarchived = [NSKeyedUnarchiver unarchiveObjectWithData:
+                                       [NSKeyedArchiver archivedDataWithRootObject:orderedDictionary]];
+    XCTAssert([unarchived isEqualToDictionary:orderedDictionary]);
+    XCTAssert([[unarchived lastKey] isEqual:[orderedDictionary lastKey]]);
+    
+    [orderedDictionary removeAllObjects];
+    XCTAssert([orderedDictionary count] == 0);
+    XCTAssert([orderedDictionary firstObject] == nil);
+    XCTAssert([copy count] == 999);
+}
+
+- (void)testOrderedDictionaryRemoval {
+    
+    JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+    for (NSUInteger i = 0; i < 10000; ++i) {
+        
+        orderedDictionary[@(i)] = @(i);
+        if (i >= 100) {
+            
+            [orderedDictionary removeObjectForKey:@(i - 100)];
+        }
+    }
+    XCTAssert([orderedDictionary count] == 100);
+    XCTAssert([[orderedDictionary firstKey] isEqual:@9900]);
+    XCTAssert([[orderedDictionary keyAtIndex:50] isEqual:@9950]);
+    XCTAssert([orderedDictionary indexOfKey:@9999] == 99);
+    
+    [orderedDictionary removeObjectForKey:@9999];
+    [orderedDictionary removeObjectForKey:@9998];
+    XCTAssert([[orderedDictionary lastObject] isEqual:@9997]);
+    
+    for (NSUInteger i = 9900; i < 9997; i += 2) {
+        
+        [orderedDictionary removeObjectForKey:@(i)];
+    }
+    XCTAssert([orderedDictionary count] == 49);
+    XCTAssert([[orderedDictionary firstKey] isEqual:@9901]);
+    XCTAssert([[orderedDictionary keyAtIndex:1] isEqual:@9903]);
+    XCTAssert([orderedDictionary indexOfKey:@9997] == 48);
+    XCTAssert(orderedDictionary[@9902] == nil);
+    XCTAssert([orderedDictionary[@9903] isEqual:@9903]);
+    
+    orderedDictionary[@9902] = @"appended";
+    XCTAssert([[orderedDictionary lastKey] isEqual:@9902]);
+    XCTAssert([[[orderedDictionary keyEnumerator] allObjects] count] == 50);
+    XCTAssert([[orderedDictionary mutableCopy] isEqualToDictionary:orderedDictionary]);
+}
+
+- (void)testOrderedDictionaryRemovalPerformance {
+    
+    [self measureBlock:^{
+        
+        // Sliding window: insert at the back and remove from the front.
+        JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+        for (NSUInteger i = 0; i < 200000; ++i) {
+            
+            NSNumber *key = @(i);
+            orderedDictionary[key] = key;
+            if ([orderedDictionary count] > 100000) {
+                
+                [orderedDictionary removeObjectForKey:[orderedDictionary firstKey]];
+            }
+        }
+        XCTAssert([orderedDictionary count] == 100000);
+    }];
+}
+
+- (void)testOrderedDictionaryPerformance {
+    
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:100000];
+    for (NSUInteger i = 0; i < 100000; ++i) {
+        
+        [keys addObject:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+    }
+    [self measureBlock:^{
+        
+        JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+        for (NSString *key in keys) {
+            
+            orderedDictionary[key] = key;
+        }
+        NSUInteger found = 0;
+        for (NSString *key in keys) {
+            
+            found += (orderedDictionary[key] != nil);
+        }
+        __block NSUInteger enumerated = 0;
+        [orderedDictionary enumerateIndexesAndKeysAndObjectsUsingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
+            
+            enumerated += (obj != nil);
+            
+        }];
+        XCTAssert(found == 100000 && enumerated == 100000);
+    }];
+}
+
+- (void)testOrderedDictionaryBaselinePerformance {
+    
+    // Same workload as testOrderedDictionaryPerformance against the previous NSMutableDictionary + NSMutableOrderedSet storage.
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:100000];
+    for (NSUInteger i = 0; i < 100000; ++i) {
+        
+        [keys addObject:[NSString stringWithFormat:@"key%lu", (unsigned long)i]];
+    }
+    [self measureBlock:^{
+        
+        NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] init];
+        NSMutableOrderedSet *orderedKeys = [[NSMutableOrderedSet alloc] init];
+        for (NSString *key in keys) {
+            
+            [dictionary setObject:key forKey:key];
+            [orderedKeys addObject:key];
+        }
+        NSUInteger found = 0;
+        for (NSString *key in keys) {
+            
+            found += ([dictionary objectForKey:key] != nil);
+        }
+        __block NSUInteger enumerated = 0;
+        [orderedKeys enumerateObjectsUsingBlock:^(id key, NSUInteger idx, BOOL *stop) {
+            
+            enumerated += ([dictionary objectForKey:key] != nil);
+            
+        }];
+        XCTAssert(found == 100000 && enumerated == 100000);
+    }];
+}
+
+- (void)testOrderedDictionaryEnumeration {
+    
+    JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+    for (NSUInteger i = 0; i < 10000; ++i) {
+        
+        orderedDictionary[@(i)] = @(i * 2);
+    }
+    [orderedDictionary removeObjectForKey:@0];
+    [orderedDictionary removeObjectForKey:@5000];
+    
+    NSUInteger expectedKey = 1;
+    BOOL isOrdered = YES;
+    for (NSNumber *key in orderedDictionary) {
+        
+        isOrdered = (isOrdered && [key unsignedIntegerValue] == expectedKey);
+        expectedKey += ((expectedKey == 4999) ? 2 : 1);
+    }
+    XCTAssert(isOrdered);
+    XCTAssert(expectedKey == 10000);
+    XCTAssertThrows(^{
+        
+        for (NSNumber *key in orderedDictionary) {
+            
+            orderedDictionary[@(-[key integerValue])] = key;
+        }
+    }());
+    [orderedDictionary removeObjectForKey:@(-1)];
+    
+    __block int64_t concurrentSum = 0;
+    [orderedDictionary enumerateIndexesAndKeysAndObjectsWithOptions:NSEnumerationConcurrent usingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
+        
+        XCTAssert([obj unsignedIntegerValue] == ([key unsignedIntegerValue] * 2));
+        __atomic_fetch_add(&concurrentSum, [key longLongValue], __ATOMIC_RELAXED);
+        
+    }];
+    XCTAssert(concurrentSum == ((9999LL * 10000LL / 2) - 5000LL));
+    
+    __block NSUInteger visitedCount = 0;
+    [orderedDictionary enumerateIndexesAndKeysAndObjectsWithOptions:NSEnumerationReverse usingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
+        
+        XCTAssert(idx == (9997 - visitedCount));
+        *stop = (++visitedCount == 10);
+        
+    }];
+    XCTAssert(visitedCount == 10);
+    
+    NSMutableIndexSet *indexes = [[NSMutableIndexSet alloc] initWithIndexesInRange:NSMakeRange(10, 5)];
+    [indexes addIndexesInRange:NSMakeRange(100, 5)];
+    __block NSUInteger indexSum = 0;
+    [orderedDictionary enumerateIndexesAndKeysAndObjectsAtIndexes:indexes options:NSEnumerationConcurrent usingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
+        
+        XCTAssert([[orderedDictionary keyAtIndex:idx] isEqual:key]);
+        __atomic_fetch_add(&indexSum, idx, __ATOMIC_RELAXED);
+        
+    }];
+    XCTAssert(indexSum == (60 + 510));
+    XCTAssert([[[orderedDictionary objectEnumerator] nextObject] isEqual:@2]);
+    
+    // Mutating from the block may move the entries, so it raises instead of reading them after they are freed.
+    XCTAssertThrowsSpecificNamed([orderedDictionary enumerateIndexesAndKeysAndObjectsUsingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
+        
+        [orderedDictionary removeObjectForKey:key];
+        
+    }], NSException, NSGenericException);
+    XCTAssert([orderedDictionary count] == 9997);
+    
+    JEOrderedDictionary *accessOrderedDictionary = [orderedDictionary mutableCopy];
+    accessOrderedDictionary.ordersByAccess = YES;
+    XCTAssertThrowsSpecificNamed([accessOrderedDictionary enumerateIndexesAndKeysAndObjectsUsingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
+        
+        [accessOrderedDictionary objectForKey:key];
+        
+    }], NSException, NSGenericException);
+    
+    // Replacing an object in place doesn't move the entries the other chunks are reading, but still counts as a mutation.
+    accessOrderedDictionary.ordersByAccess = NO;
+    XCTAssertThrowsSpecificNamed([accessOrderedDictionary enumerateIndexesAndKeysAndObjectsWithOptions:NSEnumerationConcurrent usingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
+        
+        if (idx == 0) {
+            
+            accessOrderedDictionary[key] = @"replaced";
+        }
+        
+    }], NSException, NSGenericException);
+}
+
+- (void)testOrderedDictionaryAccessOrdering {
+    
+    JEOrderedDictionary *cache = [[JEOrderedDictionary alloc] init];
+    cache.ordersByAccess = YES;
+    cache.maximumCount = 3;
+    NSMutableArray *evictedKeys = [[NSMutableArray alloc] init];
+    cache.evictionHandler = ^(id key, id obj) {
+        
+        [evictedKeys addObject:key];
+    };
+    
+    cache[@"a"] = @1;
+    cache[@"b"] = @2;
+    cache[@"c"] = @3;
+    XCTAssert([cache[@"a"] isEqual:@1]);
+    XCTAssert(cache[@"z"] == nil);
+    XCTAssert([[cache lastKey] isEqualToString:@"a"]);
+    
+    cache[@"d"] = @4;
+    XCTAssert([cache count] == 3);
+    XCTAssert([evictedKeys isEqualToArray:(@[ @"b" ])]);
+    XCTAssert([[cache firstKey] isEqualToString:@"c"]);
+    XCTAssert([cache touchKey:@"c"]);
+    XCTAssert(![cache touchKey:@"b"]);
+    XCTAssert([[cache allKeys] isEqualToArray:(@[ @"a", @"d", @"c" ])]);
+    XCTAssert(cache.hitCount == 1 && cache.missCount == 1 && cache.evictionCount == 1);
+    
+    cache.maximumCount = 0;
+    cache.totalCostLimit = 10;
+    [cache setObject:@5 forKey:@"e" cost:6];
+    [cache setObject:@6 forKey:@"f" cost:6];
+    XCTAssert(cache.totalCost == 6);
+    XCTAssert([[cache allKeys] isEqualToArray:(@[ @"f" ])]);
+    XCTAssert([evictedKeys count] == 5);
+    
+    [cache removeObjectForKey:@"f"];
+    XCTAssert(cache.totalCost == 0);
+    XCTAssert(cache.evictionCount == 5);
+    [cache resetStatistics];
+    XCTAssert(cache.hitCount == 0 && cache.evictionCount == 0);
+    
+    cache.totalCostLimit = 0;
+    for (NSUInteger i = 0; i < 1000; ++i) {
+        
+        cache[@(i)] = @(i);
+    }
+    for (NSUInteger i = 0; i < 1000; i += 2) {
+        
+        XCTAssert([cache[@(i)] isEqual:@(i)]);
+    }
+    XCTAssert([cache count] == 1000);
+    XCTAssert([[cache keyAtIndex:0] isEqual:@1]);
+    XCTAssert([[cache keyAtIndex:500] isEqual:@0]);
+    XCTAssert([[cache lastKey] isEqual:@998]);
+}
+
+- (void)testOrderedDictionaryBulkOperations {
+    
+    JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+    id pairs[] = { @"c", @3, @"a", @1, @"b", @2, @"a", @4 };
+    [orderedDictionary addEntriesFromOrderedPairs:pairs count:4];
+    XCTAssert([[orderedDictionary allKeys] isEqualToArray:(@[ @"c", @"a", @"b" ])]);
+    XCTAssert([orderedDictionary[@"a"] isEqual:@4]);
+    
+    [orderedDictionary sortKeysUsingComparator:^NSComparisonResult(id obj1, id obj2) {
+        
+        return [obj1 compare:obj2];
+    }];
+    XCTAssert([[orderedDictionary allKeys] isEqualToArray:(@[ @"a", @"b", @"c" ])]);
+    XCTAssert([[orderedDictionary allValues] isEqualToArray:(@[ @4, @2, @3 ])]);
+    XCTAssert([orderedDictionary indexOfKey:@"c"] == 2);
+    
+    [orderedDictionary removeAllObjects];
+    for (NSUInteger i = 0; i < 100000; ++i) {
+        
+        orderedDictionary[@((i * 7919) % 100000)] = @(i);
+    }
+    [orderedDictionary sortKeysUsingComparator:^NSComparisonResult(id obj1, id obj2) {
+        
+        return [obj1 compare:obj2];
+    }];
+    BOOL isSorted = YES;
+    for (NSUInteger i = 0; i < 100000 && isSorted; ++i) {
+        
+        isSorted = [[orderedDictionary keyAtIndex:i] isEqual:@(i)];
+    }
+    XCTAssert(isSorted);
+    XCTAssert([orderedDictionary[@7919] isEqual:@1]);
+    
+    // A comparator that throws partway leaves the entries and the index as they were, whether the sort ran on one core or several.
+    for (JEOrderedDictionary *dictionary in @[ orderedDictionary, [orderedDictionary mutableCopy] ]) {
+        
+        if (dictionary != orderedDictionary) {
+            
+            [dictionary removeKeysInRange:NSMakeRange(100, 99900)];
+        }
+        NSUInteger expectedCount = [dictionary count];
+        __block int64_t comparisonCount = 0;
+        XCTAssertThrowsSpecificNamed([dictionary sortKeysUsingComparator:^NSComparisonResult(id obj1, id obj2) {
+            
+            if (__atomic_add_fetch(&comparisonCount, 1, __ATOMIC_RELAXED) > (int64_t)(expectedCount / 2)) {
+                
+                [NSException raise:NSInternalInconsistencyException format:@"Comparison failed"];
+            }
+            return [obj2 compare:obj1];
+            
+        }], NSException, NSInternalInconsistencyException);
+        BOOL isUnchanged = ([dictionary count] == expectedCount);
+        for (NSUInteger i = 0; i < expectedCount && isUnchanged; ++i) {
+            
+            isUnchanged = ([[dictionary keyAtIndex:i] isEqual:@(i)] && [dictionary indexOfKey:@(i)] == i);
+        }
+        XCTAssert(isUnchanged);
+    }
+    
+    [orderedDictionary removeKeysInRange:NSMakeRange(10, 99980)];
+    XCTAssert([orderedDictionary count] == 20);
+    XCTAssert([[orderedDictionary keyAtIndex:10] isEqual:@99990]);
+    XCTAssert(orderedDictionary[@50000] == nil);
+    XCTAssertThrowsSpecificNamed([orderedDictionary removeKeysInRange:NSMakeRange(15, 10)], NSException, NSRangeException);
+    
+    [orderedDictionary removeObjectsForKeys:(@[ @0, @99999, @"missing" ])];
+    XCTAssert([orderedDictionary count] == 18);
+    XCTAssert([[orderedDictionary firstKey] isEqual:@1]);
+    XCTAssert([[orderedDictionary lastKey] isEqual:@99998]);
+    XCTAssert([orderedDictionary[@99990] isEqual:@23210]);
+}
+
+- (void)testOrderedDictionaryBulkPerformance {
+    
+    NSUInteger count = 100000;
+    __unsafe_unretained id *pairs = (__unsafe_unretained id *)calloc((count * 2), sizeof(id));
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        
+        [keys addObject:@((i * 7919) % count)];
+        pairs[i * 2] = keys[i];
+        pairs[(i * 2) + 1] = keys[i];
+    }
+    NSArray *removedKeys = [keys subarrayWithRange:NSMakeRange(0, (count / 2))];
+    [self measureBlock:^{
+        
+        JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+        [orderedDictionary addEntriesFromOrderedPairs:pairs count:count];
+        [orderedDictionary sortKeysUsingComparator:^NSComparisonResult(id obj1, id obj2) {
+            
+            return [obj1 compare:obj2];
+        }];
+        [orderedDictionary removeObjectsForKeys:removedKeys];
+        [orderedDictionary removeKeysInRange:NSMakeRange(0, ([orderedDictionary count] / 2))];
+        XCTAssert([orderedDictionary count] == (count / 4));
+    }];
+    free(pairs);
+}
+
+- (void)testOrderedDictionaryElementwisePerformance {
+    
+    // Same workload as testOrderedDictionaryBulkPerformance using one element at a time and rebuilding to sort.
+    NSUInteger count = 100000;
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        
+        [keys addObject:@((i * 7919) % count)];
+    }
+    NSArray *removedKeys = [keys subarrayWithRange:NSMakeRange(0, (count / 2))];
+    [self measureBlock:^{
+        
+        JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+        for (id key in keys) {
+            
+            orderedDictionary[key] = key;
+        }
+        JEOrderedDictionary *sortedDictionary = [[JEOrderedDictionary alloc] init];
+        for (id key in [[orderedDictionary allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+            
+            sortedDictionary[key] = orderedDictionary[key];
+        }
+        for (id key in removedKeys) {
+            
+            [sortedDictionary removeObjectForKey:key];
+        }
+        for (NSUInteger i = ([sortedDictionary count] / 2); i > 0; --i) {
+            
+            [sortedDictionary removeObjectForKey:[sortedDictionary firstKey]];
+        }
+        XCTAssert([sortedDictionary count] == (count / 4));
+    }];
+}
+
+- (void)testOrderedDictionaryArchive {
+    
+    JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+    for (NSUInteger i = 0; i < 1000; ++i) {
+        
+        orderedDictionary[[NSString stringWithFormat:@"key%lu", (unsigned long)(999 - i)]] = @{ @"index": @(i) };
+    }
+    [orderedDictionary removeObjectForKey:@"key500"];
+    
+    NSURL *archiveURL = [[NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES]
+                         URLByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    NSError *error;
+    XCTAssert([orderedDictionary writeArchiveToURL:archiveURL error:&error]);
+    XCTAssert(error == nil);
+    
+    JEOrderedDictionary *loadedDictionary = [JEOrderedDictionary orderedDictionaryWithContentsOfArchiveURL:archiveURL error:&error];
+    XCTAssert([loadedDictionary count] == 999);
+    XCTAssert([[loadedDictionary firstKey] isEqualToString:@"key999"]);
+    XCTAssert([[loadedDictionary keyAtIndex:500] isEqualToString:@"key498"]);
+    XCTAssert([loadedDictionary[@"key0"] isEqual:(@{ @"index": @999 })]);
+    
+    // Untouched values are copied without decoding, so re-archiving a partly accessed dictionary must round-trip.
+    JEOrderedDictionary *reloadedDictionary = [[JEOrderedDictionary alloc] initWithArchiveData:[loadedDictionary archiveData] error:&error];
+    XCTAssert([reloadedDictionary isEqualToDictionary:orderedDictionary]);
+    XCTAssert([[reloadedDictionary allKeys] isEqualToArray:[orderedDictionary allKeys]]);
+    
+    NSMutableData *corruptData = [[loadedDictionary archiveData] mutableCopy];
+    [corruptData setLength:([corruptData length] - 1)];
+    XCTAssert([[JEOrderedDictionary alloc] initWithArchiveData:corruptData error:&error] == nil);
+    XCTAssert([error code] == NSFileReadCorruptFileError);
+    
+    // Values are only checked when decoded, so a damaged value still loads and reads as NSNull.
+    NSMutableData *corruptValueData = [[loadedDictionary archiveData] mutableCopy];
+    memset(((uint8_t *)[corruptValueData mutableBytes] + [corruptValueData length] - 32), 0xFF, 32);
+    JEOrderedDictionary *corruptValueDictionary = [[JEOrderedDictionary alloc] initWithArchiveData:corruptValueData error:&error];
+    XCTAssert([corruptValueDictionary count] == 999);
+    XCTAssert([[corruptValueDictionary lastObject] isEqual:[NSNull null]]);
+    XCTAssert([corruptValueDictionary[@"key1"] isEqual:(@{ @"index": @998 })]);
+    
+    [[NSFileManager defaultManager] removeItemAtURL:archiveURL error:NULL];
+}
+
+- (void)testOrderedDictionarySmall {
+    
+    JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+    for (NSUInteger i = 0; i < 6; ++i) {
+        
+        orderedDictionary[[NSString stringWithFormat:@"key%lu", (unsigned long)i]] = @(i);
+    }
+    [orderedDictionary removeObjectForKey:@"key2"];
+    XCTAssert([orderedDictionary touchKey:@"key0"]);
+    XCTAssert(![orderedDictionary touchKey:@"key2"]);
+    XCTAssert([[orderedDictionary allKeys] isEqualToArray:(@[ @"key1", @"key3", @"key4", @"key5", @"key0" ])]);
+    XCTAssert([orderedDictionary indexOfKey:@"key4"] == 2);
+    XCTAssert(orderedDictionary[@"key2"] == nil);
+    
+    // Growing past the small capacity switches to the hashed layout without changing the order.
+    for (NSUInteger i = 6; i < 40; ++i) {
+        
+        orderedDictionary[[NSString stringWithFormat:@"key%lu", (unsigned long)i]] = @(i);
+    }
+    XCTAssert([orderedDictionary count] == 39);
+    XCTAssert([[orderedDictionary keyAtIndex:4] isEqualToString:@"key0"]);
+    XCTAssert([orderedDictionary[@"key39"] isEqual:@39]);
+    XCTAssert([orderedDictionary[@"key3"] isEqual:@3]);
+    
+    [orderedDictionary removeAllObjects];
+    orderedDictionary[@"key"] = @"value";
+    XCTAssert([orderedDictionary[@"key"] isEqualToString:@"value"]);
+    XCTAssert([orderedDictionary count] == 1);
+}
+
+- (void)testOrderedDictionarySmallPerformance {
+    
+    NSArray *keys = @[ @"id", @"name", @"type", @"value", @"enabled" ];
+    NSUInteger numberOfDictionaries = 1000;
+    void (^buildDictionaries)(NSUInteger capacity) = ^(NSUInteger capacity) {
+        
+        for (NSUInteger i = 0; i < numberOfDictionaries; ++i) {
+            
+            JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] initWithCapacity:capacity];
+            for (NSString *key in keys) {
+                
+                orderedDictionary[key] = key;
+            }
+        }
+    };
+    
+    // A small dictionary holds its entries inline with its storage and has no index, so besides the object itself it needs one allocation. Reserving room past the small capacity forces the indexed layout, which also allocates the index and the tombstone counts.
+    buildDictionaries([keys count]);
+    buildDictionaries(64);
+    NSUInteger numberOfSmallAllocations = _JECountAllocations(^{
+        
+        buildDictionaries([keys count]);
+    });
+    NSUInteger numberOfIndexedAllocations = _JECountAllocations(^{
+        
+        buildDictionaries(64);
+    });
+    XCTAssert(numberOfSmallAllocations >= numberOfDictionaries, @"%lu allocations counted for %lu dictionaries", (unsigned long)numberOfSmallAllocations, (unsigned long)numberOfDictionaries);
+    XCTAssert(numberOfSmallAllocations <= (numberOfDictionaries * 2));
+    XCTAssert((numberOfSmallAllocations + numberOfDictionaries) <= numberOfIndexedAllocations);
+    
+    [self measureBlock:^{
+        
+        // Many tiny dictionaries, as when holding parsed JSON objects or configuration fragments.
+        NSMutableArray *orderedDictionaries = [[NSMutableArray alloc] initWithCapacity:100000];
+        for (NSUInteger i = 0; i < 100000; ++i) {
+            
+            JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+            for (NSString *key in keys) {
+                
+                orderedDictionary[key] = key;
+            }
+            [orderedDictionaries addObject:orderedDictionary];
+        }
+        NSUInteger foundCount = 0;
+        for (JEOrderedDictionary *orderedDictionary in orderedDictionaries) {
+            
+            foundCount += (orderedDictionary[@"value"] ? 1 : 0);
+        }
+        XCTAssert(foundCount == 100000);
+    }];
+}
+
+- (void)testOrderedDictionaryCopyOnWrite {
+    
+    JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+    for (NSUInteger i = 0; i < 100; ++i) {
+        
+        orderedDictionary[@(i)] = @(i);
+    }
+    [orderedDictionary removeObjectForKey:@50];
+    
+    JEOrderedDictionary *copiedDictionary = [orderedDictionary mutableCopy];
+    JEOrderedDictionary *otherCopiedDictionary = [orderedDictionary copy];
+    copiedDictionary[@0] = @"changed";
+    copiedDictionary[@100] = @100;
+    [copiedDictionary removeObjectForKey:@1];
+    XCTAssert([orderedDictionary[@0] isEqual:@0]);
+    XCTAssert([orderedDictionary count] == 99);
+    XCTAssert(orderedDictionary[@100] == nil);
+    XCTAssert([orderedDictionary[@1] isEqual:@1]);
+    XCTAssert([copiedDictionary count] == 99);
+    XCTAssert([[copiedDictionary keyAtIndex:0] isEqual:@0]);
+    XCTAssert([[copiedDictionary lastKey] isEqual:@100]);
+    
+    [orderedDictionary removeKeysInRange:NSMakeRange(0, 10)];
+    XCTAssert([[orderedDictionary firstKey] isEqual:@10]);
+    XCTAssert([otherCopiedDictionary count] == 99);
+    XCTAssert([[otherCopiedDictionary firstKey] isEqual:@0]);
+    XCTAssert([otherCopiedDictionary indexOfKey:@51] == 50);
+    
+    [otherCopiedDictionary removeAllObjects];
+    XCTAssert([orderedDictionary count] == 89);
+    XCTAssert([copiedDictionary count] == 99);
+}
+
+- (void)testOrderedDictionaryConcurrentReads {
+    
+    JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+    NSMutableArray *expectedKeys = [[NSMutableArray alloc] init];
+    for (NSUInteger i = 0; i < 1000; ++i) {
+        
+        orderedDictionary[@(i)] = @(i);
+    }
+    for (NSUInteger i = 0; i < 1000; ++i) {
+        
+        if ((i % 3) == 1) {
+            
+            [orderedDictionary removeObjectForKey:@(i)];
+        }
+        else {
+            
+            [expectedKeys addObject:@(i)];
+        }
+    }
+    
+    // Tombstones in the middle are left for a later mutation, so index-based reads from many threads never race on compacting them.
+    JEOrderedDictionary *copiedDictionary = [orderedDictionary copy];
+    NSArray *dictionaries = @[orderedDictionary, copiedDictionary];
+    __block BOOL isConsistent = YES;
+    dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t iteration) {
+        
+        JEOrderedDictionary *dictionary = dictionaries[iteration % 2];
+        BOOL isMatching = ([dictionary count] == [expectedKeys count]);
+        for (NSUInteger idx = 0; idx < [expectedKeys count] && isMatching; ++idx) {
+            
+            id key = expectedKeys[idx];
+            isMatching = ([[dictionary keyAtIndex:idx] isEqual:key]
+                          && [[dictionary objectAtIndex:idx] isEqual:key]
+                          && [dictionary indexOfKey:key] == idx);
+        }
+        NSUInteger idx = 0;
+        for (id key in dictionary) {
+            
+            isMatching = (isMatching && [key isEqual:expectedKeys[idx++]]);
+        }
+        [dictionary enumerateIndexesAndKeysAndObjectsWithOptions:NSEnumerationConcurrent usingBlock:^(NSUInteger idx, id key, id obj, BOOL *stop) {
+            
+            if (![key isEqual:expectedKeys[idx]]) {
+                
+                __atomic_store_n(&isConsistent, NO, __ATOMIC_RELAXED);
+            }
+            
+        }];
+        if (!isMatching) {
+            
+            __atomic_store_n(&isConsistent, NO, __ATOMIC_RELAXED);
+        }
+        
+    });
+    XCTAssert(isConsistent);
+    
+    [copiedDictionary removeObjectForKey:@0];
+    XCTAssert([[copiedDictionary keyAtIndex:0] isEqual:@2]);
+    XCTAssert([[orderedDictionary keyAtIndex:0] isEqual:@0]);
+    XCTAssert([orderedDictionary indexOfKey:@999] == ([expectedKeys count] - 1));
+}
+
+- (void)testOrderedDictionaryCopyPerformance {
+    
+    JEOrderedDictionary *orderedDictionary = [[JEOrderedDictionary alloc] init];
+    for (NSUInteger i = 0; i < 100000; ++i) {
+        
+        orderedDictionary[@(i)] = @(i);
+    }
+    [self measureBlock:^{
+        
+        // Copies share storage, so only the copy that is written to pays for duplicating the entries.
+        for (NSUInteger i = 0; i < 1000; ++i) {
+            
+            JEOrderedDictionary *copiedDictionary = [orderedDictionary copy];
+            XCTAssert([copiedDictionary count] == 100000);
+        }
+    }];
+}
+
+- (void)testSortedDictionary {
+    
+    JESortedDictionary *sortedDictionary = [[JESortedDictionary alloc] init];
+    XCTAssert([sortedDictionary firstKey] == nil);
+    XCTAssert([sortedDictionary floorKeyForKey:@0] == nil);
+    
+    // Even keys only, inserted out of order, then every fourth key removed.
+    for (NSUInteger i = 0; i < 10000; ++i) {
+        
+        NSNumber *key = @(((i * 7919) % 10000) * 2);
+        sortedDictionary[key] = key;
+    }
+    for (NSUInteger i = 0; i < 20000; i += 8) {
+        
+        [sortedDictionary removeObjectForKey:@(i)];
+    }
+    XCTAssert([sortedDictionary count] == 7500);
+    XCTAssert([[sortedDictionary firstKey] isEqual:@2]);
+    XCTAssert([[sortedDictionary lastKey] isEqual:@19998]);
+    XCTAssert([[sortedDictionary lastObject] isEqual:@19998]);
+    XCTAssert(sortedDictionary[@8] == nil);
+    XCTAssert([sortedDictionary[@10] isEqual:@10]);
+    
+    XCTAssert([[sortedDictionary floorKeyForKey:@9] isEqual:@6]);
+    XCTAssert([[sortedDictionary floorKeyForKey:@10] isEqual:@10]);
+    XCTAssert([[sortedDictionary ceilingKeyForKey:@7] isEqual:@10]);
+    XCTAssert([sortedDictionary ceilingKeyForKey:@20000] == nil);
+    XCTAssert([sortedDictionary floorKeyForKey:@1] == nil);
+    
+    XCTAssert([[sortedDictionary keysInKeyRangeFromKey:@7 toKey:@18] isEqualToArray:(@[ @10, @12, @14, @18 ])]);
+    XCTAssert([[sortedDictionary objectsInKeyRangeFromKey:@19990 toKey:nil] isEqualToArray:(@[ @19990, @19994, @19996, @19998 ])]);
+    XCTAssert([[sortedDictionary objectsInKeyRangeFromKey:@11 toKey:@9] count] == 0);
+    
+    NSMutableArray *reversedKeys = [[NSMutableArray alloc] init];
+    [sortedDictionary
+     enumerateKeysAndObjectsFromKey:@17
+     options:NSEnumerationReverse
+     usingBlock:^(id key, id obj, BOOL *stop) {
+         
+         [reversedKeys addObject:key];
+         (*stop) = ([reversedKeys count] == 3);
+         
+     }];
+    XCTAssert([reversedKeys isEqualToArray:(@[ @14, @12, @10 ])]);
+    
+    NSNumber *previousKey;
+    NSUInteger enumeratedCount = 0;
+    for (NSNumber *key in sortedDictionary) {
+        
+        XCTAssert(!previousKey || [previousKey compare:key] == NSOrderedAscending);
+        previousKey = key;
+        ++enumeratedCount;
+    }
+    XCTAssert(enumeratedCount == 7500);
+    XCTAssertThrowsSpecificNamed(^{
+        
+        for (NSNumber *key in sortedDictionary) {
+            
+            [sortedDictionary removeObjectForKey:key];
+        }
+    }(), NSException, NSGenericException);
+    
+    JESortedDictionary *copiedDictionary = [sortedDictionary mutableCopy];
+    [copiedDictionary removeAllObjects];
+    XCTAssert([copiedDictionary count] == 0);
+    XCTAssert([sortedDictionary count] == 7499);
+    
+    JESortedDictionary *unarchivedDictionary = [NSKeyedUnarchiver unarchiveObjectWithData:
+                                                [NSKeyedArchiver archivedDataWithRootObject:sortedDictionary]];
+    XCTAssert([unarchivedDictionary isEqualToDictionary:sortedDictionary]);
+    XCTAssert([[unarchivedDictionary allKeys] isEqualToArray:[sortedDictionary allKeys]]);
+    
+    JESortedDictionary *descendingDictionary = [[JESortedDictionary alloc] initWithComparator:^NSComparisonResult(id obj1, id obj2) {
+        
+        return [obj2 compare:obj1];
+        
+    }];
+    [descendingDictionary addEntriesFromDictionary:(@{ @"a": @1, @"c": @3, @"b": @2 })];
+    XCTAssert([[descendingDictionary allKeys] isEqualToArray:(@[ @"c", @"b", @"a" ])]);
+    XCTAssert([[descendingDictionary ceilingKeyForKey:@"bb"] isEqualToString:@"b"]);
+}
+
+- (void)testSortedDictionaryPerformance {
+    
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:100000];
+    for (NSUInteger i = 0; i < 100000; ++i) {
+        
+        [keys addObject:@((i * 7919) % 100000)];
+    }
+    [self measureBlock:^{
+        
+        JESortedDictionary *sortedDictionary = [[JESortedDictionary alloc] init];
+        for (id key in keys) {
+            
+            sortedDictionary[key] = key;
+        }
+        NSUInteger rangeCount = 0;
+        for (NSUInteger i = 0; i < 100000; i += 100) {
+            
+            rangeCount += [[sortedDictionary objectsInKeyRangeFromKey:@(i) toKey:@(i + 9)] count];
+        }
+        for (id key in keys) {
+            
+            [sortedDictionary removeObjectForKey:key];
+        }
+        XCTAssert(rangeCount == 10000);
+        XCTAssert([sortedDictionary count] == 0);
+    }];
+}
+
+- (void)testConcurrentOrderedDictionary {
+    
+    JEConcurrentOrderedDictionary *concurrentDictionary = [[JEConcurrentOrderedDictionary alloc] init];
+    __block BOOL isConsistent = YES;
+    __block BOOL isWriting = YES;
+    dispatch_group_t readerGroup = dispatch_group_create();
+    for (NSUInteger reader = 0; reader < 4; ++reader) {
+        
+        dispatch_group_async(readerGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            
+            while (__atomic_load_n(&isWriting, __ATOMIC_ACQUIRE)) {
+                
+                // Each batch adds keys n and n + 1 together, so a snapshot always holds an even count of contiguous keys.
+                JEOrderedDictionary *snapshot = [concurrentDictionary snapshot];
+                NSUInteger count = [snapshot count];
+                BOOL isValid = ((count % 2) == 0);
+                for (NSUInteger i = 0; i < count && isValid; ++i) {
+                    
+                    isValid = [[snapshot keyAtIndex:i] isEqual:@(i)] && [snapshot[@(i)] isEqual:@(i)];
+                }
+                if (!isValid) {
+                    
+                    __atomic_store_n(&isConsistent, NO, __ATOMIC_RELEASE);
+                }
+            }
+        });
+    }
+    
+    for (NSUInteger i = 0; i < 400; i += 2) {
+        
+        [concurrentDictionary performUpdates:^(JEOrderedDictionary *dictionary) {
+            
+            dictionary[@(i)] = @(i);
+            dictionary[@(i + 1)] = @(i + 1);
+        }];
+    }
+    __atomic_store_n(&isWriting, NO, __ATOMIC_RELEASE);
+    dispatch_group_wait(readerGroup, DISPATCH_TIME_FOREVER);
+    
+    XCTAssert(isConsistent);
+    XCTAssert([concurrentDictionary count] == 400);
+    XCTAssert([concurrentDictionary[@399] isEqual:@399]);
+    
+    JEOrderedDictionary *snapshot = [concurrentDictionary snapshot];
+    [concurrentDictionary removeObjectForKey:@0];
+    XCTAssert([snapshot count] == 400);
+    XCTAssert([concurrentDictionary count] == 399);
+    [concurrentDictionary removeAllObjects];
+    XCTAssert([concurrentDictionary count] == 0);
+    
+    // Access ordering and limits set by an update must not turn lock-free lookups into writes to the shared snapshot.
+    [concurrentDictionary performUpdates:^(JEOrderedDictionary *dictionary) {
+        
+        dictionary.ordersByAccess = YES;
+        dictionary.maximumCount = 100;
+        for (NSUInteger i = 0; i < 100; ++i) {
+            
+            dictionary[@(i)] = @(i);
+        }
+    }];
+    dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t iteration) {
+        
+        for (NSUInteger i = 0; i < 10000; ++i) {
+            
+            [concurrentDictionary objectForKey:@((i * 7) % 100)];
+        }
+    });
+    JEOrderedDictionary *accessOrderedSnapshot = [concurrentDictionary snapshot];
+    XCTAssert(!accessOrderedSnapshot.ordersByAccess);
+    XCTAssert([accessOrderedSnapshot hitCount] == 0);
+    XCTAssert([[accessOrderedSnapshot firstKey] isEqual:@0]);
+    XCTAssert([[accessOrderedSnapshot lastKey] isEqual:@99]);
+    
+    concurrentDictionary[@100] = @100;
+    XCTAssert([concurrentDictionary count] == 100);
+    XCTAssert(concurrentDictionary[@0] == nil);
+}
+
+- (void)testConcurrentOrderedDictionaryReaderScaling {
+    
+    JEConcurrentOrderedDictionary *concurrentDictionary = [[JEConcurrentOrderedDictionary alloc] init];
+    JEOrderedDictionary *synchronizedDictionary = [[JEOrderedDictionary alloc] init];
+    [concurrentDictionary performUpdates:^(JEOrderedDictionary *dictionary) {
+        
+        for (NSUInteger i = 0; i < 1000; ++i) {
+            
+            dictionary[@(i)] = @(i);
+            synchronizedDictionary[@(i)] = @(i);
+        }
+    }];
+    
+    // Each reader does the same number of lookups, so with perfect scaling the elapsed time stays flat as readers are added.
+    // A writer keeps replacing values meanwhile. Every value written for a key is congruent to it modulo 1000, so any other value read means a lookup saw a released or torn snapshot.
+    NSUInteger lookupsPerReader = 100000;
+    __block BOOL isConsistent = YES;
+    for (NSUInteger readerCount = 1; readerCount <= 32; readerCount *= 2) {
+        
+        __block BOOL isWriting = YES;
+        dispatch_group_t writerGroup = dispatch_group_create();
+        dispatch_group_async(writerGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            
+            for (NSUInteger generation = 1; __atomic_load_n(&isWriting, __ATOMIC_ACQUIRE); ++generation) {
+                
+                NSUInteger key = (generation % 1000);
+                concurrentDictionary[@(key)] = @(key + (generation * 1000));
+            }
+        });
+        
+        CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+        dispatch_apply(readerCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t reader) {
+            
+            BOOL isValid = YES;
+            for (NSUInteger i = 0; i < lookupsPerReader; ++i) {
+                
+                NSNumber *value = [concurrentDictionary objectForKey:@(i % 1000)];
+                isValid = (isValid && value != nil && ([value unsignedIntegerValue] % 1000) == (i % 1000));
+            }
+            if (!isValid) {
+                
+                __atomic_store_n(&isConsistent, NO, __ATOMIC_RELEASE);
+            }
+        });
+        CFAbsoluteTime snapshotTime = (CFAbsoluteTimeGetCurrent() - startTime);
+        __atomic_store_n(&isWriting, NO, __ATOMIC_RELEASE);
+        dispatch_group_wait(writerGroup, DISPATCH_TIME_FOREVER);
+        
+        startTime = CFAbsoluteTimeGetCurrent();
+        dispatch_apply(readerCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t reader) {
+            
+            for (NSUInteger i = 0; i < lookupsPerReader; ++i) {
+                
+                @synchronized(synchronizedDictionary) {
+                    
+                    [synchronizedDictionary objectForKey:@(i % 1000)];
+                }
+            }
+        });
+        CFAbsoluteTime synchronizedTime = (CFAbsoluteTimeGetCurrent() - startTime);
+        
+        JELogNotice(@"%lu readers: snapshot %.3fs, @synchronized %.3fs", (unsigned long)readerCount, snapshotTime, synchronizedTime);
+    }
+    XCTAssert(isConsistent);
+    XCTAssert([concurrentDictionary count] == 1000);
+}
+
 JESynthesize(assign, void(^)(void), synthesizedCopy, setSynthesizedCopy);
 JESynthesize(strong, id, synthesizedId, setSynthesizedId);
 JESynthesize(copy, void(^)(void), synthesizedBlock, setSynthesizedBlock);